@@ -0,0 +1,137 @@
+/*
+ * Host-native latency bench for the greenhouse firmware.
+ * Each stage is timed per call with std::chrono and reported as a
+ * latency histogram (p50/p99/max) plus the virtual time it spent
+ * blocked in delay() and the heap it touched.
+ *
+ *   pio run -e native && .pio/build/native/program [-n 2000] [-v] [--csv] [filter]
+ */
+#pragma once
+#include <Arduino.h>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include "sim.h"
+
+class LatencyHistogram {
+public:
+  void reserve(size_t n) { samples_.reserve(n); }
+  void add(uint64_t ns) { samples_.push_back(ns); }
+  size_t count() const { return samples_.size(); }
+
+  uint64_t percentile(double p) {
+    if (samples_.empty()) return 0;
+    sort();
+    size_t i = (size_t)(p / 100.0 * (samples_.size() - 1) + 0.5);
+    return samples_[i];
+  }
+  uint64_t max() { sort(); return samples_.empty() ? 0 : samples_.back(); }
+
+  // log2 buckets: [0] <1us, [k] [2^(k-1), 2^k) us
+  void print(FILE *out) {
+    const int BUCKETS = 24;
+    size_t counts[BUCKETS] = {};
+    for (uint64_t ns : samples_) {
+      uint64_t us = ns / 1000;
+      int b = 0;
+      while (us && b < BUCKETS - 1) { us >>= 1; b++; }
+      counts[b]++;
+    }
+    for (int b = 0; b < BUCKETS; b++) {
+      if (!counts[b]) continue;
+      int bar = (int)(counts[b] * 50 / samples_.size());
+      fprintf(out, "    %8lluus | %-50.*s %zu\n",
+              b ? (unsigned long long)1 << (b - 1) : 0ULL, bar,
+              "##################################################", counts[b]);
+    }
+  }
+
+private:
+  void sort() {
+    if (!sorted_) { std::sort(samples_.begin(), samples_.end()); sorted_ = true; }
+  }
+  std::vector<uint64_t> samples_;
+  bool sorted_ = false;
+};
+
+struct BenchContext {
+  int iterations = 2000;
+  bool verbose = false;
+  bool csv = false;
+  const char *filter = nullptr;
+  int failures = 0;  // checks that failed; nonzero exit status
+
+  bool enabled(const char *name) const { return !filter || strstr(name, filter); }
+
+  // Times fn() `iterations` times after a short warmup and prints one row.
+  template <typename Fn> void measure(const char *name, Fn fn) {
+    if (!enabled(name)) return;
+    for (int i = 0; i < iterations / 20 + 1; i++) fn();
+
+    LatencyHistogram h;
+    h.reserve(iterations);
+    uint64_t blockedStart = sim::blockedUs();
+    sim::HeapStats heapStart = sim::heap();
+    sim::resetHeapPeak();
+    for (int i = 0; i < iterations; i++) {
+      auto t0 = std::chrono::steady_clock::now();
+      fn();
+      auto t1 = std::chrono::steady_clock::now();
+      h.add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+    }
+    sim::HeapStats heapEnd = sim::heap();
+    double blockedMs = (sim::blockedUs() - blockedStart) / 1000.0 / iterations;
+    double allocs = (double)(heapEnd.allocations - heapStart.allocations) / iterations;
+    size_t peak = heapEnd.peakBytes - heapStart.liveBytes;
+    report(name, h, blockedMs, allocs, peak);
+  }
+
+  void header() const {
+    if (csv) {
+      printf("stage,n,p50_us,p99_us,max_us,blocked_ms,allocs_per_op,peak_heap_bytes\n");
+    } else {
+      printf("%-34s %6s %10s %10s %10s %11s %8s %10s\n", "stage", "n", "p50(us)", "p99(us)",
+             "max(us)", "blocked(ms)", "allocs", "peak(B)");
+    }
+  }
+
+private:
+  void report(const char *name, LatencyHistogram &h, double blockedMs, double allocs, size_t peak) {
+    double p50 = h.percentile(50) / 1000.0, p99 = h.percentile(99) / 1000.0, mx = h.max() / 1000.0;
+    if (csv) {
+      printf("%s,%zu,%.3f,%.3f,%.3f,%.3f,%.2f,%zu\n", name, h.count(), p50, p99, mx, blockedMs, allocs, peak);
+      return;
+    }
+    printf("%-34s %6zu %10.3f %10.3f %10.3f %11.3f %8.2f %10zu\n", name, h.count(), p50, p99, mx,
+           blockedMs, allocs, peak);
+    if (verbose) h.print(stdout);
+  }
+};
+
+// Request headers every browser sends (without gzip the page templates answer plain text)
+#define BENCH_BROWSER_HEADERS "Accept-Encoding: gzip, deflate, br"
+
+// Bench suites (one per file under bench/)
+void benchBoot(BenchContext &ctx);  // boots the firmware: runs first
+void benchLoop(BenchContext &ctx);
+void benchSchedulerJitter(BenchContext &ctx);
+void benchHttp(BenchContext &ctx);
+void benchSnapshotStress(BenchContext &ctx);
+void benchHistory(BenchContext &ctx);
+void benchHistoryStore(BenchContext &ctx);
+void benchRollup(BenchContext &ctx);
+void benchWindow(BenchContext &ctx);
+void benchApi(BenchContext &ctx);
+void benchEvents(BenchContext &ctx);
+void benchSoil(BenchContext &ctx);
+void benchFilter(BenchContext &ctx);
+void benchCalibration(BenchContext &ctx);
+void benchBmp280(BenchContext &ctx);
+void benchBh1750(BenchContext &ctx);
+void benchI2c(BenchContext &ctx);
+void benchWifi(BenchContext &ctx);
+void benchRequestLog(BenchContext &ctx);
+void benchTelemetry(BenchContext &ctx);
+void benchTrace(BenchContext &ctx);
+void benchAlloc(BenchContext &ctx);
+void benchPages(BenchContext &ctx);
@@ -0,0 +1,39 @@
+/*
+ * Heap allocations made by handler code per request, on the GET routes a
+ * dashboard or scraper polls. Each must be zero in steady state: bodies go
+ * through ResponseWriter, sendStatic() or a ResponseCache slot, never a
+ * String or JsonDocument. The server's own request/response objects are
+ * not counted (sim::LibraryScope), they allocate on the device too.
+ *
+ * A route that allocates is reported as FAIL and fails the bench run.
+ */
+#include "bench.h"
+#include <ESPAsyncWebServer.h>
+
+#define ALLOC_WARMUP_REQUESTS 4  // first /metrics scrape registers its label strings, etc.
+
+static const char *const STEADY_ROUTES[] = {
+  "/api", "/health", "/status", "/sensors", "/metrics", "/water/status",
+  "/soil/calibration", "/i2c/scan", "/simple", "/calibrate",
+};
+
+void loop();
+
+void benchAlloc(BenchContext &ctx) {
+  if (!ctx.enabled("alloc")) return;
+  for (int i = 0; i < 50; i++) {  // a fresh /api body and metrics to render
+    sim::advanceUs(100);
+    loop();
+  }
+  for (const char *uri : STEADY_ROUTES) {
+    for (int i = 0; i < ALLOC_WARMUP_REQUESTS; i++) sim::httpRequest(HTTP_GET, uri, nullptr, BENCH_BROWSER_HEADERS);
+    uint32_t before = sim::heap().handlerAllocations;
+    uint32_t bytes = 0;
+    for (int i = 0; i < ctx.iterations; i++) bytes += sim::httpRequest(HTTP_GET, uri, nullptr, BENCH_BROWSER_HEADERS).bytes;
+    uint32_t allocs = sim::heap().handlerAllocations - before;
+    bool pass = allocs == 0 && bytes > 0;
+    if (!pass) ctx.failures++;
+    printf("alloc GET %-24s %6d requests %8u handler allocs  %s\n", uri, ctx.iterations, (unsigned)allocs,
+           pass ? "PASS" : "FAIL");
+  }
+}
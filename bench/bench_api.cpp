@@ -0,0 +1,143 @@
+/*
+ * /api: the old per-request JsonDocument handler against the body the
+ * acquisition task pre-renders into the response cache, served as 200 and
+ * as 304 for a poll that sends back the ETag. Throughput is requests/s on
+ * one host core. A stress run then races a renderer thread against readers
+ * holding leases to check no response ever sees a slot being rewritten.
+ */
+#include "bench.h"
+#include <ESPAsyncWebServer.h>
+#include <ArduinoJson.h>
+#include <WiFi.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include "../src/response_cache.h"
+
+extern AsyncWebServer server;
+
+// What the /api handler did before the cache: same fields and headers
+static void legacyApiHandler(AsyncWebServerRequest *request) {
+  static const char *const KEYS[4] = {"temperature", "pressure", "light", "soil"};
+  float values[4] = {23.4f, 1013.2f, 412.0f, 47.0f};
+  JsonDocument doc;
+  doc["temperature"] = values[0];
+  doc["pressure"] = values[1];
+  doc["light"] = values[2];
+  doc["soil"] = values[3];
+  doc["timestamp"] = millis();
+  doc["minTemperature"] = 18.1f;
+  doc["maxTemperature"] = 27.9f;
+  doc["totalReadings"] = 288;
+  doc["wifiRSSI"] = WiFi.RSSI();
+  JsonObject stats = doc["stats"].to<JsonObject>();
+  for (int i = 0; i < 4; i++) {
+    JsonObject s = stats[KEYS[i]].to<JsonObject>();
+    s["min"] = values[i] - 1;
+    s["max"] = values[i] + 1;
+    s["mean"] = values[i];
+    s["stddev"] = 0.5f;
+    s["count"] = 288;
+  }
+  String res; serializeJson(doc, res);
+  AsyncWebServerResponse *response = request->beginResponse(200, "application/json", res);
+  response->addHeader("Access-Control-Allow-Origin", "*");
+  response->addHeader("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
+  response->addHeader("Access-Control-Allow-Headers", "Content-Type");
+  request->send(response);
+}
+
+template <typename Fn>
+static double requestsPerSecond(Fn fn) {
+  const auto DURATION = std::chrono::milliseconds(200);
+  auto t0 = std::chrono::steady_clock::now();
+  uint64_t n = 0;
+  while (std::chrono::steady_clock::now() - t0 < DURATION) {
+    for (int i = 0; i < 64; i++) fn();
+    n += 64;
+  }
+  return n / std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void cacheStress() {
+  const int READERS = 3;
+  const size_t BODY = 512;
+  typedef ResponseCache<4, BODY> Cache;  // as many slots as apiCache
+  static Cache cache;
+  std::atomic<bool> stop(false);
+  std::atomic<uint64_t> reads(0), torn(0);
+  uint64_t renders = 0, skipped = 0;
+
+  // Every body is one byte repeated, so a rewrite under a lease shows up
+  std::thread writer([&] {
+    uint8_t n = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+      char *buf = cache.beginWrite();
+      if (!buf) { skipped++; continue; }
+      n = (uint8_t)(n % 250 + 1);
+      size_t len = BODY / 2 + n;
+      memset(buf, n, len);
+      cache.commit(len);
+      renders++;
+    }
+  });
+  std::vector<std::thread> readers;
+  for (int r = 0; r < READERS; r++) {
+    readers.emplace_back([&] {
+      uint64_t myReads = 0, myTorn = 0;
+      Cache::Lease lease;
+      while (!stop.load(std::memory_order_relaxed)) {
+        if (!cache.acquire(lease)) continue;
+        const char *d = lease.data();
+        size_t len = lease.length();
+        // Drain in small chunks like a slow socket would
+        for (int pass = 0; pass < 4; pass++) {
+          for (size_t i = 0; i < len; i++) {
+            if (d[i] != d[0] || len != BODY / 2 + (uint8_t)d[0]) { myTorn++; break; }
+          }
+        }
+        lease.release();
+        myReads++;
+      }
+      reads += myReads;
+      torn += myTorn;
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  stop = true;
+  writer.join();
+  for (std::thread &t : readers) t.join();
+  printf("api cache stress (%d readers, 0.3s): %llu renders, %llu skipped (spares leased), "
+         "%llu leased reads, torn %llu\n", READERS, (unsigned long long)renders,
+         (unsigned long long)skipped, (unsigned long long)reads.load(), (unsigned long long)torn.load());
+}
+
+void benchApi(BenchContext &ctx) {
+  if (!ctx.enabled("api")) return;
+
+  // Served through the same dispatch as /api so only the handlers differ
+  static bool registered = false;
+  if (!registered) server.on("/bench/api-legacy", HTTP_GET, legacyApiHandler);
+  registered = true;
+  auto legacy = [] { sim::httpRequest(HTTP_GET, "/bench/api-legacy"); };
+  sim::HttpResult first = sim::httpRequest(HTTP_GET, "/api");
+  char etag[32] = "";
+  sim::lastHeader("ETag", etag, sizeof(etag));
+  char conditional[64];
+  snprintf(conditional, sizeof(conditional), "If-None-Match: %s", etag);
+
+  ctx.measure("api GET legacy JsonDocument", legacy);
+  ctx.measure("api GET cached (200)", [] { sim::httpRequest(HTTP_GET, "/api"); });
+  int code = 0;
+  ctx.measure("api GET If-None-Match (304)", [&] { code = sim::httpRequest(HTTP_GET, "/api", nullptr, conditional).code; });
+
+  if (ctx.enabled("api throughput")) {
+    double before = requestsPerSecond(legacy);
+    double cached = requestsPerSecond([] { sim::httpRequest(HTTP_GET, "/api"); });
+    double notModified = requestsPerSecond([&] { sim::httpRequest(HTTP_GET, "/api", nullptr, conditional); });
+    printf("api throughput: legacy %.0f req/s, cached %.0f req/s (%.1fx), 304 %.0f req/s (%.1fx)\n",
+           before, cached, cached / before, notModified, notModified / before);
+    printf("api body %zu B, ETag %s, conditional poll -> %d\n", first.bytes, etag, code);
+  }
+  if (ctx.enabled("api cache stress")) cacheStress();
+}
@@ -0,0 +1,135 @@
+/*
+ * BH1750: the auto-ranging one-time driver (src/bh1750_auto.h) against the
+ * claws driver in CONTINUOUS_HIGH_RES_MODE on the simulated chip. Sweeps
+ * 0.1 lx .. 120 klx for error and resolution (where the old mode clips),
+ * then replays a day of greenhouse light at the 500 ms sample period for
+ * range switches, bus traffic and how long the chip is powered.
+ */
+#include "bench.h"
+#include <BH1750.h>
+#include "../src/bh1750_auto.h"
+
+#define BH_BENCH_PERIOD_MS 500
+
+extern TwoWire I2C_1;
+extern Bh1750 lightMeter;
+extern I2cDevice lightDevice;
+
+// Steps the driver on the virtual clock until it has a reading
+static Bh1750Status settle(Bh1750 &bh, float &lux, unsigned long *waitedMs = nullptr) {
+  unsigned long t0 = millis();
+  Bh1750Status st;
+  while ((st = bh.collect(millis(), lux)) == BH1750_BUSY || st == BH1750_RANGING) sim::advanceMs(1);
+  if (waitedMs) *waitedMs = millis() - t0;
+  return st;
+}
+
+// The claws driver never touches MTreg: put it back to the power-on 69
+static float continuousRead(BH1750 &legacy) {
+  I2C_1.beginTransmission(0x23);
+  I2C_1.write(BH1750_MTREG_HIGH | (BH1750_MTREG_DEFAULT >> 5));
+  I2C_1.endTransmission();
+  I2C_1.beginTransmission(0x23);
+  I2C_1.write(BH1750_MTREG_LOW | (BH1750_MTREG_DEFAULT & 0x1F));
+  I2C_1.endTransmission();
+  legacy.configure(BH1750::CONTINUOUS_HIGH_RES_MODE);
+  sim::advanceMs(200);  // a continuous conversion lands after 120 ms
+  float lux = legacy.readLightLevel();
+  legacy.configure((BH1750::Mode)BH1750_POWER_DOWN);
+  return lux;
+}
+
+static void sweep(Bh1750 &bh, BH1750 &legacy) {
+  printf("bh1750 %10s %12s %8s %12s %10s %12s\n", "lux", "auto", "range", "lx/count", "continuous", "lx/count");
+  const float LUX[] = {0.1f, 1.0f, 12.5f, 180.0f, 2500.0f, 9000.0f, 20000.0f, 45000.0f, 60000.0f, 90000.0f, 120000.0f};
+  for (float target : LUX) {
+    sim::setBh1750(true, target);
+    float lux = 0;
+    bh.begin(lightDevice);  // the legacy read below leaves MTreg at 69
+    settle(bh, lux);        // first reading may come from a too sensitive range
+    settle(bh, lux);
+    float old = continuousRead(legacy);
+    const Bh1750Range &r = Bh1750::RANGES[bh.countsRange()];
+    printf("bh1750 %10.1f %12.2f %8d %12.2f %10.1f%s %11.2f\n", target, lux, bh.countsRange(),
+           Bh1750::countsToLux(1, r), old, old >= 54612 ? "*" : " ", 1 / 1.2);
+  }
+  printf("bh1750 (* = clipped at 65535 counts)\n");
+}
+
+// Clear-sky day: night, dawn, noon ~100 klx with passing clouds, dusk
+static float dayLux(double hour) {
+  if (hour < 5.5 || hour > 20.5) return 0.3f;
+  double s = sin((hour - 5.5) / 15.0 * M_PI);
+  double cloud = 0.75 + 0.25 * sin(hour * 17.0) * sin(hour * 5.3);
+  return (float)(0.3 + 100000.0 * s * s * s * cloud);
+}
+
+static void day(Bh1750 &bh) {
+  // Virtual time runs 1 s per 2 min of day, so the 500 ms sample loop sees
+  // the same number of transitions a full day would have, in 12 minutes
+  const int SAMPLES = 1440;
+  sim::I2CStats before = sim::i2cStats(1);
+  unsigned long convMs = 0, switches = 0, saturated = 0, clippedOld = 0;
+  double worst = 0;
+  uint8_t lastRange = bh.countsRange();
+  bh.begin(lightDevice);
+  for (int i = 0; i < SAMPLES; i++) {
+    float target = dayLux(24.0 * i / SAMPLES);
+    sim::setBh1750(true, target);
+    unsigned long t0 = millis();
+    float lux = 0;
+    unsigned long waited;
+    while (true) {
+      Bh1750Status st = bh.collect(millis(), lux);
+      if (st == BH1750_READY || st == BH1750_ERROR) break;
+      if (st == BH1750_RANGING) saturated++;
+      sim::advanceMs(20);  // the scheduler's poll interval
+    }
+    waited = millis() - t0;
+    convMs += waited;
+    if (bh.countsRange() != lastRange) switches++;
+    lastRange = bh.countsRange();
+    if (target >= 54612) clippedOld++;
+    if (target > 10) worst = fmax(worst, fabs(lux - target) / target);
+    if (waited < BH_BENCH_PERIOD_MS) sim::advanceMs(BH_BENCH_PERIOD_MS - waited);
+  }
+  sim::I2CStats after = sim::i2cStats(1);
+  printf("bh1750 day (%d samples): %lu range switches, %lu saturated re-measures, worst error %.2f%% above 10 lx\n",
+         SAMPLES, switches, saturated, worst * 100);
+  printf("bh1750 day: %.1f ms per reading (poll 20 ms), conversion wait %.0f%% of the period (continuous: always on), "
+         "%.1f transactions/sample; continuous mode clipped %lu samples\n",
+         (double)convMs / SAMPLES, 100.0 * convMs / (SAMPLES * (double)BH_BENCH_PERIOD_MS),
+         (double)(after.transactions - before.transactions) / SAMPLES, clippedOld);
+}
+
+void benchBh1750(BenchContext &ctx) {
+  if (!ctx.enabled("bh1750")) return;
+
+  static Bh1750 bh;
+  static BH1750 legacy;
+  if (!bh.begin(lightDevice)) {
+    printf("bh1750: sensor not found on the simulated bus\n");
+    return;
+  }
+  volatile float sink = 0;
+  sim::setBh1750(true, 350.0f);
+  ctx.measure("bh1750 collect (busy)", [&] {
+    float lux = 0;
+    bh.collect(millis(), lux);
+    sink = lux;
+  });
+  ctx.measure("bh1750 conversion (virtual wait)", [&] {
+    float lux = 0;
+    bh.start(millis());
+    settle(bh, lux);
+    sink = lux;
+  });
+
+  if (ctx.enabled("bh1750 range")) {
+    legacy.begin(BH1750::CONTINUOUS_HIGH_RES_MODE, 0x23, &I2C_1);
+    sweep(bh, legacy);
+    day(bh);
+  }
+  sim::setBh1750(true, 350.0f);
+  lightMeter.begin(lightDevice);  // the firmware's driver cached an MTreg this suite overwrote
+}
@@ -0,0 +1,114 @@
+/*
+ * BMP280 acquisition: one 6-byte burst with integer compensation (src/bmp280.h)
+ * against the Adafruit driver's readTemperature() + readPressure() on the
+ * same simulated chip. Reports bus bytes, transactions and wire time per
+ * sample next to the host time, checks the datasheet test vector and the
+ * integer paths against the double-precision formulas.
+ */
+#include "bench.h"
+#include <Adafruit_BMP280.h>
+#include "../src/bmp280.h"
+
+extern I2cDevice bmpDevice;
+
+// Datasheet example trimming parameters (BST-BMP280-DS001, 3.12)
+static const Bmp280Calibration DATASHEET_CALIB = {
+  27504, 26435, -1000, 36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000
+};
+
+static double referenceTemperature(const Bmp280Calibration &c, int32_t adcT, double *tFine) {
+  double var1 = (adcT / 16384.0 - c.T1 / 1024.0) * c.T2;
+  double d = adcT / 131072.0 - c.T1 / 8192.0;
+  double var2 = d * d * c.T3;
+  *tFine = var1 + var2;
+  return (var1 + var2) / 5120.0;
+}
+
+static double referencePressure(const Bmp280Calibration &c, int32_t adcP, double tFine) {
+  double var1 = tFine / 2.0 - 64000.0;
+  double var2 = var1 * var1 * c.P6 / 32768.0;
+  var2 = var2 + var1 * c.P5 * 2.0;
+  var2 = var2 / 4.0 + c.P4 * 65536.0;
+  var1 = (c.P3 * var1 * var1 / 524288.0 + c.P2 * var1) / 524288.0;
+  var1 = (1.0 + var1 / 32768.0) * c.P1;
+  if (var1 == 0) return 0;
+  double p = 1048576.0 - adcP;
+  p = (p - var2 / 4096.0) * 6250.0 / var1;
+  var1 = c.P9 * p * p / 2147483648.0;
+  var2 = p * c.P8 / 32768.0;
+  return p + (var1 + var2 + c.P7) / 16.0;
+}
+
+static void accuracy() {
+  const Bmp280Calibration &c = DATASHEET_CALIB;
+  int32_t tFine;
+  int32_t t = Bmp280::compensateTemperature(c, 519888, &tFine);
+  uint32_t p = Bmp280::compensatePressure(c, 415148, tFine);
+  printf("bmp280 datasheet vector: T %d (2508), t_fine %d (128422), P %.2f Pa (100653.27)\n", t, tFine,
+         p / 256.0);
+
+  // Integer vs double over the operating range: -40..85 degC, 300..1100 hPa
+  double worstT = 0, worstP = 0;
+  for (int32_t adcT = 380000; adcT <= 640000; adcT += 997) {
+    double tFineRef;
+    double tRef = referenceTemperature(c, adcT, &tFineRef);
+    if (tRef < -40 || tRef > 85) continue;
+    int32_t centi = Bmp280::compensateTemperature(c, adcT, &tFine);
+    worstT = fmax(worstT, fabs(centi / 100.0 - tRef));
+    for (int32_t adcP = 150000; adcP <= 700000; adcP += 4999) {
+      double pRef = referencePressure(c, adcP, tFineRef);
+      if (pRef < 30000 || pRef > 110000) continue;
+      worstP = fmax(worstP, fabs(Bmp280::compensatePressure(c, adcP, tFine) / 256.0 - pRef));
+    }
+  }
+  printf("bmp280 integer vs double: max |dT| %.4f degC, max |dP| %.3f Pa\n", worstT, worstP);
+}
+
+// Bus cost of one temperature + pressure pair, averaged over n samples
+template <typename Fn> static void busCost(const char *name, int n, Fn sample) {
+  sim::I2CStats before = sim::i2cStats(0);
+  uint64_t t0 = sim::nowUs();
+  for (int i = 0; i < n; i++) sample();
+  sim::I2CStats after = sim::i2cStats(0);
+  printf("bmp280 %-22s %5.1f transactions %5.1f bytes %6.1f us on the wire per sample\n", name,
+         (double)(after.transactions - before.transactions) / n, (double)(after.bytes - before.bytes) / n,
+         (double)(sim::nowUs() - t0) / n);
+}
+
+void benchBmp280(BenchContext &ctx) {
+  if (!ctx.enabled("bmp280")) return;
+
+  sim::setBmp280(true, 23.4f, 100150.0f);
+  static Adafruit_BMP280 legacy(&Wire);
+  static Bmp280 burst;
+  legacy.begin(0x76);
+  legacy.setSampling(Adafruit_BMP280::MODE_NORMAL, Adafruit_BMP280::SAMPLING_X2, Adafruit_BMP280::SAMPLING_X16,
+                     Adafruit_BMP280::FILTER_X16, Adafruit_BMP280::STANDBY_MS_500);
+  if (!burst.begin(bmpDevice)) {
+    printf("bmp280: sensor not found on the simulated bus\n");
+    return;
+  }
+
+  volatile float sink = 0;
+  ctx.measure("bmp280 adafruit temp+pressure", [&] {
+    sink = legacy.readTemperature() + legacy.readPressure();
+  });
+  ctx.measure("bmp280 burst + int compensation", [&] {
+    Bmp280Sample s;
+    if (burst.read(s)) sink = s.temperature() + s.pressurePa();
+  });
+  static const uint8_t DATA[BMP280_DATA_BYTES] = {0x65, 0x5A, 0xC0, 0x7E, 0xED, 0x00};  // adc_P 415148, adc_T 519888
+  ctx.measure("bmp280 decode only", [&] {
+    Bmp280Sample d;
+    if (Bmp280::decode(DATASHEET_CALIB, DATA, d)) sink = (float)d.pressureQ8;
+  });
+
+  if (ctx.enabled("bmp280 bus")) {
+    Bmp280Sample s = {};
+    busCost("adafruit temp+pressure", 100, [&] { sink = legacy.readTemperature() + legacy.readPressure(); });
+    busCost("burst", 100, [&] { burst.read(s); });
+    printf("bmp280 readings: adafruit %.2f degC %.2f Pa, burst %.2f degC %.2f Pa\n", legacy.readTemperature(),
+           legacy.readPressure(), s.temperature(), s.pressurePa());
+  }
+  if (ctx.enabled("bmp280 accuracy")) accuracy();
+}
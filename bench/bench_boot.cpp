@@ -0,0 +1,108 @@
+/*
+ * Boot with the AP down: this is where every run boots the firmware.
+ * setup() used to spin on WiFi.status() and then wait in getLocalTime(),
+ * so with no AP it never returned and took no readings. Here the AP stays
+ * down for BOOT_BENCH_AP_DOWN_MS of virtual time, then WiFi and NTP come
+ * back. Reported: how long setup() took, the history points taken without
+ * network, the worst loop() pass, and whether the pre-sync points ended up
+ * with wall-clock timestamps in time order (RAM ring and flash).
+ */
+#include "bench.h"
+#include <chrono>
+#include "../src/history.h"
+#include "../src/history_store.h"
+#include <LittleFS.h>
+
+#define BOOT_BENCH_AP_DOWN_MS (12UL * 60 * 1000)
+#define BOOT_BENCH_TIME_VALID_MIN 1577836800UL  // TIME_VALID_MIN in main.cpp
+
+void setup();
+void loop();
+extern SensorReading sensorHistory[MAX_HISTORY_POINTS];
+extern int historyIndex, historyCount;
+extern HistoryStore historyStore;
+extern bool timeInitialized;
+
+// Runs loop() for `ms` of virtual time; 100 us per pass as in benchLoop
+// (loop() sleeps itself when the next deadline is further away)
+static uint64_t runFor(unsigned long ms) {
+  uint64_t worstNs = 0;
+  unsigned long t0 = millis();
+  while (millis() - t0 < ms) {
+    sim::advanceUs(100);
+    auto a = std::chrono::steady_clock::now();
+    loop();
+    uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - a).count();
+    if (ns > worstNs) worstNs = ns;
+  }
+  return worstNs;
+}
+
+static bool ringInOrder(int *preSync) {
+  int oldest = (historyIndex - historyCount + MAX_HISTORY_POINTS) % MAX_HISTORY_POINTS;
+  unsigned long last = 0;
+  *preSync = 0;
+  for (int i = 0; i < historyCount; i++) {
+    unsigned long ts = sensorHistory[(oldest + i) % MAX_HISTORY_POINTS].timestamp;
+    if (ts < BOOT_BENCH_TIME_VALID_MIN) (*preSync)++;
+    if (ts < last) return false;
+    last = ts;
+  }
+  return true;
+}
+
+// On the device data/ is uploaded as the filesystem image; here the page
+// templates are copied into the sim's flash (run from the project root)
+static void installPages() {
+  static const char *const PAGES[] = {"simple.html.gz", "calibrate.html.gz"};
+  for (const char *name : PAGES) {
+    char path[64];
+    snprintf(path, sizeof(path), "data/%s", name);
+    FILE *in = fopen(path, "rb");
+    if (!in) {
+      printf("boot: %s not found, /simple and /calibrate will answer 503\n", path);
+      continue;
+    }
+    File out = LittleFS.open(path + 4, "w");
+    uint8_t buf[1024];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0) out.write(buf, n);
+    out.close();
+    fclose(in);
+  }
+}
+
+void benchBoot(BenchContext &ctx) {
+  installPages();
+  sim::setWiFiAp(false);
+  sim::setNtpSynced(false);
+  uint64_t blocked0 = sim::blockedUs();
+  setup();
+  unsigned long setupMs = millis();
+  uint64_t setupBlockedUs = sim::blockedUs() - blocked0;
+
+  int count0 = historyCount;
+  uint32_t stored0 = historyStore.stats().records + historyStore.stats().pending;
+  uint64_t worstDownNs = runFor(BOOT_BENCH_AP_DOWN_MS);
+  int taken = historyCount - count0;
+  int preSyncBefore = 0;
+  ringInOrder(&preSyncBefore);
+
+  sim::setWiFiAp(true);
+  runFor(2000);
+  sim::setNtpSynced(true);
+  uint64_t worstSyncNs = runFor(2000);
+  int preSyncAfter = 0;
+  bool ordered = ringInOrder(&preSyncAfter);
+  HistoryStoreStats hs = historyStore.stats();
+
+  if (!ctx.enabled("boot")) return;
+  printf("boot setup() returned after %lu ms (%.0f ms in delay()), AP down: old setup() never returns\n", setupMs,
+         setupBlockedUs / 1000.0);
+  printf("boot AP down %lu min: %d history points (%d on the boot clock), worst loop() pass %.1f us\n",
+         BOOT_BENCH_AP_DOWN_MS / 60000, taken, preSyncBefore, worstDownNs / 1000.0);
+  printf("boot after sync: time synced %s, %d points still on the boot clock, ring in time order %s, "
+         "flash +%lu records, worst loop() pass %.1f us\n",
+         timeInitialized ? "yes" : "no", preSyncAfter, ordered ? "yes" : "no",
+         (unsigned long)(hs.records + hs.pending - stored0), worstSyncNs / 1000.0);
+}
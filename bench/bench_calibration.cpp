@@ -0,0 +1,107 @@
+/*
+ * Soil calibration table: conversion throughput of the fixed-point segment
+ * table against the same interpolation in float, its rounding error over
+ * the whole raw range, and how far 2..8 calibration points land from
+ * reference probe curves (the old build-time map() is the 2-point row).
+ * Also round-trips a table through the NVS fake.
+ */
+#include "bench.h"
+#include "../src/soil_calibration.h"
+
+#define CAL_BENCH_DRY 3285  // SOIL_DRY_VALUE
+#define CAL_BENCH_WET 27    // SOIL_WET_VALUE
+#define CAL_BENCH_BATCH 1024
+
+// Reference curves: moisture % for a raw reading, as a gravimetric
+// calibration of a capacitive probe might give (monotonic, dry = high raw)
+static float curveConcave(float raw) {  // output compresses at the wet end
+  float x = (raw - CAL_BENCH_WET) / (CAL_BENCH_DRY - CAL_BENCH_WET);
+  x = x < 0 ? 0 : (x > 1 ? 1 : x);
+  return 100.0f * (1.0f - powf(x, 0.55f));
+}
+
+static float curveSigmoid(float raw) {  // flat near both ends, steep mid-range
+  float x = (raw - CAL_BENCH_WET) / (CAL_BENCH_DRY - CAL_BENCH_WET);
+  x = x < 0 ? 0 : (x > 1 ? 1 : x);
+  float s = 1.0f / (1.0f + expf(-9.0f * (x - 0.45f)));
+  float s0 = 1.0f / (1.0f + expf(9.0f * 0.45f)), s1 = 1.0f / (1.0f + expf(-9.0f * 0.55f));
+  return 100.0f * (1.0f - (s - s0) / (s1 - s0));
+}
+
+// n points evenly spaced in raw between wet and dry, read off the curve
+static SoilCalPoints sampleCurve(float (*curve)(float), int n) {
+  SoilCalPoints p = {};
+  for (int i = 0; i < n; i++) {
+    uint16_t raw = (uint16_t)(CAL_BENCH_WET + (CAL_BENCH_DRY - CAL_BENCH_WET) * i / (n - 1));
+    p.points[i] = {raw, roundf(curve(raw) * 100) / 100};  // NVS keeps 0.01 %
+  }
+  p.count = (uint8_t)n;
+  return p;
+}
+
+static void accuracy(const char *name, float (*curve)(float)) {
+  printf("calibration %-8s max|rms error (%%) vs reference:", name);
+  const int COUNTS[] = {2, 3, 5, 8};
+  for (int n : COUNTS) {
+    SoilCalibration cal;
+    cal.set(sampleCurve(curve, n));
+    double worst = 0, sumSq = 0;
+    int samples = 0;
+    for (int raw = CAL_BENCH_WET; raw <= CAL_BENCH_DRY; raw++) {
+      double e = cal.percent((float)raw) - curve((float)raw);
+      worst = fabs(e) > worst ? fabs(e) : worst;
+      sumSq += e * e;
+      samples++;
+    }
+    printf("  %d pts %5.2f|%4.2f", n, worst, sqrt(sumSq / samples));
+  }
+  printf("\n");
+}
+
+void benchCalibration(BenchContext &ctx) {
+  if (!ctx.enabled("calibration")) return;
+
+  static SoilCalibration cal;
+  cal.set(sampleCurve(curveSigmoid, SOIL_CAL_MAX_POINTS));
+  static float raws[CAL_BENCH_BATCH];
+  uint32_t rng = 7;
+  for (int i = 0; i < CAL_BENCH_BATCH; i++) {
+    rng = rng * 1664525u + 1013904223u;
+    raws[i] = (rng >> 8) % (16 * 4096) / 16.0f;  // fractional, like the filter output
+  }
+  volatile float sink = 0;
+  ctx.measure("calibration 1024 x fixed-point", [&] {
+    float acc = 0;
+    for (int i = 0; i < CAL_BENCH_BATCH; i++) acc += cal.percent(raws[i]);
+    sink = acc;
+  });
+  ctx.measure("calibration 1024 x float reference", [&] {
+    float acc = 0;
+    for (int i = 0; i < CAL_BENCH_BATCH; i++) acc += cal.percentReference(raws[i]);
+    sink = acc;
+  });
+
+  if (ctx.enabled("calibration accuracy")) {
+    // Fixed-point rounding over every Q4 raw value, including the clamped ends
+    double worst = 0;
+    for (int q4 = 0; q4 <= SOIL_CAL_RAW_MAX * 16; q4++) {
+      double e = fabs(cal.percent(q4 / 16.0f) - cal.percentReference(q4 / 16.0f));
+      worst = e > worst ? e : worst;
+    }
+    printf("calibration fixed-point vs float over 0..4095 in 1/16 counts: max error %.4f%%\n", worst);
+    accuracy("concave", curveConcave);
+    accuracy("sigmoid", curveSigmoid);
+
+    SoilCalPoints stored = sampleCurve(curveConcave, 6), loaded = {};
+    bool saved = saveSoilCalibration(stored);
+    bool ok = saved && loadSoilCalibration(loaded) && loaded.count == stored.count;
+    for (uint8_t i = 0; ok && i < stored.count; i++) {
+      ok = loaded.points[i].raw == stored.points[i].raw &&
+           fabsf(loaded.points[i].percent - stored.points[i].percent) < 0.005f;
+    }
+    clearSoilCalibration();
+    SoilCalPoints none;
+    printf("calibration NVS round trip: %s, after clear: %s\n", ok ? "ok" : "MISMATCH",
+           loadSoilCalibration(none) ? "still stored" : "default");
+  }
+}
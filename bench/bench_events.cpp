@@ -0,0 +1,89 @@
+/*
+ * /events push channel: cost of a push on the acquisition side and of a
+ * client drain on the network side, then ten virtual minutes of drifting
+ * sensors and one manual watering with several SSE clients attached,
+ * against what the same clients would pull by polling /api every 5 s.
+ */
+#include "bench.h"
+#include <ESPAsyncWebServer.h>
+#include <string>
+#include "../src/event_log.h"
+
+void loop();
+
+#define EVENTS_BENCH_CLIENTS 4
+#define EVENTS_BENCH_MINUTES 10
+#define EVENTS_POLL_MS 5000  // what data/script.js polled /api at
+
+static size_t count(const std::string &wire, const std::string &needle) {
+  size_t n = 0;
+  for (size_t at = wire.find(needle); at != std::string::npos; at = wire.find(needle, at + 1)) n++;
+  return n;
+}
+
+static size_t countEvents(const std::string &wire, const char *type) {
+  return count(wire, std::string("event: ") + type + "\n");
+}
+
+void benchEvents(BenchContext &ctx) {
+  if (!ctx.enabled("events")) return;
+
+  static EventLog log;
+  static const char DELTA[] = "{\"temperature\":23.41,\"soil\":47,\"timestamp\":81234}";
+  ctx.measure("events push", [] { log.push("sensors", DELTA, sizeof(DELTA) - 1); });
+  EventStream reader(log);
+  uint8_t wire[1436];  // one TCP MSS, like sim::httpRequest()
+  ctx.measure("events push + client drain", [&] {
+    log.push("sensors", DELTA, sizeof(DELTA) - 1);
+    while (reader.fill(wire, sizeof(wire), 0) > 0) {}
+  });
+
+  // Slow drift plus sensor noise: most samples stay inside the deadband
+  sim::HttpStream *clients[EVENTS_BENCH_CLIENTS];
+  std::string received[EVENTS_BENCH_CLIENTS];
+  for (int c = 0; c < EVENTS_BENCH_CLIENTS; c++) clients[c] = sim::openStream("/events");
+  int refused = 0;
+  sim::HttpStream *extra = sim::openStream("/events", &refused);
+  sim::closeStream(extra);
+
+  uint64_t start = sim::nowUs();
+  uint64_t end = start + EVENTS_BENCH_MINUTES * 60ULL * 1000000;
+  uint64_t nextPoll = start, nextDrift = start;
+  uint32_t k = 0;
+  bool watered = false;
+  while (sim::nowUs() < end) {
+    if (!watered && sim::nowUs() - start >= 5 * 60ULL * 1000000) {
+      sim::httpRequest(HTTP_POST, "/water/manual");  // 15 s pump run: start + stop events
+      watered = true;
+    }
+    if (sim::nowUs() >= nextDrift) {
+      float t = (float)((sim::nowUs() - start) / 1000000.0);
+      float noise = (float)((k * 7919) % 11) * 0.01f - 0.05f;
+      sim::setBmp280(true, 22.0f + 1.5f * sinf(t / 120.0f) + noise, 101300.0f + 40.0f * sinf(t / 300.0f));
+      sim::setBh1750(true, 400.0f + 300.0f * sinf(t / 90.0f) + noise * 20.0f);
+      k++;
+      nextDrift += 1000000;
+    }
+    sim::advanceUs(500);
+    loop();  // sleeps (virtually) up to the next deadline
+    if (sim::nowUs() >= nextPoll) {
+      for (int c = 0; c < EVENTS_BENCH_CLIENTS; c++) sim::pollStream(clients[c], &received[c]);
+      nextPoll += 100000;  // AsyncTCP polls an idle response every few hundred ms
+    }
+  }
+  for (int c = 0; c < EVENTS_BENCH_CLIENTS; c++) {
+    sim::pollStream(clients[c], &received[c]);
+    sim::closeStream(clients[c]);
+  }
+
+  const std::string &w = received[0];
+  size_t apiBytes = sim::httpRequest(HTTP_GET, "/api").bytes;
+  unsigned polls = EVENTS_BENCH_MINUTES * 60000 / EVENTS_POLL_MS;
+  printf("events %d min virtual, %d clients (client %d refused: %d): per client 1 request, %zu B "
+         "(snapshot %zu, sensors %zu, history %zu, watering %zu, pings %zu)\n",
+         EVENTS_BENCH_MINUTES, EVENTS_BENCH_CLIENTS, EVENTS_BENCH_CLIENTS + 1, refused, w.size(),
+         countEvents(w, "snapshot"), countEvents(w, "sensors"), countEvents(w, "history"),
+         countEvents(w, "watering"), count(w, ": ping\n"));
+  printf("events vs polling /api every %us: %u requests, %zu B body per client\n",
+         EVENTS_POLL_MS / 1000, polls, (size_t)polls * apiBytes);
+}
@@ -0,0 +1,64 @@
+/*
+ * Per-sensor filter chains: host cost of each stage per sample, so the
+ * acquisition budget stays predictable, then how often a drifting, noisy
+ * soil reading crosses the watering threshold with and without a chain
+ * (every crossing is a potential relay or alert toggle).
+ */
+#include "bench.h"
+#include "../src/filter_chain.h"
+
+#define FILTER_BENCH_SAMPLES 2400   // 20 minutes at the 500 ms sensor period
+#define FILTER_BENCH_THRESHOLD 30.0f  // soilMinThreshold default
+
+// Soil % drying slowly through the threshold, with read noise and the odd glitch
+static float driftSample(uint32_t i, uint32_t &rng) {
+  rng = rng * 1664525u + 1013904223u;
+  float u1 = (rng >> 8) / 16777216.0f;
+  rng = rng * 1664525u + 1013904223u;
+  float u2 = (rng >> 8) / 16777216.0f;
+  float v = 32.0f - 4.0f * i / FILTER_BENCH_SAMPLES + (u1 + u2 - 1.0f) * 1.2f;
+  if (u1 > 0.997f) v += 15.0f;
+  return v;
+}
+
+static unsigned crossings(FilterChain chain) {
+  uint32_t rng = 0x9E3779B9;
+  bool below = false;
+  unsigned n = 0;
+  for (uint32_t i = 0; i < FILTER_BENCH_SAMPLES; i++) {
+    bool now = chain.apply(driftSample(i, rng)) < FILTER_BENCH_THRESHOLD;
+    if (i && now != below) n++;
+    below = now;
+  }
+  return n;
+}
+
+template <typename Chain>
+static void measureChain(BenchContext &ctx, const char *name, Chain chain) {
+  static uint32_t rng = 1;
+  static uint32_t i = 0;
+  volatile float sink = 0;
+  ctx.measure(name, [&] { sink = chain.apply(driftSample(i++ % FILTER_BENCH_SAMPLES, rng)); });
+}
+
+void benchFilter(BenchContext &ctx) {
+  if (!ctx.enabled("filter")) return;
+
+  // Each row includes generating the sample (two LCG steps), as the baseline shows
+  measureChain(ctx, "filter none (baseline)", FilterChain());
+  measureChain(ctx, "filter median(3)", FilterChain(filterMedian(3)));
+  measureChain(ctx, "filter median(7)", FilterChain(filterMedian(7)));
+  measureChain(ctx, "filter ewma(0.3)", FilterChain(filterEwma(0.3f)));
+  measureChain(ctx, "filter kalman(0.05,1)", FilterChain(filterKalman(0.05f, 1.0f)));
+  measureChain(ctx, "filter median(5) > ewma > kalman",
+               FilterChain(filterMedian(5), filterEwma(0.5f), filterKalman(0.05f, 1.0f)));
+
+  if (ctx.enabled("filter chatter")) {
+    printf("filter chatter: soil 32%% -> 28%% over %d samples, crossings of %.0f%%: none %u, median(3) %u, "
+           "ewma(0.3) %u, kalman(0.05,1) %u (default), median(5) > kalman %u\n",
+           FILTER_BENCH_SAMPLES, FILTER_BENCH_THRESHOLD, crossings(FilterChain()),
+           crossings(FilterChain(filterMedian(3))), crossings(FilterChain(filterEwma(0.3f))),
+           crossings(FilterChain(filterKalman(0.05f, 1.0f))),
+           crossings(FilterChain(filterMedian(5), filterKalman(0.05f, 1.0f))));
+  }
+}
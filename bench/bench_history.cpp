@@ -0,0 +1,172 @@
+/*
+ * /history: the old build-a-JsonDocument-then-String handler against the
+ * chunked HistoryJsonStream and /history.bin, on a full 288-point ring.
+ */
+#include "bench.h"
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+#include "../src/history.h"
+
+void addToHistory();
+
+extern SensorReading sensorHistory[MAX_HISTORY_POINTS];
+extern int historyIndex;
+extern int historyCount;
+
+// The /history handler as it was before streaming, for comparison
+static size_t legacyHistoryJson() {
+  JsonDocument doc;
+  JsonArray temps = doc["temperature"].to<JsonArray>();
+  JsonArray pressures = doc["pressure"].to<JsonArray>();
+  JsonArray lights = doc["light"].to<JsonArray>();
+  JsonArray soils = doc["soil"].to<JsonArray>();
+  JsonArray timestamps = doc["timestamps"].to<JsonArray>();
+  int start = (historyCount < MAX_HISTORY_POINTS) ? 0 : historyIndex;
+  for (int i = 0; i < historyCount; i++) {
+    int idx = (start + i) % MAX_HISTORY_POINTS;
+    temps.add(sensorHistory[idx].temperature);
+    pressures.add(sensorHistory[idx].pressure);
+    lights.add((sensorHistory[idx].lightLevel != -1) ? sensorHistory[idx].lightLevel : 0);
+    soils.add((sensorHistory[idx].soilMoisture >= 0) ? sensorHistory[idx].soilMoisture : 0);
+    timestamps.add(sensorHistory[idx].timestamp);
+  }
+  String response;
+  serializeJson(doc, response);
+  // beginResponse() copies the String once more into the response object
+  String copy = response;
+  return copy.length();
+}
+
+// Reference decoder for /history.bin (mirrors decodeHistoryBinary() in data/script.js)
+static bool decodeHistoryBinary(const uint8_t *p, size_t len, std::vector<double> cols[HISTORY_BIN_COLUMNS]) {
+  const uint8_t *end = p + len;
+  auto varint = [&](uint64_t &v) {
+    v = 0;
+    for (int shift = 0; p < end; shift += 7) {
+      uint8_t b = *p++;
+      v |= (uint64_t)(b & 0x7F) << shift;
+      if (!(b & 0x80)) return true;
+    }
+    return false;
+  };
+  if (len < 6 || p[0] != 'G' || p[1] != 'H' || p[2] != 'B' || p[3] != HISTORY_BIN_VERSION) return false;
+  p += 4;
+  uint64_t count, scale[HISTORY_BIN_COLUMNS];
+  uint8_t order[HISTORY_BIN_COLUMNS];
+  if (!varint(count) || *p++ != HISTORY_BIN_COLUMNS) return false;
+  for (int c = 0; c < HISTORY_BIN_COLUMNS; c++) {
+    if (!varint(scale[c])) return false;
+    order[c] = *p++;
+  }
+  for (int c = 0; c < HISTORY_BIN_COLUMNS; c++) {
+    int64_t prev = 0, prevDelta = 0;
+    cols[c].clear();
+    for (uint64_t i = 0; i < count; i++) {
+      uint64_t z;
+      if (!varint(z)) return false;
+      int64_t v = (int64_t)(z >> 1) ^ -(int64_t)(z & 1);
+      if (i == 0) {
+        prev = v;
+      } else {
+        int64_t delta = (order[c] == 2 && i > 1) ? prevDelta + v : v;
+        prevDelta = delta;
+        prev += delta;
+      }
+      cols[c].push_back((double)prev / scale[c]);
+    }
+  }
+  return p == end;
+}
+
+// Every decoded value must be within half a quantization step of the ring
+static int roundTripErrors(const char *body, size_t len) {
+  std::vector<double> cols[HISTORY_BIN_COLUMNS];
+  if (!decodeHistoryBinary((const uint8_t *)body, len, cols)) return -1;
+  if ((int)cols[0].size() != historyCount) return -1;
+  int errors = 0;
+  int start = (historyCount < MAX_HISTORY_POINTS) ? 0 : historyIndex;
+  for (int i = 0; i < historyCount; i++) {
+    const SensorReading &r = sensorHistory[(start + i) % MAX_HISTORY_POINTS];
+    double expect[HISTORY_BIN_COLUMNS] = {r.temperature, r.pressure, r.lightLevel != -1 ? r.lightLevel : 0,
+                                          r.soilMoisture >= 0 ? r.soilMoisture : 0, (double)r.timestamp};
+    for (int c = 0; c < HISTORY_BIN_COLUMNS; c++) {
+      double tolerance = 0.5 / HistoryBinaryStream::columnScale(c) + 1e-6;
+      if (fabs(cols[c][i] - expect[c]) > tolerance) errors++;
+    }
+  }
+  return errors;
+}
+
+static void fillHistory() {
+  for (int i = 0; i < MAX_HISTORY_POINTS; i++) {
+    sim::setBmp280(true, 18.0f + (i % 50) * 0.173f, 100800.0f + i * 3.1f);
+    sim::setBh1750(true, (float)((i * 37) % 20000));
+    sim::advanceMs(300000);  // HISTORY_INTERVAL
+    sim::advanceUs(100);
+    extern void runScheduler();
+    runScheduler();
+    addToHistory();
+  }
+}
+
+void benchHistory(BenchContext &ctx) {
+  if (!ctx.enabled("history")) return;
+  fillHistory();
+
+  LatencyHistogram legacyTotal, streamTtfb, streamTotal;
+  legacyTotal.reserve(ctx.iterations);
+  streamTtfb.reserve(ctx.iterations);
+  streamTotal.reserve(ctx.iterations);
+  size_t legacyPeak = 0, streamPeak = 0, legacyBytes = 0, streamBytes = 0, chunks = 0;
+  for (int i = 0; i < ctx.iterations; i++) {
+    sim::resetHeapPeak();
+    size_t base = sim::heap().liveBytes;
+    auto t0 = std::chrono::steady_clock::now();
+    legacyBytes = legacyHistoryJson();
+    auto t1 = std::chrono::steady_clock::now();
+    legacyTotal.add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+    legacyPeak = std::max(legacyPeak, sim::heap().peakBytes - base);
+
+    sim::resetHeapPeak();
+    base = sim::heap().liveBytes;
+    t0 = std::chrono::steady_clock::now();
+    sim::HttpResult r = sim::httpRequest(HTTP_GET, "/history");
+    t1 = std::chrono::steady_clock::now();
+    streamTtfb.add(r.ttfbNs);
+    streamTotal.add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+    streamPeak = std::max(streamPeak, sim::heap().peakBytes - base);
+    streamBytes = r.bytes;
+    chunks = r.chunks;
+  }
+
+  LatencyHistogram binTotal;
+  binTotal.reserve(ctx.iterations);
+  size_t binPeak = 0, binBytes = 0;
+  for (int i = 0; i < ctx.iterations; i++) {
+    sim::resetHeapPeak();
+    size_t base = sim::heap().liveBytes;
+    auto t0 = std::chrono::steady_clock::now();
+    sim::HttpResult r = sim::httpRequest(HTTP_GET, "/history.bin");
+    auto t1 = std::chrono::steady_clock::now();
+    binTotal.add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+    binPeak = std::max(binPeak, sim::heap().peakBytes - base);
+    binBytes = r.bytes;
+  }
+  sim::setCaptureBody(true);
+  sim::HttpResult bin = sim::httpRequest(HTTP_GET, "/history.bin");
+  int errors = roundTripErrors(sim::lastBody(), bin.bytes);
+  sim::setCaptureBody(false);
+
+  printf("history %d points: legacy JsonDocument  ttfb=total p50 %.1fus p99 %.1fus, peak heap %zu B, %zu B\n",
+         MAX_HISTORY_POINTS, legacyTotal.percentile(50) / 1000.0, legacyTotal.percentile(99) / 1000.0,
+         legacyPeak, legacyBytes);
+  printf("history %d points: chunked stream       ttfb p50 %.1fus, total p50 %.1fus p99 %.1fus, peak heap %zu B, %zu B in %zu chunks\n",
+         MAX_HISTORY_POINTS, streamTtfb.percentile(50) / 1000.0, streamTotal.percentile(50) / 1000.0,
+         streamTotal.percentile(99) / 1000.0, streamPeak, streamBytes, chunks);
+  printf("history %d points: /history.bin         total p50 %.1fus p99 %.1fus, peak heap %zu B, %zu B "
+         "(%.1fx smaller, %.1fx faster than stream), round-trip %s\n",
+         MAX_HISTORY_POINTS, binTotal.percentile(50) / 1000.0, binTotal.percentile(99) / 1000.0, binPeak,
+         binBytes, binBytes ? (double)streamBytes / binBytes : 0.0,
+         binTotal.percentile(50) ? (double)streamTotal.percentile(50) / binTotal.percentile(50) : 0.0,
+         errors == 0 ? "OK" : (errors < 0 ? "DECODE FAILED" : "MISMATCH"));
+}
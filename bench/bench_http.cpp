@@ -0,0 +1,32 @@
+/*
+ * Every GET route registered in setupWebServer(), plus the watering POSTs.
+ * Routes are discovered from the server so new endpoints show up here
+ * without touching the bench.
+ */
+#include "bench.h"
+#include <ESPAsyncWebServer.h>
+
+void handleAutoWatering();
+void stopWatering();
+
+extern AsyncWebServer server;
+
+void benchHttp(BenchContext &ctx) {
+  char name[64];
+  for (const AsyncWebServer::Route &r : server.routes()) {
+    if (!(r.method & HTTP_GET)) continue;
+    snprintf(name, sizeof(name), "http GET %s", r.uri.c_str());
+    String uri = r.uri;
+    ctx.measure(name, [&uri] { sim::httpRequest(HTTP_GET, uri.c_str(), nullptr, BENCH_BROWSER_HEADERS); });
+  }
+
+  ctx.measure("http POST /water/auto", [] {
+    sim::httpRequest(HTTP_POST, "/water/auto", "{\"minThreshold\":30,\"maxThreshold\":90}");
+  });
+  ctx.measure("http POST /water/manual", [] {
+    sim::httpRequest(HTTP_POST, "/water/manual");
+    handleAutoWatering();  // applies the queued request
+    stopWatering();
+  });
+  ctx.measure("http GET (404)", [] { sim::httpRequest(HTTP_GET, "/nope"); });
+}
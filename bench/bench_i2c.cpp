@@ -0,0 +1,210 @@
+/*
+ * I2C engine under faults: the old blocking reads (Adafruit + claws on a
+ * 50 ms Wire timeout, BH1750 given up after one failure as the firmware
+ * used to) against the firmware's queued acquisition steps on the same
+ * simulated buses. Each scenario runs 30 cycles of 500 ms with the fault
+ * active for cycles 5..14:
+ *   healthy, BH1750 unplugged (then plugged back in), BMP280 holding SCL
+ *   low, and a slave on bus 1 holding SDA (needs SCL pulses to let go).
+ * Reported per cycle: time the acquisition thread waited on the bus (old:
+ * both buses back to back; engine: the busier of the two workers, nothing
+ * on the acquisition task itself), cycles with a valid reading, bus
+ * recoveries and how long after the fault cleared the sensor was back.
+ * On the host the engine's transfers run inline, so bus time is read from
+ * the per-bus counters rather than from overlapping wall time.
+ *
+ * "i2c boot" times the boot-time device map (i2c_map.h) on the virtual
+ * clock: full scan with nothing cached, verify against the cache, an extra
+ * device (not noticed until /i2c/scan), a sensor gone (full scan again).
+ */
+#include "bench.h"
+#include <Adafruit_BMP280.h>
+#include <BH1750.h>
+#include <ESPAsyncWebServer.h>
+#include "../src/i2c_engine.h"
+#include "../src/i2c_map.h"
+#include <Preferences.h>
+
+#define I2C_BENCH_CYCLES 30
+#define I2C_BENCH_FAULT_START 5
+#define I2C_BENCH_FAULT_END 15
+#define I2C_BENCH_PERIOD_MS 500
+#define I2C_BENCH_LEGACY_TIMEOUT_MS 50  // Wire's default
+
+// Same definition as main.cpp: the bench needs the values
+enum SensorStep : uint8_t { SENSOR_STEP_DONE, SENSOR_STEP_AGAIN, SENSOR_STEP_FAILED };
+
+extern TwoWire I2C_1;
+extern I2cBus i2cBus0, i2cBus1;
+extern float lightLevel;
+void serviceI2c();
+void startBmpBurst();
+void startLight();
+SensorStep collectTemperature();
+SensorStep collectPressure();
+SensorStep collectLight();
+bool initializeBMP280();
+bool initializeBH1750();
+void loadI2cDeviceMap();
+extern bool i2cMapVerified;
+extern I2cMap i2cMap;
+
+enum Fault { FAULT_NONE, FAULT_UNPLUG, FAULT_STALL, FAULT_STUCK };
+
+struct Scenario {
+  const char *name;
+  Fault fault;
+};
+
+struct Result {
+  double waitMs = 0, worstMs = 0;
+  int bmpValid = 0, lightValid = 0;
+  uint32_t recoveries = 0;
+  long backMs = -1;  // first valid reading of the faulted sensor after the fault cleared
+};
+
+static void applyFault(Fault fault, int cycle) {
+  bool on = cycle >= I2C_BENCH_FAULT_START && cycle < I2C_BENCH_FAULT_END;
+  switch (fault) {
+    case FAULT_UNPLUG: sim::setBh1750(!on, 350.0f); break;
+    case FAULT_STALL: sim::stallI2C(0, 0x76, on); break;
+    case FAULT_STUCK: if (cycle == I2C_BENCH_FAULT_START) sim::stickI2CBus(1, 5); break;
+    default: break;
+  }
+}
+
+static void clearFaults() {
+  sim::setBh1750(true, 350.0f);
+  sim::stallI2C(0, 0x76, false);
+  sim::stickI2CBus(1, 0);
+}
+
+static void noteCycle(Result &r, Fault fault, int cycle, double waitMs, bool bmpOk, bool lightOk) {
+  r.waitMs += waitMs;
+  r.worstMs = fmax(r.worstMs, waitMs);
+  r.bmpValid += bmpOk;
+  r.lightValid += lightOk;
+  bool faulted = fault == FAULT_STALL ? bmpOk : lightOk;
+  if (fault != FAULT_NONE && r.backMs < 0 && cycle >= I2C_BENCH_FAULT_END && faulted) {
+    r.backMs = (long)(cycle - I2C_BENCH_FAULT_END) * I2C_BENCH_PERIOD_MS;
+  }
+}
+
+static Result runLegacy(Adafruit_BMP280 &bmp, BH1750 &bh, Fault fault) {
+  Result r;
+  bool lightLost = false;
+  for (int cycle = 0; cycle < I2C_BENCH_CYCLES; cycle++) {
+    applyFault(fault, cycle);
+    Wire.setTimeOut(I2C_BENCH_LEGACY_TIMEOUT_MS);
+    I2C_1.setTimeOut(I2C_BENCH_LEGACY_TIMEOUT_MS);
+    unsigned long t0 = micros();
+    float t = bmp.readTemperature();
+    float p = bmp.readPressure();
+    float lux = lightLost ? -1 : bh.readLightLevel();
+    lightLost |= lux < 0;
+    unsigned long waited = micros() - t0;
+    noteCycle(r, fault, cycle, waited / 1000.0, !isnan(t) && !isnan(p), lux >= 0);
+    sim::advanceMs(I2C_BENCH_PERIOD_MS - waited / 1000);
+  }
+  return r;
+}
+
+// The scheduler's order: starts, then collects after the conversion time
+static Result runEngine(Fault fault) {
+  Result r;
+  uint32_t recoveries = i2cBus0.stats().recoveries + i2cBus1.stats().recoveries;
+  for (int cycle = 0; cycle < I2C_BENCH_CYCLES; cycle++) {
+    applyFault(fault, cycle);
+    unsigned long c0 = millis();
+    uint64_t bus0 = sim::i2cStats(0).busUs, bus1 = sim::i2cStats(1).busUs;
+    startBmpBurst();
+    startLight();
+    SensorStep t, p, l;
+    sim::advanceMs(1);
+    while ((t = collectTemperature()) == SENSOR_STEP_AGAIN) sim::advanceMs(1);
+    while ((p = collectPressure()) == SENSOR_STEP_AGAIN) sim::advanceMs(1);
+    while ((l = collectLight()) == SENSOR_STEP_AGAIN) sim::advanceMs(20);
+    serviceI2c();
+    bus0 = sim::i2cStats(0).busUs - bus0;
+    bus1 = sim::i2cStats(1).busUs - bus1;
+    noteCycle(r, fault, cycle, (bus0 > bus1 ? bus0 : bus1) / 1000.0,
+              t == SENSOR_STEP_DONE && p == SENSOR_STEP_DONE, l == SENSOR_STEP_DONE);
+    unsigned long spent = millis() - c0;
+    if (spent < I2C_BENCH_PERIOD_MS) sim::advanceMs(I2C_BENCH_PERIOD_MS - spent);
+  }
+  r.recoveries = i2cBus0.stats().recoveries + i2cBus1.stats().recoveries - recoveries;
+  return r;
+}
+
+static void report(const char *scenario, const char *path, const Result &r) {
+  char back[24] = "-";
+  if (r.backMs >= 0) snprintf(back, sizeof(back), "%ld ms", r.backMs);
+  printf("i2c %-16s %-7s %8.2f %8.2f %6d/%d %6d/%d %10u %10s\n", scenario, path, r.waitMs / I2C_BENCH_CYCLES,
+         r.worstMs, r.bmpValid, I2C_BENCH_CYCLES, r.lightValid, I2C_BENCH_CYCLES, r.recoveries, back);
+}
+
+static void bootMap(const char *label) {
+  uint64_t t0 = micros();
+  loadI2cDeviceMap();
+  printf("i2c boot %-26s %-8s %8.2f ms\n", label, i2cMapVerified ? "verified" : "scanned",
+         (micros() - t0) / 1000.0);
+}
+
+static void benchBootMap() {
+  Preferences prefs;
+  prefs.begin(I2C_MAP_NVS_NAMESPACE, false);
+  prefs.clear();
+  prefs.end();
+  bootMap("nothing cached");
+  bootMap("cached");
+  sim::attachI2C(0, 0x3C, true);
+  bootMap("OLED added");
+  sim::HttpResult started = sim::httpRequest(HTTP_POST, "/i2c/scan");
+  sim::HttpResult result = sim::httpRequest(HTTP_GET, "/i2c/scan");
+  printf("i2c boot POST /i2c/scan -> %d, GET -> %d, OLED in the map: %s\n", started.code, result.code,
+         i2cMap.buses[0].test(0x3C) ? "yes" : "no");
+  bootMap("after /i2c/scan");
+  sim::attachI2C(0, 0x3C, false);
+  sim::setBh1750(false, 350.0f);
+  bootMap("BH1750 gone");
+  sim::setBh1750(true, 350.0f);
+  bootMap("BH1750 back");
+  initializeBMP280();
+  initializeBH1750();
+}
+
+void benchI2c(BenchContext &ctx) {
+  if (ctx.enabled("i2c boot")) benchBootMap();
+  if (!ctx.enabled("i2c")) return;
+
+  static Adafruit_BMP280 legacyBmp(&Wire);
+  static BH1750 legacyBh;
+
+  const Scenario SCENARIOS[] = {
+    {"healthy", FAULT_NONE},
+    {"bh1750 unplug", FAULT_UNPLUG},
+    {"bmp280 stall", FAULT_STALL},
+    {"bus 1 stuck", FAULT_STUCK},
+  };
+  printf("i2c %-16s %-7s %8s %8s %8s %8s %10s %10s\n", "scenario", "path", "wait ms", "worst", "bmp ok",
+         "light ok", "recoveries", "back after");
+  for (const Scenario &sc : SCENARIOS) {
+    clearFaults();
+    legacyBmp.begin(0x76);
+    legacyBmp.setSampling(Adafruit_BMP280::MODE_NORMAL, Adafruit_BMP280::SAMPLING_X2, Adafruit_BMP280::SAMPLING_X16,
+                          Adafruit_BMP280::FILTER_X16, Adafruit_BMP280::STANDBY_MS_500);
+    legacyBh.begin(BH1750::CONTINUOUS_HIGH_RES_MODE, 0x23, &I2C_1);
+    report(sc.name, "legacy", runLegacy(legacyBmp, legacyBh, sc.fault));
+
+    clearFaults();
+    initializeBMP280();
+    initializeBH1750();
+    report(sc.name, "engine", runEngine(sc.fault));
+  }
+  printf("i2c (legacy: one thread waits on both buses; engine: busier bus worker, acquisition task never waits)\n");
+
+  clearFaults();
+  initializeBMP280();
+  initializeBH1750();
+  lightLevel = 0;
+}
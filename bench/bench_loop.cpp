@@ -0,0 +1,66 @@
+/*
+ * loop() and its stages. Each stage is called directly so the numbers
+ * add up to the full loop() row (minus Serial formatting).
+ */
+#include "bench.h"
+
+#define BENCH_HISTORY_INTERVAL_MS 300000  // HISTORY_INTERVAL in main.cpp
+
+enum SensorStep : uint8_t;  // defined in main.cpp
+
+void loop();
+unsigned long schedulerMaxJitterUs();
+SensorStep collectTemperature();
+SensorStep collectPressure();
+SensorStep collectLight();
+void drainSoilAdc();
+SensorStep collectSoil();
+void addToHistory();
+void updateSensorRegistry();
+void handleAutoWatering();
+void updateLEDStatus();
+
+void benchLoop(BenchContext &ctx) {
+  // 100 us of virtual time per pass; loop() sleeps itself up to the next deadline
+  ctx.measure("loop", [] {
+    sim::advanceUs(100);
+    loop();
+  });
+
+  ctx.measure("loop/bmp280", [] {
+    collectTemperature();
+    collectPressure();
+  });
+  ctx.measure("loop/bh1750", [] { collectLight(); });
+  // One drain period of DMA samples (SOIL_ADC_DRAIN_MS at 4 kHz) through the filter
+  ctx.measure("loop/soil adc drain", [] {
+    sim::advanceMs(32);
+    drainSoilAdc();
+  });
+  ctx.measure("loop/soil collect", [] { collectSoil(); });
+
+  // Force the 5-minute path every call; the buffer fills during warmup
+  ctx.measure("loop/addToHistory", [] {
+    sim::advanceMs(BENCH_HISTORY_INTERVAL_MS);
+    addToHistory();
+  });
+  ctx.measure("loop/addToHistory (idle)", [] { addToHistory(); });
+
+  ctx.measure("loop/updateSensorRegistry", [] { updateSensorRegistry(); });
+  ctx.measure("loop/handleAutoWatering", [] { handleAutoWatering(); });
+  ctx.measure("loop/updateLEDStatus", [] {
+    sim::advanceMs(500);
+    updateLEDStatus();
+  });
+}
+
+// Scheduler jitter over a minute of virtual time, polled every 37 us (off the 1 ms grid on purpose)
+void benchSchedulerJitter(BenchContext &ctx) {
+  if (!ctx.enabled("sched")) return;
+  uint64_t end = sim::nowUs() + 60ULL * 1000000;
+  while (sim::nowUs() < end) {
+    sim::advanceUs(37);
+    loop();
+  }
+  printf("sched max jitter over 60 s virtual: %lu us\n", schedulerMaxJitterUs());
+}
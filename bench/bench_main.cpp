@@ -0,0 +1,46 @@
+/*
+ * Entry point for the host-native bench: boots the firmware once against
+ * the simulated drivers (with the AP down, see bench_boot.cpp), then runs
+ * every suite declared in bench.h.
+ */
+#include "bench.h"
+
+int main(int argc, char **argv) {
+  BenchContext ctx;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc) ctx.iterations = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-v")) ctx.verbose = true;
+    else if (!strcmp(argv[i], "--csv")) ctx.csv = true;
+    else ctx.filter = argv[i];
+  }
+  if (ctx.iterations < 1) ctx.iterations = 1;
+
+  sim::setSerialEcho(getenv("BENCH_SERIAL") != nullptr);
+  benchBoot(ctx);
+
+  // Jitter first: the other suites jump the virtual clock, which would count as lateness
+  benchSchedulerJitter(ctx);
+  ctx.header();
+  benchLoop(ctx);
+  benchHttp(ctx);
+  benchRequestLog(ctx);
+  benchTelemetry(ctx);
+  benchTrace(ctx);
+  benchAlloc(ctx);
+  benchPages(ctx);
+  benchApi(ctx);
+  benchEvents(ctx);
+  benchSoil(ctx);
+  benchFilter(ctx);
+  benchCalibration(ctx);
+  benchBmp280(ctx);
+  benchBh1750(ctx);
+  benchI2c(ctx);
+  benchWifi(ctx);
+  benchHistory(ctx);
+  benchHistoryStore(ctx);
+  benchRollup(ctx);
+  benchWindow(ctx);
+  benchSnapshotStress(ctx);
+  return ctx.failures ? 1 : 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * /simple and /calibrate: the gzip templates with streamed placeholders
+ * (page_template.h) against the pages they replaced, which were built as a
+ * String per request (kept here as "legacy" routes, same text). Rows give
+ * handler time, allocations and peak heap per request; the summary gives
+ * the bytes each sends on the wire.
+ */
+#include "bench.h"
+#include <ESPAsyncWebServer.h>
+#include <string>
+
+extern AsyncWebServer server;
+
+static std::string simpleText;  // the old F() literal: tools/pages/simple.html with the placeholders as "--"
+
+static bool loadSimpleText() {
+  FILE *in = fopen("tools/pages/simple.html", "rb");
+  if (!in) return false;
+  char buf[1024];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), in)) > 0) simpleText.append(buf, n);
+  fclose(in);
+  static const char *const FIELDS[] = {"%DEVICE_ID% @ %IP%", "%TEMPERATURE%", "%PRESSURE%", "%LIGHT%", "%SOIL%",
+                                       "%UPTIME%"};
+  for (const char *f : FIELDS) {
+    size_t at = simpleText.find(f);
+    if (at != std::string::npos) simpleText.replace(at, strlen(f), strcmp(f, FIELDS[0]) ? "--" : "");
+  }
+  return true;
+}
+
+static void registerLegacyPages() {
+  server.on("/bench/legacy/simple", HTTP_GET, [](AsyncWebServerRequest *request) {
+    String p = simpleText.c_str();
+    request->send(200, "text/html", p);
+  });
+  server.on("/bench/legacy/calibrate", HTTP_GET, [](AsyncWebServerRequest *request) {
+    int32_t soilRaw = 1800;
+    String html = "<!DOCTYPE html><html><head><meta charset='utf-8'><title>Soil Calibration</title>";
+    html += "<meta name='viewport' content='width=device-width,initial-scale=1'><style>body{font-family:Arial;margin:20px;background:#f0f0f0;} .container{max-width:600px;margin:0 auto;background:white;padding:20px;border-radius:10px;} .raw{font-size:2em;text-align:center;margin:20px 0;padding:20px;background:#e3f2fd;border-radius:8px;} .step{background:#f5f5f5;padding:15px;margin:10px 0;border-radius:5px;} .code{background:#333;color:#0f0;padding:10px;border-radius:5px;font-family:monospace;}</style></head><body>";
+    html += "<div class='container'><h1>🌱 Soil Sensor Calibration</h1>";
+    html += "<div class='raw'>Current Raw: <span id='raw'>" + String(soilRaw) + "</span></div>";
+    html += "<div class='step'><h3>Step 1: Dry Measurement</h3><p>Remove sensor from soil and measure in air.</p><div class='code'>Current: " + String(soilRaw) + "</div></div>";
+    html += "<div class='step'><h3>Step 2: Wet Measurement</h3><p>Dip sensor in water and measure.</p></div>";
+    html += "<div class='step'><h3>Step 3: Save Points</h3><p>Add mid-range points (weighed samples) for better accuracy; no reflash needed.</p><div class='code'>POST /soil/calibration<br>{\"points\":[{\"raw\":" + String(soilRaw) + ",\"percent\":0},{\"raw\":[wet_value],\"percent\":100}]}</div></div>";
+    html += "<script>setInterval(()=>fetch('/api').then(r=>r.json()).then(d=>document.getElementById('raw').textContent=d.soil_raw),2000);</script>";
+    html += "</div></body></html>";
+    request->send(200, "text/html", html);
+  });
+}
+
+void benchPages(BenchContext &ctx) {
+  if (!ctx.enabled("page")) return;
+  if (!loadSimpleText()) {
+    printf("pages: run from the project root (tools/pages/simple.html not found)\n");
+    return;
+  }
+  registerLegacyPages();
+  static const char *const PAGES[] = {"simple", "calibrate"};
+  char name[64], legacy[48], current[48];
+  for (const char *page : PAGES) {
+    snprintf(legacy, sizeof(legacy), "/bench/legacy/%s", page);
+    snprintf(current, sizeof(current), "/%s", page);
+    snprintf(name, sizeof(name), "page GET /%s (String)", page);
+    ctx.measure(name, [&legacy] { sim::httpRequest(HTTP_GET, legacy, nullptr, BENCH_BROWSER_HEADERS); });
+    snprintf(name, sizeof(name), "page GET /%s (gzip template)", page);
+    ctx.measure(name, [&current] { sim::httpRequest(HTTP_GET, current, nullptr, BENCH_BROWSER_HEADERS); });
+  }
+  for (const char *page : PAGES) {
+    snprintf(legacy, sizeof(legacy), "/bench/legacy/%s", page);
+    snprintf(current, sizeof(current), "/%s", page);
+    sim::HttpResult a = sim::httpRequest(HTTP_GET, legacy, nullptr, BENCH_BROWSER_HEADERS);
+    sim::HttpResult b = sim::httpRequest(HTTP_GET, current, nullptr, BENCH_BROWSER_HEADERS);
+    if (b.code != 200) ctx.failures++;
+    printf("page /%s on the wire: %u bytes as String, %u bytes gzip template (%.0f%%, %u chunks), status %d\n", page,
+           (unsigned)a.bytes, (unsigned)b.bytes, a.bytes ? 100.0 * b.bytes / a.bytes : 0.0, (unsigned)b.chunks,
+           b.code);
+    sim::HttpResult plain = sim::httpRequest(HTTP_GET, current, nullptr, nullptr);
+    if (plain.code != 200 || !plain.bytes) ctx.failures++;
+    printf("page /%s without Accept-Encoding: %u bytes plain text, status %d\n", page, (unsigned)plain.bytes,
+           plain.code);
+  }
+}
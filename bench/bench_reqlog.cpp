@@ -0,0 +1,71 @@
+/*
+ * Request logging cost per request, with the UART modelled at 115200 baud
+ * (sim::setSerialBaud): no logging, the old synchronous Serial.printf()
+ * from the handler (IP formatted into a String), and the deferred ring.
+ * The blocked(ms) column is what the AsyncTCP task spent waiting on the
+ * UART. The ring is not drained during a row, so past REQUEST_LOG_ENTRIES
+ * requests it drops records, which is the behaviour under a burst; the
+ * paced row drains it every REQUEST_LOG_DRAIN_MS as the drain task would.
+ */
+#include "bench.h"
+#include <ESPAsyncWebServer.h>
+#include "../src/request_log.h"
+
+#define REQLOG_BENCH_BAUD 115200
+#define REQLOG_BENCH_PACED 200
+#define REQLOG_BENCH_GAP_MS 10
+
+extern RequestLog requestLog;
+
+// logRequest() as it was, for the client address the simulated server uses
+static void legacyLog(const char *url, int status) {
+  IPAddress ip(192, 168, 2, 50);
+  Serial.printf("REQ %s %s FROM %s -> %d\n", "GET", url, ip.toString().c_str(), status);
+}
+
+static void drainAll() {
+  while (requestLog.drain(Serial)) {}
+}
+
+void benchRequestLog(BenchContext &ctx) {
+  if (!ctx.enabled("reqlog")) return;
+  sim::setSerialBaud(REQLOG_BENCH_BAUD);
+  drainAll();
+
+  requestLog.setEnabled(false);
+  ctx.measure("reqlog off GET /health", [] { sim::httpRequest(HTTP_GET, "/health"); });
+  ctx.measure("reqlog sync GET /health", [] {
+    sim::httpRequest(HTTP_GET, "/health");
+    legacyLog("/health", 200);
+  });
+  sim::setSerialBaud(REQLOG_BENCH_BAUD);  // empty FIFO for the next row
+  requestLog.setEnabled(true);
+  uint32_t logged0 = requestLog.logged() + requestLog.pending(), dropped0 = requestLog.dropped();
+  ctx.measure("reqlog ring GET /health", [] { sim::httpRequest(HTTP_GET, "/health"); });
+  uint32_t queued = requestLog.logged() + requestLog.pending() - logged0, dropped = requestLog.dropped() - dropped0;
+  drainAll();
+
+  // Paced: a request every 10 ms, drained on the drain task's period
+  uint64_t blocked0 = sim::blockedUs();
+  dropped0 = requestLog.dropped();
+  unsigned long lastDrain = millis();
+  uint64_t handlerBlockedUs = 0;
+  for (int i = 0; i < REQLOG_BENCH_PACED; i++) {
+    uint64_t b = sim::blockedUs();
+    sim::httpRequest(HTTP_GET, "/health");
+    handlerBlockedUs += sim::blockedUs() - b;
+    sim::advanceMs(REQLOG_BENCH_GAP_MS);
+    if (millis() - lastDrain >= REQUEST_LOG_DRAIN_MS) {
+      requestLog.drain(Serial);
+      lastDrain = millis();
+    }
+  }
+  drainAll();
+  uint64_t drainBlockedUs = sim::blockedUs() - blocked0 - handlerBlockedUs;
+  printf("reqlog ring burst: %u records queued, %u dropped (ring of %d, never blocks)\n", queued, dropped,
+         REQUEST_LOG_ENTRIES);
+  printf("reqlog ring paced %d req @%d ms: %u dropped, handlers blocked %.3f ms total, drain task blocked %.1f ms\n",
+         REQLOG_BENCH_PACED, REQLOG_BENCH_GAP_MS, requestLog.dropped() - dropped0, handlerBlockedUs / 1000.0,
+         drainBlockedUs / 1000.0);
+  sim::setSerialBaud(0);
+}
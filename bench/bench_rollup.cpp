@@ -0,0 +1,57 @@
+/*
+ * Rollup tiers behind /history?range=&step=: per-sample update cost and
+ * response time/size per range once 90 days of 30 s samples are in.
+ * The point is that the cost stays flat as the range grows.
+ */
+#include "bench.h"
+#include <ESPAsyncWebServer.h>
+#include "../src/rollup.h"
+
+extern Rollup historyRollup;
+uint8_t rollupValidMask(const float *values);
+
+static void sampleAt(uint32_t ts, float *values) {
+  values[0] = 20.0f + 6.0f * sinf(ts / 13751.0f);  // ~daily swing
+  values[1] = 1010.0f + (ts / 600 % 40) * 0.25f;
+  values[2] = (ts / 30 % 17 == 0) ? -1.0f : (float)(ts % 86400) / 4.0f;
+  values[3] = 35.0f + (ts / 3600 % 30);
+}
+
+void benchRollup(BenchContext &ctx) {
+  if (!ctx.enabled("rollup")) return;
+
+  uint32_t now = (uint32_t)time(nullptr);
+  uint32_t from = now - Rollup::retention(ROLLUP_TIERS - 1);
+  float values[ROLLUP_METRICS];
+  for (uint32_t ts = from; ts <= now; ts += ROLLUP_RAW_PERIOD_MS / 1000) {
+    sampleAt(ts, values);
+    historyRollup.add(ts, values, rollupValidMask(values));
+  }
+
+  uint32_t ts = now;
+  ctx.measure("rollup add (4 tiers)", [&] {
+    sampleAt(ts, values);
+    historyRollup.add(ts++, values, rollupValidMask(values));
+  });
+
+  static const char *const URLS[] = {
+    "/history?range=3600", "/history?range=86400", "/history?range=604800",
+    "/history?range=7776000", "/history?range=86400&step=60", "/history?range=7776000&step=3600",
+  };
+  char name[64];
+  size_t bytes[sizeof(URLS) / sizeof(URLS[0])];
+  for (size_t i = 0; i < sizeof(URLS) / sizeof(URLS[0]); i++) {
+    snprintf(name, sizeof(name), "rollup GET %s", URLS[i]);
+    const char *url = URLS[i];
+    size_t *out = &bytes[i];
+    ctx.measure(name, [url, out] { *out = sim::httpRequest(HTTP_GET, url).bytes; });
+  }
+  for (size_t i = 0; i < sizeof(URLS) / sizeof(URLS[0]); i++) {
+    const char *q = strchr(URLS[i], '?') + 1;
+    uint32_t range = 0, step = 0;
+    sscanf(q, "range=%u&step=%u", &range, &step);
+    RollupQuery plan = Rollup::plan(now, range, step);
+    printf("rollup %-34s tier %-3s step %6us %4u points %7zu B\n", URLS[i],
+           Rollup::spec(plan.tier).name, plan.step, plan.points, bytes[i]);
+  }
+}
@@ -0,0 +1,83 @@
+/*
+ * Seqlock stress: one writer thread publishing snapshots as fast as it can
+ * while reader threads hammer read(). Every field of a published value is
+ * derived from the same counter, so a torn read is detectable.
+ */
+#include "bench.h"
+#include "../src/seqlock.h"
+#include <atomic>
+#include <thread>
+
+namespace {
+
+struct StressPayload {
+  uint32_t counter;
+  float values[8];
+  uint32_t check;
+};
+
+StressPayload makePayload(uint32_t n) {
+  StressPayload p;
+  p.counter = n;
+  for (int i = 0; i < 8; i++) p.values[i] = (float)(n + i);
+  p.check = ~n;
+  return p;
+}
+
+bool consistent(const StressPayload &p) {
+  if (p.check != ~p.counter) return false;
+  for (int i = 0; i < 8; i++) {
+    if (p.values[i] != (float)(p.counter + i)) return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+void benchSnapshotStress(BenchContext &ctx) {
+  if (!ctx.enabled("snapshot")) return;
+  const int READERS = 3;
+  const auto DURATION = std::chrono::milliseconds(500);
+
+  Seqlock<StressPayload> lock;
+  lock.publish(makePayload(0));
+  std::atomic<bool> stop(false);
+  std::atomic<uint64_t> reads(0), retries(0), torn(0), backwards(0);
+  uint64_t writes = 0;
+
+  std::thread writer([&] {
+    uint32_t n = 1;
+    while (!stop.load(std::memory_order_relaxed)) lock.publish(makePayload(n++));
+    writes = n - 1;
+  });
+  std::vector<std::thread> readers;
+  for (int r = 0; r < READERS; r++) {
+    readers.emplace_back([&] {
+      uint64_t myReads = 0, myTorn = 0, myBackwards = 0;
+      uint32_t myRetries = 0, last = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        StressPayload p = lock.read(&myRetries);
+        if (!consistent(p)) myTorn++;
+        if (p.counter < last) myBackwards++;
+        last = p.counter;
+        myReads++;
+      }
+      reads += myReads;
+      retries += myRetries;
+      torn += myTorn;
+      backwards += myBackwards;
+    });
+  }
+
+  std::this_thread::sleep_for(DURATION);
+  stop = true;
+  writer.join();
+  for (std::thread &t : readers) t.join();
+
+  double secs = std::chrono::duration<double>(DURATION).count();
+  printf("snapshot stress (%d readers, %.1fs): %.2f M writes/s, %.2f M reads/s, "
+         "retries %.3f/read, torn %llu, backwards %llu\n",
+         READERS, secs, writes / secs / 1e6, reads.load() / secs / 1e6,
+         reads ? (double)retries.load() / reads.load() : 0.0,
+         (unsigned long long)torn.load(), (unsigned long long)backwards.load());
+}
@@ -0,0 +1,189 @@
+/*
+ * Soil channel: cost of the decimating filter per DMA frame (scalar and
+ * vector FIR, which must agree bit for bit), then noise rejection against
+ * the old 5 x analogRead burst on 4 kHz ADC traces, and the whole path
+ * through the continuous-ADC fake and loop().
+ *
+ * The built-in traces are synthetic (sensor noise, 50 Hz hum, WiFi-TX
+ * spikes, an unplugged probe). A recorded trace - one raw count per line
+ * at SOIL_ADC_SAMPLE_HZ - can be added with SOIL_TRACE=<file>.
+ */
+#include "bench.h"
+#include <string>
+#include "../src/soil_adc.h"
+
+extern SoilAdc soilAdc;
+extern float soilMoisture;
+void loop();
+
+#define SOIL_BENCH_SECONDS 60
+#define SOIL_BENCH_READ_MS 500        // the soil sensor's period in sensors[]
+#define SOIL_BENCH_BASE 1800          // true level of the synthetic traces
+#define SOIL_BENCH_COUNTS_PER_PCT ((3285 - 27) / 100.0)  // SOIL_DRY_VALUE - SOIL_WET_VALUE
+
+enum TraceKind { TRACE_CLEAN, TRACE_NOISY, TRACE_SPIKY, TRACE_UNPLUGGED };
+
+static std::vector<uint16_t> makeTrace(TraceKind kind, size_t n) {
+  std::vector<uint16_t> t(n);
+  uint32_t rng = 0x2545F491;
+  auto uniform = [&rng] {  // 0..1
+    rng = rng * 1664525u + 1013904223u;
+    return (rng >> 8) / 16777216.0;
+  };
+  for (size_t i = 0; i < n; i++) {
+    double v;
+    if (kind == TRACE_UNPLUGGED) {
+      v = uniform() < 0.02 ? uniform() * 40 : 0;  // pull-down with the odd glitch
+    } else {
+      double g = (uniform() + uniform() + uniform() + uniform() - 2.0) * 1.73;  // ~N(0,1)
+      v = SOIL_BENCH_BASE + g * (kind == TRACE_CLEAN ? 8 : 40);
+      if (kind != TRACE_CLEAN) v += 60 * sin(2 * M_PI * 50.0 * i / SOIL_ADC_SAMPLE_HZ);
+      if (kind == TRACE_SPIKY && uniform() < 0.002) v = uniform() < 0.5 ? 4095 : 0;
+    }
+    t[i] = (uint16_t)(v < 0 ? 0 : (v > 4095 ? 4095 : v));
+  }
+  return t;
+}
+
+static std::vector<uint16_t> loadTrace(const char *path) {
+  std::vector<uint16_t> t;
+  FILE *f = fopen(path, "r");
+  if (!f) return t;
+  int v;
+  while (fscanf(f, "%d", &v) == 1) t.push_back((uint16_t)(v < 0 ? 0 : (v > 4095 ? 4095 : v)));
+  fclose(f);
+  return t;
+}
+
+struct Readings {
+  unsigned n = 0, missing = 0;
+  double sum = 0, sumSq = 0;
+  void add(double v) { n++; sum += v; sumSq += v * v; }
+  double mean() const { return n ? sum / n : NAN; }
+  double stddev() const { return n > 1 ? sqrt((sumSq - sum * sum / n) / (n - 1)) : NAN; }
+};
+
+// What collectSoil() did before: 5 reads 10 ms apart, zeros dropped,
+// averaged, then halved towards the last value on jumps over 400 counts
+static Readings legacyBurst(const std::vector<uint16_t> &t) {
+  const size_t STEP = SOIL_ADC_SAMPLE_HZ / 100, PERIOD = SOIL_ADC_SAMPLE_HZ * SOIL_BENCH_READ_MS / 1000;
+  Readings r;
+  int lastRaw = -1;
+  for (size_t at = PERIOD; at + 5 * STEP < t.size(); at += PERIOD) {
+    long sum = 0;
+    int valid = 0;
+    for (int k = 0; k < 5; k++) {
+      int v = t[at + k * STEP];
+      if (v > 0) { sum += v; valid++; }
+    }
+    if (!valid) { r.missing++; continue; }
+    int raw = (int)(sum / valid);
+    if (lastRaw != -1 && abs(raw - lastRaw) > 400) raw = (raw + lastRaw) / 2;
+    lastRaw = raw;
+    r.add(raw);
+  }
+  return r;
+}
+
+// The new path: every sample through the filter, read every 500 ms
+static Readings filtered(const std::vector<uint16_t> &t) {
+  const size_t PERIOD = SOIL_ADC_SAMPLE_HZ * SOIL_BENCH_READ_MS / 1000;
+  SoilFilter f;
+  Readings r;
+  for (size_t at = 0; at + PERIOD <= t.size(); at += PERIOD) {
+    for (size_t i = 0; i < PERIOD; i += SOIL_ADC_FRAME_SAMPLES) {
+      size_t n = PERIOD - i < SOIL_ADC_FRAME_SAMPLES ? PERIOD - i : SOIL_ADC_FRAME_SAMPLES;
+      f.process(&t[at + i], n);
+    }
+    if (!f.ready()) continue;
+    if (f.missing()) r.missing++;
+    else r.add(f.latest());
+  }
+  return r;
+}
+
+static void compare(const char *name, const std::vector<uint16_t> &t, double truth) {
+  Readings a = legacyBurst(t), b = filtered(t);
+  printf("soil %-10s burst: mean %7.1f sd %6.2f (%.2f%%) missing %3u | filter: mean %7.1f sd %6.2f (%.2f%%) missing %3u",
+         name, a.mean(), a.stddev(), a.stddev() / SOIL_BENCH_COUNTS_PER_PCT, a.missing,
+         b.mean(), b.stddev(), b.stddev() / SOIL_BENCH_COUNTS_PER_PCT, b.missing);
+  if (!isnan(truth) && a.n && b.n)
+    printf(" | bias %.1f vs %.1f", 0.0 + fabs(a.mean() - truth), 0.0 + fabs(b.mean() - truth));
+  printf("\n");
+}
+
+// Scalar and vector filters fed the same trace must produce identical sums
+static bool bitExact(const std::vector<uint16_t> &t) {
+  SoilFilter scalar(soil_dsp::firDotScalar), vector(soil_dsp::firDot);
+  for (size_t i = 0; i + SOIL_ADC_FRAME_SAMPLES <= t.size(); i += SOIL_ADC_FRAME_SAMPLES) {
+    scalar.process(&t[i], SOIL_ADC_FRAME_SAMPLES);
+    vector.process(&t[i], SOIL_ADC_FRAME_SAMPLES);
+    float a = scalar.latest(), b = vector.latest();
+    if (memcmp(&a, &b, sizeof(a)) != 0) return false;
+  }
+  return scalar.outputs() == vector.outputs();
+}
+
+void benchSoil(BenchContext &ctx) {
+  if (!ctx.enabled("soil")) return;
+
+  const size_t N = SOIL_ADC_SAMPLE_HZ * SOIL_BENCH_SECONDS;
+  std::vector<uint16_t> clean = makeTrace(TRACE_CLEAN, N), noisy = makeTrace(TRACE_NOISY, N),
+                        spiky = makeTrace(TRACE_SPIKY, N), unplugged = makeTrace(TRACE_UNPLUGGED, N);
+
+  // One DMA frame (32 ms at 4 kHz) through median + FIR + mean
+  static SoilFilter scalar(soil_dsp::firDotScalar), vector(soil_dsp::firDot);
+  size_t at = 0;
+  ctx.measure("soil filter frame (scalar fir)", [&] {
+    scalar.process(&spiky[at], SOIL_ADC_FRAME_SAMPLES);
+    at = (at + SOIL_ADC_FRAME_SAMPLES) % (N - SOIL_ADC_FRAME_SAMPLES);
+  });
+  ctx.measure(SOIL_FIR_VECTOR ? "soil filter frame (vector fir)" : "soil filter frame (vector fir = scalar)", [&] {
+    vector.process(&spiky[at], SOIL_ADC_FRAME_SAMPLES);
+    at = (at + SOIL_ADC_FRAME_SAMPLES) % (N - SOIL_ADC_FRAME_SAMPLES);
+  });
+  static int32_t x[SOIL_FIR_TAPS];
+  for (int i = 0; i < SOIL_FIR_TAPS; i++) x[i] = spiky[i];
+  volatile int32_t sink = 0;
+  ctx.measure("soil fir dot (scalar)", [&] { sink = sink + soil_dsp::firDotScalar(x, scalar.taps(), SOIL_FIR_TAPS); });
+  ctx.measure("soil fir dot (vector)", [&] { sink = sink + soil_dsp::firDot(x, scalar.taps(), SOIL_FIR_TAPS); });
+
+  if (ctx.enabled("soil quality")) {
+    printf("soil fir %s, scalar vs vector bit-exact: %s\n", SOIL_FIR_VECTOR ? "vectorised" : "scalar only",
+           bitExact(spiky) && bitExact(noisy) ? "yes" : "NO");
+    printf("soil readings every %d ms over %d s of 4 kHz trace, raw counts (sd also in %%):\n",
+           SOIL_BENCH_READ_MS, SOIL_BENCH_SECONDS);
+    compare("clean", clean, SOIL_BENCH_BASE);
+    compare("noisy+hum", noisy, SOIL_BENCH_BASE);
+    compare("spiky", spiky, SOIL_BENCH_BASE);
+    compare("unplugged", unplugged, NAN);
+    const char *path = getenv("SOIL_TRACE");
+    if (path) {
+      std::vector<uint16_t> recorded = loadTrace(path);
+      if (recorded.size() < SOIL_ADC_SAMPLE_HZ) printf("soil SOIL_TRACE=%s: need at least 1 s of samples\n", path);
+      else compare("recorded", recorded, NAN);
+    }
+  }
+
+  // End to end: DMA fake -> drain task -> collectSoil() via loop()
+  if (ctx.enabled("soil e2e")) {
+    sim::setSoilTrace(spiky.data(), spiky.size());
+    SoilAdcStats before = soilAdc.stats();
+    uint64_t end = sim::nowUs() + 10 * 1000000ULL;
+    Readings r;
+    uint64_t nextRead = sim::nowUs() + 1000000;
+    while (sim::nowUs() < end) {
+      sim::advanceUs(500);
+      loop();
+      if (sim::nowUs() >= nextRead) {
+        r.add(soilMoisture);
+        nextRead += SOIL_BENCH_READ_MS * 1000;
+      }
+    }
+    SoilAdcStats after = soilAdc.stats();
+    printf("soil e2e 10 s spiky trace through loop(): %u samples in %u drains, %u overruns, "
+           "soil %.2f%% sd %.3f%%\n", after.samples - before.samples, after.drains - before.drains,
+           after.overruns - before.overruns, r.mean(), r.stddev());
+    sim::setSoilAdc(SOIL_BENCH_BASE, 15);
+  }
+}
@@ -0,0 +1,113 @@
+/*
+ * Persistent history store on the file-backed LittleFS: write amplification
+ * per flush batch size, boot recovery (clean and with a torn tail), and
+ * range queries over four weeks of 5-minute records.
+ */
+#include "bench.h"
+#include <LittleFS.h>
+#include "../src/history_store.h"
+
+#define STORE_BENCH_RECORDS (4 * HISTORY_SEGMENT_RECORDS)  // four weeks
+#define STORE_BENCH_T0 1760000000UL
+
+static void wipeDir(const char *dir) {
+  char path[64];
+  File root = LittleFS.open(dir);
+  if (!root) return;
+  for (File f = root.openNextFile(); f; f = root.openNextFile()) {
+    snprintf(path, sizeof(path), "%s/%s", dir, f.name());
+    f.close();
+    LittleFS.remove(path);
+  }
+}
+
+static SensorReading reading(uint32_t i) {
+  SensorReading r;
+  r.temperature = 18.0f + (i % 97) * 0.11f;
+  r.pressure = 1008.0f + (i % 31) * 0.3f;
+  r.lightLevel = (float)((i * 37) % 20000);
+  r.soilMoisture = (i % 13 == 0) ? -1.0f : 40.0f + (i % 50) * 0.5f;
+  r.timestamp = STORE_BENCH_T0 + i * 300;
+  return r;
+}
+
+static void fillStore(HistoryStore &store, const char *dir, uint8_t flushRecords, uint32_t records) {
+  wipeDir(dir);
+  store.begin(LittleFS, dir);
+  store.setFlushRecords(flushRecords);
+  for (uint32_t i = 0; i < records; i++) store.append(reading(i));
+  store.flush();
+}
+
+static void writeAmplification(BenchContext &ctx) {
+  static const uint8_t BATCHES[] = {1, HISTORY_FLUSH_RECORDS, HISTORY_MAX_FLUSH_RECORDS};
+  for (uint8_t batch : BATCHES) {
+    HistoryStore store;
+    sim::resetFlashStats();
+    fillStore(store, "/bench_wa", batch, STORE_BENCH_RECORDS);
+    sim::FlashStats f = sim::flashStats();
+    uint64_t payload = (uint64_t)STORE_BENCH_RECORDS * HISTORY_RECORD_SIZE;
+    if (ctx.csv) {
+      printf("store write-amp flush=%u,%u,%llu,%llu,%.2f,%u\n", batch, STORE_BENCH_RECORDS,
+             (unsigned long long)payload, (unsigned long long)f.bytesProgrammed,
+             (double)f.bytesProgrammed / payload, f.syncs);
+    } else {
+      printf("store write-amp flush=%-2u %u records: payload %llu B, programmed %llu B (%.1fx), %u syncs\n",
+             batch, STORE_BENCH_RECORDS, (unsigned long long)payload,
+             (unsigned long long)f.bytesProgrammed, (double)f.bytesProgrammed / payload, f.syncs);
+    }
+  }
+  wipeDir("/bench_wa");
+}
+
+void benchHistoryStore(BenchContext &ctx) {
+  if (!ctx.enabled("store")) return;
+  if (ctx.enabled("store write-amp")) writeAmplification(ctx);
+
+  HistoryStore store;
+  fillStore(store, "/bench_ts", HISTORY_FLUSH_RECORDS, STORE_BENCH_RECORDS);
+
+  uint32_t next = STORE_BENCH_RECORDS;
+  ctx.measure("store append", [&] { store.append(reading(next++)); });
+  store.flush();
+
+  ctx.measure("store begin (clean tail)", [&] { store.begin(LittleFS, "/bench_ts"); });
+
+  // One day in the middle of the data: segment pick + binary search + 288 reads
+  uint32_t from = STORE_BENCH_T0 + 10 * 288 * 300, to = from + 287 * 300;
+  size_t found = 0;
+  ctx.measure("store query 1 day of 4 weeks", [&] {
+    HistoryStore::Cursor c = store.query(from, to);
+    SensorReading r;
+    found = 0;
+    while (c.next(r)) found++;
+  });
+
+  static SensorReading latest[MAX_HISTORY_POINTS];
+  size_t restored = 0;
+  ctx.measure("store readLatest 288", [&] { restored = store.readLatest(latest, MAX_HISTORY_POINTS); });
+
+  // Power cut in the middle of a batch: last record half written
+  char path[64];
+  HistoryStoreStats before = store.stats();
+  File root = LittleFS.open("/bench_ts");
+  char tail[64] = "";
+  for (File f = root.openNextFile(); f; f = root.openNextFile()) {
+    if (strcmp(f.name(), tail) > 0) snprintf(tail, sizeof(tail), "%s", f.name());
+  }
+  snprintf(path, sizeof(path), "/bench_ts/%s", tail);
+  File t = LittleFS.open(path, FILE_READ);
+  size_t tailSize = t.size();
+  t.close();
+  sim::truncateFlashFile(path, tailSize - HISTORY_RECORD_SIZE / 2);
+  store.begin(LittleFS, "/bench_ts");
+  HistoryStoreStats torn = store.stats();
+  bool appended = store.append(reading(next++)) && store.flush();
+  HistoryStoreStats after = store.stats();
+
+  printf("store %u records in %u segments: query 1 day -> %zu records, readLatest -> %zu\n",
+         before.records, before.segments, found, restored);
+  printf("store torn tail: %u dropped, %u records kept, next append %s in segment %u/%u\n",
+         torn.droppedRecords, torn.records, appended ? "OK" : "FAILED", after.segments, HISTORY_MAX_SEGMENTS);
+  wipeDir("/bench_ts");
+}
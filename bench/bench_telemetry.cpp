@@ -0,0 +1,79 @@
+/*
+ * Serial status output, text lines vs binary telemetry frames
+ * (telemetry.h), with the UART modelled at 115200 baud. The rows call
+ * printSensorStatus() back to back, so blocked(ms) is the steady-state
+ * UART cost per status line once the TX FIFO is full. Then 10 s of loop()
+ * in binary mode is captured and decoded frame by frame (CRC, sequence,
+ * values against the firmware's globals). BENCH_TELEMETRY_CAPTURE=path
+ * also writes the capture for tools/telemetry_decode.
+ */
+#include "bench.h"
+#include "../src/telemetry.h"
+
+#define TELEMETRY_BENCH_BAUD 115200
+#define TELEMETRY_BENCH_RUN_MS 10000
+
+void loop();
+void printSensorStatus();
+extern bool binaryTelemetry;
+extern float temperature;
+
+static double bytesPerCall(BenchContext &ctx, const char *name) {
+  size_t bytes0 = sim::serialBytes();
+  sim::setSerialBaud(TELEMETRY_BENCH_BAUD);  // FIFO empty at the start of each row
+  ctx.measure(name, [] { printSensorStatus(); });
+  return (double)(sim::serialBytes() - bytes0) / (ctx.iterations + ctx.iterations / 20 + 1);
+}
+
+void benchTelemetry(BenchContext &ctx) {
+  if (!ctx.enabled("telemetry")) return;
+  bool wasBinary = binaryTelemetry;
+  binaryTelemetry = false;
+  double textBytes = bytesPerCall(ctx, "telemetry text status line");
+  binaryTelemetry = true;
+  double binaryBytes = bytesPerCall(ctx, "telemetry binary status frame");
+  sim::setSerialBaud(0);
+
+  std::string capture;
+  sim::setSerialCapture(&capture);
+  unsigned long t0 = millis();
+  while (millis() - t0 < TELEMETRY_BENCH_RUN_MS) {
+    sim::advanceUs(100);
+    loop();
+  }
+  sim::setSerialCapture(nullptr);
+  binaryTelemetry = wasBinary;
+
+  unsigned long frames = 0, bad = 0, lost = 0, byType[6] = {};
+  int lastSeq = -1;
+  bool valuesMatch = true;
+  size_t start = 0;
+  for (size_t i = 0; i <= capture.size(); i++) {
+    if (i < capture.size() && capture[i]) continue;
+    if (i > start) {
+      TelemetryRecord r;
+      if (decodeTelemetryFrame((const uint8_t *)capture.data() + start, i - start, r)) {
+        frames++;
+        byType[r.type]++;
+        if (lastSeq >= 0) lost += (uint8_t)(r.seq - lastSeq - 1);
+        lastSeq = r.seq;
+        if (r.type == TELEMETRY_SAMPLE && fabsf(r.sample.temperature - temperature) > 1.0f) valuesMatch = false;
+      } else {
+        bad++;  // text lines printed between frames
+      }
+    }
+    start = i + 1;
+  }
+  if (const char *path = getenv("BENCH_TELEMETRY_CAPTURE")) {
+    if (FILE *f = fopen(path, "wb")) {
+      fwrite(capture.data(), 1, capture.size(), f);
+      fclose(f);
+    }
+  }
+  printf("telemetry bytes per status: text %.0f, binary %.0f (%.1fx less UART time)\n", textBytes, binaryBytes,
+         textBytes / binaryBytes);
+  printf("telemetry %d s of loop(): %zu bytes, %lu frames (%lu sample, %lu history, %lu timing), %lu lost, "
+         "%lu non-frame segments, values match %s\n", TELEMETRY_BENCH_RUN_MS / 1000, capture.size(), frames,
+         byType[TELEMETRY_SAMPLE], byType[TELEMETRY_HISTORY], byType[TELEMETRY_TIMING], lost, bad,
+         valuesMatch ? "yes" : "no");
+}
@@ -0,0 +1,46 @@
+/*
+ * Tracing cost: one span recorded into the ring, and the loop with the
+ * TRACE_* macros compiled in or out (build once plain and once with
+ * -DENABLE_TRACE=1 and compare the "trace loop" rows). With tracing on,
+ * also /trace itself: a scrape of the last second, its size and the
+ * number of spans it carried.
+ */
+#include "bench.h"
+#include <ESPAsyncWebServer.h>
+#include "../src/trace.h"
+
+#define TRACE_BENCH_RUN_MS 1000
+
+void loop();
+
+static void runFor(unsigned long ms) {
+  unsigned long t0 = millis();
+  while (millis() - t0 < ms) {
+    sim::advanceUs(100);
+    loop();
+  }
+}
+
+void benchTrace(BenchContext &ctx) {
+  if (!ctx.enabled("trace")) return;
+#if ENABLE_TRACE
+  ctx.measure("trace span record", [] { TraceSpan span("bench"); });
+#endif
+  ctx.measure(ENABLE_TRACE ? "trace loop (tracing on)" : "trace loop (tracing off)", [] {
+    sim::advanceUs(100);
+    loop();
+  });
+#if ENABLE_TRACE
+  runFor(TRACE_BENCH_RUN_MS);
+  ctx.measure("trace GET /trace?seconds=1", [] { sim::httpRequest(HTTP_GET, "/trace?seconds=1"); });
+  TraceJsonStream stream(1);
+  uint8_t chunk[1460];
+  size_t bytes = 0, n;
+  while ((n = stream.fill(chunk, sizeof(chunk))) > 0) bytes += n;
+  printf("trace /trace?seconds=1: %u spans, %u bytes (ring holds %d, %u recorded since boot)\n",
+         (unsigned)stream.events(), (unsigned)bytes, TRACE_ENTRIES, (unsigned)traceRing.head());
+#else
+  (void)runFor;
+  printf("trace: built without ENABLE_TRACE, spans, ring and /trace compiled out\n");
+#endif
+}
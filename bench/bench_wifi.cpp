@@ -0,0 +1,58 @@
+/*
+ * WiFi reconnect after a link drop (beacon loss, AP still there), through
+ * the firmware's own loop() on the virtual clock:
+ *   cached AP        directed connect to the stored channel + BSSID
+ *   no cached AP     full scan, which is what every reconnect used to be
+ *   AP moved channel directed attempt misses, falls back to a full scan
+ *   after the move   the lease was rewritten, directed again
+ * Reported: loss -> IP address as the link measures it (includes the
+ * 100 ms service period), the connect path and fallbacks. The scan,
+ * directed-connect and DHCP times are modelled in sim.cpp, not measured on
+ * hardware, so the rows compare paths rather than promise milliseconds.
+ * With -DWIFI_STATIC_IP=1 the fast path skips DHCP as well.
+ */
+#include "bench.h"
+#include "../src/wifi_link.h"
+
+#define WIFI_BENCH_WAIT_MS 8000
+
+void loop();
+extern WifiLink wifiLink;
+
+static void runFor(unsigned long ms) {
+  unsigned long t0 = millis();
+  while (millis() - t0 < ms) {
+    sim::advanceUs(100);
+    loop();
+  }
+}
+
+// Beacon loss: the link goes down, the AP itself stays up
+static void reconnect(const char *label) {
+  WifiLinkStats s0 = wifiLink.stats();
+  sim::setWiFiAp(false);
+  sim::advanceUs(1);
+  sim::setWiFiAp(true);
+  runFor(WIFI_BENCH_WAIT_MS);
+  WifiLinkStats s = wifiLink.stats();
+  bool ok = s.connects > s0.connects && wifiLink.up();
+  printf("wifi %-18s %-5s %8u ms %9u %8s\n", label, !ok ? "-" : (s.fastConnects > s0.fastConnects ? "fast" : "scan"),
+         ok ? s.lastConnectMs : 0, s.fallbacks - s0.fallbacks, ok ? "yes" : "no");
+}
+
+void benchWifi(BenchContext &ctx) {
+  if (!ctx.enabled("wifi")) return;
+  runFor(WIFI_BENCH_WAIT_MS);  // boot left the link up
+  printf("wifi %-18s %-5s %11s %9s %8s\n", "scenario", "path", "loss->IP", "fallbacks", "link up");
+  reconnect("cached AP");
+  wifiLink.forget();
+  reconnect("no cached AP");
+  sim::setWiFiApChannel(11);
+  reconnect("AP moved channel");
+  reconnect("after the move");
+  sim::setWiFiApChannel(6);
+  reconnect("moved back");
+  WifiLinkStats s = wifiLink.stats();
+  printf("wifi totals: %u connects (%u fast, %u scan), %u drops, worst %u ms\n", s.connects, s.fastConnects,
+         s.scanConnects, s.drops, s.maxConnectMs);
+}
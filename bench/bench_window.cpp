@@ -0,0 +1,63 @@
+/*
+ * 24h window stats: the old rescan-on-every-append loop against the
+ * monotonic-deque SlidingWindow, per pushed sample, as the window grows.
+ */
+#include "bench.h"
+#include "../src/window_stats.h"
+
+template <uint16_t N>
+struct RescanWindow {
+  float values[N];
+  int index = 0, count = 0;
+  float minV = 0, maxV = 0, mean = 0;
+
+  // What addToHistory() used to do after each append
+  void push(float v) {
+    values[index] = v;
+    index = (index + 1) % N;
+    if (count < N) count++;
+    minV = 999;
+    maxV = -999;
+    double sum = 0;
+    for (int i = 0; i < count; i++) {
+      float t = values[i];
+      if (t < minV) minV = t;
+      if (t > maxV) maxV = t;
+      sum += t;
+    }
+    mean = (float)(sum / count);
+  }
+};
+
+template <uint16_t N>
+static void benchWindowSize(BenchContext &ctx) {
+  static RescanWindow<N> rescan;
+  static SlidingWindow<N> window;
+  uint32_t i = 0;
+  auto sample = [&i] { return 20.0f + 8.0f * sinf(i * 0.0218f) + (float)(i * 7919 % 97) * 0.01f; };
+
+  // Fill both windows first so every measured push evicts a sample
+  for (uint32_t k = 0; k < N; k++, i++) {
+    rescan.push(sample());
+    window.push(sample(), true);
+  }
+
+  char name[64];
+  snprintf(name, sizeof(name), "window rescan N=%u", N);
+  ctx.measure(name, [&] { rescan.push(sample()); i++; });
+  snprintf(name, sizeof(name), "window sliding N=%u", N);
+  ctx.measure(name, [&] {
+    window.push(sample(), (i % 50) != 0);  // every 50th reading is a sensor error
+    i++;
+  });
+  snprintf(name, sizeof(name), "window summary N=%u", N);
+  volatile float sink = 0;
+  ctx.measure(name, [&] { sink = sink + window.summary().stddev; });
+}
+
+void benchWindow(BenchContext &ctx) {
+  if (!ctx.enabled("window")) return;
+  benchWindowSize<288>(ctx);
+  benchWindowSize<2048>(ctx);
+  benchWindowSize<8192>(ctx);
+}
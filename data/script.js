@@ -106,19 +106,85 @@ document.addEventListener('DOMContentLoaded', function() {
     generatePlantCareRecommendations();
 });
 
+// Decode /history.bin (format documented in src/history.h) into the same
+// shape as the /history JSON: { temperature, pressure, light, soil, timestamps }
+function decodeHistoryBinary(buffer) {
+    const bytes = new Uint8Array(buffer);
+    if (bytes.length < 6 || bytes[0] !== 0x47 || bytes[1] !== 0x48 || bytes[2] !== 0x42 || bytes[3] !== 1) {
+        throw new Error('Unknown /history.bin format');
+    }
+    let pos = 4;
+    const readVarint = () => {
+        // Plain arithmetic instead of bit ops: timestamps need more than 32 bits
+        let result = 0, mult = 1, b;
+        do {
+            b = bytes[pos++];
+            result += (b & 0x7f) * mult;
+            mult *= 128;
+        } while (b & 0x80);
+        return result;
+    };
+    const unzigzag = n => (n % 2 === 0) ? n / 2 : -(n + 1) / 2;
+    
+    const count = readVarint();
+    const columnCount = bytes[pos++];
+    const columns = [];
+    for (let c = 0; c < columnCount; c++) {
+        columns.push({ scale: readVarint(), order: bytes[pos++] });
+    }
+    
+    const decoded = columns.map(col => {
+        const values = new Array(count);
+        let prev = 0, prevDelta = 0;
+        for (let i = 0; i < count; i++) {
+            const v = unzigzag(readVarint());
+            if (i === 0) {
+                prev = v;
+            } else {
+                const delta = (col.order === 2 && i > 1) ? prevDelta + v : v;
+                prevDelta = delta;
+                prev += delta;
+            }
+            values[i] = prev / col.scale;
+        }
+        return values;
+    });
+    return {
+        temperature: decoded[0],
+        pressure: decoded[1],
+        light: decoded[2],
+        soil: decoded[3],
+        timestamps: decoded[4]
+    };
+}
+
+// Fetch history: compact binary first, JSON for older firmware
+async function fetchHistory() {
+    try {
+        const response = await fetch(ESP32_BASE_URL + '/history.bin');
+        if (response.ok) {
+            return decodeHistoryBinary(await response.arrayBuffer());
+        }
+    } catch (error) {
+        if (DEBUG_MODE) console.log('ℹ️ /history.bin unavailable, falling back to JSON:', error);
+    }
+    
+    const response = await fetch(ESP32_BASE_URL + '/history');
+    if (!response.ok) return null;
+    return await response.json();
+}
+
 // Load historical data from ESP32 server
 async function loadHistoricalData() {
     try {
-        const url = ESP32_BASE_URL + '/history';
-        if (DEBUG_MODE) console.log('🔄 Loading historical data from:', url);
-        const response = await fetch(url);
+        if (DEBUG_MODE) console.log('🔄 Loading historical data from:', ESP32_BASE_URL + '/history.bin');
+        const historyData = await fetchHistory();
         
-        if (!response.ok) {
+        if (!historyData) {
             console.warn('No historical data available yet');
             return;
         }
         
-        const historyData = await response.json();
         if (DEBUG_MODE) {
             console.log('📦 Raw history data received:', historyData);
             console.log(`📊 Data arrays - Temp: ${historyData.temperature?.length}, Timestamps: ${historyData.timestamps?.length}`);
@@ -470,7 +536,7 @@ function initializeCharts() {
 }
 
 // Update sensor data and charts
-// Update live sensor values (called every 5 seconds)
+// Update live sensor values (polling fallback, every 5 seconds)
 async function updateLiveValues() {
     try {
         const url = ESP32_BASE_URL + '/api';
@@ -481,96 +547,103 @@ async function updateLiveValues() {
         }
         
         const data = await response.json();
-        
-        // Update status cards displays
-        document.getElementById('temperature').textContent = data.temperature + '°C';
-        document.getElementById('pressure').textContent = data.pressure + ' hPa';
-        
-        // Track soil moisture history for stability check
-        soilMoistureHistory.push(data.soilMoisture);
-        if (soilMoistureHistory.length > 5) {
-            soilMoistureHistory.shift(); // Keep only last 5 readings
-        }
-        
-        // Check if sensor is unstable (rapid changes indicate disconnected sensor)
-        let isUnstable = false;
-        if (soilMoistureHistory.length >= 3) {
-            // Check if any consecutive readings differ by more than 15%
-            for (let i = 1; i < soilMoistureHistory.length; i++) {
-                const diff = Math.abs(soilMoistureHistory[i] - soilMoistureHistory[i-1]);
-                if (diff > 15) {
-                    isUnstable = true;
-                    break;
-                }
+        renderLiveValues(data);
+    } catch (error) {
+        console.error('Failed to update live values:', error);
+        document.getElementById('systemStatus').textContent = 'Error ❌';
+    }
+}
+
+// Render an /api document (polled, or assembled from /events deltas)
+function renderLiveValues(data) {
+    // /api and /events call it 'soil'
+    if (data.soil !== undefined) data.soilMoisture = data.soil;
+    
+    // Update status cards displays
+    document.getElementById('temperature').textContent = data.temperature + '°C';
+    document.getElementById('pressure').textContent = data.pressure + ' hPa';
+    
+    // Track soil moisture history for stability check
+    soilMoistureHistory.push(data.soilMoisture);
+    if (soilMoistureHistory.length > 5) {
+        soilMoistureHistory.shift(); // Keep only last 5 readings
+    }
+    
+    // Check if sensor is unstable (rapid changes indicate disconnected sensor)
+    let isUnstable = false;
+    if (soilMoistureHistory.length >= 3) {
+        // Check if any consecutive readings differ by more than 15%
+        for (let i = 1; i < soilMoistureHistory.length; i++) {
+            const diff = Math.abs(soilMoistureHistory[i] - soilMoistureHistory[i-1]);
+            if (diff > 15) {
+                isUnstable = true;
+                break;
             }
         }
-        
-        // Display soil moisture based on stability
-        if (isUnstable) {
-            document.getElementById('soilMoisture').textContent = '--';
-            document.getElementById('soilStatus').textContent = 'ΑΝΕΝΕΡΓΟΣ';
-            document.getElementById('soilStatus').className = 'card-status status-critical';
+    }
+    
+    // Display soil moisture based on stability
+    if (isUnstable) {
+        document.getElementById('soilMoisture').textContent = '--';
+        document.getElementById('soilStatus').textContent = 'ΑΝΕΝΕΡΓΟΣ';
+        document.getElementById('soilStatus').className = 'card-status status-critical';
+    } else {
+        document.getElementById('soilMoisture').textContent = data.soilMoisture + '%';
+        updateStatusIndicator('soilStatus', data.soilMoisture, 40, 80);
+    }
+    
+    document.getElementById('light').textContent = data.light + ' lux';
+    
+    // Update status bar with live values
+    const soilDisplay = isUnstable ? '--' : data.soilMoisture + '%';
+    document.getElementById('liveValues').textContent = 
+        `🌡️ ${data.temperature}°C | 🔘 ${data.pressure} hPa | 💧 ${soilDisplay} | ☀️ ${data.light} lux`;
+    
+    // Update WiFi signal strength
+    if (data.wifiRSSI !== undefined) {
+        const rssi = data.wifiRSSI;
+        document.getElementById('wifiSignal').textContent = rssi + ' dBm';
+        // RSSI ranges: Excellent > -50, Good > -60, Fair > -70, Weak > -80, Poor <= -80
+        let wifiStatus = document.getElementById('wifiStatus');
+        if (rssi > -50) {
+            wifiStatus.className = 'card-status status-excellent';
+            wifiStatus.textContent = '📶 Άριστο';
+        } else if (rssi > -60) {
+            wifiStatus.className = 'card-status status-good';
+            wifiStatus.textContent = '📶 Καλό';
+        } else if (rssi > -70) {
+            wifiStatus.className = 'card-status status-warning';
+            wifiStatus.textContent = '⚠️ Μέτριο';
+        } else if (rssi > -80) {
+            wifiStatus.className = 'card-status status-warning';
+            wifiStatus.textContent = '⚠️ Αδύναμο';
         } else {
-            document.getElementById('soilMoisture').textContent = data.soilMoisture + '%';
-            updateStatusIndicator('soilStatus', data.soilMoisture, 40, 80);
-        }
-        
-        document.getElementById('light').textContent = data.light + ' lux';
-        
-        // Update status bar with live values
-        const soilDisplay = isUnstable ? '--' : data.soilMoisture + '%';
-        document.getElementById('liveValues').textContent = 
-            `🌡️ ${data.temperature}°C | 🔘 ${data.pressure} hPa | 💧 ${soilDisplay} | ☀️ ${data.light} lux`;
-        
-        // Update WiFi signal strength
-        if (data.wifiRSSI !== undefined) {
-            const rssi = data.wifiRSSI;
-            document.getElementById('wifiSignal').textContent = rssi + ' dBm';
-            // RSSI ranges: Excellent > -50, Good > -60, Fair > -70, Weak > -80, Poor <= -80
-            let wifiStatus = document.getElementById('wifiStatus');
-            if (rssi > -50) {
-                wifiStatus.className = 'card-status status-excellent';
-                wifiStatus.textContent = '📶 Άριστο';
-            } else if (rssi > -60) {
-                wifiStatus.className = 'card-status status-good';
-                wifiStatus.textContent = '📶 Καλό';
-            } else if (rssi > -70) {
-                wifiStatus.className = 'card-status status-warning';
-                wifiStatus.textContent = '⚠️ Μέτριο';
-            } else if (rssi > -80) {
-                wifiStatus.className = 'card-status status-warning';
-                wifiStatus.textContent = '⚠️ Αδύναμο';
-            } else {
-                wifiStatus.className = 'card-status status-critical';
-                wifiStatus.textContent = '❌ Πολύ Αδύναμο';
-            }
+            wifiStatus.className = 'card-status status-critical';
+            wifiStatus.textContent = '❌ Πολύ Αδύναμο';
         }
-        
-        // Update status indicators
-        updateStatusIndicator('tempStatus', data.temperature, 18, 28);
-        updateStatusIndicator('pressureStatus', data.pressure, 1000, 1030);
-        // soilStatus already updated above based on 99% check
-        updateStatusIndicator('lightStatus', data.light, 200, 2000);
-        
-        // Update system info (totalReadings, min/max temp)
-        if (data.totalReadings !== undefined) {
-            document.getElementById('totalReadings').textContent = data.totalReadings;
-        }
-        if (data.minTemperature !== undefined && data.minTemperature < 999) {
-            document.getElementById('minTemp').textContent = data.minTemperature.toFixed(1) + '°C';
-        }
-        if (data.maxTemperature !== undefined && data.maxTemperature > -999) {
-            document.getElementById('maxTemp').textContent = data.maxTemperature.toFixed(1) + '°C';
-        }
-        
-        // Update last update time
-        const now = new Date();
-        document.getElementById('pageLoadTime').textContent = now.toLocaleTimeString('el-GR');
-        document.getElementById('systemStatus').textContent = 'Live ✅';
-    } catch (error) {
-        console.error('Failed to update live values:', error);
-        document.getElementById('systemStatus').textContent = 'Error ❌';
     }
+    
+    // Update status indicators
+    updateStatusIndicator('tempStatus', data.temperature, 18, 28);
+    updateStatusIndicator('pressureStatus', data.pressure, 1000, 1030);
+    // soilStatus already updated above based on 99% check
+    updateStatusIndicator('lightStatus', data.light, 200, 2000);
+    
+    // Update system info (totalReadings, min/max temp)
+    if (data.totalReadings !== undefined) {
+        document.getElementById('totalReadings').textContent = data.totalReadings;
+    }
+    if (data.minTemperature !== undefined && data.minTemperature < 999) {
+        document.getElementById('minTemp').textContent = data.minTemperature.toFixed(1) + '°C';
+    }
+    if (data.maxTemperature !== undefined && data.maxTemperature > -999) {
+        document.getElementById('maxTemp').textContent = data.maxTemperature.toFixed(1) + '°C';
+    }
+    
+    // Update last update time
+    const now = new Date();
+    document.getElementById('pageLoadTime').textContent = now.toLocaleTimeString('el-GR');
+    document.getElementById('systemStatus').textContent = 'Live ✅';
 }
 
 // Update charts with latest data (called every 6 minutes)
@@ -923,14 +996,88 @@ function formatUptime(seconds) {
     return `${days}d ${hours}h ${minutes}m`;
 }
 
-// Unified startAutoUpdate with history reload every 5 minutes
+// ==================== LIVE PUSH (/events) ====================
+// Server-Sent Events replace the 5 s /api poll and the 5 min /history reload:
+// a snapshot on connect, then only the sensors that moved, watering changes
+// and new history points. Polling runs only while the stream is down.
+let liveSource = null;
+let liveData = {};
+
+function startLiveStream() {
+    if (!window.EventSource) return false;
+    if (liveSource) return true;
+    
+    liveSource = new EventSource(ESP32_BASE_URL + '/events');
+    liveSource.addEventListener('open', () => {
+        stopPolling();
+        loadWateringStatus();  // not part of the snapshot
+        if (DEBUG_MODE) console.log('✅ /events connected, polling stopped');
+    });
+    liveSource.addEventListener('snapshot', e => {
+        liveData = JSON.parse(e.data);
+        renderLiveValues(liveData);
+    });
+    liveSource.addEventListener('sensors', e => {
+        Object.assign(liveData, JSON.parse(e.data));
+        renderLiveValues(liveData);
+    });
+    liveSource.addEventListener('watering', e => {
+        const w = JSON.parse(e.data);
+        wateringState.isWatering = w.isWatering;
+        wateringState.manualActive = w.manualWateringActive;
+        updateWateringUI();
+    });
+    liveSource.addEventListener('history', e => appendHistoryPoint(JSON.parse(e.data)));
+    liveSource.addEventListener('resync', () => {
+        // Fell behind the device's event buffer: reload what was missed
+        updateLiveValues();
+        loadHistoricalData();
+    });
+    liveSource.onerror = () => {
+        // EventSource reconnects on its own unless the server refused it
+        if (liveSource && liveSource.readyState === EventSource.CLOSED) {
+            liveSource = null;
+        }
+        startPolling();
+    };
+    return true;
+}
+
+function stopLiveStream() {
+    if (liveSource) {
+        liveSource.close();
+        liveSource = null;
+    }
+}
+
+// One 5-minute point pushed by the device, in /history units
+function appendHistoryPoint(point) {
+    dataHistory.temperature.push(point.temperature);
+    dataHistory.pressure.push(point.pressure);
+    dataHistory.soilMoisture.push(point.soil);
+    dataHistory.light.push(point.light);
+    dataHistory.timestamps.push(new Date(point.timestamp * 1000).toISOString());
+    if (dataHistory.temperature.length > 288) {
+        dataHistory.temperature.shift();
+        dataHistory.pressure.shift();
+        dataHistory.soilMoisture.shift();
+        dataHistory.light.shift();
+        dataHistory.timestamps.shift();
+    }
+    updateChartsWithHistory();
+}
+
+// Unified startAutoUpdate: /events when available, polling as the fallback
 let liveValuesInterval = null;
 let chartsUpdateInterval = null;
 let historyReloadInterval = null;
 
 function startAutoUpdate() {
-    // Stop any existing intervals
-    if (liveValuesInterval) clearInterval(liveValuesInterval);
+    if (!startLiveStream()) startPolling();
+}
+
+function startPolling() {
+    if (liveValuesInterval) return;  // already polling
     if (chartsUpdateInterval) clearInterval(chartsUpdateInterval);
     if (historyReloadInterval) clearInterval(historyReloadInterval);
     
@@ -953,6 +1100,11 @@ function startAutoUpdate() {
 
 // Stop automatic updates
 function stopAutoUpdate() {
+    stopLiveStream();
+    stopPolling();
+}
+
+function stopPolling() {
     if (liveValuesInterval) {
         clearInterval(liveValuesInterval);
         liveValuesInterval = null;
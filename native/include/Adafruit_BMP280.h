@@ -0,0 +1,36 @@
+/*
+ * Host-native Adafruit_BMP280 shim: the library's register traffic and
+ * compensation against the simulated chip, kept so the bench can compare
+ * it with src/bmp280.h. A missing sensor returns NaN like the real driver.
+ */
+#pragma once
+#include "Arduino.h"
+#include "Wire.h"
+
+class Adafruit_BMP280 {
+public:
+  enum sensor_mode { MODE_SLEEP = 0x00, MODE_FORCED = 0x01, MODE_NORMAL = 0x03 };
+  enum sensor_sampling { SAMPLING_NONE, SAMPLING_X1, SAMPLING_X2, SAMPLING_X4, SAMPLING_X8, SAMPLING_X16 };
+  enum sensor_filter { FILTER_OFF, FILTER_X2, FILTER_X4, FILTER_X8, FILTER_X16 };
+  enum standby_duration {
+    STANDBY_MS_1 = 0x00, STANDBY_MS_63 = 0x01, STANDBY_MS_125 = 0x02, STANDBY_MS_250 = 0x03,
+    STANDBY_MS_500 = 0x04, STANDBY_MS_1000 = 0x05, STANDBY_MS_2000 = 0x06, STANDBY_MS_4000 = 0x07
+  };
+
+  explicit Adafruit_BMP280(TwoWire *theWire = &Wire) : wire_(theWire) {}
+
+  bool begin(uint8_t addr = 0x77, uint8_t chipid = 0x58);
+  void setSampling(sensor_mode mode = MODE_NORMAL, sensor_sampling tempSampling = SAMPLING_X16,
+                   sensor_sampling pressSampling = SAMPLING_X16, sensor_filter filter = FILTER_OFF,
+                   standby_duration duration = STANDBY_MS_1);
+  float readTemperature();
+  float readPressure();
+
+private:
+  bool readRegisters(uint8_t reg, uint8_t *buf, size_t len);
+
+  TwoWire *wire_;
+  uint8_t addr_ = 0;
+  uint16_t calib_[12] = {};
+  int32_t tFine_ = 0;
+};
@@ -0,0 +1,186 @@
+/*
+ * Host-native Arduino shim for the [env:native] build.
+ * Only the subset of the Arduino-ESP32 core that src/main.cpp uses.
+ * Time is virtual: millis()/delay() run on sim::clock, so a blocking
+ * delay() costs no host CPU and shows up as "blocked" time in the bench.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+
+using std::abs;
+using std::isnan;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT           0x01
+#define OUTPUT          0x03
+#define INPUT_PULLUP    0x05
+#define INPUT_PULLDOWN  0x09
+#define OUTPUT_OPEN_DRAIN 0x13
+
+#define IRAM_ATTR
+
+// --- Virtual clock / GPIO (implemented in native/src/sim.cpp) ---
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+int analogRead(uint8_t pin);
+uint8_t digitalPinToAnalogChannel(uint8_t pin);  // 0xFF if not an ADC pin
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+
+// --- Flash strings are plain strings on host ---
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+#define PSTR(s) (s)
+
+// --- Arduino String (std::string backed) ---
+class String {
+public:
+  String() {}
+  String(const char *s) : s_(s ? s : "") {}
+  String(const __FlashStringHelper *s) : s_(reinterpret_cast<const char *>(s)) {}
+  String(const std::string &s) : s_(s) {}
+  explicit String(char c) : s_(1, c) {}
+  explicit String(int v) : s_(std::to_string(v)) {}
+  explicit String(unsigned int v) : s_(std::to_string(v)) {}
+  explicit String(long v) : s_(std::to_string(v)) {}
+  explicit String(unsigned long v) : s_(std::to_string(v)) {}
+  explicit String(float v, unsigned char decimals = 2) { fmt(v, decimals); }
+  explicit String(double v, unsigned char decimals = 2) { fmt(v, decimals); }
+
+  const char *c_str() const { return s_.c_str(); }
+  unsigned int length() const { return (unsigned int)s_.size(); }
+  bool reserve(unsigned int n) { s_.reserve(n); return true; }
+  bool isEmpty() const { return s_.empty(); }
+
+  bool concat(const char *s) { s_ += s; return true; }
+  bool concat(const char *s, unsigned int n) { s_.append(s, n); return true; }
+  bool concat(const String &s) { s_ += s.s_; return true; }
+  bool concat(char c) { s_ += c; return true; }
+
+  String &operator+=(const String &o) { s_ += o.s_; return *this; }
+  String &operator+=(const char *o) { s_ += o; return *this; }
+  String &operator+=(const __FlashStringHelper *o) { s_ += reinterpret_cast<const char *>(o); return *this; }
+  String &operator+=(char c) { s_ += c; return *this; }
+
+  bool operator==(const String &o) const { return s_ == o.s_; }
+  bool operator==(const char *o) const { return s_ == o; }
+  bool operator!=(const char *o) const { return s_ != o; }
+  char operator[](unsigned int i) const { return s_[i]; }
+
+  int toInt() const { return atoi(s_.c_str()); }
+  float toFloat() const { return (float)atof(s_.c_str()); }
+
+private:
+  void fmt(double v, unsigned char decimals) {
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", decimals, v);
+    s_ = buf;
+  }
+  std::string s_;
+};
+
+// ArduinoJson checks for this type by name
+class StringSumHelper : public String {
+public:
+  using String::String;
+};
+
+inline String operator+(const String &a, const String &b) { String r(a); r += b; return r; }
+inline String operator+(const String &a, const char *b) { String r(a); r += b; return r; }
+inline String operator+(const char *a, const String &b) { String r(a); r += b; return r; }
+
+// --- Print / Serial ---
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buf, size_t n) {
+    size_t w = 0;
+    while (n--) w += write(*buf++);
+    return w;
+  }
+  size_t write(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+
+  size_t print(const char *s) { return write(s); }
+  size_t print(const String &s) { return write(s.c_str()); }
+  size_t print(const __FlashStringHelper *s) { return write(reinterpret_cast<const char *>(s)); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v) { return printf("%d", v); }
+  size_t print(unsigned int v) { return printf("%u", v); }
+  size_t print(long v) { return printf("%ld", v); }
+  size_t print(unsigned long v) { return printf("%lu", v); }
+  size_t print(double v, int decimals = 2) { return printf("%.*f", decimals, v); }
+  size_t print(const struct tm *t, const char *format) {
+    char buf[64];
+    size_t n = strftime(buf, sizeof(buf), format, t);
+    return write((const uint8_t *)buf, n);
+  }
+
+  template <typename T> size_t println(T v) { size_t n = print(v); return n + println(); }
+  size_t println(const struct tm *t, const char *format) { size_t n = print(t, format); return n + println(); }
+  size_t println() { return write((uint8_t)'\n'); }
+
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class HardwareSerial : public Print {
+public:
+  void begin(unsigned long baud) { (void)baud; }
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buf, size_t n) override;
+  using Print::write;
+  operator bool() const { return true; }
+};
+extern HardwareSerial Serial;
+
+// --- ESP chip helpers ---
+class EspClass {
+public:
+  uint32_t getFreeHeap();
+  uint32_t getMinFreeHeap();
+  uint32_t getMaxAllocHeap();
+  uint32_t getCycleCount();
+  void restart() {}
+};
+extern EspClass ESP;
+
+// --- NTP / time (esp32-hal-time) ---
+void configTime(long gmtOffset_sec, int daylightOffset_sec, const char *server1,
+                const char *server2 = nullptr, const char *server3 = nullptr);
+bool getLocalTime(struct tm *info, uint32_t ms = 5000);
+
+// --- Networking value type used by WiFi and AsyncTCP ---
+class IPAddress {
+public:
+  IPAddress() : a_{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : a_{a, b, c, d} {}
+  uint8_t operator[](int i) const { return a_[i]; }
+  String toString() const {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", a_[0], a_[1], a_[2], a_[3]);
+    return String(buf);
+  }
+private:
+  uint8_t a_[4];
+};
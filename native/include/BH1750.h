@@ -0,0 +1,29 @@
+/*
+ * Host-native BH1750 shim (claws/BH1750 API). Lux comes from sim::bh1750.
+ */
+#pragma once
+#include "Arduino.h"
+#include "Wire.h"
+
+class BH1750 {
+public:
+  enum Mode {
+    UNCONFIGURED = 0,
+    CONTINUOUS_HIGH_RES_MODE = 0x10,
+    CONTINUOUS_HIGH_RES_MODE_2 = 0x11,
+    CONTINUOUS_LOW_RES_MODE = 0x13,
+    ONE_TIME_HIGH_RES_MODE = 0x20,
+    ONE_TIME_HIGH_RES_MODE_2 = 0x21,
+    ONE_TIME_LOW_RES_MODE = 0x23
+  };
+
+  explicit BH1750(uint8_t addr = 0x23) : addr_(addr) {}
+  bool begin(Mode mode = CONTINUOUS_HIGH_RES_MODE, uint8_t addr = 0x23, TwoWire *i2c = nullptr);
+  bool configure(Mode mode);
+  float readLightLevel();
+
+private:
+  uint8_t addr_;
+  TwoWire *wire_ = nullptr;
+  Mode mode_ = UNCONFIGURED;
+};
@@ -0,0 +1,250 @@
+/*
+ * Host-native ESPAsyncWebServer shim. Handlers are stored as registered
+ * and invoked synchronously by sim::httpRequest(); the "wire" is a
+ * byte counter plus the last response kept for inspection.
+ */
+#pragma once
+#include "Arduino.h"
+#include "LittleFS.h"
+#include "sim.h"
+#include <functional>
+#include <vector>
+#include <strings.h>
+
+typedef enum {
+  HTTP_GET = 0b00000001,
+  HTTP_POST = 0b00000010,
+  HTTP_DELETE = 0b00000100,
+  HTTP_PUT = 0b00001000,
+  HTTP_PATCH = 0b00010000,
+  HTTP_HEAD = 0b00100000,
+  HTTP_OPTIONS = 0b01000000,
+  HTTP_ANY = 0b01111111,
+} WebRequestMethod;
+typedef uint8_t WebRequestMethodComposite;
+
+class AsyncClient {
+public:
+  IPAddress remoteIP() const { return ip_; }
+  void setRemoteIP(const IPAddress &ip) { ip_ = ip; }
+private:
+  IPAddress ip_{192, 168, 2, 50};
+};
+
+typedef std::function<size_t(uint8_t *buffer, size_t maxLen, size_t index)> AwsResponseFiller;
+typedef std::function<void(void)> ArDisconnectHandler;
+// Filler result meaning "nothing yet, keep the response open" (WebResponseImpl.h)
+#define RESPONSE_TRY_AGAIN 0xFFFFFFFF
+
+class AsyncWebServerResponse {
+public:
+  AsyncWebServerResponse(int code, const String &contentType, const String &content)
+    : code_(code), contentType_(contentType), content_(content) {}
+  AsyncWebServerResponse(int code, const String &contentType, AwsResponseFiller filler, size_t length = 0)
+    : code_(code), contentType_(contentType), filler_(filler), length_(length) {}
+  virtual ~AsyncWebServerResponse() {}
+  void addHeader(const String &name, const String &value) {
+    sim::LibraryScope library;
+    headers_.push_back(name + ": " + value);
+  }
+  // The real addHeader() takes Strings; the conversion is the library's cost
+  void addHeader(const char *name, const char *value) {
+    sim::LibraryScope library;
+    addHeader(String(name), String(value));
+  }
+  void setCode(int code) { code_ = code; }
+  int code() const { return code_; }
+  const String &contentType() const { return contentType_; }
+  const String &content() const { return content_; }
+  const std::vector<String> &headers() const { return headers_; }
+  bool chunked() const { return (bool)filler_ && !length_; }
+  bool streamed() const { return (bool)filler_; }
+  size_t contentLength() const { return filler_ ? length_ : content_.length(); }
+  // Pulls the next chunk the way AsyncTCP would once the socket has room
+  size_t fill(uint8_t *buffer, size_t maxLen) {
+    sim::HandlerScope handler;
+    size_t n = filler_(buffer, maxLen, index_);
+    index_ += n;
+    return n;
+  }
+private:
+  int code_;
+  String contentType_;
+  String content_;
+  AwsResponseFiller filler_;
+  size_t length_ = 0;   // Content-Length of a filler response, 0 = chunked
+  size_t index_ = 0;
+  std::vector<String> headers_;
+};
+
+class AsyncWebParameter {
+public:
+  AsyncWebParameter(const String &name, const String &value) : name_(name), value_(value) {}
+  const String &name() const { return name_; }
+  const String &value() const { return value_; }
+private:
+  String name_;
+  String value_;
+};
+
+class AsyncWebHeader {
+public:
+  AsyncWebHeader(const String &name, const String &value) : name_(name), value_(value) {}
+  const String &name() const { return name_; }
+  const String &value() const { return value_; }
+private:
+  String name_;
+  String value_;
+};
+
+class AsyncWebServerRequest {
+public:
+  // url may carry a query string; url() returns the path only, like the real server
+  AsyncWebServerRequest(WebRequestMethod method, const String &url) : method_(method) {
+    std::string full(url.c_str());
+    size_t q = full.find('?');
+    url_ = String(full.substr(0, q));
+    while (q != std::string::npos) {
+      size_t next = full.find('&', q + 1);
+      std::string pair = full.substr(q + 1, next == std::string::npos ? std::string::npos : next - q - 1);
+      size_t eq = pair.find('=');
+      if (!pair.empty()) {
+        params_.push_back(AsyncWebParameter(String(pair.substr(0, eq)),
+                                            String(eq == std::string::npos ? std::string() : pair.substr(eq + 1))));
+      }
+      q = next;
+    }
+  }
+  ~AsyncWebServerRequest() {
+    if (onDisconnect_) {
+      sim::HandlerScope handler;
+      onDisconnect_();
+    }
+    delete response_;
+  }
+  // Runs once the client is gone (response sent or connection dropped)
+  void onDisconnect(ArDisconnectHandler fn) { onDisconnect_ = fn; }
+
+  WebRequestMethodComposite method() const { return method_; }
+  const String &url() const { return url_; }
+  AsyncClient *client() { return &client_; }
+
+  bool hasParam(const char *name, bool post = false, bool file = false) const {
+    return getParam(name, post, file) != nullptr;
+  }
+  const AsyncWebParameter *getParam(const char *name, bool post = false, bool file = false) const {
+    (void)post; (void)file;
+    for (const AsyncWebParameter &p : params_) {
+      if (p.name() == name) return &p;
+    }
+    return nullptr;
+  }
+
+  // Request headers, added by sim::httpRequest() before dispatch
+  void addHeader(const String &name, const String &value) { headers_.push_back(AsyncWebHeader(name, value)); }
+  bool hasHeader(const char *name) const { return getHeader(name) != nullptr; }
+  const AsyncWebHeader *getHeader(const char *name) const {
+    for (const AsyncWebHeader &h : headers_) {
+      if (strcasecmp(h.name().c_str(), name) == 0) return &h;
+    }
+    return nullptr;
+  }
+  bool hasHeader(const String &name) const { return hasHeader(name.c_str()); }
+  const AsyncWebHeader *getHeader(const String &name) const { return getHeader(name.c_str()); }
+
+  // Response objects and their String arguments are the library's
+  // allocations (sim::LibraryScope); the const char * overloads stand for
+  // the implicit conversions the real String-taking API does
+  AsyncWebServerResponse *beginResponse(int code, const String &contentType = String(),
+                                        const String &content = String()) {
+    sim::LibraryScope library;
+    return new AsyncWebServerResponse(code, contentType, content);
+  }
+  AsyncWebServerResponse *beginResponse(int code, const char *contentType, const char *content = "") {
+    sim::LibraryScope library;
+    return beginResponse(code, String(contentType), String(content));
+  }
+  // Fixed Content-Length body pulled through the filler (AsyncCallbackResponse)
+  AsyncWebServerResponse *beginResponse(const String &contentType, size_t len, AwsResponseFiller callback) {
+    sim::LibraryScope library;
+    return new AsyncWebServerResponse(200, contentType, callback, len);
+  }
+  AsyncWebServerResponse *beginResponse(const char *contentType, size_t len, AwsResponseFiller callback) {
+    sim::LibraryScope library;
+    return beginResponse(String(contentType), len, callback);
+  }
+  AsyncWebServerResponse *beginChunkedResponse(const String &contentType, AwsResponseFiller callback) {
+    sim::LibraryScope library;
+    return new AsyncWebServerResponse(200, contentType, callback);
+  }
+  AsyncWebServerResponse *beginChunkedResponse(const char *contentType, AwsResponseFiller callback) {
+    sim::LibraryScope library;
+    return beginChunkedResponse(String(contentType), callback);
+  }
+  void send(AsyncWebServerResponse *response) { delete response_; response_ = response; }
+  void send(int code, const String &contentType = String(), const String &content = String()) {
+    send(beginResponse(code, contentType, content));
+  }
+  void send(int code, const char *contentType, const char *content = "") {
+    send(beginResponse(code, contentType, content));
+  }
+  void send(fs::FS &fs, const String &path, const String &contentType = String(), bool download = false) {
+    (void)fs; (void)download;
+    sim::LibraryScope library;
+    send(beginResponse(200, contentType, String("<file:") + path + ">"));
+  }
+  void send(fs::FS &fs, const char *path, const char *contentType, bool download = false) {
+    sim::LibraryScope library;
+    send(fs, String(path), String(contentType), download);
+  }
+
+  AsyncWebServerResponse *response() const { return response_; }
+
+private:
+  WebRequestMethod method_;
+  String url_;
+  AsyncClient client_;
+  AsyncWebServerResponse *response_ = nullptr;
+  ArDisconnectHandler onDisconnect_;
+  std::vector<AsyncWebParameter> params_;
+  std::vector<AsyncWebHeader> headers_;
+};
+
+typedef std::function<void(AsyncWebServerRequest *request)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest *request, const String &filename, size_t index,
+                           uint8_t *data, size_t len, bool final)> ArUploadHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index,
+                           size_t total)> ArBodyHandlerFunction;
+
+class AsyncWebServer {
+public:
+  struct Route {
+    String uri;
+    WebRequestMethodComposite method;
+    ArRequestHandlerFunction onRequest;
+    ArBodyHandlerFunction onBody;
+  };
+
+  explicit AsyncWebServer(uint16_t port);
+  ~AsyncWebServer();
+
+  void begin() { started_ = true; }
+  void on(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest) {
+    routes_.push_back({String(uri), method, onRequest, nullptr});
+  }
+  void on(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+          ArUploadHandlerFunction onUpload, ArBodyHandlerFunction onBody) {
+    (void)onUpload;
+    routes_.push_back({String(uri), method, onRequest, onBody});
+  }
+  void onNotFound(ArRequestHandlerFunction fn) { notFound_ = fn; }
+
+  // Host-side dispatch used by sim::httpRequest()
+  void dispatch(AsyncWebServerRequest *request, const uint8_t *body, size_t len);
+  const std::vector<Route> &routes() const { return routes_; }
+
+private:
+  std::vector<Route> routes_;
+  ArRequestHandlerFunction notFound_;
+  bool started_ = false;
+};
@@ -0,0 +1,73 @@
+/*
+ * Host-native fs::FS / fs::File (Arduino-ESP32 FS.h subset).
+ * Files live in a host directory (sim::setFlashRoot(), a fresh temp dir by
+ * default), so data written by the firmware survives a simulated reboot.
+ * Every sync is also charged to a littlefs-like flash model: appending to a
+ * partly filled block re-programs that block (copy-on-write) plus one
+ * metadata commit, which is what sim::flashStats() reports as programmed.
+ */
+#pragma once
+#include "Arduino.h"
+#include <memory>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+class FileImpl;
+typedef std::shared_ptr<FileImpl> FileImplPtr;
+
+class File : public Print {
+public:
+  File(FileImplPtr p = FileImplPtr()) : p_(p) {}
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buf, size_t size) override;
+  using Print::write;
+  int available();
+  int read();
+  size_t read(uint8_t *buf, size_t size);
+  bool seek(uint32_t pos, SeekMode mode = SeekSet);
+  size_t position() const;
+  size_t size() const;
+  void flush();
+  void close();
+  operator bool() const;
+  const char *path() const;
+  const char *name() const;
+  boolean isDirectory();
+  File openNextFile(const char *mode = FILE_READ);
+  void rewindDirectory();
+
+private:
+  FileImplPtr p_;
+};
+
+class FS {
+public:
+  virtual ~FS() {}
+  File open(const char *path, const char *mode = FILE_READ, const bool create = false);
+  File open(const String &path, const char *mode = FILE_READ, const bool create = false) {
+    return open(path.c_str(), mode, create);
+  }
+  bool exists(const char *path);
+  bool exists(const String &path) { return exists(path.c_str()); }
+  bool remove(const char *path);
+  bool remove(const String &path) { return remove(path.c_str()); }
+  bool rename(const char *pathFrom, const char *pathTo);
+  bool mkdir(const char *path);
+  bool rmdir(const char *path);
+};
+
+}  // namespace fs
+
+using fs::FS;
+using fs::File;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
@@ -0,0 +1,39 @@
+/*
+ * Host-native FastLED shim. show() only counts refreshes.
+ */
+#pragma once
+#include "Arduino.h"
+
+enum EOrder { RGB = 0012, GRB = 0102 };
+
+struct CRGB {
+  uint8_t r, g, b;
+  CRGB() : r(0), g(0), b(0) {}
+  CRGB(uint8_t ir, uint8_t ig, uint8_t ib) : r(ir), g(ig), b(ib) {}
+  CRGB(uint32_t code) : r((code >> 16) & 0xFF), g((code >> 8) & 0xFF), b(code & 0xFF) {}
+  bool operator==(const CRGB &o) const { return r == o.r && g == o.g && b == o.b; }
+
+  enum HTMLColorCode : uint32_t {
+    Black = 0x000000,
+    Blue = 0x0000FF,
+    Green = 0x008000,
+    Purple = 0x800080,
+    Red = 0xFF0000,
+    White = 0xFFFFFF
+  };
+};
+
+template <uint8_t DATA_PIN, EOrder RGB_ORDER = GRB> class WS2812 {};
+
+class CFastLED {
+public:
+  template <template <uint8_t, EOrder> class CHIPSET, uint8_t DATA_PIN, EOrder RGB_ORDER>
+  CFastLED &addLeds(CRGB *data, int nLeds) { leds_ = data; count_ = nLeds; return *this; }
+  void setBrightness(uint8_t scale) { brightness_ = scale; }
+  void show();
+private:
+  CRGB *leds_ = nullptr;
+  int count_ = 0;
+  uint8_t brightness_ = 255;
+};
+extern CFastLED FastLED;
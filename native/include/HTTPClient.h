@@ -0,0 +1,15 @@
+/*
+ * Host-native HTTPClient shim. POST returns sim::remoteHttpCode.
+ */
+#pragma once
+#include "Arduino.h"
+
+class HTTPClient {
+public:
+  bool begin(const char *url) { (void)url; return true; }
+  bool begin(const String &url) { return begin(url.c_str()); }
+  void addHeader(const char *name, const char *value) { (void)name; (void)value; }
+  int POST(const String &payload);
+  int POST(const char *payload) { return POST(String(payload)); }
+  void end() {}
+};
@@ -0,0 +1,24 @@
+/*
+ * Host-native LittleFS shim on top of the file-backed fs::FS in FS.h.
+ * Mounting always succeeds; the web server fake only records which path
+ * was requested when a handler sends a file.
+ */
+#pragma once
+#include "FS.h"
+
+namespace fs {
+class LittleFSFS : public FS {
+public:
+  bool begin(bool formatOnFail = false, const char *basePath = "/littlefs", uint8_t maxOpenFiles = 10,
+             const char *partitionLabel = "spiffs") {
+    (void)formatOnFail; (void)basePath; (void)maxOpenFiles; (void)partitionLabel;
+    return true;
+  }
+  bool format();
+  size_t totalBytes();
+  size_t usedBytes();
+  void end() {}
+};
+}  // namespace fs
+
+extern fs::LittleFSFS LittleFS;
@@ -0,0 +1,29 @@
+/*
+ * Host-native Preferences (NVS) shim. Key/value pairs live in memory for
+ * the life of the process and survive sim::reset(), like NVS across a
+ * reboot; sim::eraseNvs() wipes them. Only the blob/int calls the
+ * firmware uses are provided.
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+class Preferences {
+public:
+  bool begin(const char *name, bool readOnly = false, const char *partitionLabel = nullptr);
+  void end();
+
+  size_t putBytes(const char *key, const void *value, size_t len);
+  size_t getBytes(const char *key, void *buf, size_t maxLen);
+  size_t getBytesLength(const char *key);
+  size_t putUInt(const char *key, uint32_t value);
+  uint32_t getUInt(const char *key, uint32_t defaultValue = 0);
+  bool isKey(const char *key);
+  bool remove(const char *key);
+  bool clear();
+
+private:
+  char namespace_[16] = {0};
+  bool open_ = false;
+  bool readOnly_ = true;
+};
@@ -0,0 +1,80 @@
+/*
+ * Host-native WiFi shim. The station associates with a simulated AP
+ * (sim::setWiFiAp) on the virtual clock: a full scan, or a directed connect
+ * when channel + BSSID are given, then DHCP unless config() set a static
+ * address. Events are delivered to onEvent() handlers as time advances.
+ */
+#pragma once
+#include "Arduino.h"
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+
+typedef enum {
+  ARDUINO_EVENT_WIFI_STA_START,
+  ARDUINO_EVENT_WIFI_STA_CONNECTED,
+  ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+  ARDUINO_EVENT_WIFI_STA_GOT_IP,
+  ARDUINO_EVENT_WIFI_STA_LOST_IP,
+  ARDUINO_EVENT_MAX
+} arduino_event_id_t;
+
+// The fields the firmware reads, laid out like the IDF event structs
+typedef union {
+  struct {
+    uint8_t ssid[32];
+    uint8_t ssid_len;
+    uint8_t bssid[6];
+    uint8_t reason;
+    int8_t rssi;
+  } wifi_sta_disconnected;
+  struct {
+    uint8_t ssid[32];
+    uint8_t ssid_len;
+    uint8_t bssid[6];
+    uint8_t channel;
+  } wifi_sta_connected;
+  struct {
+    struct {
+      struct { uint32_t addr; } ip, netmask, gw;
+    } ip_info;
+    bool ip_changed;
+  } got_ip;
+} arduino_event_info_t;
+
+#define WIFI_REASON_ASSOC_LEAVE 8
+#define WIFI_REASON_BEACON_TIMEOUT 200
+#define WIFI_REASON_NO_AP_FOUND 201
+
+typedef void (*WiFiEventFuncCb)(arduino_event_id_t event, arduino_event_info_t info);
+
+class WiFiClass {
+public:
+  wl_status_t begin(const char *ssid, const char *passphrase = nullptr,
+                    int32_t channel = 0, const uint8_t *bssid = nullptr, bool connect = true);
+  // 0.0.0.0 goes back to DHCP
+  bool config(IPAddress local, IPAddress gateway, IPAddress subnet, IPAddress dns1 = IPAddress(),
+              IPAddress dns2 = IPAddress());
+  bool mode(wifi_mode_t m);
+  void persistent(bool persistent);
+  bool setAutoReconnect(bool autoReconnect);
+  int onEvent(WiFiEventFuncCb cb, arduino_event_id_t event = ARDUINO_EVENT_MAX);
+  wl_status_t status();
+  int8_t RSSI();
+  IPAddress localIP();
+  IPAddress gatewayIP();
+  IPAddress subnetMask();
+  IPAddress dnsIP(uint8_t n = 0);
+  uint8_t *BSSID();
+  int32_t channel();
+  bool disconnect(bool wifioff = false);
+};
+extern WiFiClass WiFi;
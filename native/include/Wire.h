@@ -0,0 +1,42 @@
+/*
+ * Host-native TwoWire shim. Devices "exist" when registered with
+ * sim::attachI2C(); every transaction is counted per bus.
+ */
+#pragma once
+#include "Arduino.h"
+
+class TwoWire {
+public:
+  explicit TwoWire(uint8_t busNum) : bus_(busNum) {}
+
+  bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0);
+  bool end();
+  void setClock(uint32_t frequency) { freq_ = frequency; }
+  uint32_t getClock() const { return freq_; }
+  void setTimeOut(uint16_t ms) { timeoutMs_ = ms; }
+  uint16_t getTimeOut() const { return timeoutMs_; }
+
+  void beginTransmission(uint16_t address);
+  size_t write(uint8_t data);
+  size_t write(const uint8_t *data, size_t n);
+  uint8_t endTransmission(bool sendStop = true);
+  size_t requestFrom(uint16_t address, size_t size, bool sendStop = true);
+  int available();
+  int read();
+
+  uint8_t busNum() const { return bus_; }
+
+private:
+  uint8_t bus_;
+  uint32_t freq_ = 100000;
+  uint16_t timeoutMs_ = 50;
+  uint16_t txAddr_ = 0;
+  uint8_t txBuf_[32];
+  size_t txLen_ = 0;
+  uint8_t rxBuf_[32];
+  size_t rxLen_ = 0;
+  size_t rxPos_ = 0;
+};
+
+extern TwoWire Wire;
+extern TwoWire Wire1;
@@ -0,0 +1,128 @@
+/*
+ * Simulation controls for the host-native build.
+ * The bench (and anything else linking native/src) drives the fake
+ * drivers through these knobs instead of real hardware.
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+class AsyncWebServerRequest;
+
+namespace sim {
+
+struct I2CStats {
+  uint32_t transactions;
+  uint32_t bytes;
+  uint32_t nacks;    // incl. timeouts
+  uint64_t busUs;    // time the bus was held (bytes on the wire + timeouts)
+};
+
+struct HeapStats {
+  size_t liveBytes;
+  size_t peakBytes;
+  uint32_t allocations;
+  uint32_t handlerAllocations;  // made by web handler code, not by the server shim
+};
+
+struct FlashStats {
+  uint64_t bytesWritten;     // bytes handed to File::write()
+  uint64_t bytesProgrammed;  // modelled flash programming: copy-on-write tail blocks + commits
+  uint32_t syncs;            // flush()/close() calls that had dirty data
+};
+
+struct HttpResult {
+  int code;
+  size_t bytes;          // body bytes that would go on the wire
+  size_t headerCount;
+  uint64_t ttfbNs;       // host time until the first body byte was ready
+  size_t chunks;         // filler calls for chunked responses (1 otherwise)
+};
+
+// --- Virtual clock ---
+uint64_t nowUs();
+void advanceMs(uint32_t ms);
+void advanceUs(uint64_t us);
+uint64_t blockedUs();    // total virtual time spent inside delay()
+
+// --- Sensors ---
+void setBmp280(bool present, float temperatureC, float pressurePa);
+void setBh1750(bool present, float lux);
+void setSoilAdc(int raw, int noise);   // noise = +/- uniform counts
+// Raw 12-bit samples the soil ADC replays in a loop, one per conversion
+// (continuous mode at its sample rate, or per analogRead()); until setSoilAdc()
+void setSoilTrace(const uint16_t *samples, size_t count);
+void attachI2C(uint8_t bus, uint8_t address, bool present);
+bool i2cPresent(uint8_t bus, uint8_t address);
+I2CStats i2cStats(uint8_t bus);
+// Device stretches SCL forever: its transfers time out (Wire's timeout)
+void stallI2C(uint8_t bus, uint8_t address, bool stalled);
+// A slave holds SDA low until it sees `pulses` SCL clocks (0 = release)
+void stickI2CBus(uint8_t bus, int pulses);
+
+// --- Network / board ---
+// The AP the station connects to; the link follows through the firmware's
+// own (re)connects on the virtual clock
+void setWiFiAp(bool up);
+void setWiFiApChannel(int channel);
+void setRssi(int8_t rssi);
+void setNtpSynced(bool synced);
+void setRemoteHttpCode(int code);
+int gpioLevel(uint8_t pin);
+uint32_t ledShows();
+
+// --- Serial sink ---
+void setSerialEcho(bool echo);
+// 0 (default): writes are free. Otherwise a 128-byte TX FIFO at baud/10
+// bytes/s, and a write that does not fit blocks on the virtual clock.
+void setSerialBaud(uint32_t baud);
+// Appends everything written to Serial to *out; nullptr stops
+void setSerialCapture(std::string *out);
+size_t serialBytes();
+
+// --- Heap accounting (global operator new/delete are instrumented) ---
+HeapStats heap();
+void resetHeapPeak();
+// Attribution for handlerAllocations: the server shim runs handlers and
+// response fillers inside a HandlerScope, and its own request, response and
+// header objects (which ESPAsyncWebServer allocates on the device too)
+// inside a LibraryScope
+struct HandlerScope {
+  HandlerScope();
+  ~HandlerScope();
+};
+struct LibraryScope {
+  LibraryScope();
+  ~LibraryScope();
+};
+
+// --- Flash (LittleFS backed by a host directory) ---
+void setFlashRoot(const char *dir);   // default: a temp dir, or $SIM_FLASH_ROOT
+const char *flashRoot();
+void formatFlash();                   // delete every file under the root
+FlashStats flashStats();
+void resetFlashStats();
+bool truncateFlashFile(const char *path, size_t size);  // simulate a write torn by power loss
+
+// --- NVS (Preferences); survives reset() ---
+void eraseNvs();
+
+// --- HTTP ---
+// headers: "Name: value" lines separated by '\n'
+HttpResult httpRequest(uint8_t method, const char *url, const char *body = nullptr,
+                       const char *headers = nullptr);
+void setCaptureBody(bool capture);   // keep the last body for lastBody()
+const char *lastBody();
+// Value of a header on the last response copied into value, or nullptr
+const char *lastHeader(const char *name, char *value, size_t size);
+// Long-lived GET (e.g. /events): the response stays open across polls the
+// way AsyncTCP keeps calling a filler that answered RESPONSE_TRY_AGAIN
+struct HttpStream;
+HttpStream *openStream(const char *url, int *code = nullptr);
+size_t pollStream(HttpStream *stream, std::string *out = nullptr);  // bytes the filler had ready
+void closeStream(HttpStream *stream);
+
+void reset();
+
+}  // namespace sim
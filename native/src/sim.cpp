@@ -0,0 +1,1416 @@
+/*
+ * Fake drivers for the host-native build: virtual clock, GPIO/ADC,
+ * I2C bus, BMP280, BH1750, WiFi, LED strip, a directory-backed LittleFS,
+ * HTTP dispatch and an instrumented heap so ESP.getFreeHeap() means
+ * something on Linux.
+ */
+#include <Arduino.h>
+#include <Wire.h>
+#include <WiFi.h>
+#include <LittleFS.h>
+#include <HTTPClient.h>
+#include <FastLED.h>
+#include <Adafruit_BMP280.h>
+#include <BH1750.h>
+#include <ESPAsyncWebServer.h>
+#include <Preferences.h>
+#include <driver/adc.h>
+#include <stdarg.h>
+#include <dirent.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <new>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include "sim.h"
+
+#define SIM_HEAP_SIZE (320 * 1024)  // roughly what an ESP32-S3 has free after WiFi start
+#define SIM_I2C_BUSES 2
+#define SIM_GPIO_COUNT 49
+#define SIM_TCP_CHUNK 1436  // one TCP MSS, what AsyncTCP typically offers a filler
+#define SIM_FLASH_BLOCK 4096        // littlefs block = one flash erase sector
+#define SIM_FLASH_COMMIT 64         // rough size of one littlefs metadata commit
+#define SIM_FLASH_SIZE (1536 * 1024)  // "spiffs" data partition of the default layout
+
+namespace {
+
+struct SimState {
+  uint64_t clockUs = 0;
+  uint64_t blockedUs = 0;
+
+  bool bmpPresent = true;
+  float bmpTemperature = 22.5f;
+  float bmpPressurePa = 101325.0f;
+  uint8_t bmpPointer = 0;           // register address for the next read
+  uint8_t bmpCtrlMeas = 0, bmpConfig = 0;
+  float bmpRawFor[2] = {NAN, NAN};  // temperature/pressure the cached raw values encode
+  int32_t bmpAdcT = 0, bmpAdcP = 0;
+  bool bh1750Present = true;
+  float bh1750Lux = 350.0f;
+  bool bhPowered = false;
+  uint8_t bhMode = 0;               // last measurement opcode (0 = none since power-up)
+  uint8_t bhMtreg = 69;
+  uint64_t bhDoneUs = 0;            // end of the conversion in progress
+  bool bhConverting = false;
+  uint16_t bhData = 0;
+  int soilRaw = 1800;
+  int soilNoise = 15;
+  std::vector<uint16_t> soilTrace;  // replaces soilRaw/soilNoise when set
+  size_t soilTracePos = 0;
+  uint32_t rng = 0x12345678;
+
+  // Continuous ADC: conversions due since adcNextUs land in adcPool on read
+  bool adcConfigured = false;
+  bool adcRunning = false;
+  uint32_t adcPoolBytes = 0;
+  uint32_t adcHz = 0;
+  uint8_t adcChannel = 0;
+  uint64_t adcNextUs = 0;
+  std::deque<uint16_t> adcPool;
+  bool adcOverflow = false;
+
+  bool i2cDevice[SIM_I2C_BUSES][128] = {};
+  bool i2cStall[SIM_I2C_BUSES][128] = {};  // holds SCL low: every transfer times out
+  sim::I2CStats i2c[SIM_I2C_BUSES] = {};
+  int i2cSda[SIM_I2C_BUSES] = {-1, -1}, i2cScl[SIM_I2C_BUSES] = {-1, -1};
+  int i2cStuckPulses[SIM_I2C_BUSES] = {};  // SCL pulses until the slave holding SDA lets go
+
+  // Station / AP model (WiFiClass); times in virtual us, 0 = nothing pending
+  bool wifiAp = true;
+  int wifiApChannel = 6;
+  uint8_t wifiApBssid[6] = {0x24, 0x0A, 0xC4, 0x12, 0x34, 0x56};
+  bool wifiLinked = false;
+  bool wifiStatic = false;
+  uint64_t wifiAssocAtUs = 0;
+  uint64_t wifiIpAtUs = 0;
+  uint64_t wifiFailAtUs = 0;
+  uint8_t wifiFailReason = 0;
+  uint8_t wifiBssidOut[6] = {};
+  WiFiEventFuncCb wifiHandlers[4] = {};
+  int8_t rssi = -58;
+  bool ntpSynced = true;
+  int remoteHttpCode = 200;
+  uint8_t gpio[SIM_GPIO_COUNT] = {};
+  uint32_t ledShows = 0;
+
+  bool serialEcho = false;
+  size_t serialBytes = 0;
+  // UART model, off unless setSerialBaud(): a 128-byte TX FIFO emptied at
+  // baud/10 bytes/s; a write that does not fit waits in delay()
+  uint32_t serialBaud = 0;
+  std::string *serialCapture = nullptr;
+  uint64_t serialFifoEmptyUs = 0;  // when the queued bytes are all out
+  bool captureBody = false;
+
+  sim::FlashStats flash = {};
+
+  AsyncWebServer *server = nullptr;
+};
+
+SimState &state() {
+  static SimState s;
+  return s;
+}
+
+size_t gLiveBytes = 0;
+size_t gPeakBytes = 0;
+uint32_t gAllocations = 0;
+uint32_t gHandlerAllocations = 0;
+int gHandlerDepth = 0;
+int gLibraryDepth = 0;
+
+uint32_t nextRandom() {
+  uint32_t &x = state().rng;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return x;
+}
+
+void defaultDevices() {
+  SimState &s = state();
+  memset(s.i2cDevice, 0, sizeof(s.i2cDevice));
+  s.i2cDevice[0][0x76] = true;  // BMP280 on Wire (16/17)
+  s.i2cDevice[1][0x23] = true;  // BH1750 on I2C_1 (8/9)
+}
+
+struct DeviceInit {
+  DeviceInit() { defaultDevices(); }
+} deviceInit;
+
+}  // namespace
+
+// ==================== HEAP ACCOUNTING ====================
+
+static void *trackedAlloc(size_t n) {
+  size_t *p = static_cast<size_t *>(malloc(n + sizeof(max_align_t)));
+  if (!p) throw std::bad_alloc();
+  *p = n;
+  gLiveBytes += n;
+  if (gLiveBytes > gPeakBytes) gPeakBytes = gLiveBytes;
+  gAllocations++;
+  if (gHandlerDepth && !gLibraryDepth) gHandlerAllocations++;
+  return reinterpret_cast<char *>(p) + sizeof(max_align_t);
+}
+
+static void trackedFree(void *ptr) {
+  if (!ptr) return;
+  size_t *p = reinterpret_cast<size_t *>(static_cast<char *>(ptr) - sizeof(max_align_t));
+  gLiveBytes -= *p;
+  free(p);
+}
+
+void *operator new(size_t n) { return trackedAlloc(n); }
+void *operator new[](size_t n) { return trackedAlloc(n); }
+void operator delete(void *p) noexcept { trackedFree(p); }
+void operator delete[](void *p) noexcept { trackedFree(p); }
+void operator delete(void *p, size_t) noexcept { trackedFree(p); }
+void operator delete[](void *p, size_t) noexcept { trackedFree(p); }
+
+// ==================== ARDUINO CORE ====================
+
+HardwareSerial Serial;
+EspClass ESP;
+TwoWire Wire(0);
+TwoWire Wire1(1);
+WiFiClass WiFi;
+fs::LittleFSFS LittleFS;
+CFastLED FastLED;
+
+unsigned long millis() { return (unsigned long)(state().clockUs / 1000); }
+unsigned long micros() { return (unsigned long)state().clockUs; }
+
+static void wifiTick();
+
+void delay(uint32_t ms) {
+  state().clockUs += (uint64_t)ms * 1000;
+  state().blockedUs += (uint64_t)ms * 1000;
+  wifiTick();
+}
+
+void delayMicroseconds(uint32_t us) {
+  state().clockUs += us;
+  state().blockedUs += us;
+}
+
+void yield() {}
+
+// One conversion of the soil probe: the recorded trace if there is one
+int soilSample() {
+  SimState &s = state();
+  if (!s.soilTrace.empty()) {
+    uint16_t v = s.soilTrace[s.soilTracePos];
+    s.soilTracePos = (s.soilTracePos + 1) % s.soilTrace.size();
+    return v;
+  }
+  if (s.soilRaw <= 0) return 0;
+  int noise = s.soilNoise ? (int)(nextRandom() % (2 * s.soilNoise + 1)) - s.soilNoise : 0;
+  int v = s.soilRaw + noise;
+  return v < 0 ? 0 : (v > 4095 ? 4095 : v);
+}
+
+int analogRead(uint8_t pin) {
+  (void)pin;
+  return soilSample();
+}
+
+uint8_t digitalPinToAnalogChannel(uint8_t pin) {
+  return pin >= 1 && pin <= 10 ? pin - 1 : 0xFF;  // ESP32-S3: GPIO1..10 are ADC1_CH0..9
+}
+
+// --- Preferences (NVS) ---
+// Outside SimState so the contents survive sim::reset(), like a reboot
+
+static std::map<std::string, std::vector<uint8_t>> &nvs() {
+  static std::map<std::string, std::vector<uint8_t>> entries;
+  return entries;
+}
+
+static std::string nvsKey(const char *ns, const char *key) { return std::string(ns) + "/" + key; }
+
+bool Preferences::begin(const char *name, bool readOnly, const char *partitionLabel) {
+  (void)partitionLabel;
+  if (!name || strlen(name) >= sizeof(namespace_)) return false;  // NVS names are at most 15 chars
+  snprintf(namespace_, sizeof(namespace_), "%s", name);
+  open_ = true;
+  readOnly_ = readOnly;
+  return true;
+}
+
+void Preferences::end() { open_ = false; }
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t len) {
+  if (!open_ || readOnly_ || !key || strlen(key) > 15) return 0;
+  const uint8_t *p = (const uint8_t *)value;
+  nvs()[nvsKey(namespace_, key)].assign(p, p + len);
+  return len;
+}
+
+size_t Preferences::getBytes(const char *key, void *buf, size_t maxLen) {
+  if (!open_) return 0;
+  auto it = nvs().find(nvsKey(namespace_, key));
+  if (it == nvs().end() || it->second.size() > maxLen) return 0;
+  memcpy(buf, it->second.data(), it->second.size());
+  return it->second.size();
+}
+
+size_t Preferences::getBytesLength(const char *key) {
+  if (!open_) return 0;
+  auto it = nvs().find(nvsKey(namespace_, key));
+  return it == nvs().end() ? 0 : it->second.size();
+}
+
+size_t Preferences::putUInt(const char *key, uint32_t value) {
+  return putBytes(key, &value, sizeof(value));
+}
+
+uint32_t Preferences::getUInt(const char *key, uint32_t defaultValue) {
+  uint32_t v;
+  return getBytesLength(key) == sizeof(v) && getBytes(key, &v, sizeof(v)) == sizeof(v) ? v : defaultValue;
+}
+
+bool Preferences::isKey(const char *key) {
+  return open_ && nvs().count(nvsKey(namespace_, key)) > 0;
+}
+
+bool Preferences::remove(const char *key) {
+  if (!open_ || readOnly_) return false;
+  return nvs().erase(nvsKey(namespace_, key)) > 0;
+}
+
+bool Preferences::clear() {
+  if (!open_ || readOnly_) return false;
+  std::string prefix = std::string(namespace_) + "/";
+  for (auto it = nvs().begin(); it != nvs().end();) {
+    if (it->first.compare(0, prefix.size(), prefix) == 0) it = nvs().erase(it);
+    else ++it;
+  }
+  return true;
+}
+
+// --- Continuous ADC (driver/adc.h) ---
+
+esp_err_t adc_digi_initialize(const adc_digi_init_config_t *config) {
+  SimState &s = state();
+  if (!config || config->max_store_buf_size == 0 || s.adcConfigured) return ESP_ERR_INVALID_ARG;
+  s.adcConfigured = true;
+  s.adcPoolBytes = config->max_store_buf_size;
+  s.adcPool.clear();
+  return ESP_OK;
+}
+
+esp_err_t adc_digi_deinitialize() {
+  SimState &s = state();
+  s.adcConfigured = s.adcRunning = false;
+  s.adcPool.clear();
+  return ESP_OK;
+}
+
+esp_err_t adc_digi_controller_configure(const adc_digi_configuration_t *config) {
+  SimState &s = state();
+  if (!s.adcConfigured || !config || config->pattern_num != 1 || !config->adc_pattern) return ESP_ERR_INVALID_STATE;
+  if (config->sample_freq_hz < SOC_ADC_SAMPLE_FREQ_THRES_LOW || config->sample_freq_hz > SOC_ADC_SAMPLE_FREQ_THRES_HIGH)
+    return ESP_ERR_INVALID_ARG;
+  s.adcHz = config->sample_freq_hz;
+  s.adcChannel = config->adc_pattern[0].channel;
+  return ESP_OK;
+}
+
+esp_err_t adc_digi_start() {
+  SimState &s = state();
+  if (!s.adcConfigured || s.adcHz == 0) return ESP_ERR_INVALID_STATE;
+  s.adcRunning = true;
+  s.adcNextUs = s.clockUs;
+  return ESP_OK;
+}
+
+esp_err_t adc_digi_stop() {
+  state().adcRunning = false;
+  return ESP_OK;
+}
+
+esp_err_t adc_digi_read_bytes(uint8_t *buf, uint32_t length_max, uint32_t *out_length, uint32_t timeout_ms) {
+  SimState &s = state();
+  *out_length = 0;
+  if (!s.adcConfigured) return ESP_ERR_INVALID_STATE;
+  (void)timeout_ms;  // never waits: the firmware only polls with 0
+  // DMA ran while the caller was busy: convert what is due, drop what the pool cannot hold
+  size_t capacity = s.adcPoolBytes / SOC_ADC_DIGI_RESULT_BYTES;
+  uint64_t periodUs = 1000000 / s.adcHz;
+  while (s.adcRunning && s.adcNextUs + periodUs <= s.clockUs) {
+    uint16_t v = (uint16_t)soilSample();
+    if (s.adcPool.size() < capacity) s.adcPool.push_back(v);
+    else s.adcOverflow = true;
+    s.adcNextUs += periodUs;
+  }
+  if (s.adcPool.empty()) return ESP_ERR_TIMEOUT;
+  size_t n = length_max / SOC_ADC_DIGI_RESULT_BYTES;
+  if (n > s.adcPool.size()) n = s.adcPool.size();
+  for (size_t i = 0; i < n; i++) {
+    adc_digi_output_data_t d;
+    d.val = 0;
+    d.type2.data = s.adcPool.front();
+    d.type2.channel = s.adcChannel;
+    d.type2.unit = 0;
+    memcpy(buf + i * SOC_ADC_DIGI_RESULT_BYTES, &d, SOC_ADC_DIGI_RESULT_BYTES);
+    s.adcPool.pop_front();
+  }
+  *out_length = (uint32_t)(n * SOC_ADC_DIGI_RESULT_BYTES);
+  if (s.adcOverflow) {
+    s.adcOverflow = false;
+    return ESP_ERR_INVALID_STATE;
+  }
+  return ESP_OK;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) { (void)pin; (void)mode; }
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  SimState &s = state();
+  for (int b = 0; b < SIM_I2C_BUSES; b++) {  // recovery clocking on a stuck bus
+    if (pin == s.i2cScl[b] && val == HIGH && s.gpio[pin] == LOW && s.i2cStuckPulses[b] > 0) s.i2cStuckPulses[b]--;
+  }
+  if (pin < SIM_GPIO_COUNT) state().gpio[pin] = val;
+}
+
+int digitalRead(uint8_t pin) {
+  SimState &s = state();
+  for (int b = 0; b < SIM_I2C_BUSES; b++) {
+    if (pin == s.i2cSda[b] && s.i2cStuckPulses[b] > 0) return LOW;
+  }
+  return pin < SIM_GPIO_COUNT ? s.gpio[pin] : LOW;
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+size_t Print::printf(const char *format, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  if (n < 0) return 0;
+  if ((size_t)n >= sizeof(buf)) n = sizeof(buf) - 1;
+  return write((const uint8_t *)buf, (size_t)n);
+}
+
+size_t HardwareSerial::write(uint8_t c) { return write(&c, 1); }
+
+size_t HardwareSerial::write(const uint8_t *buf, size_t n) {
+  SimState &s = state();
+  s.serialBytes += n;
+  if (s.serialEcho) fwrite(buf, 1, n, stdout);
+  if (s.serialCapture) s.serialCapture->append((const char *)buf, n);
+  if (s.serialBaud) {
+    const uint64_t FIFO_BYTES = 128;
+    double byteUs = 10e6 / s.serialBaud;
+    uint64_t start = s.serialFifoEmptyUs > s.clockUs ? s.serialFifoEmptyUs : s.clockUs;
+    s.serialFifoEmptyUs = start + (uint64_t)(n * byteUs);
+    uint64_t fifoUs = (uint64_t)(FIFO_BYTES * byteUs);
+    if (s.serialFifoEmptyUs > s.clockUs + fifoUs) {
+      uint64_t wait = s.serialFifoEmptyUs - fifoUs - s.clockUs;
+      s.clockUs += wait;
+      s.blockedUs += wait;
+    }
+  }
+  return n;
+}
+
+uint32_t EspClass::getFreeHeap() { return (uint32_t)(SIM_HEAP_SIZE - gLiveBytes); }
+uint32_t EspClass::getMinFreeHeap() { return (uint32_t)(SIM_HEAP_SIZE - gPeakBytes); }
+uint32_t EspClass::getMaxAllocHeap() { return getFreeHeap(); }
+uint32_t EspClass::getCycleCount() { return (uint32_t)(state().clockUs * 240); }  // 240 MHz
+
+void configTime(long gmtOffset_sec, int daylightOffset_sec, const char *server1,
+                const char *server2, const char *server3) {
+  (void)gmtOffset_sec; (void)daylightOffset_sec; (void)server1; (void)server2; (void)server3;
+}
+
+bool getLocalTime(struct tm *info, uint32_t ms) {
+  if (!state().ntpSynced) {
+    delay(ms);  // the real call polls until the timeout expires
+    return false;
+  }
+  time_t now = time(nullptr);
+  localtime_r(&now, info);
+  return true;
+}
+
+// ==================== BMP280 REGISTER MODEL ====================
+// Trimming parameters and test vector from the BMP280 datasheet (8.2).
+// The data registers hold whatever raw values make the datasheet's
+// floating-point compensation give sim::setBmp280()'s temperature/pressure.
+
+namespace {
+
+const uint16_t BMP_CALIB[12] = {27504, 26435, (uint16_t)-1000, 36477, (uint16_t)-10685, 3024,
+                                2855, 140, (uint16_t)-7, 15500, (uint16_t)-14600, 6000};
+
+double bmpTempDouble(int32_t adcT, double *tFine) {
+  double T1 = BMP_CALIB[0], T2 = (int16_t)BMP_CALIB[1], T3 = (int16_t)BMP_CALIB[2];
+  double var1 = (adcT / 16384.0 - T1 / 1024.0) * T2;
+  double var2 = (adcT / 131072.0 - T1 / 8192.0) * (adcT / 131072.0 - T1 / 8192.0) * T3;
+  *tFine = var1 + var2;
+  return (var1 + var2) / 5120.0;
+}
+
+double bmpPressDouble(int32_t adcP, double tFine) {
+  double P[10];
+  P[1] = BMP_CALIB[3];
+  for (int i = 2; i <= 9; i++) P[i] = (int16_t)BMP_CALIB[i + 2];
+  double var1 = tFine / 2.0 - 64000.0;
+  double var2 = var1 * var1 * P[6] / 32768.0;
+  var2 = var2 + var1 * P[5] * 2.0;
+  var2 = var2 / 4.0 + P[4] * 65536.0;
+  var1 = (P[3] * var1 * var1 / 524288.0 + P[2] * var1) / 524288.0;
+  var1 = (1.0 + var1 / 32768.0) * P[1];
+  double p = 1048576.0 - adcP;
+  p = (p - var2 / 4096.0) * 6250.0 / var1;
+  var1 = P[9] * p * p / 2147483648.0;
+  var2 = p * P[8] / 32768.0;
+  return p + (var1 + var2 + P[7]) / 16.0;
+}
+
+// Raw values for the current sim temperature/pressure (bisection, cached)
+void bmpUpdateRaw() {
+  SimState &s = state();
+  if (s.bmpRawFor[0] == s.bmpTemperature && s.bmpRawFor[1] == s.bmpPressurePa) return;
+  double tFine;
+  int32_t lo = 0, hi = (1 << 20) - 1;  // temperature rises with adc_T
+  while (lo < hi) {
+    int32_t mid = (lo + hi) / 2;
+    if (bmpTempDouble(mid, &tFine) < s.bmpTemperature) lo = mid + 1;
+    else hi = mid;
+  }
+  s.bmpAdcT = lo;
+  bmpTempDouble(lo, &tFine);
+  lo = 0, hi = (1 << 20) - 1;  // pressure falls as adc_P rises
+  while (lo < hi) {
+    int32_t mid = (lo + hi) / 2;
+    if (bmpPressDouble(mid, tFine) > s.bmpPressurePa) lo = mid + 1;
+    else hi = mid;
+  }
+  s.bmpAdcP = lo;
+  s.bmpRawFor[0] = s.bmpTemperature;
+  s.bmpRawFor[1] = s.bmpPressurePa;
+}
+
+uint8_t bmpRegister(uint8_t reg) {
+  SimState &s = state();
+  if (reg >= 0x88 && reg < 0x88 + 24) {
+    uint16_t v = BMP_CALIB[(reg - 0x88) / 2];
+    return (reg - 0x88) & 1 ? (uint8_t)(v >> 8) : (uint8_t)v;
+  }
+  if (reg == 0xD0) return s.bmpPresent ? 0x58 : 0x00;
+  if (reg == 0xF4) return s.bmpCtrlMeas;
+  if (reg == 0xF5) return s.bmpConfig;
+  if (reg >= 0xF7 && reg <= 0xFC) {
+    // Not measuring (sleep / not present): registers keep their reset value 0x80000
+    bool measuring = s.bmpPresent && (s.bmpCtrlMeas & 0x03) != 0;
+    int32_t adc = reg < 0xFA ? s.bmpAdcP : s.bmpAdcT;
+    if (!measuring) adc = 0x80000;
+    switch ((reg - 0xF7) % 3) {
+      case 0: return (uint8_t)(adc >> 12);
+      case 1: return (uint8_t)(adc >> 4);
+      default: return (uint8_t)((adc & 0x0F) << 4);
+    }
+  }
+  return 0;
+}
+
+bool isBmp280(uint8_t bus, uint16_t address) { return bus == 0 && (address == 0x76 || address == 0x77); }
+
+}  // namespace
+
+// ==================== BH1750 REGISTER MODEL ====================
+// Opcodes, MTreg and timing from the BH1750FVI datasheet: counts =
+// lux * 1.2 * MTreg / 69 (twice that in H-resolution mode 2), saturating at
+// 0xFFFF. A conversion takes the typical time (120 ms H, 16 ms L at MTreg
+// 69, scaled by MTreg); one-time modes power down when it is done, and the
+// data register keeps the last result until the next one lands.
+
+namespace {
+
+bool isBh1750(uint8_t bus, uint16_t address) { return bus == 1 && (address == 0x23 || address == 0x5C); }
+
+uint64_t bhConversionUs(uint8_t mode, uint8_t mtreg) {
+  uint64_t typUs = (mode & 0x03) == 0x03 ? 16000 : 120000;
+  return typUs * mtreg / 69;
+}
+
+uint16_t bhCounts(uint8_t mode, uint8_t mtreg, float lux) {
+  double counts = lux * 1.2 * mtreg / 69.0;
+  if ((mode & 0x03) == 0x01) counts *= 2;
+  if ((mode & 0x03) == 0x03) counts = floor(counts / 4) * 4;  // 4 lx steps
+  return counts >= 65535 ? 0xFFFF : (counts <= 0 ? 0 : (uint16_t)counts);
+}
+
+void bhUpdate() {
+  SimState &s = state();
+  if (!s.bhConverting || s.clockUs < s.bhDoneUs) return;
+  s.bhData = bhCounts(s.bhMode, s.bhMtreg, s.bh1750Lux);
+  if (s.bhMode & 0x20) {  // one-time: back to power down
+    s.bhConverting = false;
+    s.bhPowered = false;
+  } else {
+    s.bhDoneUs += bhConversionUs(s.bhMode, s.bhMtreg) * ((s.clockUs - s.bhDoneUs) / bhConversionUs(s.bhMode, s.bhMtreg) + 1);
+  }
+}
+
+void bhCommand(uint8_t op) {
+  SimState &s = state();
+  bhUpdate();
+  if (op == 0x00) {
+    s.bhPowered = false;
+    s.bhConverting = false;
+  } else if (op == 0x01) {
+    s.bhPowered = true;
+  } else if (op == 0x07) {
+    if (s.bhPowered) s.bhData = 0;
+  } else if ((op & 0xF8) == 0x40) {
+    s.bhMtreg = (uint8_t)((s.bhMtreg & 0x1F) | ((op & 0x07) << 5));
+  } else if ((op & 0xE0) == 0x60) {
+    s.bhMtreg = (uint8_t)((s.bhMtreg & 0xE0) | (op & 0x1F));
+  } else if (op == 0x10 || op == 0x11 || op == 0x13 || op == 0x20 || op == 0x21 || op == 0x23) {
+    s.bhMode = op;
+    s.bhPowered = true;
+    s.bhConverting = true;
+    s.bhDoneUs = s.clockUs + bhConversionUs(op, s.bhMtreg);
+  }
+}
+
+}  // namespace
+
+// ==================== I2C ====================
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency) {
+  if (frequency) freq_ = frequency;
+  SimState &s = state();
+  s.i2cSda[bus_ % SIM_I2C_BUSES] = sda;
+  s.i2cScl[bus_ % SIM_I2C_BUSES] = scl;
+  return true;
+}
+
+bool TwoWire::end() { return true; }
+
+// Clock stretched past the timeout or SDA held low: the caller waits the
+// full timeout, nothing reaches the device
+static bool i2cBlocked(uint8_t bus, uint16_t address, uint16_t timeoutMs, sim::I2CStats &st) {
+  SimState &s = state();
+  if (s.i2cStuckPulses[bus] <= 0 && !(address < 128 && s.i2cStall[bus][address])) return false;
+  s.clockUs += (uint64_t)timeoutMs * 1000;
+  st.busUs += (uint64_t)timeoutMs * 1000;
+  st.nacks++;
+  return true;
+}
+
+void TwoWire::beginTransmission(uint16_t address) {
+  txAddr_ = address;
+  txLen_ = 0;
+}
+
+size_t TwoWire::write(uint8_t data) {
+  if (txLen_ >= sizeof(txBuf_)) return 0;
+  txBuf_[txLen_++] = data;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t n) {
+  size_t w = 0;
+  while (n-- && write(*data++)) w++;
+  return w;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+  (void)sendStop;
+  SimState &s = state();
+  sim::I2CStats &st = s.i2c[bus_ % SIM_I2C_BUSES];
+  st.transactions++;
+  if (i2cBlocked(bus_ % SIM_I2C_BUSES, txAddr_, timeoutMs_, st)) return s.i2cStuckPulses[bus_ % SIM_I2C_BUSES] > 0 ? 4 : 5;
+  st.bytes += 1 + txLen_;
+  // ~10 bit times per byte incl. ACK
+  s.clockUs += (uint64_t)(1 + txLen_) * 10 * 1000000 / freq_;
+  st.busUs += (uint64_t)(1 + txLen_) * 10 * 1000000 / freq_;
+  if (!sim::i2cPresent(bus_, (uint8_t)txAddr_)) {
+    st.nacks++;
+    return 2;  // NACK on address
+  }
+  if (isBh1750(bus_, txAddr_)) {
+    if (!s.bh1750Present) {  // unplugged
+      st.nacks++;
+      return 2;
+    }
+    for (size_t i = 0; i < txLen_; i++) bhCommand(txBuf_[i]);
+  }
+  if (isBmp280(bus_, txAddr_) && txLen_ >= 1) {
+    s.bmpPointer = txBuf_[0];
+    for (size_t i = 0; i + 1 < txLen_; i += 2) {  // (register, value) pairs
+      if (txBuf_[i] == 0xF4) s.bmpCtrlMeas = txBuf_[i + 1];
+      else if (txBuf_[i] == 0xF5) s.bmpConfig = txBuf_[i + 1];
+      else if (txBuf_[i] == 0xE0 && txBuf_[i + 1] == 0xB6) s.bmpCtrlMeas = s.bmpConfig = 0;
+    }
+  }
+  return 0;
+}
+
+size_t TwoWire::requestFrom(uint16_t address, size_t size, bool sendStop) {
+  (void)sendStop;
+  SimState &s = state();
+  sim::I2CStats &st = s.i2c[bus_ % SIM_I2C_BUSES];
+  st.transactions++;
+  rxPos_ = 0;
+  rxLen_ = 0;
+  if (i2cBlocked(bus_ % SIM_I2C_BUSES, address, timeoutMs_, st)) return 0;
+  st.bytes += 1 + size;
+  s.clockUs += (uint64_t)(1 + size) * 10 * 1000000 / freq_;
+  st.busUs += (uint64_t)(1 + size) * 10 * 1000000 / freq_;
+  if (!sim::i2cPresent(bus_, (uint8_t)address) || (isBh1750(bus_, address) && !s.bh1750Present)) {
+    st.nacks++;
+    return 0;
+  }
+  rxLen_ = size > sizeof(rxBuf_) ? sizeof(rxBuf_) : size;
+  memset(rxBuf_, 0, rxLen_);
+  if (isBmp280(bus_, address)) {
+    bmpUpdateRaw();
+    for (size_t i = 0; i < rxLen_; i++) rxBuf_[i] = bmpRegister((uint8_t)(s.bmpPointer + i));  // auto-increment
+  }
+  if (isBh1750(bus_, address)) {
+    bhUpdate();
+    for (size_t i = 0; i < rxLen_; i++) rxBuf_[i] = (uint8_t)(i == 0 ? s.bhData >> 8 : s.bhData);
+  }
+  return rxLen_;
+}
+
+int TwoWire::available() { return (int)(rxLen_ - rxPos_); }
+int TwoWire::read() { return rxPos_ < rxLen_ ? rxBuf_[rxPos_++] : -1; }
+
+// ==================== SENSORS ====================
+
+// Same register traffic and integer compensation as the Adafruit library:
+// readPressure() reads temperature again for t_fine
+
+bool Adafruit_BMP280::readRegisters(uint8_t reg, uint8_t *buf, size_t len) {
+  wire_->beginTransmission(addr_);
+  wire_->write(reg);
+  if (wire_->endTransmission() != 0) return false;
+  if (wire_->requestFrom(addr_, len) != len) return false;
+  for (size_t i = 0; i < len; i++) buf[i] = (uint8_t)wire_->read();
+  return true;
+}
+
+bool Adafruit_BMP280::begin(uint8_t addr, uint8_t chipid) {
+  addr_ = addr;
+  uint8_t id = 0, c[24];
+  if (!readRegisters(0xD0, &id, 1) || id != chipid || !readRegisters(0x88, c, sizeof(c))) return false;
+  for (int i = 0; i < 12; i++) calib_[i] = (uint16_t)(c[2 * i] | (c[2 * i + 1] << 8));
+  setSampling();
+  return true;
+}
+
+void Adafruit_BMP280::setSampling(sensor_mode mode, sensor_sampling tempSampling,
+                                  sensor_sampling pressSampling, sensor_filter filter,
+                                  standby_duration duration) {
+  wire_->beginTransmission(addr_);
+  wire_->write(0xF5);
+  wire_->write((uint8_t)((duration << 5) | (filter << 2)));
+  wire_->endTransmission();
+  wire_->beginTransmission(addr_);
+  wire_->write(0xF4);
+  wire_->write((uint8_t)((tempSampling << 5) | (pressSampling << 2) | mode));
+  wire_->endTransmission();
+}
+
+float Adafruit_BMP280::readTemperature() {
+  uint8_t d[3];
+  if (!readRegisters(0xFA, d, 3)) return NAN;
+  int32_t adcT = (int32_t)(((uint32_t)d[0] << 12) | ((uint32_t)d[1] << 4) | (d[2] >> 4));
+  if (adcT == 0x80000) return NAN;
+  int32_t T1 = calib_[0], T2 = (int16_t)calib_[1], T3 = (int16_t)calib_[2];
+  int32_t var1 = ((((adcT >> 3) - (T1 << 1))) * T2) >> 11;
+  int32_t var2 = (((((adcT >> 4) - T1) * ((adcT >> 4) - T1)) >> 12) * T3) >> 14;
+  tFine_ = var1 + var2;
+  return ((tFine_ * 5 + 128) >> 8) / 100.0f;
+}
+
+float Adafruit_BMP280::readPressure() {
+  if (isnan(readTemperature())) return NAN;
+  uint8_t d[3];
+  if (!readRegisters(0xF7, d, 3)) return NAN;
+  int32_t adcP = (int32_t)(((uint32_t)d[0] << 12) | ((uint32_t)d[1] << 4) | (d[2] >> 4));
+  if (adcP == 0x80000) return NAN;
+  int64_t P1 = calib_[3], P[10];
+  for (int i = 2; i <= 9; i++) P[i] = (int16_t)calib_[i + 2];
+  int64_t var1 = (int64_t)tFine_ - 128000;
+  int64_t var2 = var1 * var1 * P[6];
+  var2 = var2 + var1 * P[5] * 131072;
+  var2 = var2 + P[4] * ((int64_t)1 << 35);
+  var1 = ((var1 * var1 * P[3]) >> 8) + var1 * P[2] * 4096;
+  var1 = ((((int64_t)1 << 47) + var1) * P1) >> 33;
+  if (var1 == 0) return 0;
+  int64_t p = 1048576 - adcP;
+  p = ((p * ((int64_t)1 << 31) - var2) * 3125) / var1;
+  var1 = (P[9] * (p >> 13) * (p >> 13)) >> 25;
+  var2 = (P[8] * p) >> 19;
+  p = ((p + var1 + var2) >> 8) + P[7] * 16;
+  return (float)p / 256;
+}
+
+// Same traffic and conversion as claws/BH1750 (default MTreg 69)
+
+bool BH1750::configure(Mode mode) {
+  mode_ = mode;
+  if (!wire_) return false;
+  wire_->beginTransmission(addr_);
+  wire_->write((uint8_t)mode);
+  return wire_->endTransmission() == 0;
+}
+
+bool BH1750::begin(Mode mode, uint8_t addr, TwoWire *i2c) {
+  addr_ = addr;
+  wire_ = i2c ? i2c : &Wire;
+  return configure(mode);
+}
+
+float BH1750::readLightLevel() {
+  if (!wire_ || mode_ == UNCONFIGURED) return -2;
+  if (wire_->requestFrom(addr_, (size_t)2) != 2) return -1;
+  unsigned hi = (unsigned)wire_->read();
+  float level = (float)((hi << 8) | (unsigned)wire_->read());
+  if (mode_ == CONTINUOUS_HIGH_RES_MODE_2 || mode_ == ONE_TIME_HIGH_RES_MODE_2) level /= 2;
+  return level / 1.2f;
+}
+
+// ==================== FLASH FILESYSTEM ====================
+
+namespace {
+
+std::string &flashRootDir() {
+  static std::string root;
+  return root;
+}
+
+void removeTree(const std::string &dir, bool keepRoot) {
+  DIR *d = opendir(dir.c_str());
+  if (d) {
+    while (struct dirent *e = readdir(d)) {
+      if (!strcmp(e->d_name, ".") || !strcmp(e->d_name, "..")) continue;
+      std::string child = dir + "/" + e->d_name;
+      struct stat st;
+      if (stat(child.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) removeTree(child, false);
+      else unlink(child.c_str());
+    }
+    closedir(d);
+  }
+  if (!keepRoot) rmdir(dir.c_str());
+}
+
+void cleanupTempRoot() { removeTree(flashRootDir(), false); }
+
+// Ctrl-C, `| head` (SIGPIPE) and kill end the process without atexit();
+// the temp root goes first, then the signal's default action. Not strictly
+// async-signal-safe, but the process is on its way out anyway.
+void cleanupOnSignal(int sig) {
+  cleanupTempRoot();
+  signal(sig, SIG_DFL);
+  raise(sig);
+}
+
+const std::string &hostRoot() {
+  std::string &root = flashRootDir();
+  if (root.empty()) {
+    const char *env = getenv("SIM_FLASH_ROOT");
+    if (env && *env) {
+      root = env;
+      ::mkdir(root.c_str(), 0755);
+    } else {
+      // Never fall back to a shared directory: format() wipes the root
+      char tmpl[] = "/tmp/greenhouse-flash-XXXXXX";
+      if (!mkdtemp(tmpl)) {
+        perror("sim: cannot create the flash directory (set SIM_FLASH_ROOT)");
+        exit(1);
+      }
+      root = tmpl;
+      atexit(cleanupTempRoot);
+      static const int SIGNALS[] = {SIGINT, SIGTERM, SIGHUP, SIGPIPE};
+      for (int sig : SIGNALS) signal(sig, cleanupOnSignal);
+    }
+  }
+  return root;
+}
+
+std::string hostPath(const char *path) {
+  std::string p = hostRoot();
+  if (!path || path[0] != '/') p += '/';
+  if (path) p += path;
+  return p;
+}
+
+void makeParents(const std::string &host) {
+  for (size_t i = hostRoot().size() + 1; i < host.size(); i++) {
+    if (host[i] == '/') ::mkdir(host.substr(0, i).c_str(), 0755);
+  }
+}
+
+void sumUsed(const std::string &dir, size_t &used) {
+  DIR *d = opendir(dir.c_str());
+  if (!d) return;
+  while (struct dirent *e = readdir(d)) {
+    if (!strcmp(e->d_name, ".") || !strcmp(e->d_name, "..")) continue;
+    std::string child = dir + "/" + e->d_name;
+    struct stat st;
+    if (stat(child.c_str(), &st) != 0) continue;
+    if (S_ISDIR(st.st_mode)) sumUsed(child, used);
+    else used += ((size_t)st.st_size + SIM_FLASH_BLOCK - 1) / SIM_FLASH_BLOCK * SIM_FLASH_BLOCK;
+  }
+  closedir(d);
+}
+
+}  // namespace
+
+class fs::FileImpl {
+public:
+  std::string path;
+  std::string name;
+  FILE *fp = nullptr;
+  bool append = false;
+  bool directory = false;
+  std::vector<std::string> entries;
+  size_t nextEntry = 0;
+  size_t dirtyFrom = SIZE_MAX;  // lowest offset written since the last sync
+
+  ~FileImpl() { close(); }
+
+  size_t size() const {
+    if (!fp) return 0;
+    long pos = ftell(fp);
+    fseek(fp, 0, SEEK_END);
+    long end = ftell(fp);
+    fseek(fp, pos, SEEK_SET);
+    return end < 0 ? 0 : (size_t)end;
+  }
+
+  // littlefs never rewrites in place: the block holding the first dirty byte
+  // and everything after it is programmed again, plus a metadata commit
+  void sync() {
+    if (!fp || dirtyFrom == SIZE_MAX) return;
+    fflush(fp);
+    size_t end = size();
+    sim::FlashStats &f = state().flash;
+    f.bytesProgrammed += end - dirtyFrom / SIM_FLASH_BLOCK * SIM_FLASH_BLOCK + SIM_FLASH_COMMIT;
+    f.syncs++;
+    dirtyFrom = SIZE_MAX;
+  }
+
+  void close() {
+    sync();
+    if (fp) fclose(fp);
+    fp = nullptr;
+  }
+};
+
+namespace fs {
+
+size_t File::write(const uint8_t *buf, size_t size) {
+  if (!p_ || !p_->fp) return 0;
+  if (p_->append) fseek(p_->fp, 0, SEEK_END);
+  long pos = ftell(p_->fp);
+  size_t n = fwrite(buf, 1, size, p_->fp);
+  if (n && pos >= 0 && (size_t)pos < p_->dirtyFrom) p_->dirtyFrom = (size_t)pos;
+  state().flash.bytesWritten += n;
+  return n;
+}
+
+int File::available() {
+  if (!p_ || !p_->fp) return 0;
+  long pos = ftell(p_->fp);
+  return pos < 0 ? 0 : (int)(p_->size() - (size_t)pos);
+}
+
+int File::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+size_t File::read(uint8_t *buf, size_t size) {
+  if (!p_ || !p_->fp) return 0;
+  fflush(p_->fp);
+  return fread(buf, 1, size, p_->fp);
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+  if (!p_ || !p_->fp) return false;
+  int whence = mode == SeekSet ? SEEK_SET : (mode == SeekCur ? SEEK_CUR : SEEK_END);
+  return fseek(p_->fp, (long)pos, whence) == 0;
+}
+
+size_t File::position() const {
+  if (!p_ || !p_->fp) return 0;
+  long pos = ftell(p_->fp);
+  return pos < 0 ? 0 : (size_t)pos;
+}
+
+size_t File::size() const { return p_ ? p_->size() : 0; }
+void File::flush() { if (p_) p_->sync(); }
+void File::close() { if (p_) p_->close(); p_.reset(); }
+File::operator bool() const { return p_ && (p_->fp || p_->directory); }
+const char *File::path() const { return p_ ? p_->path.c_str() : nullptr; }
+const char *File::name() const { return p_ ? p_->name.c_str() : nullptr; }
+boolean File::isDirectory() { return p_ && p_->directory; }
+
+File File::openNextFile(const char *mode) {
+  if (!p_ || !p_->directory || p_->nextEntry >= p_->entries.size()) return File();
+  std::string child = p_->path;
+  if (child.empty() || child.back() != '/') child += '/';
+  child += p_->entries[p_->nextEntry++];
+  return LittleFS.open(child.c_str(), mode);
+}
+
+void File::rewindDirectory() { if (p_) p_->nextEntry = 0; }
+
+File FS::open(const char *path, const char *mode, const bool create) {
+  (void)create;
+  std::string host = hostPath(path);
+  FileImplPtr impl = std::make_shared<FileImpl>();
+  impl->path = path;
+  size_t slash = impl->path.find_last_of('/');
+  impl->name = slash == std::string::npos ? impl->path : impl->path.substr(slash + 1);
+
+  struct stat st;
+  if (stat(host.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+    DIR *d = opendir(host.c_str());
+    if (!d) return File();
+    while (struct dirent *e = readdir(d)) {
+      if (strcmp(e->d_name, ".") && strcmp(e->d_name, "..")) impl->entries.push_back(e->d_name);
+    }
+    closedir(d);
+    impl->directory = true;
+    return File(impl);
+  }
+
+  const char *hostMode = "rb";
+  if (mode[0] == 'w') hostMode = mode[1] == '+' ? "w+b" : "wb";
+  else if (mode[0] == 'a') hostMode = mode[1] == '+' ? "a+b" : "ab";
+  else if (mode[1] == '+') hostMode = "r+b";
+  if (mode[0] != 'r') makeParents(host);
+  impl->fp = fopen(host.c_str(), hostMode);
+  if (!impl->fp) return File();
+  impl->append = mode[0] == 'a';
+  if (mode[0] == 'w') impl->dirtyFrom = 0;  // truncation rewrites the file
+  return File(impl);
+}
+
+bool FS::exists(const char *path) {
+  struct stat st;
+  return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char *path) { return unlink(hostPath(path).c_str()) == 0; }
+
+bool FS::rename(const char *pathFrom, const char *pathTo) {
+  return ::rename(hostPath(pathFrom).c_str(), hostPath(pathTo).c_str()) == 0;
+}
+
+bool FS::mkdir(const char *path) {
+  std::string host = hostPath(path);
+  makeParents(host);
+  return ::mkdir(host.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+bool FS::rmdir(const char *path) { return ::rmdir(hostPath(path).c_str()) == 0; }
+
+bool LittleFSFS::format() {
+  removeTree(hostRoot(), true);
+  return true;
+}
+
+size_t LittleFSFS::totalBytes() { return SIM_FLASH_SIZE; }
+
+size_t LittleFSFS::usedBytes() {
+  size_t used = 0;
+  sumUsed(hostRoot(), used);
+  return used;
+}
+
+}  // namespace fs
+
+// ==================== NETWORK / LED ====================
+
+// Assumed timings, not measurements: an all-channel active scan plus the
+// handshake, a directed connect to a known BSSID/channel, and DHCP
+#define SIM_WIFI_SCAN_US 2200000
+#define SIM_WIFI_DIRECTED_US 150000
+#define SIM_WIFI_DIRECTED_MISS_US 300000  // probe on the cached channel gets no answer
+#define SIM_WIFI_DHCP_US 800000
+#define SIM_WIFI_STATIC_US 5000
+
+static void wifiEvent(arduino_event_id_t id, const arduino_event_info_t &info) {
+  for (WiFiEventFuncCb cb : state().wifiHandlers) {
+    if (cb) cb(id, info);
+  }
+}
+
+static void wifiDisconnected(uint8_t reason) {
+  arduino_event_info_t info = {};
+  info.wifi_sta_disconnected.reason = reason;
+  wifiEvent(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, info);
+}
+
+// The IDF event task, run whenever virtual time moves
+static void wifiTick() {
+  SimState &s = state();
+  if (s.wifiLinked && !s.wifiAp) {
+    s.wifiLinked = false;
+    wifiDisconnected(WIFI_REASON_BEACON_TIMEOUT);
+  }
+  if (s.wifiFailAtUs && s.clockUs >= s.wifiFailAtUs) {
+    s.wifiFailAtUs = 0;
+    wifiDisconnected(s.wifiFailReason);
+  }
+  if (s.wifiAssocAtUs && s.clockUs >= s.wifiAssocAtUs) {
+    s.wifiAssocAtUs = 0;
+    if (!s.wifiAp) {
+      wifiDisconnected(WIFI_REASON_NO_AP_FOUND);
+      return;
+    }
+    arduino_event_info_t info = {};
+    memcpy(info.wifi_sta_connected.bssid, s.wifiApBssid, 6);
+    info.wifi_sta_connected.channel = (uint8_t)s.wifiApChannel;
+    wifiEvent(ARDUINO_EVENT_WIFI_STA_CONNECTED, info);
+    s.wifiIpAtUs = s.clockUs + (s.wifiStatic ? SIM_WIFI_STATIC_US : SIM_WIFI_DHCP_US);
+  }
+  if (s.wifiIpAtUs && s.clockUs >= s.wifiIpAtUs) {
+    s.wifiIpAtUs = 0;
+    s.wifiLinked = true;
+    arduino_event_info_t info = {};
+    info.got_ip.ip_info.ip.addr = 0x1402A8C0;  // 192.168.2.20, network order
+    wifiEvent(ARDUINO_EVENT_WIFI_STA_GOT_IP, info);
+  }
+}
+
+wl_status_t WiFiClass::begin(const char *ssid, const char *passphrase, int32_t channel,
+                             const uint8_t *bssid, bool connect) {
+  (void)ssid; (void)passphrase; (void)connect;
+  SimState &s = state();
+  s.wifiLinked = false;
+  s.wifiAssocAtUs = s.wifiIpAtUs = s.wifiFailAtUs = 0;
+  if (channel && bssid) {
+    if (s.wifiAp && channel == s.wifiApChannel && !memcmp(bssid, s.wifiApBssid, 6)) {
+      s.wifiAssocAtUs = s.clockUs + SIM_WIFI_DIRECTED_US;
+    } else {
+      s.wifiFailAtUs = s.clockUs + SIM_WIFI_DIRECTED_MISS_US;
+      s.wifiFailReason = WIFI_REASON_NO_AP_FOUND;
+    }
+  } else if (s.wifiAp) {
+    s.wifiAssocAtUs = s.clockUs + SIM_WIFI_SCAN_US;
+  } else {
+    s.wifiFailAtUs = s.clockUs + SIM_WIFI_SCAN_US;
+    s.wifiFailReason = WIFI_REASON_NO_AP_FOUND;
+  }
+  return WL_DISCONNECTED;
+}
+
+bool WiFiClass::config(IPAddress local, IPAddress gateway, IPAddress subnet, IPAddress dns1, IPAddress dns2) {
+  (void)gateway; (void)subnet; (void)dns1; (void)dns2;
+  state().wifiStatic = local[0] || local[1] || local[2] || local[3];
+  return true;
+}
+
+bool WiFiClass::mode(wifi_mode_t m) { (void)m; return true; }
+void WiFiClass::persistent(bool persistent) { (void)persistent; }
+bool WiFiClass::setAutoReconnect(bool autoReconnect) { (void)autoReconnect; return true; }
+
+int WiFiClass::onEvent(WiFiEventFuncCb cb, arduino_event_id_t event) {
+  (void)event;  // handlers here see every event and filter themselves
+  for (int i = 0; i < 4; i++) {
+    if (!state().wifiHandlers[i]) {
+      state().wifiHandlers[i] = cb;
+      return i;
+    }
+  }
+  return -1;
+}
+
+wl_status_t WiFiClass::status() {
+  wifiTick();
+  return state().wifiLinked ? WL_CONNECTED : WL_DISCONNECTED;
+}
+int8_t WiFiClass::RSSI() { return state().wifiLinked ? state().rssi : 0; }
+IPAddress WiFiClass::localIP() { return state().wifiLinked ? IPAddress(192, 168, 2, 20) : IPAddress(); }
+IPAddress WiFiClass::gatewayIP() { return state().wifiLinked ? IPAddress(192, 168, 2, 1) : IPAddress(); }
+IPAddress WiFiClass::subnetMask() { return state().wifiLinked ? IPAddress(255, 255, 255, 0) : IPAddress(); }
+IPAddress WiFiClass::dnsIP(uint8_t n) { return state().wifiLinked && !n ? IPAddress(192, 168, 2, 1) : IPAddress(); }
+uint8_t *WiFiClass::BSSID() {
+  SimState &s = state();
+  if (!s.wifiLinked) return nullptr;
+  memcpy(s.wifiBssidOut, s.wifiApBssid, 6);
+  return s.wifiBssidOut;
+}
+int32_t WiFiClass::channel() { return state().wifiLinked ? state().wifiApChannel : 0; }
+
+bool WiFiClass::disconnect(bool wifioff) {
+  (void)wifioff;
+  SimState &s = state();
+  bool active = s.wifiLinked || s.wifiAssocAtUs || s.wifiIpAtUs || s.wifiFailAtUs;
+  s.wifiLinked = false;
+  s.wifiAssocAtUs = s.wifiIpAtUs = s.wifiFailAtUs = 0;
+  if (active) wifiDisconnected(WIFI_REASON_ASSOC_LEAVE);
+  return true;
+}
+
+int HTTPClient::POST(const String &payload) {
+  (void)payload;
+  return state().remoteHttpCode;
+}
+
+void CFastLED::show() { state().ledShows++; }
+
+AsyncWebServer::AsyncWebServer(uint16_t port) {
+  (void)port;
+  state().server = this;
+}
+
+AsyncWebServer::~AsyncWebServer() {
+  if (state().server == this) state().server = nullptr;
+}
+
+void AsyncWebServer::dispatch(AsyncWebServerRequest *request, const uint8_t *body, size_t len) {
+  for (const Route &r : routes_) {
+    if (!(r.method & request->method()) || !(r.uri == request->url())) continue;
+    sim::HandlerScope handler;
+    if (r.onBody && body) r.onBody(request, const_cast<uint8_t *>(body), len, 0, len);
+    if (!request->response() && r.onRequest) r.onRequest(request);
+    return;
+  }
+  sim::HandlerScope handler;
+  if (notFound_) notFound_(request);
+}
+
+// ==================== SIM CONTROLS ====================
+
+namespace sim {
+
+uint64_t nowUs() { return state().clockUs; }
+void advanceMs(uint32_t ms) {
+  state().clockUs += (uint64_t)ms * 1000;
+  wifiTick();
+}
+void advanceUs(uint64_t us) {
+  state().clockUs += us;
+  wifiTick();
+}
+uint64_t blockedUs() { return state().blockedUs; }
+
+void setBmp280(bool present, float temperatureC, float pressurePa) {
+  state().bmpPresent = present;
+  state().bmpTemperature = temperatureC;
+  state().bmpPressurePa = pressurePa;
+}
+
+void setBh1750(bool present, float lux) {
+  SimState &s = state();
+  if (present && !s.bh1750Present) {  // plugged back in: power-on reset
+    s.bhPowered = false;
+    s.bhMode = 0;
+    s.bhMtreg = 69;
+    s.bhConverting = false;
+  }
+  s.bh1750Present = present;
+  s.bh1750Lux = lux;
+}
+
+void setSoilTrace(const uint16_t *samples, size_t count) {
+  state().soilTrace.assign(samples, samples + count);
+  state().soilTracePos = 0;
+}
+
+void setSoilAdc(int raw, int noise) {
+  state().soilTrace.clear();
+  state().soilRaw = raw;
+  state().soilNoise = noise;
+}
+
+void attachI2C(uint8_t bus, uint8_t address, bool present) {
+  if (bus < SIM_I2C_BUSES && address < 128) state().i2cDevice[bus][address] = present;
+}
+
+bool i2cPresent(uint8_t bus, uint8_t address) {
+  return bus < SIM_I2C_BUSES && address < 128 && state().i2cDevice[bus][address];
+}
+
+void stallI2C(uint8_t bus, uint8_t address, bool stalled) {
+  if (bus < SIM_I2C_BUSES && address < 128) state().i2cStall[bus][address] = stalled;
+}
+
+void stickI2CBus(uint8_t bus, int pulses) {
+  if (bus < SIM_I2C_BUSES) state().i2cStuckPulses[bus] = pulses;
+}
+
+I2CStats i2cStats(uint8_t bus) { return bus < SIM_I2C_BUSES ? state().i2c[bus] : I2CStats{}; }
+
+void setWiFiAp(bool up) { state().wifiAp = up; }
+void setWiFiApChannel(int channel) { state().wifiApChannel = channel; }
+void setRssi(int8_t rssi) { state().rssi = rssi; }
+void setNtpSynced(bool synced) { state().ntpSynced = synced; }
+void setRemoteHttpCode(int code) { state().remoteHttpCode = code; }
+int gpioLevel(uint8_t pin) { return digitalRead(pin); }
+uint32_t ledShows() { return state().ledShows; }
+
+void setSerialEcho(bool echo) { state().serialEcho = echo; }
+void setSerialCapture(std::string *out) { state().serialCapture = out; }
+void setSerialBaud(uint32_t baud) {
+  state().serialBaud = baud;
+  state().serialFifoEmptyUs = state().clockUs;
+}
+size_t serialBytes() { return state().serialBytes; }
+
+HeapStats heap() { return HeapStats{gLiveBytes, gPeakBytes, gAllocations, gHandlerAllocations}; }
+void resetHeapPeak() { gPeakBytes = gLiveBytes; }
+HandlerScope::HandlerScope() { gHandlerDepth++; }
+HandlerScope::~HandlerScope() { gHandlerDepth--; }
+LibraryScope::LibraryScope() { gLibraryDepth++; }
+LibraryScope::~LibraryScope() { gLibraryDepth--; }
+
+static std::string &capturedBody() {
+  static std::string body;
+  return body;
+}
+
+// "Name: value\n" lines of the last response; a fixed buffer so the heap
+// numbers of the HTTP benches stay the handler's own
+static char gLastHeaders[1024];
+
+HttpResult httpRequest(uint8_t method, const char *url, const char *body, const char *headers) {
+  HttpResult result{0, 0, 0, 0, 0};
+  AsyncWebServer *server = state().server;
+  if (!server) return result;
+  bool capture = state().captureBody;
+  if (capture) capturedBody().clear();
+
+  auto t0 = std::chrono::steady_clock::now();
+  AsyncWebServerRequest request((WebRequestMethod)method, String(url));
+  for (const char *line = headers; line && *line;) {
+    const char *end = strchr(line, '\n');
+    size_t len = end ? (size_t)(end - line) : strlen(line);
+    const char *colon = (const char *)memchr(line, ':', len);
+    if (colon) {
+      const char *value = colon + 1;
+      while (*value == ' ') value++;
+      request.addHeader(String(std::string(line, colon - line)),
+                        String(std::string(value, line + len - value)));
+    }
+    line = end ? end + 1 : line + len;
+  }
+  server->dispatch(&request, (const uint8_t *)body, body ? strlen(body) : 0);
+  AsyncWebServerResponse *r = request.response();
+  if (!r) return result;
+
+  result.code = r->code();
+  result.headerCount = r->headers().size();
+  size_t used = 0;
+  gLastHeaders[0] = '\0';
+  for (const String &h : r->headers()) {
+    int n = snprintf(gLastHeaders + used, sizeof(gLastHeaders) - used, "%s\n", h.c_str());
+    if (n < 0 || (size_t)n >= sizeof(gLastHeaders) - used) break;
+    used += n;
+  }
+  if (!r->streamed()) {
+    result.ttfbNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - t0).count();
+    result.bytes = r->content().length();
+    result.chunks = 1;
+    if (capture) capturedBody() = r->content().c_str();
+    return result;
+  }
+
+  static uint8_t chunk[SIM_TCP_CHUNK];  // the TCP send buffer, not the handler's heap
+  size_t n;
+  while ((n = r->fill(chunk, sizeof(chunk))) > 0 && n != RESPONSE_TRY_AGAIN) {
+    if (result.chunks++ == 0) {
+      result.ttfbNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+    }
+    result.bytes += n;
+    if (capture) capturedBody().append((const char *)chunk, n);
+  }
+  return result;
+}
+
+struct HttpStream {
+  AsyncWebServerRequest request;
+  HttpStream(const char *url) : request(HTTP_GET, String(url)) {}
+};
+
+HttpStream *openStream(const char *url, int *code) {
+  AsyncWebServer *server = state().server;
+  if (code) *code = 0;
+  if (!server) return nullptr;
+  HttpStream *s = new HttpStream(url);
+  server->dispatch(&s->request, nullptr, 0);
+  if (code && s->request.response()) *code = s->request.response()->code();
+  return s;
+}
+
+size_t pollStream(HttpStream *s, std::string *out) {
+  AsyncWebServerResponse *r = s ? s->request.response() : nullptr;
+  if (!r || !r->streamed()) return 0;
+  static uint8_t chunk[SIM_TCP_CHUNK];
+  size_t total = 0, n;
+  while ((n = r->fill(chunk, sizeof(chunk))) > 0 && n != RESPONSE_TRY_AGAIN) {
+    total += n;
+    if (out) out->append((const char *)chunk, n);
+  }
+  return total;
+}
+
+void closeStream(HttpStream *s) { delete s; }
+
+void setFlashRoot(const char *dir) {
+  flashRootDir() = dir ? dir : "";
+  if (dir) ::mkdir(dir, 0755);
+}
+
+const char *flashRoot() { return hostRoot().c_str(); }
+void formatFlash() { LittleFS.format(); }
+void eraseNvs() { nvs().clear(); }
+FlashStats flashStats() { return state().flash; }
+void resetFlashStats() { state().flash = FlashStats{}; }
+
+bool truncateFlashFile(const char *path, size_t size) {
+  return ::truncate(hostPath(path).c_str(), (off_t)size) == 0;
+}
+
+void setCaptureBody(bool capture) { state().captureBody = capture; }
+const char *lastBody() { return capturedBody().c_str(); }
+
+const char *lastHeader(const char *name, char *value, size_t size) {
+  size_t nameLen = strlen(name);
+  for (const char *line = gLastHeaders; *line;) {
+    const char *end = strchr(line, '\n');
+    if (!end) break;
+    if (strncasecmp(line, name, nameLen) == 0 && line[nameLen] == ':') {
+      const char *v = line + nameLen + 1;
+      while (*v == ' ') v++;
+      snprintf(value, size, "%.*s", (int)(end - v), v);
+      return value;
+    }
+    line = end + 1;
+  }
+  return nullptr;
+}
+
+void reset() {
+  SimState &s = state();
+  AsyncWebServer *server = s.server;
+  s = SimState();  // flash contents persist, like a reboot
+  s.server = server;
+  defaultDevices();
+}
+
+}  // namespace sim
@@ -0,0 +1,114 @@
+/*
+ * BH1750 one-time conversions with auto-ranging (see bh1750_auto.h).
+ */
+#include "bh1750_auto.h"
+
+const Bh1750Range Bh1750::RANGES[BH1750_RANGE_COUNT] = {
+  {BH1750_ONE_TIME_H2, 180},
+  {BH1750_ONE_TIME_H2, BH1750_MTREG_DEFAULT},
+  {BH1750_ONE_TIME_H, BH1750_MTREG_DEFAULT},
+  {BH1750_ONE_TIME_H, 31}
+};
+
+bool Bh1750::command(I2cTransfer &t, uint8_t op) {
+  t.prepare(&op, 1, 0);
+  return device_->submit(t);
+}
+
+bool Bh1750::begin(I2cDevice &device) {
+  device_ = &device;
+  ready_ = false;
+  range_ = 0;
+  mtregSet_ = 0;
+  converting_ = false;
+  readQueued_ = false;
+  for (uint8_t op : {(uint8_t)BH1750_POWER_ON, (uint8_t)BH1750_POWER_DOWN}) {
+    commands_[0].prepare(&op, 1, 0);
+    I2cStatus st = device_->transfer(commands_[0]);
+    commands_[0].release();
+    if (st != I2C_OK) return false;
+  }
+  ready_ = true;
+  return true;
+}
+
+bool Bh1750::start(unsigned long nowMs) {
+  if (!ready_ || commands_[0].pending() || commands_[1].pending() || commands_[2].pending() || read_.pending()) {
+    return false;
+  }
+  const Bh1750Range &r = RANGES[range_];
+  commandCount_ = 0;
+  if (mtregSet_ != r.mtreg) {
+    mtregSet_ = r.mtreg;  // optimistic; commandsFailed() forgets it again
+    if (!command(commands_[commandCount_++], BH1750_MTREG_HIGH | (r.mtreg >> 5)) ||
+        !command(commands_[commandCount_++], BH1750_MTREG_LOW | (r.mtreg & 0x1F))) {
+      mtregSet_ = 0;
+      return false;
+    }
+  }
+  if (!command(commands_[commandCount_++], r.mode)) return false;
+  converting_ = true;
+  readQueued_ = false;
+  startMs_ = nowMs;
+  waitMs_ = maxConversionMs(r);
+  return true;
+}
+
+// True if any opcode of the current conversion did not make it
+bool Bh1750::commandsFailed() {
+  bool failed = false;
+  for (uint8_t i = 0; i < commandCount_; i++) failed |= commands_[i].state() != I2C_OK;
+  if (failed) mtregSet_ = 0;
+  return failed;
+}
+
+Bh1750Status Bh1750::collect(unsigned long nowMs, float &lux) {
+  if (!converting_) return start(nowMs) ? BH1750_BUSY : BH1750_ERROR;
+  for (uint8_t i = 0; i < commandCount_; i++) {
+    if (commands_[i].pending()) return BH1750_BUSY;
+  }
+  if (nowMs - startMs_ < waitMs_) return BH1750_BUSY;
+  if (!readQueued_) {
+    read_.prepare(nullptr, 0, 2);
+    if (commandsFailed() || !device_->submit(read_)) {
+      converting_ = false;
+      return BH1750_ERROR;
+    }
+    readQueued_ = true;
+  }
+  if (read_.pending()) return BH1750_BUSY;
+  converting_ = false;
+  readQueued_ = false;
+  I2cStatus st = read_.state();
+  read_.release();
+  if (st != I2C_OK) return BH1750_ERROR;
+  counts_ = (uint16_t)((read_.rx[0] << 8) | read_.rx[1]);
+
+  uint8_t measured = range_;
+  countsRange_ = measured;
+  range_ = selectRange(measured, counts_);
+  if (counts_ == BH1750_SATURATED && range_ != measured) {
+    return start(nowMs) ? BH1750_RANGING : BH1750_ERROR;
+  }
+  lux = countsToLux(counts_, RANGES[measured]);
+  return BH1750_READY;
+}
+
+float Bh1750::countsToLux(uint16_t counts, const Bh1750Range &r) {
+  float lux = counts / 1.2f * BH1750_MTREG_DEFAULT / r.mtreg;
+  return r.mode == BH1750_ONE_TIME_H2 ? lux / 2 : lux;
+}
+
+// Datasheet maximum: 180 ms in H / H2 mode at MTreg 69, scaled by MTreg
+unsigned long Bh1750::maxConversionMs(const Bh1750Range &r) {
+  return (180UL * r.mtreg + BH1750_MTREG_DEFAULT - 1) / BH1750_MTREG_DEFAULT;
+}
+
+uint8_t Bh1750::selectRange(uint8_t range, uint16_t counts) {
+  if (counts >= BH1750_RANGE_UP_COUNTS) return range + 1 < BH1750_RANGE_COUNT ? range + 1 : range;
+  float lux = countsToLux(counts, RANGES[range]);
+  for (uint8_t r = 0; r < range; r++) {
+    if (lux * 2 <= countsToLux(BH1750_SATURATED, RANGES[r])) return r;
+  }
+  return range;
+}
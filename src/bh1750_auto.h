@@ -0,0 +1,92 @@
+/*
+ * BH1750 on the I2C engine: one-time conversions, auto-ranging, never blocks.
+ *
+ * The claws driver ran CONTINUOUS_HIGH_RES_MODE at the default MTreg 69:
+ * the chip stays powered, resolution is fixed at 0.83 lx and the count
+ * saturates at 54612 lx, well below full sun in a greenhouse. Here each
+ * sample is one one-time conversion (the chip powers itself down when it
+ * is done) and the measurement time register picks the range:
+ *
+ *   range  mode  MTreg  lx/count  full scale  max conversion
+ *     0     H2    180    0.16      10467 lx      470 ms
+ *     1     H2     69    0.42      27306 lx      180 ms
+ *     2     H      69    0.83      54612 lx      180 ms
+ *     3     H      31    1.85     121557 lx       81 ms
+ *
+ * start() queues the opcodes (i2c_engine.h) and returns; collect() does
+ * nothing on the bus until the datasheet's maximum conversion time has
+ * passed, then queues the two-byte read and picks it up on a later call. A saturated count moves up one range and re-measures
+ * right away; otherwise the most sensitive range whose full scale is at
+ * least twice the reading is used next (hysteresis against the 92 % step
+ * up). Times are passed in so the driver can be stepped on a virtual clock.
+ */
+#pragma once
+#include <Arduino.h>
+#include "i2c_engine.h"
+
+#define BH1750_POWER_DOWN 0x00
+#define BH1750_POWER_ON 0x01
+#define BH1750_ONE_TIME_H 0x20      // 1 lx / 1.2 at MTreg 69
+#define BH1750_ONE_TIME_H2 0x21     // 0.5 lx / 1.2 at MTreg 69
+#define BH1750_MTREG_HIGH 0x40      // 01000_MT[7:5]
+#define BH1750_MTREG_LOW 0x60       // 011_MT[4:0]
+#define BH1750_MTREG_DEFAULT 69
+#define BH1750_SATURATED 0xFFFF
+#define BH1750_RANGE_UP_COUNTS 60000  // ~92 % of full scale: next sample one range up
+#define BH1750_RANGE_COUNT 4
+
+struct Bh1750Range {
+  uint8_t mode;   // one-time opcode
+  uint8_t mtreg;  // 31..254
+};
+
+enum Bh1750Status : uint8_t {
+  BH1750_READY,    // new reading in lux
+  BH1750_BUSY,     // conversion or read still running
+  BH1750_RANGING,  // saturated: restarted one range up
+  BH1750_ERROR     // transfer failed or device missing; the next collect() starts over
+};
+
+class Bh1750 {
+public:
+  static const Bh1750Range RANGES[BH1750_RANGE_COUNT];  // most to least sensitive
+
+  // Power on then power down (synchronous); conversions start from range 0
+  bool begin(I2cDevice &device);
+
+  // Queues MTreg (only when the range changed) + one-time opcode
+  bool start(unsigned long nowMs);
+
+  // Starts a conversion if none is in flight; see Bh1750Status
+  Bh1750Status collect(unsigned long nowMs, float &lux);
+
+  bool present() const { return ready_ && device_->present(); }
+  uint8_t address() const { return device_ ? device_->address() : 0; }
+  uint8_t range() const { return range_; }     // used by the next conversion
+  uint16_t counts() const { return counts_; }  // last raw data register...
+  uint8_t countsRange() const { return countsRange_; }  // ...and the range it was read in
+  unsigned long conversionMs() const { return maxConversionMs(RANGES[range_]); }
+
+  static float countsToLux(uint16_t counts, const Bh1750Range &r);
+  static unsigned long maxConversionMs(const Bh1750Range &r);
+  // Range for the next sample after `counts` in `range`
+  static uint8_t selectRange(uint8_t range, uint16_t counts);
+
+private:
+  bool command(I2cTransfer &t, uint8_t op);
+  bool commandsFailed();
+
+  I2cDevice *device_ = nullptr;
+  bool ready_ = false;
+  I2cTransfer commands_[3];  // MTreg high, MTreg low, mode (in queue order)
+  I2cTransfer read_;
+  uint8_t commandCount_ = 0;
+  uint8_t range_ = 0;
+  uint8_t mtregSet_ = 0;  // MTreg last written (0 = unknown, write before the next start)
+  bool converting_ = false;
+  bool readQueued_ = false;
+  unsigned long startMs_ = 0;
+  unsigned long waitMs_ = 0;
+  uint16_t counts_ = 0;
+  uint8_t countsRange_ = 0;
+};
@@ -0,0 +1,120 @@
+/*
+ * BMP280 burst driver and Bosch integer compensation (see bmp280.h).
+ */
+#include "bmp280.h"
+
+// ctrl_meas: osrs_t x2 (010), osrs_p x16 (101), mode normal (11)
+#define BMP280_CTRL_MEAS_VALUE ((0x02 << 5) | (0x05 << 2) | 0x03)
+// config: t_sb 500 ms (100), filter x16 (100), no SPI3
+#define BMP280_CONFIG_VALUE ((0x04 << 5) | (0x04 << 2))
+
+bool Bmp280::readRegisters(uint8_t reg, uint8_t *buf, size_t len) {
+  setup_.prepare(&reg, 1, (uint8_t)len);
+  if (device_->transfer(setup_) != I2C_OK) return false;
+  memcpy(buf, setup_.rx, len);
+  setup_.release();
+  return true;
+}
+
+bool Bmp280::writeRegister(uint8_t reg, uint8_t value) {
+  const uint8_t data[2] = {reg, value};
+  setup_.prepare(data, 2, 0);
+  bool ok = device_->transfer(setup_) == I2C_OK;
+  setup_.release();
+  return ok;
+}
+
+bool Bmp280::begin(I2cDevice &device) {
+  device_ = &device;
+  ready_ = false;
+  uint8_t id = 0;
+  uint8_t calib[BMP280_CALIB_BYTES];
+  if (!readRegisters(BMP280_REG_CHIP_ID, &id, 1) || id != BMP280_CHIP_ID ||
+      !readRegisters(BMP280_REG_CALIB, calib, sizeof(calib))) {
+    return false;
+  }
+  parseCalibration(calib, calib_);
+  // config is only guaranteed to take effect in sleep mode, so write it first
+  if (!writeRegister(BMP280_REG_CTRL_MEAS, 0x00) || !writeRegister(BMP280_REG_CONFIG, BMP280_CONFIG_VALUE) ||
+      !writeRegister(BMP280_REG_CTRL_MEAS, BMP280_CTRL_MEAS_VALUE)) {
+    return false;
+  }
+  ready_ = true;
+  return true;
+}
+
+bool Bmp280::startRead() {
+  if (!ready_) return false;
+  const uint8_t reg = BMP280_REG_DATA;
+  burst_.prepare(&reg, 1, BMP280_DATA_BYTES);
+  return device_->submit(burst_);
+}
+
+Bmp280Status Bmp280::pollRead(Bmp280Sample &out) {
+  I2cStatus st = burst_.state();
+  if (st == I2C_PENDING) return BMP280_BUSY;
+  burst_.release();
+  return st == I2C_OK && decode(calib_, burst_.rx, out) ? BMP280_READY : BMP280_ERROR;
+}
+
+bool Bmp280::read(Bmp280Sample &out) {
+  if (!ready_) return false;
+  const uint8_t reg = BMP280_REG_DATA;
+  burst_.prepare(&reg, 1, BMP280_DATA_BYTES);
+  if (device_->transfer(burst_) != I2C_OK) return false;
+  burst_.release();
+  return decode(calib_, burst_.rx, out);
+}
+
+void Bmp280::parseCalibration(const uint8_t *r, Bmp280Calibration &c) {
+  auto u16 = [r](int i) { return (uint16_t)(r[i] | (r[i + 1] << 8)); };
+  c.T1 = u16(0);
+  c.T2 = (int16_t)u16(2);
+  c.T3 = (int16_t)u16(4);
+  c.P1 = u16(6);
+  c.P2 = (int16_t)u16(8);
+  c.P3 = (int16_t)u16(10);
+  c.P4 = (int16_t)u16(12);
+  c.P5 = (int16_t)u16(14);
+  c.P6 = (int16_t)u16(16);
+  c.P7 = (int16_t)u16(18);
+  c.P8 = (int16_t)u16(20);
+  c.P9 = (int16_t)u16(22);
+}
+
+int32_t Bmp280::compensateTemperature(const Bmp280Calibration &c, int32_t adcT, int32_t *tFine) {
+  int32_t var1 = ((((adcT >> 3) - ((int32_t)c.T1 << 1))) * ((int32_t)c.T2)) >> 11;
+  int32_t d = (adcT >> 4) - (int32_t)c.T1;
+  int32_t var2 = ((int32_t)(((int64_t)d * d) >> 12) * ((int32_t)c.T3)) >> 14;  // square can pass 2^31 at the range ends
+  *tFine = var1 + var2;
+  return (*tFine * 5 + 128) >> 8;
+}
+
+// Shifts of signed values written as multiplies (same result, no UB)
+uint32_t Bmp280::compensatePressure(const Bmp280Calibration &c, int32_t adcP, int32_t tFine) {
+  int64_t var1 = (int64_t)tFine - 128000;
+  int64_t var2 = var1 * var1 * (int64_t)c.P6;
+  var2 = var2 + var1 * (int64_t)c.P5 * 131072;
+  var2 = var2 + (int64_t)c.P4 * ((int64_t)1 << 35);
+  var1 = ((var1 * var1 * (int64_t)c.P3) >> 8) + var1 * (int64_t)c.P2 * 4096;
+  var1 = ((((int64_t)1 << 47) + var1) * (int64_t)c.P1) >> 33;
+  if (var1 == 0) return 0;  // avoid division by zero
+  int64_t p = 1048576 - adcP;
+  p = ((p * ((int64_t)1 << 31) - var2) * 3125) / var1;
+  var1 = ((int64_t)c.P9 * (p >> 13) * (p >> 13)) >> 25;
+  var2 = ((int64_t)c.P8 * p) >> 19;
+  p = ((p + var1 + var2) >> 8) + (int64_t)c.P7 * 16;
+  return (uint32_t)p;
+}
+
+bool Bmp280::decode(const Bmp280Calibration &c, const uint8_t *d, Bmp280Sample &out) {
+  int32_t adcP = (int32_t)(((uint32_t)d[0] << 12) | ((uint32_t)d[1] << 4) | (d[2] >> 4));
+  int32_t adcT = (int32_t)(((uint32_t)d[3] << 12) | ((uint32_t)d[4] << 4) | (d[5] >> 4));
+  if (adcT == BMP280_ADC_SKIPPED || adcP == BMP280_ADC_SKIPPED) return false;
+  int32_t tFine;
+  out.rawTemperature = adcT;
+  out.rawPressure = adcP;
+  out.temperatureCenti = compensateTemperature(c, adcT, &tFine);
+  out.pressureQ8 = compensatePressure(c, adcP, tFine);
+  return out.pressureQ8 != 0;
+}
@@ -0,0 +1,94 @@
+/*
+ * BMP280 on the I2C engine, one burst per sample.
+ *
+ * The Adafruit driver reads temperature (pointer write + 3 bytes), then
+ * for pressure reads temperature again to get t_fine and then pressure:
+ * three register transactions and the temperature compensation twice per
+ * sample. Here a single pointer write to 0xF7 is followed by one 6-byte
+ * read of press_msb..temp_xlsb (the chip shadows the data registers for
+ * the whole burst, so both values come from the same conversion), and the
+ * Bosch integer compensation runs once: 32-bit for temperature, 64-bit
+ * for pressure, exactly as in the datasheet (BST-BMP280-DS001, 3.11.3 and
+ * 8.2). No floats until the caller asks for them.
+ *
+ * Transfers go through the I2C engine (i2c_engine.h): startRead() queues
+ * the burst and pollRead() picks it up, so the acquisition task never
+ * waits on the bus. begin() runs its transfers synchronously.
+ */
+#pragma once
+#include <Arduino.h>
+#include "i2c_engine.h"
+
+#define BMP280_CHIP_ID 0x58
+#define BMP280_REG_CALIB 0x88     // dig_T1 .. dig_P9, 24 bytes little-endian
+#define BMP280_REG_CHIP_ID 0xD0
+#define BMP280_REG_RESET 0xE0
+#define BMP280_REG_CTRL_MEAS 0xF4
+#define BMP280_REG_CONFIG 0xF5
+#define BMP280_REG_DATA 0xF7      // press msb/lsb/xlsb, temp msb/lsb/xlsb
+#define BMP280_CALIB_BYTES 24
+#define BMP280_DATA_BYTES 6
+#define BMP280_ADC_SKIPPED 0x80000  // reset value: measurement off or not done yet
+
+struct Bmp280Calibration {
+  uint16_t T1;
+  int16_t T2, T3;
+  uint16_t P1;
+  int16_t P2, P3, P4, P5, P6, P7, P8, P9;
+};
+
+enum Bmp280Status : uint8_t {
+  BMP280_READY,  // sample decoded
+  BMP280_BUSY,   // burst queued or on the bus
+  BMP280_ERROR   // not started, bus error, device missing or skipped measurement
+};
+
+// One conversion, raw and compensated together
+struct Bmp280Sample {
+  int32_t rawTemperature;    // 20-bit adc_T
+  int32_t rawPressure;       // 20-bit adc_P
+  int32_t temperatureCenti;  // 0.01 degC
+  uint32_t pressureQ8;       // Pa in Q24.8
+  float temperature() const { return temperatureCenti / 100.0f; }
+  float pressurePa() const { return pressureQ8 / 256.0f; }
+};
+
+class Bmp280 {
+public:
+  // Checks the chip id, reads the trimming parameters and starts NORMAL
+  // mode with the settings the firmware always used (T x2, P x16, IIR x16,
+  // 500 ms standby)
+  bool begin(I2cDevice &device);
+
+  // Queues the pointer write + 6-byte burst; false if the device is missing
+  bool startRead();
+  // Result of the queued burst; the sample is untouched unless READY
+  Bmp280Status pollRead(Bmp280Sample &out);
+  // startRead() and wait (bench, begin paths)
+  bool read(Bmp280Sample &out);
+
+  bool present() const { return ready_ && device_->present(); }
+  // A burst was queued and its result not taken yet by pollRead()
+  bool requested() const { return burst_.state() != I2C_IDLE; }
+  uint8_t address() const { return device_ ? device_->address() : 0; }
+  const Bmp280Calibration &calibration() const { return calib_; }
+
+  static void parseCalibration(const uint8_t *raw, Bmp280Calibration &out);
+  // Datasheet bmp280_compensate_T_int32: returns 0.01 degC, sets t_fine
+  static int32_t compensateTemperature(const Bmp280Calibration &c, int32_t adcT, int32_t *tFine);
+  // Datasheet bmp280_compensate_P_int64: returns Pa in Q24.8 (0 if the
+  // trimming parameters are invalid)
+  static uint32_t compensatePressure(const Bmp280Calibration &c, int32_t adcP, int32_t tFine);
+  // Decodes a burst and compensates; false for skipped measurements
+  static bool decode(const Bmp280Calibration &c, const uint8_t *data, Bmp280Sample &out);
+
+private:
+  bool readRegisters(uint8_t reg, uint8_t *buf, size_t len);
+  bool writeRegister(uint8_t reg, uint8_t value);
+
+  I2cDevice *device_ = nullptr;
+  bool ready_ = false;  // begin() succeeded
+  I2cTransfer setup_;   // begin(): id, trimming parameters, config
+  I2cTransfer burst_;
+  Bmp280Calibration calib_ = {};
+};
@@ -0,0 +1,161 @@
+/*
+ * Live push channel behind /events (Server-Sent Events).
+ *
+ * The acquisition task appends small events (sensor deltas past their
+ * deadband, watering changes, new history points) to EventLog, a fixed
+ * ring with one writer. Each /events client is a long-lived chunked
+ * response whose filler, running on the network core, copies events past
+ * its own cursor into the socket - so the acquisition task never touches
+ * a connection and a slow client only ever falls behind itself.
+ *
+ * Entries are seqlocked individually (seqlock.h): a reader lapped by the
+ * writer sees a different id and resyncs instead of sending a torn event.
+ *
+ * Wire format per event:
+ *   event: sensors
+ *   data: {"temperature":23.41,"timestamp":81234}
+ *
+ * A new client first gets `retry:` and a `snapshot` event carrying the
+ * full /api body, then only deltas; `: ping` comments keep idle
+ * connections alive, and a client that fell more than EVENT_LOG_ENTRIES
+ * behind gets a `resync` event (reload /api) and continues from the head.
+ */
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include "seqlock.h"
+
+#define EVENT_LOG_ENTRIES 32
+#define EVENT_TYPE_MAX 12       // including the terminator
+#define EVENT_DATA_MAX 192
+#define EVENTS_RETRY_MS 3000    // client reconnect delay announced on connect
+#define EVENTS_HEARTBEAT_MS 15000
+
+class EventLog {
+public:
+  struct Event {
+    uint32_t id;
+    char type[EVENT_TYPE_MAX];
+    uint16_t length;
+    char data[EVENT_DATA_MAX];
+  };
+
+  // Single writer. Data longer than EVENT_DATA_MAX is dropped, not cut.
+  bool push(const char *type, const char *data, size_t length) {
+    if (length > EVENT_DATA_MAX) return false;
+    uint32_t id = head_.load(std::memory_order_relaxed);
+    Event e;
+    e.id = id;
+    snprintf(e.type, sizeof(e.type), "%s", type);
+    e.length = (uint16_t)length;
+    memcpy(e.data, data, length);
+    entries_[id % EVENT_LOG_ENTRIES].publish(e);
+    head_.store(id + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Id the next push() will get
+  uint32_t head() const { return head_.load(std::memory_order_acquire); }
+
+  // false if event `id` was not written yet or has been overwritten
+  bool read(uint32_t id, Event &out) const {
+    if ((int32_t)(head() - id) <= 0) return false;
+    out = entries_[id % EVENT_LOG_ENTRIES].read();
+    return out.id == id && out.length <= EVENT_DATA_MAX;
+  }
+
+private:
+  Seqlock<Event> entries_[EVENT_LOG_ENTRIES];
+  std::atomic<uint32_t> head_{0};
+};
+
+// One /events client. fill() returns 0 bytes when there is nothing to send;
+// the handler maps that to RESPONSE_TRY_AGAIN so the stream stays open.
+class EventStream {
+public:
+  explicit EventStream(const EventLog &log) : log_(log), next_(log.head()) {}
+
+  // Body of the initial `snapshot` event; must outlive the stream
+  void setSnapshot(const char *data, size_t length) {
+    snapshot_ = data;
+    snapshotLen_ = length;
+  }
+
+  size_t fill(uint8_t *buf, size_t maxLen, uint32_t nowMs) {
+    size_t written = 0;
+    while (written < maxLen) {
+      if (pendingPos_ == pendingLen_ && !renderNext(nowMs)) break;
+      size_t n = pendingLen_ - pendingPos_;
+      if (n > maxLen - written) n = maxLen - written;
+      memcpy(buf + written, pending_ + pendingPos_, n);
+      pendingPos_ += n;
+      written += n;
+    }
+    if (written) lastSendMs_ = nowMs;
+    return written;
+  }
+
+  uint32_t sent() const { return sent_; }
+  bool snapshotSent() const { return started_ && !snapshot_; }
+
+private:
+  bool renderNext(uint32_t nowMs) {
+    if (!started_) {
+      started_ = true;
+      lastSendMs_ = nowMs;
+      if (!snapshot_) return set("retry: %u\n\n", EVENTS_RETRY_MS);
+      // Snapshot body goes out in pieces; pending_ holds one piece at a time
+      return set("retry: %u\nevent: snapshot\ndata: ", EVENTS_RETRY_MS);
+    }
+    if (snapshot_) {
+      size_t n = snapshotLen_ - snapshotPos_;
+      if (n == 0) {
+        snapshot_ = nullptr;
+        return set("\n\n");
+      }
+      if (n > sizeof(pending_)) n = sizeof(pending_);
+      memcpy(pending_, snapshot_ + snapshotPos_, n);
+      snapshotPos_ += n;
+      pendingLen_ = n;
+      pendingPos_ = 0;
+      return true;
+    }
+    if (next_ != log_.head()) {
+      EventLog::Event e;
+      if (!log_.read(next_, e)) {
+        next_ = log_.head();  // lapped: skip to now and have the client reload
+        return set("event: resync\ndata: {}\n\n");
+      }
+      next_++;
+      sent_++;
+      return set("event: %s\ndata: %.*s\n\n", e.type, (int)e.length, e.data);
+    }
+    if (nowMs - lastSendMs_ >= EVENTS_HEARTBEAT_MS) {
+      lastSendMs_ = nowMs;
+      return set(": ping\n\n");
+    }
+    return false;
+  }
+
+  template <typename... Args>
+  bool set(const char *fmt, Args... args) {
+    int n = snprintf(pending_, sizeof(pending_), fmt, args...);
+    pendingLen_ = n < 0 ? 0 : ((size_t)n >= sizeof(pending_) ? sizeof(pending_) - 1 : (size_t)n);
+    pendingPos_ = 0;
+    return true;
+  }
+
+  const EventLog &log_;
+  uint32_t next_;
+  uint32_t sent_ = 0;
+  uint32_t lastSendMs_ = 0;
+  bool started_ = false;
+  const char *snapshot_ = nullptr;
+  size_t snapshotLen_ = 0;
+  size_t snapshotPos_ = 0;
+  char pending_[EVENT_DATA_MAX + EVENT_TYPE_MAX + 24];
+  size_t pendingLen_ = 0;
+  size_t pendingPos_ = 0;
+};
@@ -0,0 +1,190 @@
+/*
+ * Per-sensor denoising: a short chain of stages every accepted sample
+ * passes through before it becomes the published value.
+ *
+ *   median(n)     running median of the last n samples (odd, <= 7); drops
+ *                 isolated spikes without lagging a step change by more
+ *                 than n/2 samples
+ *   ewma(alpha)   y += alpha * (x - y)
+ *   kalman(q, r)  1-D constant-level Kalman filter: q = process noise
+ *                 (how fast the true value may wander per sample, unit^2),
+ *                 r = measurement noise (unit^2); settles at a gain of
+ *                 roughly sqrt(q / r)
+ *
+ * Everything lives inline in the chain, so filtering never allocates. A
+ * failed read resets the state; the first sample after that passes
+ * through unchanged, so a reconnected sensor does not ramp up from stale
+ * values. FilterConfig is trivially copyable and can be published through
+ * a Seqlock from the web handlers to the acquisition task.
+ */
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#define FILTER_MAX_STAGES 3
+#define FILTER_MEDIAN_MAX 7
+
+enum FilterKind : uint8_t {
+  FILTER_NONE,
+  FILTER_MEDIAN,
+  FILTER_EWMA,
+  FILTER_KALMAN
+};
+
+struct FilterStageConfig {
+  FilterKind kind;
+  float a;  // median: window, ewma: alpha, kalman: q
+  float b;  // kalman: r
+};
+
+struct FilterConfig {
+  FilterStageConfig stages[FILTER_MAX_STAGES];
+  uint8_t count;
+};
+
+inline FilterStageConfig filterMedian(int window) { return {FILTER_MEDIAN, (float)window, 0}; }
+inline FilterStageConfig filterEwma(float alpha) { return {FILTER_EWMA, alpha, 0}; }
+inline FilterStageConfig filterKalman(float q, float r) { return {FILTER_KALMAN, q, r}; }
+
+inline const char *filterKindName(FilterKind kind) {
+  switch (kind) {
+    case FILTER_MEDIAN: return "median";
+    case FILTER_EWMA: return "ewma";
+    case FILTER_KALMAN: return "kalman";
+    default: return "none";
+  }
+}
+
+// Parameters in range? (window odd and 1..FILTER_MEDIAN_MAX, 0 < alpha <= 1, q, r > 0)
+inline bool filterStageValid(const FilterStageConfig &c) {
+  switch (c.kind) {
+    case FILTER_MEDIAN: {
+      int n = (int)c.a;
+      return n == c.a && n >= 1 && n <= FILTER_MEDIAN_MAX && (n & 1);
+    }
+    case FILTER_EWMA: return c.a > 0 && c.a <= 1;
+    case FILTER_KALMAN: return c.a > 0 && c.b > 0 && !isinf(c.a) && !isinf(c.b);
+    default: return false;
+  }
+}
+
+// "median(3) > kalman(0.05,1)", or "none"
+inline size_t describeFilter(const FilterConfig &config, char *out, size_t size) {
+  size_t len = 0;
+  if (size) out[0] = '\0';
+  if (config.count == 0) return (size_t)snprintf(out, size, "none");
+  for (uint8_t i = 0; i < config.count && len < size; i++) {
+    const FilterStageConfig &c = config.stages[i];
+    const char *sep = i ? " > " : "";
+    int n;
+    if (c.kind == FILTER_MEDIAN) n = snprintf(out + len, size - len, "%smedian(%d)", sep, (int)c.a);
+    else if (c.kind == FILTER_EWMA) n = snprintf(out + len, size - len, "%sewma(%g)", sep, (double)c.a);
+    else n = snprintf(out + len, size - len, "%skalman(%g,%g)", sep, (double)c.a, (double)c.b);
+    len += n > 0 ? (size_t)n : 0;
+  }
+  return len;
+}
+
+class FilterStage {
+public:
+  void configure(const FilterStageConfig &config) {
+    config_ = config;
+    reset();
+  }
+
+  void reset() {
+    primed_ = false;
+    count_ = head_ = 0;
+  }
+
+  float apply(float x) {
+    switch (config_.kind) {
+      case FILTER_MEDIAN: return median(x);
+      case FILTER_EWMA:
+        y_ = primed_ ? y_ + config_.a * (x - y_) : x;
+        primed_ = true;
+        return y_;
+      case FILTER_KALMAN:
+        if (!primed_) {
+          y_ = x;
+          p_ = config_.b;  // first estimate is as uncertain as one measurement
+          primed_ = true;
+          return y_;
+        } else {
+          float p = p_ + config_.a;
+          float k = p / (p + config_.b);
+          y_ += k * (x - y_);
+          p_ = (1 - k) * p;
+          return y_;
+        }
+      default: return x;
+    }
+  }
+
+  const FilterStageConfig &config() const { return config_; }
+
+private:
+  // Insertion sort of at most FILTER_MEDIAN_MAX values: cheaper than
+  // keeping a sorted window at these sizes
+  float median(float x) {
+    uint8_t n = (uint8_t)config_.a;
+    window_[head_] = x;
+    head_ = (uint8_t)((head_ + 1) % n);
+    if (count_ < n) count_++;
+    float sorted[FILTER_MEDIAN_MAX];
+    for (uint8_t i = 0; i < count_; i++) {
+      float v = window_[i];
+      int j = i;
+      while (j > 0 && sorted[j - 1] > v) {
+        sorted[j] = sorted[j - 1];
+        j--;
+      }
+      sorted[j] = v;
+    }
+    return count_ & 1 ? sorted[count_ / 2] : 0.5f * (sorted[count_ / 2 - 1] + sorted[count_ / 2]);
+  }
+
+  FilterStageConfig config_ = {FILTER_NONE, 0, 0};
+  bool primed_ = false;
+  float y_ = 0;
+  float p_ = 0;
+  float window_[FILTER_MEDIAN_MAX];
+  uint8_t count_ = 0;
+  uint8_t head_ = 0;
+};
+
+class FilterChain {
+public:
+  FilterChain() { config_.count = 0; }
+  FilterChain(FilterStageConfig s0) { configure({{s0}, 1}); }
+  FilterChain(FilterStageConfig s0, FilterStageConfig s1) { configure({{s0, s1}, 2}); }
+  FilterChain(FilterStageConfig s0, FilterStageConfig s1, FilterStageConfig s2) { configure({{s0, s1, s2}, 3}); }
+
+  // Invalid stages are dropped, so a bad config degrades to fewer stages
+  void configure(const FilterConfig &config) {
+    config_.count = 0;
+    for (uint8_t i = 0; i < config.count && i < FILTER_MAX_STAGES; i++) {
+      if (!filterStageValid(config.stages[i])) continue;
+      config_.stages[config_.count] = config.stages[i];
+      stages_[config_.count].configure(config.stages[i]);
+      config_.count++;
+    }
+  }
+
+  void reset() {
+    for (uint8_t i = 0; i < config_.count; i++) stages_[i].reset();
+  }
+
+  float apply(float x) {
+    for (uint8_t i = 0; i < config_.count; i++) x = stages_[i].apply(x);
+    return x;
+  }
+
+  const FilterConfig &config() const { return config_; }
+
+private:
+  FilterConfig config_;
+  FilterStage stages_[FILTER_MAX_STAGES];
+};
@@ -0,0 +1,218 @@
+/*
+ * History ring buffer types and the streaming /history serializer.
+ */
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// History storage - 24 hours of data (one reading every 5 minutes)
+#define MAX_HISTORY_POINTS 288  // 24 hours at 5-minute intervals (24*60/5=288)
+
+struct SensorReading {
+  float temperature;
+  float pressure;
+  float lightLevel;
+  float soilMoisture;
+  unsigned long timestamp;
+};
+
+// Emits the /history JSON document ({"temperature":[..],"pressure":[..],
+// "light":[..],"soil":[..],"timestamps":[..]}) straight from the ring,
+// one token at a time. Memory use is this object (~64 bytes) regardless
+// of how many points are in the ring; plug fill() into a chunked response.
+class HistoryJsonStream {
+public:
+  HistoryJsonStream(const SensorReading *ring, int capacity, int start, int count)
+    : ring_(ring), capacity_(capacity), start_(start), count_(count) {}
+
+  // Copies up to maxLen bytes of the document into buf; 0 once it is complete
+  size_t fill(uint8_t *buf, size_t maxLen) {
+    size_t written = 0;
+    while (written < maxLen) {
+      if (pendingPos_ == pendingLen_ && !renderNext()) break;
+      size_t n = pendingLen_ - pendingPos_;
+      if (n > maxLen - written) n = maxLen - written;
+      memcpy(buf + written, pending_ + pendingPos_, n);
+      pendingPos_ += n;
+      written += n;
+    }
+    return written;
+  }
+
+private:
+  enum { COLUMNS = 5 };
+
+  // Renders the next token (column header, one value, or the closing brace)
+  bool renderNext() {
+    static const char *const HEADS[COLUMNS] = {
+      "{\"temperature\":[", "],\"pressure\":[", "],\"light\":[", "],\"soil\":[", "],\"timestamps\":["
+    };
+    if (column_ == COLUMNS) {
+      if (done_) return false;
+      done_ = true;
+      return set("]}", 2);
+    }
+    if (row_ < 0) {
+      row_ = 0;
+      return set(HEADS[column_], strlen(HEADS[column_]));
+    }
+    if (row_ == count_) {
+      column_++;
+      row_ = -1;
+      return renderNext();
+    }
+
+    const SensorReading &r = ring_[(start_ + row_) % capacity_];
+    char *p = pending_;
+    if (row_ > 0) *p++ = ',';
+    size_t room = sizeof(pending_) - (p - pending_);
+    int n;
+    switch (column_) {
+      case 0: n = formatFloat(p, room, r.temperature); break;
+      case 1: n = formatFloat(p, room, r.pressure); break;
+      case 2: n = formatFloat(p, room, r.lightLevel != -1 ? r.lightLevel : 0); break;
+      case 3: n = formatFloat(p, room, r.soilMoisture >= 0 ? r.soilMoisture : 0); break;
+      default: n = snprintf(p, room, "%lu", r.timestamp); break;
+    }
+    row_++;
+    return set(nullptr, (p - pending_) + n);
+  }
+
+  static int formatFloat(char *p, size_t room, float v) {
+    if (isnan(v) || isinf(v)) return snprintf(p, room, "null");
+    return snprintf(p, room, "%.7g", (double)v);
+  }
+
+  bool set(const char *text, size_t len) {
+    if (text) memcpy(pending_, text, len);
+    pendingLen_ = (uint8_t)len;
+    pendingPos_ = 0;
+    return true;
+  }
+
+  const SensorReading *ring_;
+  int capacity_;
+  int start_;
+  int count_;
+  int column_ = 0;
+  int row_ = -1;       // -1 = column header not emitted yet
+  bool done_ = false;
+  char pending_[32];
+  uint8_t pendingLen_ = 0;
+  uint8_t pendingPos_ = 0;
+};
+
+// Compact /history.bin encoding (little-endian varints throughout):
+//
+//   'G' 'H' 'B' 0x01          magic + format version
+//   varint count              points per column
+//   u8 columns                5: temperature, pressure, light, soil, timestamp
+//   per column: varint scale, u8 order
+//   per column: count zig-zag varints
+//
+// Values are sent as round(value * scale). order 1 = first value absolute,
+// then deltas; order 2 = delta-of-delta (the 5-minute timestamps collapse
+// to ~1 byte each). light/soil use the same 0-for-missing rule as /history.
+#define HISTORY_BIN_VERSION 1
+#define HISTORY_BIN_COLUMNS 5
+
+class HistoryBinaryStream {
+public:
+  HistoryBinaryStream(const SensorReading *ring, int capacity, int start, int count)
+    : ring_(ring), capacity_(capacity), start_(start), count_(count) {}
+
+  // Same contract as HistoryJsonStream::fill()
+  size_t fill(uint8_t *buf, size_t maxLen) {
+    size_t written = 0;
+    while (written < maxLen) {
+      if (pendingPos_ == pendingLen_ && !renderNext()) break;
+      size_t n = pendingLen_ - pendingPos_;
+      if (n > maxLen - written) n = maxLen - written;
+      memcpy(buf + written, pending_ + pendingPos_, n);
+      pendingPos_ += n;
+      written += n;
+    }
+    return written;
+  }
+
+  // 0.01 °C, 0.01 hPa, 0.1 lux, 0.1 %, 1 s
+  static uint32_t columnScale(int column) {
+    static const uint32_t SCALES[HISTORY_BIN_COLUMNS] = {100, 100, 10, 10, 1};
+    return SCALES[column];
+  }
+  static uint8_t columnOrder(int column) { return column == HISTORY_BIN_COLUMNS - 1 ? 2 : 1; }
+
+private:
+  bool renderNext() {
+    pendingPos_ = 0;
+    pendingLen_ = 0;
+    if (column_ < 0) {
+      pending_[pendingLen_++] = 'G';
+      pending_[pendingLen_++] = 'H';
+      pending_[pendingLen_++] = 'B';
+      pending_[pendingLen_++] = HISTORY_BIN_VERSION;
+      putVarint((uint64_t)count_);
+      pending_[pendingLen_++] = HISTORY_BIN_COLUMNS;
+      for (int c = 0; c < HISTORY_BIN_COLUMNS; c++) {
+        putVarint(columnScale(c));
+        pending_[pendingLen_++] = columnOrder(c);
+      }
+      column_ = 0;
+      return true;
+    }
+    if (row_ == count_) {
+      if (++column_ == HISTORY_BIN_COLUMNS) column_ = HISTORY_BIN_COLUMNS + 1;
+      row_ = 0;
+    }
+    if (column_ > HISTORY_BIN_COLUMNS || count_ == 0) return false;
+
+    int64_t v = fixedValue(ring_[(start_ + row_) % capacity_], column_);
+    int64_t out;
+    if (row_ == 0) {
+      out = v;
+    } else {
+      int64_t delta = v - prev_;
+      out = (columnOrder(column_) == 2 && row_ > 1) ? delta - prevDelta_ : delta;
+      prevDelta_ = delta;
+    }
+    prev_ = v;
+    row_++;
+    putVarint(((uint64_t)out << 1) ^ (uint64_t)(out >> 63));  // zig-zag
+    return true;
+  }
+
+  static int64_t fixedValue(const SensorReading &r, int column) {
+    float v;
+    switch (column) {
+      case 0: v = r.temperature; break;
+      case 1: v = r.pressure; break;
+      case 2: v = r.lightLevel != -1 ? r.lightLevel : 0; break;
+      case 3: v = r.soilMoisture >= 0 ? r.soilMoisture : 0; break;
+      default: return (int64_t)r.timestamp;
+    }
+    if (isnan(v) || isinf(v)) v = -999;  // firmware error indicator
+    return (int64_t)llround((double)v * columnScale(column));
+  }
+
+  void putVarint(uint64_t v) {
+    while (v >= 0x80) {
+      pending_[pendingLen_++] = (uint8_t)(v | 0x80);
+      v >>= 7;
+    }
+    pending_[pendingLen_++] = (uint8_t)v;
+  }
+
+  const SensorReading *ring_;
+  int capacity_;
+  int start_;
+  int count_;
+  int column_ = -1;    // -1 = header not emitted yet
+  int row_ = 0;
+  int64_t prev_ = 0;
+  int64_t prevDelta_ = 0;
+  uint8_t pending_[48];
+  uint8_t pendingLen_ = 0;
+  uint8_t pendingPos_ = 0;
+};
@@ -0,0 +1,459 @@
+/*
+ * Segment store for persistent history (format and policy in history_store.h).
+ */
+#include <Arduino.h>
+#include "history_store.h"
+
+static void put16(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+  put16(p, (uint16_t)v);
+  put16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t get16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t get32(const uint8_t *p) { return get16(p) | ((uint32_t)get16(p + 2) << 16); }
+
+// Fixed-point with a sentinel for the firmware's error values (-999 / -1)
+static int16_t toFixed16(float v, float scale, bool valid) {
+  if (!valid || isnan(v)) return INT16_MIN;
+  float f = roundf(v * scale);
+  if (f < -32767.0f) return -32767;
+  if (f > 32767.0f) return 32767;
+  return (int16_t)f;
+}
+
+// CRC-16/CCITT-FALSE
+uint16_t HistoryStore::crc16(const uint8_t *p, size_t len) {
+  uint16_t crc = 0xFFFF;
+  while (len--) {
+    crc ^= (uint16_t)(*p++) << 8;
+    for (int i = 0; i < 8; i++) crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+  }
+  return crc;
+}
+
+void HistoryStore::packRecord(uint8_t *p, const SensorReading &r) {
+  put32(p, (uint32_t)r.timestamp);
+  put16(p + 4, (uint16_t)toFixed16(r.temperature, 100.0f, r.temperature > -300));
+  uint16_t pressure = 0xFFFF;
+  if (!isnan(r.pressure) && r.pressure >= 0) {
+    float f = roundf(r.pressure * 10.0f);
+    pressure = f > 65534.0f ? 65534 : (uint16_t)f;
+  }
+  put16(p + 6, pressure);
+  uint32_t light = 0xFFFFFFFF;
+  if (!isnan(r.lightLevel) && r.lightLevel >= 0) {
+    double f = round((double)r.lightLevel * 10.0);
+    light = f > 4294967294.0 ? 0xFFFFFFFE : (uint32_t)f;
+  }
+  put32(p + 8, light);
+  put16(p + 12, (uint16_t)toFixed16(r.soilMoisture, 10.0f, true));
+  put16(p + 14, crc16(p, HISTORY_RECORD_SIZE - 2));
+}
+
+bool HistoryStore::unpackRecord(const uint8_t *p, SensorReading &r) {
+  if (crc16(p, HISTORY_RECORD_SIZE - 2) != get16(p + 14)) return false;
+  int16_t temperature = (int16_t)get16(p + 4);
+  uint16_t pressure = get16(p + 6);
+  uint32_t light = get32(p + 8);
+  int16_t soil = (int16_t)get16(p + 12);
+  r.timestamp = get32(p);
+  r.temperature = temperature == INT16_MIN ? -999.0f : temperature / 100.0f;
+  r.pressure = pressure == 0xFFFF ? -999.0f : pressure / 10.0f;
+  r.lightLevel = light == 0xFFFFFFFF ? -1.0f : (float)(light / 10.0);
+  r.soilMoisture = soil == INT16_MIN ? -1.0f : soil / 10.0f;
+  return true;
+}
+
+void HistoryStore::segmentPath(char *out, size_t len, uint32_t seq) const {
+  snprintf(out, len, "%s/%08lx.seg", dir_, (unsigned long)seq);
+}
+
+static bool parseSegmentName(const char *name, uint32_t &seq) {
+  const char *slash = strrchr(name, '/');
+  if (slash) name = slash + 1;
+  if (strlen(name) != 12 || strcmp(name + 8, ".seg") != 0) return false;
+  char *end;
+  seq = (uint32_t)strtoul(name, &end, 16);
+  return end == name + 8;
+}
+
+bool HistoryStore::begin(fs::FS &fs, const char *dir) {
+  unsigned long t0 = micros();
+  fs_ = &fs;
+  strncpy(dir_, dir, sizeof(dir_) - 1);
+  segmentCount_ = 0;
+  tailSealed_ = false;
+  lastTimestamp_ = 0;
+  pendingCount_ = 0;
+  stats_ = HistoryStoreStats();
+
+  if (!fs.exists(dir) && !fs.mkdir(dir)) return false;
+  File root = fs.open(dir);
+  if (!root || !root.isDirectory()) return false;
+
+  // Keep the newest HISTORY_MAX_SEGMENTS sequence numbers, sorted ascending
+  uint32_t seqs[HISTORY_MAX_SEGMENTS];
+  size_t found = 0;
+  bool evicted = false;
+  for (File f = root.openNextFile(); f; f = root.openNextFile()) {
+    uint32_t seq;
+    if (f.isDirectory() || !parseSegmentName(f.name(), seq)) continue;
+    if (found == HISTORY_MAX_SEGMENTS) {
+      evicted = true;
+      if (seq < seqs[0]) continue;
+      memmove(seqs, seqs + 1, (--found) * sizeof(uint32_t));
+    }
+    size_t i = found++;
+    while (i > 0 && seqs[i - 1] > seq) {
+      seqs[i] = seqs[i - 1];
+      i--;
+    }
+    seqs[i] = seq;
+  }
+  root.close();
+
+  // Leftovers from an interrupted rotation
+  if (evicted) {
+    char path[40];
+    File again = fs.open(dir);
+    for (File f = again.openNextFile(); f; f = again.openNextFile()) {
+      uint32_t seq;
+      if (f.isDirectory() || !parseSegmentName(f.name(), seq) || seq >= seqs[0]) continue;
+      f.close();
+      segmentPath(path, sizeof(path), seq);
+      fs.remove(path);
+    }
+  }
+
+  // Headers and sizes only; the tail segment also gets its last records checked
+  indexWriteBegin();
+  for (size_t i = 0; i < found; i++) {
+    Segment seg;
+    if (loadSegment(seqs[i], seg, i == found - 1)) {
+      segments_[segmentCount_++] = seg;
+    } else {
+      char path[40];
+      segmentPath(path, sizeof(path), seqs[i]);
+      fs.remove(path);  // unreadable header: nothing in it can be trusted
+    }
+  }
+  indexWriteEnd();
+
+  // Newest timestamp on flash, so appends keep every segment in time order
+  for (int i = segmentCount_ - 1; i >= 0 && lastTimestamp_ == 0; i--) {
+    if (!segments_[i].count) continue;
+    char path[40];
+    segmentPath(path, sizeof(path), segments_[i].seq);
+    File f = fs.open(path, FILE_READ);
+    if (f) lastTimestamp_ = timestampAt(f, segments_[i].count - 1);
+  }
+
+  stats_.recoveryUs = (uint32_t)(micros() - t0);
+  return true;
+}
+
+bool HistoryStore::loadSegment(uint32_t seq, Segment &seg, bool isTail) {
+  char path[40];
+  segmentPath(path, sizeof(path), seq);
+  File f = fs_->open(path, FILE_READ);
+  if (!f) return false;
+
+  uint8_t head[HISTORY_SEGMENT_HEADER + HISTORY_RECORD_SIZE];
+  size_t size = f.size();
+  size_t n = f.read(head, sizeof(head));
+  if (n < HISTORY_SEGMENT_HEADER || memcmp(head, "GHTS", 4) != 0 || head[4] != HISTORY_STORE_VERSION ||
+      head[5] != HISTORY_RECORD_SIZE || get32(head + 8) != seq ||
+      crc16(head, HISTORY_SEGMENT_HEADER - 2) != get16(head + HISTORY_SEGMENT_HEADER - 2)) {
+    return false;
+  }
+
+  seg.seq = seq;
+  seg.count = (uint32_t)((size - HISTORY_SEGMENT_HEADER) / HISTORY_RECORD_SIZE);
+  if (seg.count > HISTORY_SEGMENT_RECORDS) seg.count = HISTORY_SEGMENT_RECORDS;
+  seg.firstTimestamp = n == sizeof(head) ? get32(head + HISTORY_SEGMENT_HEADER) : 0;
+  if (!isTail) return true;
+
+  // A power cut can only have damaged the last batch: walk back over records
+  // that fail their CRC (bounded by the largest batch), then seal the segment
+  bool torn = (size - HISTORY_SEGMENT_HEADER) % HISTORY_RECORD_SIZE != 0;
+  if (torn) stats_.droppedRecords++;
+  uint8_t rec[HISTORY_RECORD_SIZE];
+  SensorReading r;
+  for (int walked = 0; seg.count > 0 && walked <= HISTORY_MAX_FLUSH_RECORDS; walked++) {
+    f.seek(HISTORY_SEGMENT_HEADER + (seg.count - 1) * HISTORY_RECORD_SIZE);
+    if (f.read(rec, sizeof(rec)) == sizeof(rec) && unpackRecord(rec, r)) break;
+    seg.count--;
+    stats_.droppedRecords++;
+    torn = true;
+  }
+  if (seg.count == 0) seg.firstTimestamp = 0;
+  if (torn) tailSealed_ = true;  // appends continue in a fresh segment
+  return true;
+}
+
+uint32_t HistoryStore::timestampAt(File &f, uint32_t index) const {
+  uint8_t ts[4];
+  if (!f.seek(HISTORY_SEGMENT_HEADER + index * HISTORY_RECORD_SIZE) || f.read(ts, sizeof(ts)) != sizeof(ts)) return 0;
+  return get32(ts);
+}
+
+uint8_t HistoryStore::copyIndex(Segment *out) const {
+  uint32_t seq;
+  uint8_t n;
+  do {
+    while ((seq = indexSeq_.load(std::memory_order_acquire)) & 1) {}
+    n = segmentCount_;
+    memcpy(out, segments_, n * sizeof(Segment));
+  } while (indexSeq_.load(std::memory_order_acquire) != seq);
+  return n;
+}
+
+bool HistoryStore::openNewSegment(File &f) {
+  uint32_t seq = segmentCount_ ? segments_[segmentCount_ - 1].seq + 1 : 0;
+  char path[40];
+
+  // Rotation: drop the oldest week whole (no partial rewrites)
+  if (segmentCount_ == HISTORY_MAX_SEGMENTS) {
+    segmentPath(path, sizeof(path), segments_[0].seq);
+    fs_->remove(path);
+    indexWriteBegin();
+    memmove(segments_, segments_ + 1, (--segmentCount_) * sizeof(Segment));
+    indexWriteEnd();
+  }
+
+  segmentPath(path, sizeof(path), seq);
+  f = fs_->open(path, FILE_WRITE, true);
+  if (!f) return false;
+
+  uint8_t head[HISTORY_SEGMENT_HEADER];
+  memcpy(head, "GHTS", 4);
+  head[4] = HISTORY_STORE_VERSION;
+  head[5] = HISTORY_RECORD_SIZE;
+  put16(head + 6, HISTORY_SEGMENT_RECORDS);
+  put32(head + 8, seq);
+  put16(head + 12, 0);
+  put16(head + 14, crc16(head, HISTORY_SEGMENT_HEADER - 2));
+  if (f.write(head, sizeof(head)) != sizeof(head)) {
+    f.close();
+    fs_->remove(path);
+    return false;
+  }
+  stats_.bytesAppended += sizeof(head);
+
+  indexWriteBegin();
+  Segment seg = {seq, 0, 0};
+  segments_[segmentCount_++] = seg;
+  indexWriteEnd();
+  tailSealed_ = false;
+  return true;
+}
+
+bool HistoryStore::append(const SensorReading &r) {
+  if (!fs_ || (uint32_t)r.timestamp < lastTimestamp_) {
+    stats_.droppedRecords++;
+    return false;
+  }
+  if (pendingCount_ == HISTORY_MAX_FLUSH_RECORDS) {
+    // Flash keeps failing: drop the oldest queued reading rather than block
+    memmove(pending_, pending_ + HISTORY_RECORD_SIZE, (HISTORY_MAX_FLUSH_RECORDS - 1) * HISTORY_RECORD_SIZE);
+    pendingCount_--;
+    stats_.droppedRecords++;
+  }
+  packRecord(pending_ + pendingCount_ * HISTORY_RECORD_SIZE, r);
+  pendingCount_++;
+  lastTimestamp_ = (uint32_t)r.timestamp;
+  return pendingCount_ < flushRecords_ || flush();
+}
+
+bool HistoryStore::flush() {
+  if (!fs_) return false;
+  uint8_t done = 0;
+  while (done < pendingCount_) {
+    File f;
+    Segment *tail = segmentCount_ ? &segments_[segmentCount_ - 1] : nullptr;
+    if (!tail || tailSealed_ || tail->count >= HISTORY_SEGMENT_RECORDS) {
+      if (!openNewSegment(f)) {
+        stats_.writeErrors++;
+        break;
+      }
+      tail = &segments_[segmentCount_ - 1];
+    } else {
+      char path[40];
+      segmentPath(path, sizeof(path), tail->seq);
+      f = fs_->open(path, FILE_APPEND);
+      if (!f) {
+        stats_.writeErrors++;
+        tailSealed_ = true;
+        break;
+      }
+    }
+
+    uint32_t n = pendingCount_ - done;
+    if (n > HISTORY_SEGMENT_RECORDS - tail->count) n = HISTORY_SEGMENT_RECORDS - tail->count;
+    const uint8_t *src = pending_ + done * HISTORY_RECORD_SIZE;
+    size_t written = f.write(src, n * HISTORY_RECORD_SIZE);
+    f.close();  // one sync per batch
+    stats_.bytesAppended += written;
+    stats_.syncs++;
+
+    uint32_t complete = (uint32_t)(written / HISTORY_RECORD_SIZE);
+    indexWriteBegin();
+    if (tail->count == 0 && complete) tail->firstTimestamp = get32(src);
+    tail->count += complete;
+    indexWriteEnd();
+    done += complete;
+    if (complete != n) {
+      stats_.writeErrors++;
+      tailSealed_ = true;  // a partial record may sit at the end now
+      break;
+    }
+  }
+
+  if (done) {
+    memmove(pending_, pending_ + done * HISTORY_RECORD_SIZE, (pendingCount_ - done) * HISTORY_RECORD_SIZE);
+    pendingCount_ -= done;
+  }
+  return pendingCount_ == 0;
+}
+
+void HistoryStore::setFlushRecords(uint8_t n) {
+  if (n < 1) n = 1;
+  if (n > HISTORY_MAX_FLUSH_RECORDS) n = HISTORY_MAX_FLUSH_RECORDS;
+  flushRecords_ = n;
+  if (pendingCount_ >= flushRecords_) flush();
+}
+
+HistoryStore::Cursor HistoryStore::query(uint32_t from, uint32_t to) const {
+  Cursor c;
+  Segment segs[HISTORY_MAX_SEGMENTS];
+  uint8_t n = copyIndex(segs);
+  if (!fs_ || n == 0 || from > to) return c;
+
+  // Last segment starting at or before `from`, then binary search inside it
+  uint8_t i = 0;
+  while (i + 1 < n && segs[i + 1].count && segs[i + 1].firstTimestamp <= from) i++;
+
+  char path[40];
+  segmentPath(path, sizeof(path), segs[i].seq);
+  File f = fs_->open(path, FILE_READ);
+  uint32_t lo = 0, hi = segs[i].count;
+  while (f && lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (timestampAt(f, mid) < from) lo = mid + 1;
+    else hi = mid;
+  }
+
+  c.store_ = this;
+  c.seq_ = segs[i].seq;
+  c.lastSeq_ = segs[n - 1].seq;
+  c.record_ = lo;
+  c.from_ = from;
+  c.to_ = to;
+  c.done_ = false;
+  if (f && f.seek(HISTORY_SEGMENT_HEADER + lo * HISTORY_RECORD_SIZE)) c.file_ = f;
+  return c;
+}
+
+size_t HistoryStore::readLatest(SensorReading *out, size_t max) const {
+  Segment segs[HISTORY_MAX_SEGMENTS];
+  uint8_t n = copyIndex(segs);
+  if (!fs_ || n == 0 || max == 0) return 0;
+
+  // Walk back from the tail until `max` records are covered
+  int i = n - 1;
+  uint32_t startRecord = 0;
+  size_t covered = 0;
+  for (; i >= 0; i--) {
+    if (covered + segs[i].count >= max) {
+      startRecord = segs[i].count - (uint32_t)(max - covered);
+      break;
+    }
+    covered += segs[i].count;
+  }
+  if (i < 0) i = 0;
+
+  Cursor c;
+  c.store_ = this;
+  c.seq_ = segs[i].seq;
+  c.lastSeq_ = segs[n - 1].seq;
+  c.record_ = startRecord;
+  c.from_ = 0;
+  c.to_ = UINT32_MAX;
+  c.done_ = false;
+  size_t got = 0;
+  while (got < max && c.next(out[got])) got++;
+  return got;
+}
+
+HistoryStoreStats HistoryStore::stats() const {
+  Segment segs[HISTORY_MAX_SEGMENTS];
+  uint8_t n = copyIndex(segs);
+  HistoryStoreStats s = stats_;
+  s.segments = n;
+  s.records = 0;
+  s.oldestTimestamp = 0;
+  for (uint8_t i = 0; i < n; i++) {
+    s.records += segs[i].count;
+    if (!s.oldestTimestamp && segs[i].count) s.oldestTimestamp = segs[i].firstTimestamp;
+  }
+  s.pending = pendingCount_;
+  s.newestTimestamp = lastTimestamp_;
+  return s;
+}
+
+bool HistoryStore::Cursor::refill() {
+  while (!done_) {
+    if (!file_) {
+      if (seq_ > lastSeq_) break;
+      char path[40];
+      store_->segmentPath(path, sizeof(path), seq_);
+      file_ = store_->fs_->open(path, FILE_READ);
+      if (!file_ || !file_.seek(HISTORY_SEGMENT_HEADER + record_ * HISTORY_RECORD_SIZE)) {
+        file_ = File();  // segment rotated away meanwhile
+        seq_++;
+        record_ = 0;
+        continue;
+      }
+    }
+    uint32_t want = BUFFER_RECORDS;
+    if (record_ + want > HISTORY_SEGMENT_RECORDS) want = HISTORY_SEGMENT_RECORDS - record_;
+    uint32_t n = want ? (uint32_t)(file_.read(buf_, want * HISTORY_RECORD_SIZE) / HISTORY_RECORD_SIZE) : 0;
+    if (n == 0) {
+      file_.close();
+      seq_++;
+      record_ = 0;
+      continue;
+    }
+    record_ += n;
+    bufLen_ = (uint8_t)n;
+    bufPos_ = 0;
+    return true;
+  }
+  done_ = true;
+  file_ = File();
+  return false;
+}
+
+bool HistoryStore::Cursor::next(SensorReading &out) {
+  for (;;) {
+    if (bufPos_ == bufLen_ && !refill()) return false;
+    const uint8_t *p = buf_ + (bufPos_++) * HISTORY_RECORD_SIZE;
+    if (!HistoryStore::unpackRecord(p, out)) {
+      skipped_++;
+      continue;
+    }
+    if (out.timestamp < from_) continue;
+    if (out.timestamp > to_) {
+      done_ = true;
+      file_ = File();
+      bufLen_ = bufPos_ = 0;
+      return false;
+    }
+    return true;
+  }
+}
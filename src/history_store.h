@@ -0,0 +1,173 @@
+/*
+ * Persistent history on LittleFS: weeks of 5-minute readings that survive a
+ * reboot, appended to fixed-size segment files and queried by time range
+ * without loading more than a few records into RAM.
+ *
+ * On flash (all little-endian):
+ *
+ *   /ts/<seq as 8 hex digits>.seg
+ *     header  'G' 'H' 'T' 'S', u8 version, u8 record size, u16 records per
+ *             segment, u32 seq, u16 reserved, u16 crc16 of bytes 0..13
+ *     records u32 timestamp, i16 temperature*100, u16 pressure*10,
+ *             u32 light*10, i16 soil*10, u16 crc16 of bytes 0..13
+ *
+ * Segments are only ever appended to and deleted whole, oldest first, once
+ * HISTORY_MAX_SEGMENTS exist. littlefs re-programs the partly filled tail
+ * block on every sync, so appends are batched HISTORY_FLUSH_RECORDS at a
+ * time to cut write amplification (the RAM ring still holds the newest
+ * points if power drops before a flush). A torn tail record is detected by
+ * its CRC at begin(); the damaged segment is sealed and appends continue in
+ * a fresh one, so recovery only ever reads the last few records.
+ */
+#pragma once
+#include <FS.h>
+#include <atomic>
+#include "history.h"
+
+#define HISTORY_STORE_DIR "/ts"
+#define HISTORY_SEGMENT_RECORDS 2016  // one week at 5-minute intervals (32 KB per segment)
+#define HISTORY_MAX_SEGMENTS 8        // ~8 weeks retained
+#ifndef HISTORY_FLUSH_RECORDS
+#define HISTORY_FLUSH_RECORDS 3       // one flash sync per 15 minutes of readings
+#endif
+#define HISTORY_MAX_FLUSH_RECORDS 12  // upper bound for setFlushRecords()
+#define HISTORY_RECORD_SIZE 16
+#define HISTORY_SEGMENT_HEADER 16
+#define HISTORY_STORE_VERSION 1
+
+struct HistoryStoreStats {
+  uint32_t segments;
+  uint32_t records;           // on flash, pending appends not included
+  uint32_t pending;
+  uint32_t oldestTimestamp;
+  uint32_t newestTimestamp;
+  uint32_t bytesAppended;     // header + record bytes handed to the filesystem
+  uint32_t syncs;
+  uint32_t droppedRecords;    // torn/corrupt records found at begin() or rejected appends
+  uint32_t writeErrors;
+  uint32_t recoveryUs;        // time spent in begin()
+};
+
+class HistoryStore {
+public:
+  // Reads segment records in time order, a small buffer at a time; records
+  // that fail their CRC are skipped. Keeps one file open while in use.
+  class Cursor {
+  public:
+    bool next(SensorReading &out);
+    uint32_t skipped() const { return skipped_; }
+
+  private:
+    friend class HistoryStore;
+    enum { BUFFER_RECORDS = 8 };
+    bool refill();
+
+    const HistoryStore *store_ = nullptr;
+    uint32_t seq_ = 0;
+    uint32_t lastSeq_ = 0;
+    uint32_t record_ = 0;       // next record index to read from the segment
+    uint32_t from_ = 0;
+    uint32_t to_ = 0;
+    bool done_ = true;
+    File file_;
+    uint8_t buf_[BUFFER_RECORDS * HISTORY_RECORD_SIZE];
+    uint8_t bufLen_ = 0;
+    uint8_t bufPos_ = 0;
+    uint32_t skipped_ = 0;
+  };
+
+  // Mounts the store under dir and recovers the tail segment
+  bool begin(fs::FS &fs, const char *dir = HISTORY_STORE_DIR);
+
+  // Queues one reading; timestamps must not go backwards (pre-NTP readings
+  // are rejected). Flushes when the batch is full.
+  bool append(const SensorReading &r);
+  bool flush();
+  void setFlushRecords(uint8_t n);
+
+  // Readings with from <= timestamp <= to, oldest first
+  Cursor query(uint32_t from, uint32_t to) const;
+
+  // The newest `max` readings on flash, oldest first; returns how many were read
+  size_t readLatest(SensorReading *out, size_t max) const;
+
+  HistoryStoreStats stats() const;
+
+  static uint16_t crc16(const uint8_t *p, size_t len);
+  static void packRecord(uint8_t *p, const SensorReading &r);
+  static bool unpackRecord(const uint8_t *p, SensorReading &r);
+
+private:
+  struct Segment {
+    uint32_t seq;
+    uint32_t firstTimestamp;
+    uint32_t count;
+  };
+
+  void segmentPath(char *out, size_t len, uint32_t seq) const;
+  bool loadSegment(uint32_t seq, Segment &seg, bool isTail);
+  bool openNewSegment(File &f);
+  uint32_t timestampAt(File &f, uint32_t index) const;
+  uint8_t copyIndex(Segment *out) const;
+  void indexWriteBegin() { indexSeq_.fetch_add(1, std::memory_order_relaxed); std::atomic_thread_fence(std::memory_order_release); }
+  void indexWriteEnd() { indexSeq_.fetch_add(1, std::memory_order_release); }
+
+  fs::FS *fs_ = nullptr;
+  char dir_[24] = {0};
+  // Index of the segments on flash, oldest first. Written by the appending
+  // task only; readers on other tasks copy it under indexSeq_ (seqlock).
+  Segment segments_[HISTORY_MAX_SEGMENTS];
+  uint8_t segmentCount_ = 0;
+  std::atomic<uint32_t> indexSeq_{0};
+  bool tailSealed_ = false;
+  uint32_t lastTimestamp_ = 0;
+
+  uint8_t pending_[HISTORY_MAX_FLUSH_RECORDS * HISTORY_RECORD_SIZE];
+  uint8_t pendingCount_ = 0;
+  uint8_t flushRecords_ = HISTORY_FLUSH_RECORDS;
+
+  HistoryStoreStats stats_ = {};
+};
+
+// Streams a Cursor as CSV (timestamp,temperature,pressure,light,soil) for a
+// chunked response; same fill() contract as HistoryJsonStream
+class HistoryCsvStream {
+public:
+  explicit HistoryCsvStream(const HistoryStore::Cursor &cursor) : cursor_(cursor) {}
+
+  size_t fill(uint8_t *buf, size_t maxLen) {
+    size_t written = 0;
+    while (written < maxLen) {
+      if (pendingPos_ == pendingLen_ && !renderNext()) break;
+      size_t n = pendingLen_ - pendingPos_;
+      if (n > maxLen - written) n = maxLen - written;
+      memcpy(buf + written, pending_ + pendingPos_, n);
+      pendingPos_ += n;
+      written += n;
+    }
+    return written;
+  }
+
+private:
+  bool renderNext() {
+    int n;
+    if (!headerDone_) {
+      headerDone_ = true;
+      n = snprintf(pending_, sizeof(pending_), "timestamp,temperature,pressure,light,soil\n");
+    } else {
+      SensorReading r;
+      if (!cursor_.next(r)) return false;
+      n = snprintf(pending_, sizeof(pending_), "%lu,%.2f,%.1f,%.1f,%.1f\n", r.timestamp,
+                   (double)r.temperature, (double)r.pressure, (double)r.lightLevel, (double)r.soilMoisture);
+    }
+    pendingLen_ = (uint8_t)(n < (int)sizeof(pending_) ? n : (int)sizeof(pending_) - 1);
+    pendingPos_ = 0;
+    return true;
+  }
+
+  HistoryStore::Cursor cursor_;
+  bool headerDone_ = false;
+  char pending_[80];
+  uint8_t pendingLen_ = 0;
+  uint8_t pendingPos_ = 0;
+};
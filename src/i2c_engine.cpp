@@ -0,0 +1,258 @@
+/*
+ * I2C transaction engine (see i2c_engine.h).
+ */
+#include "i2c_engine.h"
+#include "trace.h"
+
+// ---- I2cDevice ----
+
+I2cDevice::I2cDevice(I2cBus &bus, uint8_t address, uint16_t timeoutMs)
+    : bus_(bus), address_(address), timeoutMs_(timeoutMs) {
+  bus.attach(*this);
+}
+
+bool I2cDevice::submit(I2cTransfer &t) {
+  if (t.pending()) return false;
+  t.device = this;
+  if (!present() || !bus_.enqueue(t)) {
+    t.status.store(I2C_SKIPPED, std::memory_order_release);
+    return false;
+  }
+  return true;
+}
+
+I2cStatus I2cDevice::transfer(I2cTransfer &t) {
+  if (!submit(t)) return t.pending() ? I2C_PENDING : t.state();
+  while (t.pending()) {
+#if I2C_ENGINE_TASKS
+    vTaskDelay(1);  // bounded by the device timeout (+ one recovery)
+#endif
+  }
+  return t.state();
+}
+
+I2cDeviceStats I2cDevice::stats() const {
+  return {transfers_.load(std::memory_order_relaxed), errors_.load(std::memory_order_relaxed),
+          probes_.load(std::memory_order_relaxed), redetections_.load(std::memory_order_relaxed)};
+}
+
+void I2cDevice::noteResult(I2cStatus status) {
+  transfers_.fetch_add(1, std::memory_order_relaxed);
+  if (status == I2C_OK) {
+    failures_ = 0;
+    backoffMs_ = I2C_PROBE_MIN_MS;
+    return;
+  }
+  errors_.fetch_add(1, std::memory_order_relaxed);
+  // A NACK on a device that answered before means it was unplugged
+  if (status == I2C_NACK || ++failures_ >= I2C_FAILURES_TO_MISSING) markMissing();
+}
+
+void I2cDevice::probeIfDue(unsigned long nowMs) {
+  if (present()) {
+    probing_ = false;
+    return;
+  }
+  if (!probing_) {  // just went missing
+    probing_ = true;
+    nextProbeMs_ = nowMs + backoffMs_;
+    return;
+  }
+  if ((long)(nowMs - nextProbeMs_) < 0) return;
+  probes_.fetch_add(1, std::memory_order_relaxed);
+  if (bus_.probe(*this)) {
+    failures_ = 0;
+    probing_ = false;
+    redetections_.fetch_add(1, std::memory_order_relaxed);
+    present_.store(true, std::memory_order_release);
+    redetected_.store(true, std::memory_order_release);
+    // The backoff only resets on a transfer that succeeds, so a device that
+    // ACKs but fails begin() is not re-initialised every 500 ms
+    growBackoff();
+    return;
+  }
+  growBackoff();
+  nextProbeMs_ = nowMs + backoffMs_;
+}
+
+void I2cDevice::growBackoff() {
+  backoffMs_ = backoffMs_ * 2 > I2C_PROBE_MAX_MS ? I2C_PROBE_MAX_MS : backoffMs_ * 2;
+}
+
+// ---- I2cBus ----
+
+I2cBus::I2cBus(TwoWire &wire, int sda, int scl, uint32_t frequency)
+    : wire_(wire), sda_(sda), scl_(scl), frequency_(frequency) {}
+
+void I2cBus::attach(I2cDevice &device) {
+  if (deviceCount_ < I2C_MAX_DEVICES) devices_[deviceCount_++] = &device;
+}
+
+bool I2cBus::begin() {
+  if (!wire_.begin(sda_, scl_, frequency_)) return false;
+#if I2C_ENGINE_TASKS
+  if (!task_) {
+    char name[8] = "i2c0";
+    name[3] = (char)('0' + wire_.busNum());
+    xTaskCreatePinnedToCore(worker, name, I2C_WORKER_STACK, this, I2C_WORKER_PRIORITY, &task_, 1);
+  }
+#endif
+  return true;
+}
+
+// Single producer (the acquisition task; setup() before it starts)
+bool I2cBus::enqueue(I2cTransfer &t) {
+  uint8_t head = head_.load(std::memory_order_relaxed);
+  if ((uint8_t)(head - tail_.load(std::memory_order_acquire)) >= I2C_QUEUE_DEPTH) {
+    queueFull_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  t.status.store(I2C_PENDING, std::memory_order_relaxed);
+  queue_[head % I2C_QUEUE_DEPTH] = &t;
+  head_.store((uint8_t)(head + 1), std::memory_order_release);
+#if I2C_ENGINE_TASKS
+  if (task_) xTaskNotifyGive(task_);
+#else
+  drainQueue();
+#endif
+  return true;
+}
+
+void I2cBus::drainQueue() {
+  uint8_t tail = tail_.load(std::memory_order_relaxed);
+  while (tail != head_.load(std::memory_order_acquire)) {
+    run(*queue_[tail % I2C_QUEUE_DEPTH]);
+    tail_.store(++tail, std::memory_order_release);
+  }
+}
+
+void I2cBus::probeMissing(unsigned long nowMs) {
+  for (uint8_t i = 0; i < deviceCount_; i++) devices_[i]->probeIfDue(nowMs);
+}
+
+void I2cBus::poll(unsigned long nowMs) {
+#if !I2C_ENGINE_TASKS
+  probeMissing(nowMs);
+#else
+  (void)nowMs;
+#endif
+}
+
+#if I2C_ENGINE_TASKS
+void I2cBus::worker(void *arg) {
+  I2cBus &bus = *static_cast<I2cBus *>(arg);
+  for (;;) {
+    // A running scan only yields to queued transfers, it does not sleep
+    ulTaskNotifyTake(pdTRUE, bus.scanning() ? 0 : pdMS_TO_TICKS(I2C_WORKER_IDLE_MS));
+    bus.drainQueue();
+    bus.probeMissing(millis());
+    if (bus.scanning()) bus.scanStep();
+  }
+}
+#endif
+
+static I2cStatus statusFor(uint8_t wireError) {
+  switch (wireError) {
+    case 0: return I2C_OK;
+    case 2:                 // NACK on address
+    case 3: return I2C_NACK;  // NACK on data
+    case 5: return I2C_TIMEOUT;
+    default: return I2C_BUS_ERROR;
+  }
+}
+
+void I2cBus::run(I2cTransfer &t) {
+  TRACE_SCOPE_TRACK("i2c transfer", TRACE_TRACK_I2C + wire_.busNum());  // buses run in parallel
+  I2cDevice &d = *t.device;
+  wire_.setTimeOut(d.timeoutMs());
+  unsigned long t0 = micros();
+  I2cStatus st = I2C_OK;
+  if (t.txLen || !t.rxLen) {  // plain reads (BH1750 data) skip the write phase
+    wire_.beginTransmission(d.address());
+    wire_.write(t.tx, t.txLen);
+    st = statusFor(wire_.endTransmission(t.rxLen == 0));  // repeated start before a read
+  }
+  if (st == I2C_OK && t.rxLen) {
+    if (wire_.requestFrom(d.address(), (size_t)t.rxLen) == t.rxLen) {
+      for (uint8_t i = 0; i < t.rxLen; i++) t.rx[i] = (uint8_t)wire_.read();
+    } else {
+      st = micros() - t0 >= d.timeoutMs() * 1000UL ? I2C_TIMEOUT : I2C_NACK;
+    }
+  }
+  t.busUs = micros() - t0;
+  busUs_.fetch_add(t.busUs, std::memory_order_relaxed);
+  transfers_.fetch_add(1, std::memory_order_relaxed);
+  d.noteResult(st);
+  if (st != I2C_OK) errors_.fetch_add(1, std::memory_order_relaxed);
+  if (st == I2C_TIMEOUT || st == I2C_BUS_ERROR) recover();
+  t.status.store(st, std::memory_order_release);
+}
+
+bool I2cBus::probe(I2cDevice &device) { return probeAddress(device.address(), device.timeoutMs()); }
+
+bool I2cBus::probeAddress(uint8_t address, uint16_t timeoutMs) {
+  wire_.setTimeOut(timeoutMs);
+  unsigned long t0 = micros();
+  wire_.beginTransmission(address);
+  uint8_t err = wire_.endTransmission();
+  uint32_t us = micros() - t0;
+  busUs_.fetch_add(us, std::memory_order_relaxed);
+  if (scanning_.load(std::memory_order_relaxed)) scanUs_ += us;
+  if (err == 5 || err == 4) recover();
+  return err == 0;
+}
+
+bool I2cBus::requestScan(const I2cAddressSet &addresses) {
+  if (scanning()) return false;
+  scanWanted_ = addresses;
+  scanFound_ = I2cAddressSet();
+  scanNext_ = 0;
+  scanUs_ = 0;
+  scanning_.store(true, std::memory_order_release);
+#if I2C_ENGINE_TASKS
+  if (task_) xTaskNotifyGive(task_);
+#else
+  while (scanning()) scanStep();
+#endif
+  return true;
+}
+
+void I2cBus::scanStep() {
+  for (int probed = 0; scanNext_ < 128 && probed < I2C_SCAN_BATCH; scanNext_++) {
+    if (!scanWanted_.test(scanNext_)) continue;
+    if (probeAddress(scanNext_, I2C_SCAN_TIMEOUT_MS)) scanFound_.set(scanNext_);
+    probed++;
+  }
+  if (scanNext_ >= 128) scanning_.store(false, std::memory_order_release);
+}
+
+bool I2cBus::recover() {
+  recoveries_.fetch_add(1, std::memory_order_relaxed);
+  wire_.end();
+  pinMode(sda_, INPUT_PULLUP);
+  pinMode(scl_, OUTPUT_OPEN_DRAIN);
+  digitalWrite(scl_, HIGH);
+  // A slave stuck mid-byte releases SDA once it has clocked out its bits
+  for (int i = 0; i < I2C_RECOVERY_PULSES && digitalRead(sda_) == LOW; i++) {
+    digitalWrite(scl_, LOW);
+    delayMicroseconds(5);
+    digitalWrite(scl_, HIGH);
+    delayMicroseconds(5);
+  }
+  // STOP: SDA rises while SCL is high
+  pinMode(sda_, OUTPUT_OPEN_DRAIN);
+  digitalWrite(sda_, LOW);
+  delayMicroseconds(5);
+  digitalWrite(sda_, HIGH);
+  delayMicroseconds(5);
+  pinMode(sda_, INPUT_PULLUP);
+  bool released = digitalRead(sda_) == HIGH;
+  wire_.begin(sda_, scl_, frequency_);
+  return released;
+}
+
+I2cBusStats I2cBus::stats() const {
+  return {transfers_.load(std::memory_order_relaxed), errors_.load(std::memory_order_relaxed),
+          recoveries_.load(std::memory_order_relaxed), queueFull_.load(std::memory_order_relaxed),
+          busUs_.load(std::memory_order_relaxed)};
+}
@@ -0,0 +1,226 @@
+/*
+ * I2C transaction engine: queued transfers, one worker per physical bus.
+ *
+ * Arduino's TwoWire blocks the caller until a transfer ends or times out
+ * (50 ms by default), so a sensor that drops off or stretches the clock
+ * used to stall the acquisition loop on every read. Here the acquisition
+ * task only queues I2cTransfer descriptors and polls their status; each
+ * bus has its own worker task that owns the TwoWire and runs the queue
+ * (the IDF driver underneath is interrupt-driven, so a worker waiting on
+ * the bus leaves the CPU to everyone else). Wire (16/17) and I2C_1 (8/9)
+ * are separate controllers, so their transfers overlap.
+ *
+ * Per device:
+ *   - every transfer runs with the device's own timeout (setTimeOut);
+ *   - a NACK marks the device missing at once, I2C_FAILURES_TO_MISSING
+ *     timeouts/bus errors in a row do too; transfers to a missing device
+ *     are refused without touching the bus (I2C_SKIPPED);
+ *   - a missing device is probed (address-only write) with exponential
+ *     backoff from I2C_PROBE_MIN_MS to I2C_PROBE_MAX_MS; when it answers,
+ *     takeRedetected() tells the driver to run its begin() again.
+ * A timeout or bus error also triggers bus recovery: up to 9 SCL pulses
+ * until the slave holding SDA lets go, then a STOP, then Wire.begin().
+ *
+ * requestScan() probes a set of addresses (boot check of the cached map,
+ * or all of 1..126 for /i2c/scan) on the worker, I2C_SCAN_BATCH addresses
+ * at a time between queued transfers, so sensors keep their bus slots.
+ *
+ * On the host build there are no tasks: submit() runs the transfer inline
+ * and poll() runs the due probes, so the same code is stepped by the
+ * virtual clock.
+ */
+#pragma once
+#include <Arduino.h>
+#include <Wire.h>
+#include <atomic>
+
+#ifndef NATIVE_BUILD
+#define I2C_ENGINE_TASKS 1
+#else
+#define I2C_ENGINE_TASKS 0  // host: inline transfers, probes from poll()
+#endif
+
+#define I2C_QUEUE_DEPTH 8
+#define I2C_MAX_TX 4
+#define I2C_MAX_RX 24              // BMP280 trimming parameters in one read
+#define I2C_MAX_DEVICES 4          // per bus
+#define I2C_FAILURES_TO_MISSING 2  // consecutive timeouts / bus errors
+#define I2C_PROBE_MIN_MS 500
+#define I2C_PROBE_MAX_MS 30000
+#define I2C_RECOVERY_PULSES 9
+#define I2C_WORKER_STACK 3072
+#define I2C_WORKER_PRIORITY 3      // above the acquisition task: queued work starts at once
+#define I2C_WORKER_IDLE_MS 50      // wake-up for due probes when nothing is queued
+#define I2C_SCAN_BATCH 8           // addresses probed per worker pass
+#define I2C_SCAN_TIMEOUT_MS 5
+
+enum I2cStatus : uint8_t {
+  I2C_IDLE,       // not submitted (or result already taken)
+  I2C_PENDING,    // queued or on the bus
+  I2C_OK,
+  I2C_NACK,       // address or data not acknowledged
+  I2C_TIMEOUT,    // clock held past the device timeout
+  I2C_BUS_ERROR,  // bus busy / arbitration lost
+  I2C_SKIPPED     // device missing or queue full: nothing was sent
+};
+
+class I2cBus;
+class I2cDevice;
+
+// A write (register pointer, command) and an optional read after a
+// repeated start. Owned by the driver; the engine only keeps a pointer
+// while it is pending.
+struct I2cTransfer {
+  uint8_t tx[I2C_MAX_TX];
+  uint8_t txLen = 0;
+  uint8_t rx[I2C_MAX_RX];
+  uint8_t rxLen = 0;
+  uint32_t busUs = 0;  // how long it held the bus
+  I2cDevice *device = nullptr;
+  std::atomic<uint8_t> status{I2C_IDLE};
+
+  void prepare(const uint8_t *data, uint8_t len, uint8_t readLen) {
+    if (len) memcpy(tx, data, len);
+    txLen = len;
+    rxLen = readLen;
+  }
+  I2cStatus state() const { return (I2cStatus)status.load(std::memory_order_acquire); }
+  bool pending() const { return state() == I2C_PENDING; }
+  bool failed() const { return state() >= I2C_NACK; }
+  // Acquisition side, once the result is read
+  void release() { status.store(I2C_IDLE, std::memory_order_relaxed); }
+};
+
+// 7-bit address set, bit a = address a
+struct I2cAddressSet {
+  uint32_t bits[4] = {};
+
+  void set(uint8_t a) { bits[(a >> 5) & 3] |= 1UL << (a & 31); }
+  bool test(uint8_t a) const { return a < 128 && (bits[a >> 5] >> (a & 31)) & 1; }
+  int count() const {
+    int n = 0;
+    for (uint32_t w : bits) n += __builtin_popcount(w);
+    return n;
+  }
+  bool operator==(const I2cAddressSet &o) const { return memcmp(bits, o.bits, sizeof(bits)) == 0; }
+  bool operator!=(const I2cAddressSet &o) const { return !(*this == o); }
+  static I2cAddressSet all() {  // 1..126: 0 is general call, 127 is reserved
+    I2cAddressSet s;
+    for (uint8_t a = 1; a < 127; a++) s.set(a);
+    return s;
+  }
+};
+
+struct I2cDeviceStats {
+  uint32_t transfers;
+  uint32_t failures;
+  uint32_t probes;
+  uint32_t redetections;
+};
+
+class I2cDevice {
+public:
+  I2cDevice(I2cBus &bus, uint8_t address, uint16_t timeoutMs);
+
+  // Queues t; false (t -> I2C_SKIPPED) if the device is missing, t is
+  // still pending or the queue is full
+  bool submit(I2cTransfer &t);
+  // submit() and wait for the result: for begin() paths only
+  I2cStatus transfer(I2cTransfer &t);
+
+  bool present() const { return present_.load(std::memory_order_acquire); }
+  // A begin() that failed on a device that ACKs (wrong chip) or never
+  // answered: hand it to the prober
+  void markMissing() { present_.store(false, std::memory_order_release); }
+  // True once after a probe found the device again
+  bool takeRedetected() { return redetected_.exchange(false, std::memory_order_acq_rel); }
+
+  uint8_t address() const { return address_; }
+  // Before any transfer is queued; the new address gets a fresh start
+  void setAddress(uint8_t address) {
+    address_ = address;
+    present_.store(true, std::memory_order_release);
+  }
+  uint16_t timeoutMs() const { return timeoutMs_; }
+  I2cBus &bus() const { return bus_; }
+  I2cDeviceStats stats() const;
+
+private:
+  friend class I2cBus;
+  // Worker side
+  void noteResult(I2cStatus status);
+  void probeIfDue(unsigned long nowMs);
+  void growBackoff();
+
+  I2cBus &bus_;
+  uint8_t address_;
+  uint16_t timeoutMs_;
+  std::atomic<bool> present_{true};
+  std::atomic<bool> redetected_{false};
+  uint8_t failures_ = 0;        // consecutive, worker only
+  bool probing_ = false;        // worker only
+  unsigned long nextProbeMs_ = 0;
+  unsigned long backoffMs_ = I2C_PROBE_MIN_MS;
+  std::atomic<uint32_t> transfers_{0}, errors_{0}, probes_{0}, redetections_{0};
+};
+
+struct I2cBusStats {
+  uint32_t transfers;
+  uint32_t errors;
+  uint32_t recoveries;
+  uint32_t queueFull;
+  uint32_t busUs;  // total time transfers held the bus (wraps after ~71 min)
+};
+
+class I2cBus {
+public:
+  I2cBus(TwoWire &wire, int sda, int scl, uint32_t frequency);
+
+  // Wire.begin() and the worker task
+  bool begin();
+  // Host: runs due probes (the worker does this on the target)
+  void poll(unsigned long nowMs);
+  // SCL pulses + STOP + Wire.begin(); true if SDA is high afterwards
+  bool recover();
+
+  // Address-only probes of `addresses` in the background; false if a
+  // scan is already running. On the host it runs to completion here.
+  bool requestScan(const I2cAddressSet &addresses);
+  bool scanning() const { return scanning_.load(std::memory_order_acquire); }
+  // Valid once scanning() is false
+  const I2cAddressSet &scanFound() const { return scanFound_; }
+  uint32_t scanUs() const { return scanUs_; }  // bus time the last scan took
+
+  TwoWire &wire() const { return wire_; }
+  I2cBusStats stats() const;
+
+private:
+  friend class I2cDevice;
+  void attach(I2cDevice &device);
+  bool enqueue(I2cTransfer &t);
+  void drainQueue();
+  void probeMissing(unsigned long nowMs);
+  void run(I2cTransfer &t);
+  bool probe(I2cDevice &device);
+  bool probeAddress(uint8_t address, uint16_t timeoutMs);
+  void scanStep();
+#if I2C_ENGINE_TASKS
+  static void worker(void *arg);
+  TaskHandle_t task_ = nullptr;
+#endif
+
+  TwoWire &wire_;
+  int sda_, scl_;
+  uint32_t frequency_;
+  I2cTransfer *queue_[I2C_QUEUE_DEPTH];
+  std::atomic<uint8_t> head_{0};  // written by submitters
+  std::atomic<uint8_t> tail_{0};  // written by the worker
+  I2cDevice *devices_[I2C_MAX_DEVICES];
+  uint8_t deviceCount_ = 0;
+  // Scan: written by requestScan() while idle, then by the worker until done
+  std::atomic<bool> scanning_{false};
+  I2cAddressSet scanWanted_, scanFound_;
+  uint8_t scanNext_ = 0;
+  uint32_t scanUs_ = 0;
+  std::atomic<uint32_t> transfers_{0}, errors_{0}, recoveries_{0}, queueFull_{0}, busUs_{0};
+};
@@ -0,0 +1,68 @@
+/*
+ * Cached I2C device map and its NVS copy (format in i2c_map.h).
+ */
+#include "i2c_map.h"
+#include <Preferences.h>
+
+size_t packI2cMap(const I2cMap &map, uint8_t *out, size_t cap) {
+  if (cap < I2C_MAP_BLOB_SIZE) return 0;
+  out[0] = 'I';
+  out[1] = 'M';
+  out[2] = I2C_MAP_VERSION;
+  out[3] = I2C_MAP_BUSES;
+  for (int i = 0; i < 4; i++) out[4 + i] = (uint8_t)(map.fullScanUs >> (8 * i));
+  for (int b = 0; b < I2C_MAP_BUSES; b++) {
+    for (int i = 0; i < 16; i++) out[8 + 16 * b + i] = (uint8_t)(map.buses[b].bits[i / 4] >> (8 * (i % 4)));
+  }
+  return I2C_MAP_BLOB_SIZE;
+}
+
+bool unpackI2cMap(const uint8_t *in, size_t len, I2cMap &out) {
+  if (len != I2C_MAP_BLOB_SIZE || in[0] != 'I' || in[1] != 'M' || in[2] != I2C_MAP_VERSION ||
+      in[3] != I2C_MAP_BUSES) {
+    return false;
+  }
+  out = I2cMap();
+  for (int i = 0; i < 4; i++) out.fullScanUs |= (uint32_t)in[4 + i] << (8 * i);
+  for (int b = 0; b < I2C_MAP_BUSES; b++) {
+    for (int i = 0; i < 16; i++) out.buses[b].bits[i / 4] |= (uint32_t)in[8 + 16 * b + i] << (8 * (i % 4));
+  }
+  return true;
+}
+
+bool loadI2cMap(I2cMap &out) {
+  Preferences prefs;
+  if (!prefs.begin(I2C_MAP_NVS_NAMESPACE, true)) return false;
+  uint8_t blob[I2C_MAP_BLOB_SIZE];
+  size_t len = prefs.getBytesLength(I2C_MAP_NVS_KEY);
+  bool ok = len == sizeof(blob) && prefs.getBytes(I2C_MAP_NVS_KEY, blob, len) == len && unpackI2cMap(blob, len, out);
+  prefs.end();
+  return ok;
+}
+
+bool saveI2cMap(const I2cMap &map) {
+  uint8_t blob[I2C_MAP_BLOB_SIZE];
+  size_t len = packI2cMap(map, blob, sizeof(blob));
+  if (!len) return false;
+  Preferences prefs;
+  if (!prefs.begin(I2C_MAP_NVS_NAMESPACE, false)) return false;
+  bool ok = prefs.putBytes(I2C_MAP_NVS_KEY, blob, len) == len;
+  prefs.end();
+  return ok;
+}
+
+const char *i2cDeviceName(uint8_t address) {
+  switch (address) {
+    case 0x23: return "BH1750 Light Sensor";
+    case 0x5C: return "BH1750 Light Sensor (ADDR high)";
+    case 0x76: return "BMP280 Temp/Pressure - Primary";
+    case 0x77: return "BMP280 Temp/Pressure - Alternative";
+    case 0x48: return "ADS1115 ADC";
+    case 0x68: return "DS3231 RTC or MPU6050 IMU";
+    case 0x3C: return "OLED Display 128x64";
+    case 0x3D: return "OLED Display 128x64 Alt";
+    case 0x50:
+    case 0x57: return "EEPROM";
+    default: return "Unknown device";
+  }
+}
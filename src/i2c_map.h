@@ -0,0 +1,41 @@
+/*
+ * Cached I2C device map: which addresses answered on each bus at the last
+ * full scan, kept in NVS so boot only probes those addresses (a full
+ * 2 x 126-address scan runs when the cache is missing or does not match,
+ * and on request via /i2c/scan).
+ *
+ * NVS blob (namespace "i2cmap", key "devices"), little-endian:
+ *   'I' 'M', u8 version, u8 buses, u32 full scan time in us,
+ *   buses x 16 bytes (bit a = address a answered)
+ */
+#pragma once
+#include "i2c_engine.h"
+
+#define I2C_MAP_BUSES 2
+#define I2C_MAP_NVS_NAMESPACE "i2cmap"
+#define I2C_MAP_NVS_KEY "devices"
+#define I2C_MAP_VERSION 1
+#define I2C_MAP_BLOB_SIZE (8 + 16 * I2C_MAP_BUSES)
+
+struct I2cMap {
+  I2cAddressSet buses[I2C_MAP_BUSES];
+  uint32_t fullScanUs = 0;  // what the last full scan cost, for the boot report
+
+  bool operator==(const I2cMap &o) const {
+    for (int b = 0; b < I2C_MAP_BUSES; b++) {
+      if (buses[b] != o.buses[b]) return false;
+    }
+    return true;
+  }
+  bool operator!=(const I2cMap &o) const { return !(*this == o); }
+};
+
+size_t packI2cMap(const I2cMap &map, uint8_t *out, size_t cap);
+bool unpackI2cMap(const uint8_t *in, size_t len, I2cMap &out);
+
+// NVS persistence (Preferences); false if nothing valid is stored
+bool loadI2cMap(I2cMap &out);
+bool saveI2cMap(const I2cMap &map);
+
+// Usual part behind an address (from individual_sensors/i2c_scanner.cpp)
+const char *i2cDeviceName(uint8_t address);
@@ -4,14 +4,36 @@
  */
 #include <WiFi.h>
 #include <ESPAsyncWebServer.h>
-#include <Adafruit_BMP280.h>
 #include <ArduinoJson.h>
-#include <BH1750.h>
 #include <Wire.h>
 #include <LittleFS.h>
 #include <HTTPClient.h>
 // #include <FirebaseESP32.h>  // DISABLED - Local IP only
 #include <FastLED.h>
+#include <atomic>
+#include <memory>
+#include <stdarg.h>
+#include "seqlock.h"
+#include "history.h"
+#include "history_store.h"
+#include "rollup.h"
+#include "window_stats.h"
+#include "response_cache.h"
+#include "response_writer.h"
+#include "page_template.h"
+#include "event_log.h"
+#include "soil_adc.h"
+#include "filter_chain.h"
+#include "soil_calibration.h"
+#include "i2c_engine.h"
+#include "i2c_map.h"
+#include "bmp280.h"
+#include "bh1750_auto.h"
+#include "wifi_link.h"
+#include "request_log.h"
+#include "telemetry.h"
+#include "metrics.h"
+#include "trace.h"
 
 // RGB LED Configuration (WS2812 addressable LED on ESP32-S3)
 #define LED_PIN 48
@@ -31,6 +53,22 @@ enum SensorType {
   SENSOR_COUNT
 };
 
+// Result of one non-blocking acquisition step
+enum SensorStep : uint8_t {
+  SENSOR_STEP_DONE,    // value published, wait for the next period
+  SENSOR_STEP_AGAIN,   // needs another conversion interval (e.g. multi-sample burst)
+  SENSOR_STEP_FAILED   // read failed, value marked invalid
+};
+
+// Scheduler bookkeeping (all times in micros(), compared wrap-safe)
+struct TaskTiming {
+  unsigned long nextDueUs;
+  unsigned long readyAtUs;
+  bool converting;
+  unsigned long runs;
+  unsigned long maxJitterUs;  // worst lateness vs. due time
+};
+
 struct SensorInfo {
   const char* name;
   const char* unit;
@@ -38,14 +76,43 @@ struct SensorInfo {
   bool available;
   float lastValue;
   unsigned long lastRead;
+  unsigned long periodMs;      // how often a fresh value is wanted
+  unsigned long conversionMs;  // wait between start() and collect() (0 = read right away)
+  void (*start)();             // kick off a conversion (NULL if the sensor free-runs)
+  SensorStep (*collect)();     // fetch the result, never blocks
+  float *value;                // global collect() writes; filtered in place once DONE
+  float deadband;              // /events pushes a new value once it moves further than this
+  bool (*missing)(float v);    // v is this sensor's error marker, not a reading
+  FilterChain filter;          // default stages; replaced at runtime via POST /sensors/filter
+  TaskTiming timing;
 };
 
+void startBmpBurst();
+SensorStep collectTemperature();
+SensorStep collectPressure();
+void startLight();
+SensorStep collectLight();
+SensorStep collectSoil();
+extern float temperature, pressure, lightLevel, soilMoisture;
+static bool bmpMissing(float v) { return v == -999; }  // BMP280 failures read -999 (0 °C is a reading)
+static bool negativeMissing(float v) { return v < 0; }  // light/soil: -1 when absent
+
+// Filter chains (filter_chain.h) run once per 500 ms sample. median(3) drops
+// single bad I2C reads; soil is already averaged at 4 kHz, the Kalman stage
+// only steadies the percentage the watering thresholds compare against.
 SensorInfo sensors[SENSOR_COUNT] = {
-  {"Temperature", "°C", true, false, 0.0, 0},
-  {"Pressure", "hPa", true, false, 0.0, 0},
-  {"Light", "lux", true, false, 0.0, 0},
-  {"Soil Moisture", "%", true, false, 0.0, 0}
+  // BMP280 runs in NORMAL mode with 500 ms standby, so results are always ready;
+  // start queues the burst on the I2C engine, collect picks it up (~1 ms at 100 kHz)
+  {"Temperature", "°C", true, false, 0.0, 0, 500, 1, startBmpBurst, collectTemperature, &temperature, 0.1, bmpMissing, FilterChain(filterMedian(3)), {}},
+  {"Pressure", "hPa", true, false, 0.0, 0, 500, 1, startBmpBurst, collectPressure, &pressure, 0.2, bmpMissing, FilterChain(filterMedian(3)), {}},
+  // BH1750 one-time conversions take 81..470 ms depending on the range; collect() polls every 20 ms
+  {"Light", "lux", true, false, 0.0, 0, 500, 20, startLight, collectLight, &lightLevel, 10.0, negativeMissing, FilterChain(filterMedian(3)), {}},
+  // Continuous ADC + filter (soil_adc.h): the latest filtered value is always ready
+  {"Soil Moisture", "%", true, false, 0.0, 0, 500, 0, NULL, collectSoil, &soilMoisture, 1.0, negativeMissing, FilterChain(filterKalman(0.05, 1.0)), {}}
 };
+// Filter config as last set over HTTP (single writer: the web handlers);
+// the acquisition task picks up a new version before the next sample
+Seqlock<FilterConfig> sensorFilterConfig[SENSOR_COUNT];
 
 // --- Cloud Configuration (DISABLED - Local IP Only) ---
 #define ENABLE_CLOUD_SYNC false  // Set to true to enable remote data transmission
@@ -54,6 +121,17 @@ SensorInfo sensors[SENSOR_COUNT] = {
 // Βάλτε το public IP server σας εδώ αν θέλετε να στέλνετε δεδομένα
 const char* REMOTE_PUBLIC_IP = "";  // π.χ. "http://your-public-ip.com/api/data"
 #define REMOTE_SYNC_INTERVAL 60000  // Send every 60 seconds (1 minute)
+// The POST can block for seconds (DNS, connect timeout), so it runs on its own
+// task on the network core; the scheduler only hands it a sample
+#define REMOTE_SYNC_POLL_MS 500
+#define REMOTE_SYNC_STACK 6144
+#define REMOTE_SYNC_PRIORITY 1
+#define REMOTE_SYNC_CORE 0
+#ifndef NATIVE_BUILD
+#define REMOTE_SYNC_TASK 1
+#else
+#define REMOTE_SYNC_TASK 0  // host: sent from the scheduler (the POST shim returns at once)
+#endif
 
 /*
 // Firebase Configuration (COMMENTED OUT)
@@ -73,8 +151,9 @@ unsigned long lastRemoteAttempt = 0;  // For remote public IP transmission track
 
 // --- Soil Moisture Configuration ---
 // Adjust SOIL_PIN to your actual analog pin. Choose an ADC1 capable pin.
-// Calibrate SOIL_DRY_VALUE (reading in completely dry air) and SOIL_WET_VALUE (reading fully wet)
-// then percentage = map(raw, SOIL_DRY_VALUE, SOIL_WET_VALUE, 0, 100) (clamped)
+// Raw -> % goes through a piecewise-linear table (soil_calibration.h) kept in
+// NVS and edited via POST /soil/calibration. Until one is stored, the table is
+// the two points below (reading in dry air = 0%, fully wet = 100%).
 #define SOIL_PIN 4  // GPIO 4 - excellent ADC1 pin for soil sensor
 #define SOIL_DRY_VALUE 3285  // Capacitive sensor reading in air (dry = 0%)
 #define SOIL_WET_VALUE 27    // Capacitive sensor in wet soil (wet = 100%)
@@ -97,9 +176,26 @@ bool timeInitialized = false;
 #define SDA_PIN_1 8
 #define SCL_PIN_1 9
 
-Adafruit_BMP280 bmp;
 TwoWire I2C_1 = TwoWire(1);  // Second I2C bus
-BH1750 lightMeter(0x23);  // Initialize with address
+// Queued transfers, one worker per bus, per-device timeouts and hot-plug (i2c_engine.h)
+#define I2C_FREQUENCY 100000
+#define SENSOR_I2C_TIMEOUT_MS 10  // a 24-byte read takes ~2.5 ms at 100 kHz
+I2cBus i2cBus0(Wire, SDA_PIN, SCL_PIN, I2C_FREQUENCY);
+I2cBus i2cBus1(I2C_1, SDA_PIN_1, SCL_PIN_1, I2C_FREQUENCY);
+I2cDevice bmpDevice(i2cBus0, 0x76, SENSOR_I2C_TIMEOUT_MS);
+I2cDevice lightDevice(i2cBus1, 0x23, SENSOR_I2C_TIMEOUT_MS);
+I2cBus *const i2cBuses[I2C_MAP_BUSES] = {&i2cBus0, &i2cBus1};
+// Devices that answered at boot (or at the last /i2c/scan); see i2c_map.h
+I2cMap i2cMap;
+bool i2cMapVerified = false;   // boot probed the cached addresses only
+bool i2cScanRequested = false; // POST /i2c/scan result not yet taken (HTTP task only)
+
+Bmp280 bmp;                 // one 6-byte burst + integer compensation per sample (bmp280.h)
+Bmp280Sample bmpSample;     // last burst, raw and compensated
+bool bmpSampleValid = false;
+unsigned long bmpSampleUs = 0;
+#define BMP_SAMPLE_REUSE_US 100000  // temperature and pressure share a burst within this
+Bh1750 lightMeter;          // one-time conversions, auto-ranging MTreg (bh1750_auto.h)
 AsyncWebServer server(80);
 
 // Legacy global variables (kept for compatibility)
@@ -107,36 +203,101 @@ float temperature = 0.0;
 float pressure = 0.0;
 float lightLevel = 0.0;
 float soilMoisture = -1.0; // percent, -1 means not initialized
-int soilRaw = -1;          // last raw ADC reading
+int soilRaw = -1;          // last filtered raw ADC reading
+SoilAdc soilAdc;           // continuous ADC sampling + filter for the soil probe
+SoilCalibration soilCalibration;         // used by collectSoil() on the acquisition task
+Seqlock<SoilCalPoints> soilCalibrationPoints;  // latest points, written by the web handlers
 
 // Sensor management functions
 void updateSensorRegistry();
 void sendToCloud();
+void sendRemoteSample();
+#if REMOTE_SYNC_TASK
+static void remoteSyncTask(void *);
+#endif
 
-// History storage - 48 hours of data (one reading every 5 minutes = 576 points)
-#define MAX_HISTORY_POINTS 288  // 24 hours at 5-minute intervals (24*60/5=288)
-#define MAX_FIREBASE_HISTORY 288  // Keep last 24 hours in Firebase
-struct SensorReading {
-  float temperature;
-  float pressure;
-  float lightLevel;
-  float soilMoisture;
-  unsigned long timestamp;
-};
+// --- Dual-core layout ---
+// Acquisition (sensors, scheduler, watering) runs pinned to APP_CPU; WiFi and
+// AsyncTCP stay on PRO_CPU (see CONFIG_ASYNC_TCP_RUNNING_CORE in platformio.ini).
+// Handlers only ever read liveSnapshot, never the globals above.
+#define ACQ_TASK_CORE 1
+#define ACQ_TASK_PRIORITY 2
+#define ACQ_TASK_STACK 8192
+#ifndef NATIVE_BUILD
+#define ENABLE_ACQUISITION_TASK 1
+#else
+#define ENABLE_ACQUISITION_TASK 0  // host bench drives loop() directly
+#endif
 
+// History storage: SensorReading / MAX_HISTORY_POINTS live in history.h
+#define MAX_FIREBASE_HISTORY 288  // Keep last 24 hours in Firebase
 SensorReading sensorHistory[MAX_HISTORY_POINTS];
 int historyIndex = 0;
 int historyCount = 0;
 int totalReadingsCount = 0;  // Total readings sent to Firebase
 float minTemperature = 999.0;  // Track min temp in 24h window
 float maxTemperature = -999.0; // Track max temp in 24h window
+// Sliding 24h stats over the history ring, indexed by SensorType (window_stats.h)
+SlidingWindow<MAX_HISTORY_POINTS> historyWindow[SENSOR_COUNT];
+static const char *const SENSOR_KEYS[SENSOR_COUNT] = {"temperature", "pressure", "light", "soil"};
 unsigned long lastHistoryUpdate = 0;
 #define HISTORY_INTERVAL 300000  // 5 minutes in milliseconds
+std::atomic<uint32_t> historySeq(0);  // odd while addToHistory() is writing (seqlock for readers)
+std::atomic<int> historyStreams(0);   // /history responses still streaming from the ring
+#define HISTORY_MAX_DEFER 30000       // appends wait at most this long for streams to finish
+HistoryStore historyStore;            // weeks of history on LittleFS (history_store.h)
+bool historyStoreReady = false;
+Rollup historyRollup;                 // raw/5m/1h/1d aggregates for /history?range=&step=
+
+// Everything the web handlers need, published once per acquisition pass
+struct SensorSnapshot {
+  float temperature;
+  float pressure;
+  float lightLevel;
+  float soilMoisture;
+  int32_t soilRaw;
+  int32_t bmpRawTemperature;  // adc_T / adc_P of the last burst (0 if none)
+  int32_t bmpRawPressure;
+  uint16_t lightCounts;       // BH1750 data register and the range it was read in
+  uint8_t lightRange;
+  float minTemperature;
+  float maxTemperature;
+  int32_t totalReadings;
+  uint32_t publishedAtMs;
+  bool isWatering;
+  bool manualWateringActive;
+  bool sensorAvailable[SENSOR_COUNT];
+  float sensorValue[SENSOR_COUNT];
+  uint32_t sensorLastRead[SENSOR_COUNT];
+  WindowSummary windowStats[SENSOR_COUNT];
+};
+Seqlock<SensorSnapshot> liveSnapshot;
+
+// /api body, rendered by the acquisition task once per new sample and sent
+// as-is (with an ETag) to every poll until the next one (response_cache.h)
+#define API_BODY_SIZE 1024
+#define API_CACHE_SLOTS 4
+typedef ResponseCache<API_CACHE_SLOTS, API_BODY_SIZE> ApiCache;
+typedef ApiCache::Lease ApiCacheLease;
+ApiCache apiCache;
+bool apiBodyStale = true;  // a sample landed since the body was rendered
+
+// /events: deltas, watering changes and history points pushed to SSE clients
+// (event_log.h). Each client holds a socket, so their number is capped.
+#define MAX_EVENT_STREAMS 4
+EventLog liveEvents;
+std::atomic<int> eventStreams(0);
 
 #define ENABLE_SOIL_DEBUG 1
 #define ENABLE_REQUEST_LOG 1
 #define ENABLE_CALIBRATION_MODE 1  // Set to 1 to see calibration values
 #define ENABLE_ALERTS 1            // Enable temperature/soil alerts
+#define SERIAL_TELEMETRY_BINARY 0  // 1: status/history/watering/alerts as COBS frames (telemetry.h)
+#define TELEMETRY_TIMING_MS 5000   // scheduler timing records in binary mode
+
+// Serial telemetry: text lines, or binary frames for tools/telemetry_decode
+bool binaryTelemetry = SERIAL_TELEMETRY_BINARY;
+TelemetryEncoder telemetry;  // acquisition task only
 
 // Alert thresholds
 #define TEMP_HIGH_ALERT 30.0       // Alert if temperature > 30°C
@@ -151,6 +312,9 @@ bool isWatering = false;            // Current watering state
 unsigned long wateringStartTime = 0;
 unsigned long manualWateringDuration = 15000;  // 15 seconds for manual watering
 bool manualWateringActive = false;
+// Watering commands from the web handlers, applied on the acquisition core
+std::atomic<bool> manualWateringRequested(false);
+std::atomic<bool> wateringStopRequested(false);
 
 // LED Status Indicators
 enum LEDStatus {
@@ -164,53 +328,254 @@ enum LEDStatus {
 LEDStatus currentLEDStatus = LED_STATUS_LOCAL_OK;
 unsigned long lastLEDUpdate = 0;
 bool ledBlinkState = false;
-bool remoteTransmissionOK = false;
-unsigned long lastRemoteTransmission = 0;
+// Written by the remote sync task, read by updateLEDStatus()
+std::atomic<bool> remoteTransmissionOK(false);
+std::atomic<unsigned long> lastRemoteTransmission(0);
+struct RemoteSample {
+  float temperature;
+  float pressure;
+  float lightLevel;
+  float soilMoisture;
+  uint32_t takenAtMs;
+};
+Seqlock<RemoteSample> remoteOutbox;  // newest sample for the remote POST
 #define REMOTE_TRANSMISSION_TIMEOUT 70000  // 70 seconds (if no transmission, show error)
 
-static const char* httpMethodName(AsyncWebServerRequest *r){
-  switch(r->method()){
-    case HTTP_GET: return "GET";
-    case HTTP_POST: return "POST";
-    case HTTP_PUT: return "PUT";
-    case HTTP_PATCH: return "PATCH";
-    case HTTP_DELETE: return "DELETE";
-    case HTTP_OPTIONS: return "OPTIONS";
-    default: return "OTHER";
-  }
-}
-void logRequest(AsyncWebServerRequest *request, int status){
+// Request log (request_log.h): handlers fill a fixed record, a low-priority
+// task prints it. onRoute() registers a handler with its route id and
+// times it; the record is pushed when the handler returns.
+RequestLog requestLog;
+struct RequestContext {  // AsyncTCP task only: one handler runs at a time
+  unsigned long startUs;
+  uint8_t route;
+  bool answered;  // logRequest() ran: status known
+  bool logged;    // ... and the record goes to the request log
+  RequestRecord record;
+};
+RequestContext currentRequest;
+
+// /metrics (metrics.h): fed from the hot paths below, rendered per scrape
+// into a fixed slot on the AsyncTCP task. Durations are in microseconds.
+#define METRICS_BODY_SIZE 12288  // ~9.5 KB with a dozen routes hit
+#define METRICS_CACHE_SLOTS 2
+static const uint32_t LOOP_BUCKETS_US[] = {50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000};
+static const uint32_t SOIL_BUCKETS_US[] = {2, 5, 10, 25, 50, 100, 250, 1000};
+static const uint32_t HTTP_BUCKETS_US[] = {100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000};
+#define BUCKETS(b) b, (uint8_t)(sizeof(b) / sizeof(b[0]))
+MetricHistogram loopDuration(BUCKETS(LOOP_BUCKETS_US));   // acquisition task
+MetricHistogram soilReadDuration(BUCKETS(SOIL_BUCKETS_US));  // acquisition task
+MetricHistogram httpDuration(BUCKETS(HTTP_BUCKETS_US));   // AsyncTCP task
+MetricCounter sensorReads[SENSOR_COUNT];
+MetricCounter sensorFailures[SENSOR_COUNT];
+MetricCounter httpRequests[REQUEST_LOG_ROUTES + 1][5];    // [route, last = none][1xx..5xx]
+MetricCounter relayCycles;
+MetricCounter wateringMs;
+MetricGauge lastWateringSeconds;
+typedef ResponseCache<METRICS_CACHE_SLOTS, METRICS_BODY_SIZE> MetricsCache;
+MetricsCache metricsCache;
+
+// /simple and /calibrate: gzip templates on LittleFS (page_template.h),
+// sources in tools/pages/
+PageTemplate simplePage;
+PageTemplate calibratePage;
+
+void logRequest(AsyncWebServerRequest *request, int status, size_t bytes = 0){
+  RequestRecord &r = currentRequest.record;
+  r.status = (uint16_t)status;
+  r.bytes = (uint32_t)bytes;
+  currentRequest.answered = true;
 #if ENABLE_REQUEST_LOG
+  if (!requestLog.enabled()) return;
   IPAddress ip = request->client()->remoteIP();
-  Serial.printf("REQ %s %s FROM %s -> %d\n", httpMethodName(request), request->url().c_str(), ip.toString().c_str(), status);
+  r.atMs = millis();
+  r.ip = (uint32_t)ip[0] | (uint32_t)ip[1] << 8 | (uint32_t)ip[2] << 16 | (uint32_t)ip[3] << 24;
+  r.method = (uint8_t)request->method();
+  r.route = currentRequest.route;
+  currentRequest.logged = true;
 #endif
 }
 
+static void beginRequest(uint8_t route) {
+  currentRequest.route = route;
+  currentRequest.answered = false;
+  currentRequest.logged = false;
+  currentRequest.startUs = micros();
+}
+
+static void endRequest() {
+  if (!currentRequest.answered) return;  // e.g. the empty onRequest of a body route
+  uint32_t latencyUs = (uint32_t)(micros() - currentRequest.startUs);
+  httpDuration.observe(latencyUs);
+  uint8_t route = currentRequest.route < REQUEST_LOG_ROUTES ? currentRequest.route : REQUEST_LOG_ROUTES;
+  uint16_t status = currentRequest.record.status;
+  if (status >= 100 && status < 600) httpRequests[route][status / 100 - 1].inc();
+#if ENABLE_REQUEST_LOG
+  if (!currentRequest.logged) return;
+  currentRequest.record.latencyUs = latencyUs;
+  requestLog.push(currentRequest.record);
+#endif
+}
+
+void onRoute(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest) {
+  uint8_t route = requestLog.addRoute(uri);
+  server.on(uri, method, [route, uri, onRequest](AsyncWebServerRequest *request) {
+    TRACE_SCOPE(uri);
+    beginRequest(route);
+    onRequest(request);
+    endRequest();
+  });
+}
+
+void onRoute(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+             ArUploadHandlerFunction onUpload, ArBodyHandlerFunction onBody) {
+  uint8_t route = requestLog.addRoute(uri);
+  server.on(uri, method,
+    [route, uri, onRequest](AsyncWebServerRequest *request) {
+      TRACE_SCOPE(uri);
+      beginRequest(route);
+      onRequest(request);
+      endRequest();
+    },
+    onUpload,
+    [route, onBody](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+      beginRequest(route);
+      onBody(request, data, len, index, total);
+      endRequest();
+    });
+}
+
+// Host build: no drain task, the scheduler empties the ring
+void drainRequestLog() {
+  requestLog.drain(Serial);
+}
+
 bool initializeBMP280();
 bool initializeBH1750();
+void loadI2cDeviceMap();
+void applyBootEpoch(unsigned long bootEpoch);
 float readSoilMoisturePercent();
 void setupWebServer();
 void checkAlerts();
 void calibrateSoilSensor();
 void addToHistory();
+void restoreHistoryFromStore();
+void addToRollup();
+uint8_t rollupValidMask(const float *values);
+void pushHistoryWindow(const SensorReading &r);
+void updateTemperatureRange();
 void startWatering();
 void stopWatering();
 void handleAutoWatering();
 void updateLEDStatus();
+void runScheduler();
+void runAcquisitionPass();
+void publishSnapshot();
+void renderApiBody(const SensorSnapshot &snap);
+void renderMetrics(MetricsWriter &w);
+void pushSensorEvents(const SensorSnapshot &snap);
+void pushWateringEvent();
+unsigned long schedulerMaxJitterUs();
+void sendTimingTelemetry();
+
+// ==================== BOOT PHASES ====================
+// Boot is a state machine: setup() only does the local steps (storage, I2C,
+// sensors, web server) and the scheduler starts right after it. WiFi and NTP
+// come up in the background (serviceNetwork), so readings, history and
+// auto-watering run even when the AP is down after a power cut. Each phase
+// is recorded with its start and duration; /status shows them.
+#define BOOT_PHASE_MAX 8
+#define TIME_VALID_MIN 1577836800UL  // 2020-01-01: below this a timestamp is seconds since boot
+
+struct BootPhase {
+  const char *name;
+  uint32_t startUs;  // since boot
+  uint32_t us;
+};
+
+enum NetPhase : uint8_t { NET_WIFI, NET_NTP, NET_READY };
+
+BootPhase bootPhases[BOOT_PHASE_MAX];
+std::atomic<uint8_t> bootPhaseCount{0};  // entries below it are complete (acquisition task appends)
+NetPhase netPhase = NET_WIFI;
+unsigned long netPhaseStartUs = 0;
+WifiLink wifiLink;  // (re)connects from WiFi events, fast path to the cached AP
+
+void bootPhaseEnd(const char *name, unsigned long startUs) {
+  uint8_t n = bootPhaseCount.load(std::memory_order_relaxed);
+  if (n >= BOOT_PHASE_MAX) return;
+  bootPhases[n] = {name, (uint32_t)startUs, (uint32_t)(micros() - startUs)};
+  bootPhaseCount.store(n + 1, std::memory_order_release);
+}
+
+void printBootPhases() {
+  uint8_t n = bootPhaseCount.load(std::memory_order_acquire);
+  Serial.print("Boot phases:");
+  for (uint8_t i = 0; i < n; i++) {
+    Serial.printf(" %s %.1f ms%s", bootPhases[i].name, bootPhases[i].us / 1000.0, i + 1 < n ? "," : "\n");
+  }
+}
+
+const char *netPhaseName(NetPhase phase) {
+  switch (phase) {
+    case NET_WIFI: return "wifi";
+    case NET_NTP: return "ntp";
+    default: return "ready";
+  }
+}
+
+// History timestamp: wall clock once NTP has synced, seconds since boot
+// before that (shifted by applyBootEpoch() when the sync lands)
+unsigned long sampleTimestamp() {
+  if (!timeInitialized) return millis() / 1000;
+  time_t now;
+  time(&now);
+  return (unsigned long)now;
+}
+
+void beginNetwork() {
+  netPhase = NET_WIFI;
+  netPhaseStartUs = micros();
+  timeInitialized = false;
+  wifiLink.begin(ssid, password);
+  Serial.printf("Connecting to WiFi in the background (%s)\n",
+                wifiLink.leaseCached() ? "cached AP" : "full scan");
+}
 
 void setup() {
   Serial.begin(115200);
   delay(1000);
   
   // Initialize LittleFS for serving web files
+  unsigned long phaseUs = micros();
   if(!LittleFS.begin(true)) {
     Serial.println("LittleFS Mount Failed");
     return;
   }
   Serial.println("LittleFS Mounted Successfully");
+  if (!simplePage.begin(LittleFS, "/simple.html.gz") || !calibratePage.begin(LittleFS, "/calibrate.html.gz")) {
+    Serial.println("Page templates missing or invalid - /simple and /calibrate answer 503 (uploadfs)");
+  }
+  
+  // Persistent history: recover the segment tail and refill the 24h ring
+  historyStoreReady = historyStore.begin(LittleFS);
+  if (historyStoreReady) {
+    restoreHistoryFromStore();
+  } else {
+    Serial.println("History store unavailable - history kept in RAM only");
+  }
+  bootPhaseEnd("storage", phaseUs);
   
   // Configure soil sensor pin with pull-down to prevent floating
   pinMode(SOIL_PIN, INPUT_PULLDOWN);
+  SoilCalPoints calibration;
+  bool storedCalibration = loadSoilCalibration(calibration) && soilCalibration.set(calibration);
+  if (!storedCalibration) soilCalibration.set(SoilCalibration::twoPoint(SOIL_DRY_VALUE, SOIL_WET_VALUE));
+  soilCalibrationPoints.publish(soilCalibration.points());
+  Serial.printf("Soil calibration: %u points (%s)\n", soilCalibration.points().count,
+                storedCalibration ? "NVS" : "default");
+  if (!soilAdc.begin(SOIL_PIN)) {
+    Serial.println("Soil ADC continuous mode failed to start - soil reads as missing");
+  }
   
   // 🔧 FIX: Configure water pump relay EARLY to prevent unwanted activation during boot
   // Set OUTPUT mode AND set LOW immediately to ensure relay stays OFF
@@ -221,42 +586,21 @@ void setup() {
   Serial.println("⚡ Water pump relay initialized (OFF - boot-safe)");
   
   // Initialize I2C Bus 0 for BMP280
-  Wire.begin(SDA_PIN, SCL_PIN, 100000);
+  i2cBus0.begin();
   Serial.printf("I2C Bus 0 initialized: SDA=%d, SCL=%d (BMP280)\n", SDA_PIN, SCL_PIN);
   
   // Initialize I2C Bus 1 for BH1750
-  I2C_1.begin(SDA_PIN_1, SCL_PIN_1, 100000);
+  i2cBus1.begin();
   Serial.printf("I2C Bus 1 initialized: SDA=%d, SCL=%d (BH1750)\n", SDA_PIN_1, SCL_PIN_1);
   
   delay(100);
   
-  // Scan I2C Bus 1 to find devices
-  Serial.println("Scanning I2C Bus 1 (GPIO 8/9)...");
-  byte count = 0;
-  for (byte i = 1; i < 127; i++) {
-    I2C_1.beginTransmission(i);
-    byte error = I2C_1.endTransmission();
-    if (error == 0) {
-      Serial.printf("Found device at address 0x%02X\n", i);
-      count++;
-    }
-  }
-  Serial.printf("Found %d device(s) on Bus 1\n", count);
-  
-  // Scan I2C Bus 0 to see if BH1750 is there instead
-  Serial.println("Scanning I2C Bus 0 (GPIO 16/17)...");
-  count = 0;
-  for (byte i = 1; i < 127; i++) {
-    Wire.beginTransmission(i);
-    byte error = Wire.endTransmission();
-    if (error == 0) {
-      Serial.printf("Found device at address 0x%02X\n", i);
-      count++;
-    }
-  }
-  Serial.printf("Found %d device(s) on Bus 0\n", count);
+  phaseUs = micros();
+  loadI2cDeviceMap();
+  bootPhaseEnd("i2c map", phaseUs);
   
   Serial.println("Initializing sensors...");
+  phaseUs = micros();
   
   if (!initializeBMP280()) { 
     Serial.println("Could not find a valid BMP280 sensor, check wiring! (continuing without BMP)"); 
@@ -271,6 +615,7 @@ void setup() {
   }
   // Initial soil moisture read (will stay -1 if pin not connected / invalid)
   soilMoisture = readSoilMoisturePercent();
+  bootPhaseEnd("sensors", phaseUs);
   
   // Initialize RGB LED (WS2812 - GRB color order!)
   FastLED.addLeds<WS2812, LED_PIN, GRB>(leds, NUM_LEDS);  // WS2812 uses GRB, not RGB!
@@ -278,28 +623,8 @@ void setup() {
   leds[0] = CRGB::Black;  // Off initially
   FastLED.show();
   
-  WiFi.begin(ssid, password);
-  Serial.print("Connecting to WiFi");
-  while (WiFi.status() != WL_CONNECTED) { delay(500); Serial.print("."); }
-  Serial.println();
-  Serial.println("🔵 LED Status: LOCAL OK (Blue blinking)");
-  currentLEDStatus = LED_STATUS_LOCAL_OK;
-  leds[0] = CRGB::Blue;
-  FastLED.show();
-  
-  // Initialize NTP for accurate timestamps
-  Serial.println("Initializing NTP time...");
-  configTime(gmtOffset_sec, daylightOffset_sec, ntpServer);
-  struct tm timeinfo;
-  if (getLocalTime(&timeinfo)) {
-    Serial.println("Time synchronized with NTP server");
-    Serial.print("Current time: ");
-    Serial.println(&timeinfo, "%Y-%m-%d %H:%M:%S");
-    timeInitialized = true;
-  } else {
-    Serial.println("Failed to sync time with NTP - timestamps may be incorrect");
-    timeInitialized = false;
-  }
+  // WiFi, then NTP, continue in serviceNetwork(); nothing below needs them
+  beginNetwork();
   
   /*
   // Firebase Initialization (DISABLED - Local IP Only)
@@ -312,91 +637,154 @@ void setup() {
   */
   Serial.println("Cloud sync DISABLED - Local IP only mode");
   
+  publishSnapshot();
+  for (int i = 0; i < SENSOR_COUNT; i++) sensorFilterConfig[i].publish(sensors[i].filter.config());
   setupWebServer();
   server.begin();
+  requestLog.begin();
+#if REMOTE_SYNC_TASK
+  if (strlen(REMOTE_PUBLIC_IP) > 0) {
+    xTaskCreatePinnedToCore(remoteSyncTask, "remote", REMOTE_SYNC_STACK, NULL, REMOTE_SYNC_PRIORITY, NULL,
+                            REMOTE_SYNC_CORE);
+  }
+#endif
   Serial.println("HTTP server started - Access at http://192.168.2.20");
+  bootPhaseEnd("setup", 0);
+  printBootPhases();
+
+#if ENABLE_ACQUISITION_TASK
+  xTaskCreatePinnedToCore([](void *) { for (;;) runAcquisitionPass(); },
+                          "acquisition", ACQ_TASK_STACK, NULL, ACQ_TASK_PRIORITY, NULL, ACQ_TASK_CORE);
+  Serial.printf("Acquisition task pinned to core %d\n", ACQ_TASK_CORE);
+#endif
+}
+
+// Probes both buses for the addresses in `wanted` at once (each bus's
+// worker runs its own scan); returns the longer scan's bus time
+static uint32_t scanI2cBuses(const I2cAddressSet *wanted, I2cMap &found) {
+  for (int b = 0; b < I2C_MAP_BUSES; b++) i2cBuses[b]->requestScan(wanted[b]);
+  uint32_t us = 0;
+  for (int b = 0; b < I2C_MAP_BUSES; b++) {
+    while (i2cBuses[b]->scanning()) delay(1);
+    found.buses[b] = i2cBuses[b]->scanFound();
+    if (i2cBuses[b]->scanUs() > us) us = i2cBuses[b]->scanUs();
+  }
+  return us;
+}
+
+static void printI2cMap(const I2cMap &map) {
+  for (int b = 0; b < I2C_MAP_BUSES; b++) {
+    for (uint8_t a = 1; a < 127; a++) {
+      if (map.buses[b].test(a)) Serial.printf("Bus %d: 0x%02X (%s)\n", b, a, i2cDeviceName(a));
+    }
+  }
+}
+
+// Boot: probe the cached addresses plus the sensors' own (so a sensor that
+// was added shows up as a mismatch); full scan of both buses only when
+// nothing is cached or something moved
+void loadI2cDeviceMap() {
+  I2cMap cached, found;
+  if (loadI2cMap(cached)) {
+    I2cAddressSet wanted[I2C_MAP_BUSES] = {cached.buses[0], cached.buses[1]};
+    wanted[0].set(0x76); wanted[0].set(0x77);  // BMP280
+    wanted[1].set(0x23); wanted[1].set(0x5C);  // BH1750
+    uint32_t us = scanI2cBuses(wanted, found);
+    if (found == cached) {
+      i2cMap = cached;
+      i2cMapVerified = true;
+      Serial.printf("I2C map verified: %d device(s), %.1f ms on the bus (full scan %.1f ms)\n",
+                    cached.buses[0].count() + cached.buses[1].count(), us / 1000.0, cached.fullScanUs / 1000.0);
+      return;
+    }
+    Serial.println("I2C map changed - scanning both buses");
+  }
+  const I2cAddressSet all[I2C_MAP_BUSES] = {I2cAddressSet::all(), I2cAddressSet::all()};
+  found = I2cMap();
+  found.fullScanUs = scanI2cBuses(all, found);
+  printI2cMap(found);
+  i2cMap = found;
+  i2cMapVerified = false;
+  if (!saveI2cMap(found)) Serial.println("I2C map not saved (NVS write failed)");
 }
 
 bool initializeBMP280() {
-  if (!bmp.begin(0x76)) {
+  // NORMAL mode, T x2, P x16, IIR x16, 500 ms standby (set by Bmp280::begin)
+  // The map says which of the two addresses to try first
+  uint8_t primary = !i2cMap.buses[0].test(0x76) && i2cMap.buses[0].test(0x77) ? 0x77 : 0x76;
+  bmpDevice.setAddress(primary);
+  if (!bmp.begin(bmpDevice)) {
     Serial.println("Trying alternative address...");
-    if (!bmp.begin(0x77)) return false;
+    bmpDevice.setAddress(primary == 0x76 ? 0x77 : 0x76);
+    if (!bmp.begin(bmpDevice)) {
+      bmpDevice.setAddress(primary);
+      bmpDevice.markMissing();  // keep probing: the sensor may be plugged in later
+      return false;
+    }
   }
-  bmp.setSampling(Adafruit_BMP280::MODE_NORMAL,
-                  Adafruit_BMP280::SAMPLING_X2,
-                  Adafruit_BMP280::SAMPLING_X16,
-                  Adafruit_BMP280::FILTER_X16,
-                  Adafruit_BMP280::STANDBY_MS_500);
   return true;
 }
 
 bool initializeBH1750() {
-  // Configure BH1750 to use second I2C bus
-  lightMeter.configure(BH1750::CONTINUOUS_HIGH_RES_MODE);
-  if (lightMeter.begin(BH1750::CONTINUOUS_HIGH_RES_MODE, 0x23, &I2C_1)) {
-    Serial.println("BH1750 initialized successfully on Bus 1!");
+  // Configure BH1750 to use second I2C bus, at the address the map found
+  uint8_t primary = !i2cMap.buses[1].test(0x23) && i2cMap.buses[1].test(0x5C) ? 0x5C : 0x23;
+  lightDevice.setAddress(primary);
+  if (lightMeter.begin(lightDevice)) {
+    Serial.printf("BH1750 initialized successfully on Bus 1 (0x%02X)!\n", primary);
     return true;
   }
   // Try alternative address
-  if (lightMeter.begin(BH1750::CONTINUOUS_HIGH_RES_MODE, 0x5C, &I2C_1)) {
-    Serial.println("BH1750 initialized successfully on Bus 1 (0x5C)!");
+  lightDevice.setAddress(primary == 0x23 ? 0x5C : 0x23);
+  if (lightMeter.begin(lightDevice)) {
+    Serial.printf("BH1750 initialized successfully on Bus 1 (0x%02X)!\n", lightDevice.address());
     return true;
   }
+  lightDevice.setAddress(primary);
+  lightDevice.markMissing();  // keep probing: the sensor may be plugged in later
   return false;
 }
 
-float readSoilMoisturePercent() {
-  // Take multiple readings for stability 
-  int readings[5];
-  int validReadings = 0;
-  
-  for (int i = 0; i < 5; i++) {
-    int reading = analogRead(SOIL_PIN);
-    if (reading > 0) {
-      readings[validReadings] = reading;
-      validReadings++;
-    }
-    delay(10); // Small delay between readings
-  }
-  
-  if (validReadings == 0) return -1; // No valid readings
-  
-  // Calculate average
-  long sum = 0;
-  for (int i = 0; i < validReadings; i++) {
-    sum += readings[i];
+// Periodic task: move the DMA's samples into the soil filter before the pool fills
+void drainSoilAdc() {
+  soilAdc.drain();
+}
+
+// O(1): the filter always holds the latest 100 ms average
+static SensorStep collectSoilPercent() {
+  static uint32_t calibrationVersion = 0;
+  uint32_t version = soilCalibrationPoints.version();
+  if (version != calibrationVersion) {  // new points posted: rebuild the segment table
+    soilCalibration.set(soilCalibrationPoints.read());
+    calibrationVersion = version;
   }
-  soilRaw = sum / validReadings;
-  
-  // REVERSE APPROACH: Use raw value, add minimal smoothing only for extreme noise
-  static int lastRaw = -1;
-  static float lastPercent = -1;
-  
-  // Only smooth for extreme spikes (over 400 raw units difference)
-  if (lastRaw != -1) {
-    int diff = abs(soilRaw - lastRaw);
-    if (diff > 400) { // Only for extreme spikes
-      soilRaw = (soilRaw + lastRaw) / 2;
-    }
+  const SoilFilter &f = soilAdc.filter();
+  if (!soilAdc.running() || !f.ready() || f.missing()) {
+    soilMoisture = -1;
+    return SENSOR_STEP_FAILED;
   }
-  lastRaw = soilRaw;
-  
-  int pct = map(soilRaw, SOIL_DRY_VALUE, SOIL_WET_VALUE, 0, 100);
-  if (pct < 0) pct = 0; 
-  if (pct > 100) pct = 100;
-  
-  float currentPercent = (float)pct;
-  
-  // Minimal percentage smoothing - only for very large jumps
-  if (lastPercent != -1) {
-    float diff = abs(currentPercent - lastPercent);
-    if (diff > 80) { // Only smooth very extreme percentage changes
-      currentPercent = (currentPercent + lastPercent) / 2;
-    }
+  float raw = f.latest();
+  soilRaw = (int)lroundf(raw);
+  soilMoisture = soilCalibration.percent(raw);
+  return SENSOR_STEP_DONE;
+}
+
+// Timed for /metrics: the filtered-ADC lookup and calibration curve
+SensorStep collectSoil() {
+  unsigned long startUs = micros();
+  SensorStep step = collectSoilPercent();
+  soilReadDuration.observe((uint32_t)(micros() - startUs));
+  return step;
+}
+
+// Blocking variant, only used once in setup() before the scheduler runs:
+// waits for the filter to fill (~130 ms of samples)
+float readSoilMoisturePercent() {
+  for (int i = 0; soilAdc.running() && !soilAdc.filter().ready() && i < 16; i++) {
+    delay(SOIL_ADC_DRAIN_MS);
+    soilAdc.drain();
   }
-  lastPercent = currentPercent;
-  
-  return currentPercent;
+  collectSoil();
+  return soilMoisture;
 }
 
 void calibrateSoilSensor() {
@@ -418,6 +806,16 @@ void calibrateSoilSensor() {
 #endif
 }
 
+void sendTelemetry() {
+  size_t n = telemetry.end();
+  if (n) Serial.write(telemetry.frame(), n);
+}
+
+void sendAlert(TelemetryAlert kind, float value, float threshold) {
+  telemetry.begin(TELEMETRY_ALERT, millis()).u8(kind).f32(value).f32(threshold);
+  sendTelemetry();
+}
+
 void checkAlerts() {
 #if ENABLE_ALERTS
   static unsigned long lastAlert = 0;
@@ -425,6 +823,12 @@ void checkAlerts() {
     lastAlert = millis();
     
     // Temperature alerts
+    if (binaryTelemetry) {
+      if (temperature > TEMP_HIGH_ALERT) sendAlert(TELEMETRY_ALERT_TEMP_HIGH, temperature, TEMP_HIGH_ALERT);
+      if (temperature < TEMP_LOW_ALERT && temperature > 0) sendAlert(TELEMETRY_ALERT_TEMP_LOW, temperature, TEMP_LOW_ALERT);
+      if (soilMoisture >= 0 && soilMoisture < SOIL_LOW_ALERT) sendAlert(TELEMETRY_ALERT_SOIL_LOW, soilMoisture, SOIL_LOW_ALERT);
+      return;
+    }
     if (temperature > TEMP_HIGH_ALERT) {
       Serial.printf("🔥 ALERT: High temperature %.1f°C (threshold: %.1f°C)\n", 
                     temperature, TEMP_HIGH_ALERT);
@@ -443,15 +847,67 @@ void checkAlerts() {
 #endif
 }
 
+// Holds off addToHistory() while a response streams from the ring (see HISTORY_MAX_DEFER)
+template <typename Stream>
+struct HistoryStreamGuard : Stream {
+  HistoryStreamGuard(int start, int count)
+    : Stream(sensorHistory, MAX_HISTORY_POINTS, start, count) { historyStreams++; }
+  ~HistoryStreamGuard() { historyStreams--; }
+};
+
+// Chunked response that walks the current history ring through Stream::fill()
+template <typename Stream>
+AsyncWebServerResponse *beginHistoryResponse(AsyncWebServerRequest *request, const char *contentType) {
+  uint32_t seq;
+  int count, start;
+  do {
+    while ((seq = historySeq.load(std::memory_order_acquire)) & 1) {}
+    count = historyCount;
+    start = (count < MAX_HISTORY_POINTS) ? 0 : historyIndex;
+  } while (historySeq.load(std::memory_order_acquire) != seq);
+  std::shared_ptr<HistoryStreamGuard<Stream> > stream = std::make_shared<HistoryStreamGuard<Stream> >(start, count);
+  
+  AsyncWebServerResponse *resp = request->beginChunkedResponse(contentType,
+    [stream](uint8_t *buffer, size_t maxLen, size_t) -> size_t {
+      return stream->fill(buffer, maxLen);
+    });
+  
+  // Add CORS headers for remote access (GitHub Pages)
+  resp->addHeader("Access-Control-Allow-Origin", "*");
+  resp->addHeader("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
+  resp->addHeader("Access-Control-Allow-Headers", "Content-Type");
+  return resp;
+}
+
+// Chunked /history?range=&step= response; rollup reads are seqlocked, so
+// unlike the ring streams this never holds off the writer
+AsyncWebServerResponse *beginRollupResponse(AsyncWebServerRequest *request) {
+  time_t now;
+  time(&now);
+  uint32_t range = request->hasParam("range") ? strtoul(request->getParam("range")->value().c_str(), NULL, 10) : 0;
+  uint32_t step = request->hasParam("step") ? strtoul(request->getParam("step")->value().c_str(), NULL, 10) : 0;
+  std::shared_ptr<RollupJsonStream> stream =
+    std::make_shared<RollupJsonStream>(historyRollup, Rollup::plan((uint32_t)now, range, step));
+  
+  AsyncWebServerResponse *resp = request->beginChunkedResponse("application/json",
+    [stream](uint8_t *buffer, size_t maxLen, size_t) -> size_t {
+      return stream->fill(buffer, maxLen);
+    });
+  resp->addHeader("Access-Control-Allow-Origin", "*");
+  resp->addHeader("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
+  resp->addHeader("Access-Control-Allow-Headers", "Content-Type");
+  return resp;
+}
+
 void setupWebServer() {
   // Serve main page from LittleFS
-  server.on("/", HTTP_GET, [](AsyncWebServerRequest *request){
+  onRoute("/", HTTP_GET, [](AsyncWebServerRequest *request){
     logRequest(request, 200);
     request->send(LittleFS, "/index.html", "text/html");
   });
 
   // CORS preflight handler for OPTIONS requests
-  server.on("/api", HTTP_OPTIONS, [](AsyncWebServerRequest *request){
+  onRoute("/api", HTTP_OPTIONS, [](AsyncWebServerRequest *request){
     AsyncWebServerResponse *response = request->beginResponse(204);
     response->addHeader("Access-Control-Allow-Origin", "*");
     response->addHeader("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
@@ -459,7 +915,7 @@ void setupWebServer() {
     request->send(response);
   });
   
-  server.on("/history", HTTP_OPTIONS, [](AsyncWebServerRequest *request){
+  onRoute("/history", HTTP_OPTIONS, [](AsyncWebServerRequest *request){
     AsyncWebServerResponse *response = request->beginResponse(204);
     response->addHeader("Access-Control-Allow-Origin", "*");
     response->addHeader("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
@@ -467,121 +923,388 @@ void setupWebServer() {
     request->send(response);
   });
 
-  server.on("/api", HTTP_GET, [](AsyncWebServerRequest *request){
-    JsonDocument doc; 
-    doc["temperature"]=temperature; 
-    doc["pressure"]=pressure; 
-    doc["light"]= lightLevel;  // Send -1 when disconnected, not 0
-    doc["soil"]= soilMoisture;  // Send actual value including -1 or 0
-    doc["timestamp"]=millis();
-    doc["minTemperature"]=minTemperature;
-    doc["maxTemperature"]=maxTemperature;
-    doc["totalReadings"]=totalReadingsCount;
-    doc["wifiRSSI"]=WiFi.RSSI();  // WiFi signal strength
-    String res; serializeJson(doc,res); 
-    
+  onRoute("/api", HTTP_GET, [](AsyncWebServerRequest *request){
+    // Body pre-rendered on the acquisition core (renderApiBody); the response
+    // reads the leased slot directly, no JsonDocument or String per poll
+    char etag[16];
+    uint32_t version = apiCache.version();
+    if (version && request->hasHeader("If-None-Match")) {
+      snprintf(etag, sizeof(etag), "\"%lu\"", (unsigned long)version);
+      if (strstr(request->getHeader("If-None-Match")->value().c_str(), etag)) {
+        AsyncWebServerResponse *response = request->beginResponse(304);
+        response->addHeader("ETag", etag);
+        response->addHeader("Access-Control-Allow-Origin", "*");
+        request->send(response);
+        logRequest(request,304);
+        return;
+      }
+    }
+    uint32_t leased;
+    size_t length;
+    AsyncWebServerResponse *response = beginCachedResponse(request, apiCache, "application/json", &leased, &length);
+    if (!response) {
+      logRequest(request,503);
+      sendStatic(request, 503, "text/plain", "warming up");
+      return;
+    }
+    snprintf(etag, sizeof(etag), "\"%lu\"", (unsigned long)leased);
+    response->addHeader("ETag", etag);
     // Add CORS headers for remote access (GitHub Pages)
-    AsyncWebServerResponse *response = request->beginResponse(200, "application/json", res);
     response->addHeader("Access-Control-Allow-Origin", "*");
     response->addHeader("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
     response->addHeader("Access-Control-Allow-Headers", "Content-Type");
     request->send(response);
+    logRequest(request,200,length);
+  });
+  // Server-Sent Events: snapshot on connect, then pushed deltas (event_log.h).
+  // A chunked response whose filler reports "try again" while idle, so the
+  // server keeps polling it on the network core; nothing is sent from the
+  // acquisition task.
+  onRoute("/events", HTTP_GET, [](AsyncWebServerRequest *request){
+    if (eventStreams.fetch_add(1) >= MAX_EVENT_STREAMS) {
+      eventStreams--;
+      logRequest(request,503);
+      sendStatic(request, 503, "text/plain", "too many event streams");
+      return;
+    }
+    struct Client {
+      ApiCacheLease snapshot;
+      EventStream stream;
+      Client() : stream(liveEvents) {
+        if (apiCache.acquire(snapshot)) stream.setSnapshot(snapshot.data(), snapshot.length());
+      }
+      ~Client() { eventStreams--; }
+    };
+    std::shared_ptr<Client> client = std::make_shared<Client>();
+    AsyncWebServerResponse *resp = request->beginChunkedResponse("text/event-stream",
+      [client](uint8_t *buffer, size_t maxLen, size_t) -> size_t {
+        size_t n = client->stream.fill(buffer, maxLen, millis());
+        if (client->snapshot.valid() && client->stream.snapshotSent()) client->snapshot.release();
+        return n ? n : RESPONSE_TRY_AGAIN;
+      });
+    resp->addHeader("Cache-Control", "no-cache");
+    resp->addHeader("Access-Control-Allow-Origin", "*");
+    request->send(resp);
     logRequest(request,200);
   });
-  server.on("/health", HTTP_GET, [](AsyncWebServerRequest *request){
-    String body = "OK\n";
-    body += "uptime_ms=" + String(millis()) + "\n";
-    body += "free_heap=" + String(ESP.getFreeHeap()) + "\n";
-    body += "bmp=" + String(temperature!=0.0 || pressure!=0.0 ? 1:0) + "\n";
-    body += "light_sensor=" + String(lightLevel!=-1?1:0) + "\n";
-    body += "soil_sensor=" + String(soilMoisture>=0?1:0) + "\n";
-  logRequest(request,200);
-  request->send(200,"text/plain",body);
+  onRoute("/health", HTTP_GET, [](AsyncWebServerRequest *request){
+    SensorSnapshot snap = liveSnapshot.read();
+    ResponseWriter w(request);
+    w.printf("OK\nuptime_ms=%lu\nfree_heap=%lu\nbmp=%d\nlight_sensor=%d\nsoil_sensor=%d\n",
+             (unsigned long)millis(), (unsigned long)ESP.getFreeHeap(),
+             snap.temperature!=0.0 || snap.pressure!=0.0 ? 1:0, snap.lightLevel!=-1?1:0, snap.soilMoisture>=0?1:0);
+    logRequest(request,w.send(200,"text/plain"),w.length());
   });
-  server.on("/status", HTTP_GET, [](AsyncWebServerRequest *request){
-    JsonDocument doc; doc["uptime_ms"] = millis(); doc["free_heap"] = ESP.getFreeHeap(); doc["light_sensor"] = (lightLevel!=-1); doc["soil_sensor"] = (soilMoisture>=0); doc["bmp_sensor"] = (temperature!=0.0 || pressure!=0.0); String res; serializeJson(doc,res); request->send(200,"application/json",res);
-  logRequest(request,200);
+  onRoute("/status", HTTP_GET, [](AsyncWebServerRequest *request){
+    SensorSnapshot snap = liveSnapshot.read();
+    ResponseWriter w(request);
+    w.beginObject().field("uptime_ms", (uint32_t)millis()).field("free_heap", (uint32_t)ESP.getFreeHeap()).field("light_sensor", snap.lightLevel!=-1).field("soil_sensor", snap.soilMoisture>=0).field("bmp_sensor", snap.temperature!=0.0 || snap.pressure!=0.0).field("sched_max_jitter_us", (uint32_t)schedulerMaxJitterUs());
+    HistoryStoreStats hs = historyStore.stats(); w.field("history_segments", hs.segments).field("history_records", hs.records).field("history_oldest", hs.oldestTimestamp).field("history_dropped", hs.droppedRecords).field("history_recovery_us", hs.recoveryUs);
+    w.field("net_phase", netPhaseName(netPhase)).field("time_synced", timeInitialized);
+    WifiLinkStats ws = wifiLink.stats(); w.field("wifi_link", wifiLink.stateName()).field("wifi_ap_cached", wifiLink.leaseCached()).field("wifi_reconnect_ms", ws.lastConnectMs).field("wifi_reconnect_max_ms", ws.maxConnectMs).field("wifi_fast_connects", ws.fastConnects).field("wifi_scan_connects", ws.scanConnects).field("wifi_fallbacks", ws.fallbacks).field("wifi_drops", ws.drops);
+    w.field("request_log_logged", requestLog.logged()).field("request_log_dropped", requestLog.dropped()).field("response_pool_exhausted", responsePool.exhausted());
+    w.beginArray("boot_phases");
+    for (uint8_t i = 0, n = bootPhaseCount.load(std::memory_order_acquire); i < n; i++) {
+      w.beginObject().field("name", bootPhases[i].name).field("start_ms", bootPhases[i].startUs / 1000.0).field("ms", bootPhases[i].us / 1000.0).endObject();
+    }
+    w.endArray().endObject();
+    logRequest(request,w.send(200,"application/json"),w.length());
   });
   
   // Sensor registry endpoint
-  server.on("/sensors", HTTP_GET, [](AsyncWebServerRequest *request){
-    JsonDocument doc;
-    JsonArray sensorArray = doc["sensors"].to<JsonArray>();
+  onRoute("/sensors", HTTP_GET, [](AsyncWebServerRequest *request){
+    SensorSnapshot snap = liveSnapshot.read();
+    ResponseWriter w(request);
+    w.beginObject().beginArray("sensors");
     
     for (int i = 0; i < SENSOR_COUNT; i++) {
-      JsonObject sensor = sensorArray.add<JsonObject>();
-      sensor["name"] = sensors[i].name;
-      sensor["unit"] = sensors[i].unit;
-      sensor["enabled"] = sensors[i].enabled;
-      sensor["available"] = sensors[i].available;
-      sensor["value"] = sensors[i].lastValue;
-      sensor["last_read"] = sensors[i].lastRead;
+      w.beginObject();
+      w.field("name", sensors[i].name);
+      w.field("unit", sensors[i].unit);
+      w.field("enabled", sensors[i].enabled);
+      w.field("available", snap.sensorAvailable[i]);
+      w.field("value", snap.sensorValue[i]);
+      w.field("last_read", snap.sensorLastRead[i]);
+      char filter[96];
+      describeFilter(sensorFilterConfig[i].read(), filter, sizeof(filter));
+      w.field("key", SENSOR_KEYS[i]);
+      if (i == SENSOR_BMP280_TEMP) w.field("raw", snap.bmpRawTemperature);
+      else if (i == SENSOR_BMP280_PRESSURE) w.field("raw", snap.bmpRawPressure);
+      else if (i == SENSOR_BH1750_LIGHT) {
+        w.field("raw", (uint32_t)snap.lightCounts);
+        w.field("range", (uint32_t)snap.lightRange);
+      }
+      else if (i == SENSOR_SOIL_MOISTURE) w.field("raw", snap.soilRaw);
+      w.field("filter", filter);
+      w.endObject();
     }
     
-    doc["device_id"] = deviceId;
-    doc["cloud_sync_enabled"] = ENABLE_CLOUD_SYNC;
-    
-    String res;
-    serializeJson(doc, res);
-    logRequest(request,200);
-    request->send(200, "application/json", res);
+    w.endArray();
+    w.field("device_id", deviceId);
+    w.field("cloud_sync_enabled", (bool)ENABLE_CLOUD_SYNC);
+    w.endObject();
+    logRequest(request,w.send(200,"application/json"),w.length());
   });
   
+  // Replace a sensor's filter chain: {"sensor":"soil","stages":[{"type":"median","window":5},
+  // {"type":"ewma","alpha":0.3},{"type":"kalman","q":0.05,"r":1}]}; "stages":[] turns it off
+  onRoute("/sensors/filter", HTTP_POST, [](AsyncWebServerRequest *){}, NULL,
+  [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total){
+    if (len != total) {  // body split over several calls: refuse once, on the first
+      if (index == 0) {
+        sendStatic(request, 413, "application/json", "{\"error\":\"Body too large\"}");
+        logRequest(request, 413);
+      }
+      return;
+    }
+    StaticJsonDocument<512> doc;
+    DeserializationError error = deserializeJson(doc, data, len);
+    if (error) {
+      sendStatic(request, 400, "application/json", "{\"error\":\"Invalid JSON\"}");
+      logRequest(request, 400);
+      return;
+    }
+    const char *key = doc["sensor"] | "";
+    int sensor = -1;
+    for (int i = 0; i < SENSOR_COUNT; i++) {
+      if (strcmp(key, SENSOR_KEYS[i]) == 0) sensor = i;
+    }
+    JsonArray stages = doc["stages"].as<JsonArray>();
+    if (sensor < 0 || stages.isNull() || stages.size() > FILTER_MAX_STAGES) {
+      sendStatic(request, 400, "application/json", "{\"error\":\"Expected sensor and up to 3 stages\"}");
+      logRequest(request, 400);
+      return;
+    }
+    FilterConfig config = {};
+    for (JsonObject stage : stages) {
+      const char *type = stage["type"] | "";
+      FilterStageConfig c = {FILTER_NONE, 0, 0};
+      if (strcmp(type, "median") == 0) c = filterMedian(stage["window"] | 0);
+      else if (strcmp(type, "ewma") == 0) c = filterEwma(stage["alpha"] | 0.0f);
+      else if (strcmp(type, "kalman") == 0) c = filterKalman(stage["q"] | 0.0f, stage["r"] | 0.0f);
+      if (!filterStageValid(c)) {
+        sendStatic(request, 400, "application/json", "{\"error\":\"Invalid filter stage\"}");
+        logRequest(request, 400);
+        return;
+      }
+      config.stages[config.count++] = c;
+    }
+    sensorFilterConfig[sensor].publish(config);  // applied by the acquisition task
+    char filter[96];
+    describeFilter(config, filter, sizeof(filter));
+    Serial.printf("Filter for %s set to %s\n", key, filter);
+
+    ResponseWriter w(request);
+    w.beginObject().field("success", true).field("sensor", key).field("filter", filter).endObject();
+    w.cors();
+    logRequest(request, w.send(200, "application/json"), w.length());
+  });
+
+  onRoute("/sensors/filter", HTTP_OPTIONS, [](AsyncWebServerRequest *request){
+    AsyncWebServerResponse *response = request->beginResponse(204);
+    response->addHeader("Access-Control-Allow-Origin", "*");
+    response->addHeader("Access-Control-Allow-Methods", "POST, OPTIONS");
+    response->addHeader("Access-Control-Allow-Headers", "Content-Type");
+    request->send(response);
+  });
+  
+  // Soil calibration table (soil_calibration.h)
+  onRoute("/soil/calibration", HTTP_GET, [](AsyncWebServerRequest *request){
+    SoilCalPoints cal = soilCalibrationPoints.read();
+    ResponseWriter w(request);
+    w.beginObject().beginArray("points");
+    for (uint8_t i = 0; i < cal.count; i++) {
+      w.beginObject().field("raw", (uint32_t)cal.points[i].raw).field("percent", cal.points[i].percent).endObject();
+    }
+    w.endArray();
+    w.field("maxPoints", (uint32_t)SOIL_CAL_MAX_POINTS);
+    w.field("currentRaw", liveSnapshot.read().soilRaw);
+    w.endObject().cors();
+    logRequest(request, w.send(200, "application/json"), w.length());
+  });
+
+  // {"points":[{"raw":3285,"percent":0},{"raw":1900,"percent":40},...]} replaces the
+  // table and stores it in NVS; "points":[] goes back to SOIL_DRY_VALUE/SOIL_WET_VALUE
+  onRoute("/soil/calibration", HTTP_POST, [](AsyncWebServerRequest *){}, NULL,
+  [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total){
+    if (len != total) {  // body split over several calls: refuse once, on the first
+      if (index == 0) {
+        sendStatic(request, 413, "application/json", "{\"error\":\"Body too large\"}");
+        logRequest(request, 413);
+      }
+      return;
+    }
+    StaticJsonDocument<768> doc;
+    DeserializationError error = deserializeJson(doc, data, len);
+    if (error) {
+      sendStatic(request, 400, "application/json", "{\"error\":\"Invalid JSON\"}");
+      logRequest(request, 400);
+      return;
+    }
+    JsonArray points = doc["points"].as<JsonArray>();
+    if (points.isNull() || points.size() > SOIL_CAL_MAX_POINTS) {
+      sendStatic(request, 400, "application/json", "{\"error\":\"Expected up to 8 points\"}");
+      logRequest(request, 400);
+      return;
+    }
+    SoilCalPoints cal = {};
+    for (JsonObject p : points) {
+      cal.points[cal.count].raw = (uint16_t)(p["raw"] | -1);
+      cal.points[cal.count].percent = p["percent"] | -1.0f;
+      cal.count++;
+    }
+    bool reset = cal.count == 0;
+    if (reset) cal = SoilCalibration::twoPoint(SOIL_DRY_VALUE, SOIL_WET_VALUE);
+    SoilCalibration check;  // same validation and sorting the acquisition task will apply
+    if (!check.set(cal)) {
+      sendStatic(request, 400, "application/json", "{\"error\":\"Need 2-8 points, distinct raw 0-4095, percent 0-100\"}");
+      logRequest(request, 400);
+      return;
+    }
+    // NVS write blocks for a few ms; it happens here, never on the acquisition core
+    bool stored = true;
+    if (reset) clearSoilCalibration();
+    else stored = saveSoilCalibration(check.points());
+    soilCalibrationPoints.publish(check.points());
+    Serial.printf("Soil calibration set: %u points%s\n", check.points().count, stored ? "" : " (NVS write failed)");
+
+    ResponseWriter w(request);
+    w.beginObject().field("success", true).field("points", (uint32_t)check.points().count).field("stored", stored).endObject();
+    w.cors();
+    logRequest(request, w.send(200, "application/json"), w.length());
+  });
+
+  onRoute("/soil/calibration", HTTP_OPTIONS, [](AsyncWebServerRequest *request){
+    AsyncWebServerResponse *response = request->beginResponse(204);
+    response->addHeader("Access-Control-Allow-Origin", "*");
+    response->addHeader("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
+    response->addHeader("Access-Control-Allow-Headers", "Content-Type");
+    request->send(response);
+  });
+
+  // I2C diagnostics: POST starts a full scan of both buses on their workers
+  // (sensor transfers keep running in between), GET returns the device map,
+  // and once a requested scan is done stores it in NVS if it changed
+  onRoute("/i2c/scan", HTTP_POST, [](AsyncWebServerRequest *request){
+    if (i2cBus0.scanning() || i2cBus1.scanning()) {
+      sendStatic(request, 409, "application/json", "{\"error\":\"Scan already running\"}");
+      logRequest(request, 409);
+      return;
+    }
+    for (int b = 0; b < I2C_MAP_BUSES; b++) i2cBuses[b]->requestScan(I2cAddressSet::all());
+    i2cScanRequested = true;
+    logRequest(request, 202, sendStatic(request, 202, "application/json", "{\"scanning\":true}", true));
+  });
+
+  onRoute("/i2c/scan", HTTP_GET, [](AsyncWebServerRequest *request){
+    bool scanning = i2cBus0.scanning() || i2cBus1.scanning();
+    bool stored = false;
+    if (i2cScanRequested && !scanning) {
+      I2cMap found;
+      for (int b = 0; b < I2C_MAP_BUSES; b++) {
+        found.buses[b] = i2cBuses[b]->scanFound();
+        if (i2cBuses[b]->scanUs() > found.fullScanUs) found.fullScanUs = i2cBuses[b]->scanUs();
+      }
+      // NVS write blocks for a few ms; it happens here, never on the acquisition core
+      if (found != i2cMap) stored = saveI2cMap(found);
+      i2cMap = found;
+      i2cScanRequested = false;
+    }
+    ResponseWriter w(request);
+    w.beginObject();
+    w.field("scanning", scanning);
+    w.field("boot_verified", i2cMapVerified);
+    w.field("full_scan_ms", i2cMap.fullScanUs / 1000.0);
+    w.field("stored", stored);
+    w.beginArray("buses");
+    for (int b = 0; b < I2C_MAP_BUSES; b++) {
+      w.beginObject().field("bus", (int32_t)b).beginArray("devices");
+      for (uint8_t a = 1; a < 127; a++) {
+        if (!i2cMap.buses[b].test(a)) continue;
+        char addr[5];
+        snprintf(addr, sizeof(addr), "0x%02X", a);
+        w.beginObject().field("address", addr).field("name", i2cDeviceName(a)).endObject();
+      }
+      w.endArray().endObject();
+    }
+    w.endArray().endObject().cors();
+    logRequest(request, w.send(scanning ? 202 : 200, "application/json"), w.length());
+  });
+
   // Lightweight plain HTML page (no heavy CSS) for quick remote check
-  server.on("/simple", HTTP_GET, [](AsyncWebServerRequest *request){
-    String p = F("<!DOCTYPE html><html><head><meta charset='utf-8'><title>Greenhouse Simple</title><meta name='viewport' content='width=device-width,initial-scale=1'><style>body{font-family:Arial;margin:10px;}table{border-collapse:collapse;}td,th{border:1px solid #888;padding:6px;}code{background:#eee;padding:2px 4px;border-radius:4px;}</style></head><body><h2>Smart Greenhouse - Simple</h2><div id='ip'></div><table><thead><tr><th>Metric</th><th>Value</th></tr></thead><tbody><tr><td>Temperature (°C)</td><td id='t'>--</td></tr><tr><td>Pressure (hPa)</td><td id='p'>--</td></tr><tr><td>Light (lux)</td><td id='l'>--</td></tr><tr><td>Soil (%)</td><td id='s'>--</td></tr><tr><td>Uptime (s)</td><td id='u'>--</td></tr></tbody></table><p>API: <code>/api</code>, Health: <code>/health</code>, Metrics: <code>/metrics</code></p><script>function g(id){return document.getElementById(id);}function upd(){fetch('/api').then(r=>r.json()).then(d=>{g('t').textContent=d.temperature.toFixed(1);g('p').textContent=d.pressure.toFixed(2);g('l').textContent=d.light>0?d.light.toFixed(0):'N/A';g('s').textContent=d.soil>=0?d.soil.toFixed(0):'N/A';g('u').textContent=(d.timestamp/1000).toFixed(0);});}upd();setInterval(upd,2000);</script></body></html>");
-  logRequest(request,200);
-  request->send(200, "text/html", p);
+  onRoute("/simple", HTTP_GET, [](AsyncWebServerRequest *request){
+    SensorSnapshot snap = liveSnapshot.read();
+    IPAddress ip = WiFi.localIP();
+    PageResponse page(request, simplePage);
+    page.set("DEVICE_ID", "%s", deviceId).set("IP", "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+    page.set("TEMPERATURE", "%.1f", snap.temperature).set("PRESSURE", "%.2f", snap.pressure);
+    if (snap.lightLevel > 0) page.set("LIGHT", "%.0f", snap.lightLevel);
+    else page.set("LIGHT", "N/A");
+    if (snap.soilMoisture >= 0) page.set("SOIL", "%.0f", snap.soilMoisture);
+    else page.set("SOIL", "N/A");
+    page.set("UPTIME", "%lu", (unsigned long)(millis() / 1000));
+    logRequest(request,page.send(200),page.length());
   });
   // Prometheus-like metrics endpoint
-  server.on("/metrics", HTTP_GET, [](AsyncWebServerRequest *request){
-    String m;
-    m  = F("# HELP greenhouse_temperature_c Current temperature in Celsius\n");
-    m += F("# TYPE greenhouse_temperature_c gauge\n");
-    m += String("greenhouse_temperature_c ")+String(temperature,2)+"\n";
-    m += F("# HELP greenhouse_pressure_hpa Current pressure hPa\n# TYPE greenhouse_pressure_hpa gauge\n");
-    m += String("greenhouse_pressure_hpa ")+String(pressure,2)+"\n";
-    m += F("# HELP greenhouse_light_lux Light level in lux\n# TYPE greenhouse_light_lux gauge\n");
-    m += String("greenhouse_light_lux ")+String(lightLevel!=-1?lightLevel:0,2)+"\n";
-    m += F("# HELP greenhouse_soil_percent Soil moisture percent\n# TYPE greenhouse_soil_percent gauge\n");
-    m += String("greenhouse_soil_percent ")+String(soilMoisture>=0?soilMoisture:0,2)+"\n";
-    m += F("# HELP greenhouse_uptime_ms Uptime in milliseconds\n# TYPE greenhouse_uptime_ms counter\n");
-    m += String("greenhouse_uptime_ms ")+String(millis())+"\n";
-    m += F("# HELP greenhouse_free_heap_bytes Free heap bytes\n# TYPE greenhouse_free_heap_bytes gauge\n");
-    m += String("greenhouse_free_heap_bytes ")+String(ESP.getFreeHeap())+"\n";
-    logRequest(request,200);
-    request->send(200, "text/plain; version=0.0.4", m);
+  onRoute("/metrics", HTTP_GET, [](AsyncWebServerRequest *request){
+    // Rendered per scrape into a fixed slot (renderMetrics), then streamed
+    // from the leased slot: no String or heap buffer per scrape
+    char *buf = metricsCache.beginWrite();
+    if (buf) {
+      MetricsWriter w(buf, METRICS_BODY_SIZE);
+      renderMetrics(w);
+      static bool warned = false;
+      if (w.overflowed() && !warned) {  // still valid text, the last families are missing
+        Serial.println("/metrics body does not fit METRICS_BODY_SIZE");
+        warned = true;
+      }
+      metricsCache.commit(w.length());
+    }
+    size_t length;
+    AsyncWebServerResponse *response =
+      buf ? beginCachedResponse(request, metricsCache, "text/plain; version=0.0.4", nullptr, &length) : nullptr;
+    if (!response) {  // every slot still streaming to earlier scrapes
+      logRequest(request,503);
+      sendStatic(request, 503, "text/plain", "busy");
+      return;
+    }
+    request->send(response);
+    logRequest(request,200,length);
   });
   
   // ==================== WATERING API ENDPOINTS ====================
   
   // Get watering status
-  server.on("/water/status", HTTP_GET, [](AsyncWebServerRequest *request){
-    StaticJsonDocument<256> doc;
-    doc["isWatering"] = isWatering;
-    doc["autoEnabled"] = autoWateringEnabled;
-    doc["minThreshold"] = soilMinThreshold;
-    doc["maxThreshold"] = soilMaxThreshold;
-    doc["currentSoilMoisture"] = soilMoisture;
-    doc["manualWateringActive"] = manualWateringActive;
-    
-    String response;
-    serializeJson(doc, response);
-    
-    AsyncWebServerResponse *resp = request->beginResponse(200, "application/json", response);
-    resp->addHeader("Access-Control-Allow-Origin", "*");
-    request->send(resp);
-    logRequest(request, 200);
+  onRoute("/water/status", HTTP_GET, [](AsyncWebServerRequest *request){
+    SensorSnapshot snap = liveSnapshot.read();
+    ResponseWriter w(request);
+    w.beginObject();
+    w.field("isWatering", snap.isWatering);
+    w.field("autoEnabled", autoWateringEnabled);
+    w.field("minThreshold", soilMinThreshold);
+    w.field("maxThreshold", soilMaxThreshold);
+    w.field("currentSoilMoisture", snap.soilMoisture);
+    w.field("manualWateringActive", snap.manualWateringActive);
+    w.endObject().cors();
+    logRequest(request, w.send(200, "application/json"), w.length());
   });
   
   // Enable/Disable auto watering
-  server.on("/water/auto", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL, 
+  onRoute("/water/auto", HTTP_POST, [](AsyncWebServerRequest *){}, NULL, 
   [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total){
+    if (len != total) {  // body split over several calls: refuse once, on the first
+      if (index == 0) {
+        sendStatic(request, 413, "application/json", "{\"error\":\"Body too large\"}");
+        logRequest(request, 413);
+      }
+      return;
+    }
     StaticJsonDocument<256> doc;
     DeserializationError error = deserializeJson(doc, data, len);
     
     if (error) {
-      request->send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+      sendStatic(request, 400, "application/json", "{\"error\":\"Invalid JSON\"}");
+      logRequest(request, 400);
       return;
     }
     
@@ -590,10 +1313,9 @@ void setupWebServer() {
       Serial.printf("Auto watering %s\n", autoWateringEnabled ? "ENABLED" : "DISABLED");
       
       // 🔧 FIX: Όταν απενεργοποιείται το auto watering, σταμάτα αμέσως την αντλία
-      if (!autoWateringEnabled && isWatering) {
-        isWatering = false;
-        digitalWrite(RELAY_PIN, LOW);  // Απενεργοποίηση relay (LOW = OFF για active HIGH relay)
-        Serial.println("🛑 Auto watering DISABLED - Pump turned OFF");
+      // (το relay το χειρίζεται το acquisition task, εδώ μόνο το ζητάμε)
+      if (!autoWateringEnabled) {
+        wateringStopRequested = true;
       }
     }
     if (doc.containsKey("minThreshold")) {
@@ -605,23 +1327,18 @@ void setupWebServer() {
       Serial.printf("Max threshold set to %.1f%%\n", soilMaxThreshold);
     }
     
-    StaticJsonDocument<128> response;
-    response["success"] = true;
-    response["autoMode"] = autoWateringEnabled;
-    response["minThreshold"] = soilMinThreshold;
-    response["maxThreshold"] = soilMaxThreshold;
-    
-    String res;
-    serializeJson(response, res);
-    
-    AsyncWebServerResponse *resp = request->beginResponse(200, "application/json", res);
-    resp->addHeader("Access-Control-Allow-Origin", "*");
-    request->send(resp);
-    logRequest(request, 200);
+    ResponseWriter w(request);
+    w.beginObject();
+    w.field("success", true);
+    w.field("autoMode", autoWateringEnabled);
+    w.field("minThreshold", soilMinThreshold);
+    w.field("maxThreshold", soilMaxThreshold);
+    w.endObject().cors();
+    logRequest(request, w.send(200, "application/json"), w.length());
   });
   
   // OPTIONS for CORS preflight
-  server.on("/water/auto", HTTP_OPTIONS, [](AsyncWebServerRequest *request){
+  onRoute("/water/auto", HTTP_OPTIONS, [](AsyncWebServerRequest *request){
     AsyncWebServerResponse *response = request->beginResponse(204);
     response->addHeader("Access-Control-Allow-Origin", "*");
     response->addHeader("Access-Control-Allow-Methods", "POST, OPTIONS");
@@ -630,31 +1347,22 @@ void setupWebServer() {
   });
   
   // Manual watering (15 seconds)
-  server.on("/water/manual", HTTP_POST, [](AsyncWebServerRequest *request){
-    if (!manualWateringActive && !isWatering) {
-      manualWateringActive = true;
-      startWatering();
-      Serial.println("🚿 Manual watering started (15s timer)");
-      
-      StaticJsonDocument<128> response;
-      response["success"] = true;
-      response["message"] = "Manual watering started (15s)";
-      
-      String res;
-      serializeJson(response, res);
+  onRoute("/water/manual", HTTP_POST, [](AsyncWebServerRequest *request){
+    SensorSnapshot snap = liveSnapshot.read();
+    if (!snap.manualWateringActive && !snap.isWatering && !manualWateringRequested) {
+      manualWateringRequested = true;  // started by handleAutoWatering() on the acquisition core
       
-      AsyncWebServerResponse *resp = request->beginResponse(200, "application/json", res);
-      resp->addHeader("Access-Control-Allow-Origin", "*");
-      request->send(resp);
-      logRequest(request, 200);
+      ResponseWriter w(request);
+      w.beginObject().field("success", true).field("message", "Manual watering started (15s)").endObject().cors();
+      logRequest(request, w.send(200, "application/json"), w.length());
     } else {
-      request->send(400, "application/json", "{\"error\":\"Watering already active\"}");
+      sendStatic(request, 400, "application/json", "{\"error\":\"Watering already active\"}");
       logRequest(request, 400);
     }
   });
   
   // OPTIONS for CORS preflight
-  server.on("/water/manual", HTTP_OPTIONS, [](AsyncWebServerRequest *request){
+  onRoute("/water/manual", HTTP_OPTIONS, [](AsyncWebServerRequest *request){
     AsyncWebServerResponse *response = request->beginResponse(204);
     response->addHeader("Access-Control-Allow-Origin", "*");
     response->addHeader("Access-Control-Allow-Methods", "POST, OPTIONS");
@@ -663,53 +1371,74 @@ void setupWebServer() {
   });
 
   // Calibration helper endpoint
-  server.on("/calibrate", HTTP_GET, [](AsyncWebServerRequest *request){
-    String html = "<!DOCTYPE html><html><head><meta charset='utf-8'><title>Soil Calibration</title>";
-    html += "<meta name='viewport' content='width=device-width,initial-scale=1'><style>body{font-family:Arial;margin:20px;background:#f0f0f0;} .container{max-width:600px;margin:0 auto;background:white;padding:20px;border-radius:10px;} .raw{font-size:2em;text-align:center;margin:20px 0;padding:20px;background:#e3f2fd;border-radius:8px;} .step{background:#f5f5f5;padding:15px;margin:10px 0;border-radius:5px;} .code{background:#333;color:#0f0;padding:10px;border-radius:5px;font-family:monospace;}</style></head><body>";
-    html += "<div class='container'><h1>🌱 Soil Sensor Calibration</h1>";
-    html += "<div class='raw'>Current Raw: <span id='raw'>" + String(soilRaw) + "</span></div>";
-    html += "<div class='step'><h3>Step 1: Dry Measurement</h3><p>Remove sensor from soil and measure in air.</p><div class='code'>Current: " + String(soilRaw) + "</div></div>";
-    html += "<div class='step'><h3>Step 2: Wet Measurement</h3><p>Dip sensor in water and measure.</p></div>";
-    html += "<div class='step'><h3>Step 3: Update Code</h3><div class='code'>#define SOIL_DRY_VALUE " + String(soilRaw) + "<br>#define SOIL_WET_VALUE [wet_value]</div></div>";
-    html += "<script>setInterval(()=>fetch('/api').then(r=>r.json()).then(d=>document.getElementById('raw').textContent=d.soil_raw),2000);</script>";
-    html += "</div></body></html>";
-    logRequest(request,200);
-    request->send(200, "text/html", html);
+  onRoute("/calibrate", HTTP_GET, [](AsyncWebServerRequest *request){
+    PageResponse page(request, calibratePage);
+    page.set("SOIL_RAW", "%ld", (long)liveSnapshot.read().soilRaw);
+    logRequest(request,page.send(200),page.length());
   });
   
-  // History endpoint for charts
-  server.on("/history", HTTP_GET, [](AsyncWebServerRequest *request){
-    JsonDocument doc;
-    JsonArray temps = doc["temperature"].to<JsonArray>();
-    JsonArray pressures = doc["pressure"].to<JsonArray>();
-    JsonArray lights = doc["light"].to<JsonArray>();
-    JsonArray soils = doc["soil"].to<JsonArray>();
-    JsonArray timestamps = doc["timestamps"].to<JsonArray>();
-    
-    // Add historical data in chronological order
-    int start = (historyCount < MAX_HISTORY_POINTS) ? 0 : historyIndex;
-    for (int i = 0; i < historyCount; i++) {
-      int idx = (start + i) % MAX_HISTORY_POINTS;
-      temps.add(sensorHistory[idx].temperature);
-      pressures.add(sensorHistory[idx].pressure);
-      lights.add((sensorHistory[idx].lightLevel != -1) ? sensorHistory[idx].lightLevel : 0);
-      soils.add((sensorHistory[idx].soilMoisture >= 0) ? sensorHistory[idx].soilMoisture : 0);
-      timestamps.add(sensorHistory[idx].timestamp);
+  // History endpoint for charts: streamed straight from the ring buffer in
+  // TCP-sized chunks, so heap use per request is one small HistoryJsonStream
+  // With ?range=<s> and/or ?step=<s> the answer comes from the cheapest rollup
+  // tier instead (min/max/mean per bucket, see rollup.h)
+  onRoute("/history", HTTP_GET, [](AsyncWebServerRequest *request){
+    if (request->hasParam("range") || request->hasParam("step")) {
+      request->send(beginRollupResponse(request));
+      logRequest(request,200);
+      return;
     }
-    
-    String response;
-    serializeJson(doc, response);
-    
-    // Add CORS headers for remote access (GitHub Pages)
-    AsyncWebServerResponse *resp = request->beginResponse(200, "application/json", response);
+    request->send(beginHistoryResponse<HistoryJsonStream>(request, "application/json"));
+    logRequest(request,200);
+  });
+  
+  // Same data as /history, delta + zig-zag varint encoded (format in history.h)
+  onRoute("/history.bin", HTTP_GET, [](AsyncWebServerRequest *request){
+    request->send(beginHistoryResponse<HistoryBinaryStream>(request, "application/octet-stream"));
+    logRequest(request,200);
+  });
+  
+  // Long-range history from flash as CSV: /archive.csv?from=<unix>&to=<unix>
+  // (defaults: the last 7 days). Streams through a cursor, a few records at a time.
+  onRoute("/archive.csv", HTTP_GET, [](AsyncWebServerRequest *request){
+    time_t now;
+    time(&now);
+    uint32_t to = request->hasParam("to") ? strtoul(request->getParam("to")->value().c_str(), NULL, 10) : (uint32_t)now;
+    uint32_t from = request->hasParam("from") ? strtoul(request->getParam("from")->value().c_str(), NULL, 10)
+                                              : (to > 7UL * 86400 ? to - 7UL * 86400 : 0);
+    std::shared_ptr<HistoryCsvStream> stream = std::make_shared<HistoryCsvStream>(historyStore.query(from, to));
+    AsyncWebServerResponse *resp = request->beginChunkedResponse("text/csv",
+      [stream](uint8_t *buffer, size_t maxLen, size_t) -> size_t {
+        return stream->fill(buffer, maxLen);
+      });
     resp->addHeader("Access-Control-Allow-Origin", "*");
-    resp->addHeader("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
-    resp->addHeader("Access-Control-Allow-Headers", "Content-Type");
     request->send(resp);
     logRequest(request,200);
   });
   
-  server.onNotFound([](AsyncWebServerRequest *request){ logRequest(request,404); request->send(404,"text/plain","File not found"); });
+#if ENABLE_TRACE
+  // Spans of the last ?seconds=<n> (default 2) as Chrome trace-event JSON
+  // (trace.h): open in chrome://tracing or ui.perfetto.dev
+  onRoute("/trace", HTTP_GET, [](AsyncWebServerRequest *request){
+    uint32_t seconds = request->hasParam("seconds") ? strtoul(request->getParam("seconds")->value().c_str(), NULL, 10)
+                                                    : TRACE_DEFAULT_SECONDS;
+    std::shared_ptr<TraceJsonStream> stream = std::make_shared<TraceJsonStream>(seconds);
+    AsyncWebServerResponse *resp = request->beginChunkedResponse("application/json",
+      [stream](uint8_t *buffer, size_t maxLen, size_t) -> size_t {
+        return stream->fill(buffer, maxLen);
+      });
+    resp->addHeader("Access-Control-Allow-Origin", "*");
+    request->send(resp);
+    logRequest(request,200);
+  });
+#endif
+  
+  server.onNotFound([](AsyncWebServerRequest *request){
+    TRACE_SCOPE("(not found)");
+    beginRequest(REQUEST_ROUTE_NONE);
+    logRequest(request,404);
+    sendStatic(request, 404, "text/plain", "File not found");
+    endRequest();
+  });
 }
 
 // ==================== WATERING SYSTEM FUNCTIONS ====================
@@ -720,7 +1449,14 @@ void startWatering() {
     digitalWrite(RELAY_PIN, HIGH);       // Turn ON relay (pump ON) - active HIGH
     isWatering = true;
     wateringStartTime = millis();
-    Serial.println("💧 WATERING STARTED - Relay ON (active HIGH)");
+    relayCycles.inc();
+    if (binaryTelemetry) {
+      telemetry.begin(TELEMETRY_WATERING, millis()).u8(1).u8(manualWateringActive).f32(soilMoisture);
+      sendTelemetry();
+    } else {
+      Serial.println("💧 WATERING STARTED - Relay ON (active HIGH)");
+    }
+    pushWateringEvent();
   }
 }
 
@@ -728,13 +1464,33 @@ void stopWatering() {
   if (isWatering) {
     digitalWrite(RELAY_PIN, LOW);        // Turn OFF relay (pump OFF) - active HIGH
     isWatering = false;
+    unsigned long wateredMs = millis() - wateringStartTime;
+    wateringMs.inc(wateredMs);
+    lastWateringSeconds.set(wateredMs / 1000.0f);
+    if (binaryTelemetry) {
+      telemetry.begin(TELEMETRY_WATERING, millis()).u8(0).u8(manualWateringActive).f32(soilMoisture);
+      sendTelemetry();
+    } else {
+      Serial.println("🛑 WATERING STOPPED - Relay OFF (active HIGH)");
+    }
     manualWateringActive = false;
-    Serial.println("🛑 WATERING STOPPED - Relay OFF (active HIGH)");
+    pushWateringEvent();
   }
 }
 
 // Automatic watering logic
 void handleAutoWatering() {
+  // Commands queued by the web handlers on the network core
+  if (wateringStopRequested.exchange(false) && isWatering) {
+    stopWatering();
+    Serial.println("🛑 Auto watering DISABLED - Pump turned OFF");
+  }
+  if (manualWateringRequested.exchange(false) && !isWatering) {
+    manualWateringActive = true;
+    startWatering();
+    Serial.println("🚿 Manual watering started (15s timer)");
+  }
+  
   // Handle manual watering timer (15 seconds)
   if (manualWateringActive) {
     if (millis() - wateringStartTime >= manualWateringDuration) {
@@ -759,81 +1515,140 @@ void handleAutoWatering() {
   }
 }
 
-void loop() {
-  // Check BMP280 sensor connection
-  float newTemp = bmp.readTemperature();
-  float newPressure = bmp.readPressure() / 100.0F;
-  
-  // Validate BMP280 readings (NaN means disconnected)
-  if (isnan(newTemp) || isnan(newPressure) || newTemp < -50 || newTemp > 100) {
+// ==================== SENSOR ACQUISITION STEPS ====================
+
+// Both BMP280 registry entries come due in the same pass: the first start
+// queues the burst, whichever collect runs first decodes it and the other
+// reuses the sample
+static bool bmpSampleFresh() {
+  return bmpSampleValid && micros() - bmpSampleUs < BMP_SAMPLE_REUSE_US;
+}
+
+void startBmpBurst() {
+  if (!bmpSampleFresh() && !bmp.requested()) bmp.startRead();
+}
+
+static SensorStep readBmpSample() {
+  if (bmpSampleFresh()) return SENSOR_STEP_DONE;
+  if (!bmp.requested()) bmp.startRead();  // a refused burst shows up as BMP280_ERROR
+  switch (bmp.pollRead(bmpSample)) {
+    case BMP280_BUSY:
+      return SENSOR_STEP_AGAIN;
+    case BMP280_READY:
+      bmpSampleValid = true;
+      bmpSampleUs = micros();
+      return SENSOR_STEP_DONE;
+    default:
+      bmpSampleValid = false;
+      return SENSOR_STEP_FAILED;
+  }
+}
+
+SensorStep collectTemperature() {
+  SensorStep step = readBmpSample();
+  if (step == SENSOR_STEP_AGAIN) return step;
+  // A failed burst, missing sensor or skipped measurement means disconnected
+  float newTemp = step == SENSOR_STEP_DONE ? bmpSample.temperature() : NAN;
+  if (isnan(newTemp) || newTemp < -50 || newTemp > 100) {
     temperature = -999; // Error indicator
+    return SENSOR_STEP_FAILED;
+  }
+  temperature = newTemp;
+  return SENSOR_STEP_DONE;
+}
+
+SensorStep collectPressure() {
+  SensorStep step = temperature != -999 ? readBmpSample() : SENSOR_STEP_FAILED;
+  if (step == SENSOR_STEP_AGAIN) return step;
+  float newPressure = step == SENSOR_STEP_DONE ? bmpSample.pressurePa() / 100.0F : NAN;
+  if (isnan(newPressure)) {
     pressure = -999;    // Error indicator
-  } else {
-    temperature = newTemp;
-    pressure = newPressure;
+    return SENSOR_STEP_FAILED;
   }
-  
-  // Check BH1750 sensor connection
-  if (lightLevel != -1) {
-    float newLight = lightMeter.readLightLevel();
-    if (isnan(newLight) || newLight < 0) {
-      lightLevel = -1; // Mark as disconnected
-    } else {
+  pressure = newPressure;
+  return SENSOR_STEP_DONE;
+}
+
+void startLight() {
+  if (lightMeter.present()) lightMeter.start(millis());
+}
+
+SensorStep collectLight() {
+  // Missing until the engine's prober finds it again (serviceI2c)
+  if (!lightMeter.present()) {
+    lightLevel = -1;
+    return SENSOR_STEP_FAILED;
+  }
+  float newLight;
+  switch (lightMeter.collect(millis(), newLight)) {
+    case BH1750_READY:
       lightLevel = newLight;
+      return SENSOR_STEP_DONE;
+    case BH1750_BUSY:     // conversion time depends on the range
+    case BH1750_RANGING:  // saturated, re-measuring one range up
+      return SENSOR_STEP_AGAIN;
+    default:
+      lightLevel = -1; // Mark as disconnected
+      return SENSOR_STEP_FAILED;
+  }
+}
+
+// Periodic task: the background half of boot, and the WiFi link's
+// reconnects for as long as the device runs. Waits for the link, starts
+// SNTP, then polls for the first sync without blocking (the old setup()
+// spun on WiFi.status() and sat in getLocalTime() for 5 s).
+void serviceNetwork() {
+  wifiLink.service(millis());
+  switch (netPhase) {
+    case NET_WIFI:
+      if (!wifiLink.up()) return;
+      bootPhaseEnd("wifi", netPhaseStartUs);
+      Serial.printf("WiFi connected after %lu ms (%s): %s\n", (micros() - netPhaseStartUs) / 1000,
+                    wifiLink.stats().fastConnects ? "cached AP" : "full scan", WiFi.localIP().toString().c_str());
+      configTime(gmtOffset_sec, daylightOffset_sec, ntpServer);
+      netPhase = NET_NTP;
+      netPhaseStartUs = micros();
+      return;
+    case NET_NTP: {
+      struct tm timeinfo;
+      if (!getLocalTime(&timeinfo, 0)) return;
+      time_t now;
+      time(&now);
+      unsigned long bootEpoch = (unsigned long)now - millis() / 1000;
+      timeInitialized = true;
+      applyBootEpoch(bootEpoch);
+      bootPhaseEnd("ntp", netPhaseStartUs);
+      Serial.print("Time synchronized with NTP server: ");
+      Serial.println(&timeinfo, "%Y-%m-%d %H:%M:%S");
+      netPhase = NET_READY;
+      printBootPhases();
+      return;
     }
+    default:
+      return;
   }
-  
-  // Check soil sensor connection
-  soilMoisture = readSoilMoisturePercent();
-  
-  // Add to history every 5 minutes
-  addToHistory();
-  
-  // Update sensor registry
-  updateSensorRegistry();
-  
-  // Calibration and alerts
-  calibrateSoilSensor();
-  checkAlerts();
-  
-  // Automatic watering control
-  handleAutoWatering();
-  
-  // Update LED status based on network conditions
-  updateLEDStatus();
-  
-  // 🔴 Remote Public IP transmission (if configured)
+}
+
+// Periodic task: host-side probes, and begin() again for a sensor that came
+// back (the probe only checks the address ACKs)
+void serviceI2c() {
+  unsigned long now = millis();
+  i2cBus0.poll(now);
+  i2cBus1.poll(now);
+  if (bmpDevice.takeRedetected() && initializeBMP280()) Serial.println("BMP280 back on bus 0");
+  if (lightDevice.takeRedetected() && initializeBH1750()) Serial.println("BH1750 back on bus 1");
+}
+
+// 🔴 Remote Public IP transmission (if configured) + cloud sync
+// Acquisition side: only publishes the sample; sendRemoteSample() posts it
+void handleRemoteSync() {
   if (strlen(REMOTE_PUBLIC_IP) > 0 && millis() - lastRemoteAttempt >= REMOTE_SYNC_INTERVAL) {
     lastRemoteAttempt = millis();
-    
-    HTTPClient http;
-    http.begin(REMOTE_PUBLIC_IP);
-    http.addHeader("Content-Type", "application/json");
-    
-    // Build JSON payload
-    StaticJsonDocument<512> doc;
-    doc["device"] = deviceId;
-    doc["temperature"] = temperature;
-    doc["pressure"] = pressure;
-    doc["light"] = lightLevel;
-    doc["soil"] = soilMoisture;
-    doc["timestamp"] = millis();
-    
-    String payload;
-    serializeJson(doc, payload);
-    
-    int httpCode = http.POST(payload);
-    
-    if (httpCode == 200 || httpCode == 201) {
-      remoteTransmissionOK = true;
-      lastRemoteTransmission = millis();
-      Serial.printf("🔴 Remote transmission OK (HTTP %d)\\n", httpCode);
-    } else {
-      remoteTransmissionOK = false;
-      Serial.printf("💥 Remote transmission FAILED (HTTP %d)\\n", httpCode);
-    }
-    
-    http.end();
+    RemoteSample sample = {temperature, pressure, lightLevel, soilMoisture, (uint32_t)millis()};
+    remoteOutbox.publish(sample);
+#if !REMOTE_SYNC_TASK
+    sendRemoteSample();
+#endif
   }
   
   // Cloud sync (if enabled - Firebase/other)
@@ -841,31 +1656,533 @@ void loop() {
     sendToCloud();
     lastCloudSync = millis();
   }
+}
+
+// Network core: POSTs the newest sample from handleRemoteSync(), once
+void sendRemoteSample() {
+  static uint32_t sent = 0;
+  uint32_t version = remoteOutbox.version();
+  if (version == sent) return;
+  sent = version;
+  RemoteSample sample = remoteOutbox.read();
+  HTTPClient http;
+  http.begin(REMOTE_PUBLIC_IP);
+  http.addHeader("Content-Type", "application/json");
+  
+  // Build JSON payload
+  StaticJsonDocument<512> doc;
+  doc["device"] = deviceId;
+  doc["temperature"] = sample.temperature;
+  doc["pressure"] = sample.pressure;
+  doc["light"] = sample.lightLevel;
+  doc["soil"] = sample.soilMoisture;
+  doc["timestamp"] = sample.takenAtMs;
+  
+  String payload;
+  serializeJson(doc, payload);
+  
+  TRACE_BEGIN(post, "remote POST");
+  int httpCode = http.POST(payload);
+  TRACE_END(post);
+  
+  if (httpCode == 200 || httpCode == 201) {
+    remoteTransmissionOK = true;
+    lastRemoteTransmission = millis();
+    Serial.printf("🔴 Remote transmission OK (HTTP %d)\\n", httpCode);
+  } else {
+    remoteTransmissionOK = false;
+    Serial.printf("💥 Remote transmission FAILED (HTTP %d)\\n", httpCode);
+  }
   
+  http.end();
+}
+
+#if REMOTE_SYNC_TASK
+static void remoteSyncTask(void *) {
+  for (;;) {
+    sendRemoteSample();
+    vTaskDelay(pdMS_TO_TICKS(REMOTE_SYNC_POLL_MS));
+  }
+}
+#endif
+
+void runAlerts() {
+  calibrateSoilSensor();
+  checkAlerts();
+}
+
+void printSensorStatus() {
+  if (binaryTelemetry) {
+    SoilAdcStats adc = soilAdc.stats();
+    telemetry.begin(TELEMETRY_SAMPLE, millis()).f32(temperature).f32(pressure).f32(lightLevel).f32(soilMoisture)
+      .u16((uint16_t)(soilRaw + 0.5f)).u32(adc.samples).u32(adc.overruns);
+    sendTelemetry();
+    return;
+  }
   Serial.print("Temperature: "); Serial.print(temperature); Serial.print(" °C, Pressure: "); Serial.print(pressure); Serial.print(" hPa");
   if (lightLevel != -1) { Serial.print(", Light: "); Serial.print(lightLevel); Serial.print(" lux"); } else { Serial.print(", Light: N/A"); }
   
-  // Direct ADC read for troubleshooting
-  int directADC = analogRead(SOIL_PIN);
-  
   if (soilMoisture >= 0) {
     Serial.print(", Soil: "); Serial.print(soilMoisture); Serial.print(" %");
 #if ENABLE_SOIL_DEBUG
-    Serial.print(" (filtered="); Serial.print(soilRaw); Serial.print(", direct="); Serial.print(directADC); Serial.print(")");
+    // analogRead() would fight the continuous driver for ADC1; show its counters instead
+    SoilAdcStats adc = soilAdc.stats();
+    Serial.print(" (filtered="); Serial.print(soilRaw); Serial.print(", samples="); Serial.print(adc.samples);
+    Serial.print(", overruns="); Serial.print(adc.overruns); Serial.print(")");
 #endif
     Serial.println();
   } else {
     Serial.println(", Soil: N/A");
   }
-  delay(500);
+}
+
+// ==================== COOPERATIVE SCHEDULER ====================
+// Sensors come from sensors[] (period + conversion time each); everything
+// else is a plain periodic task. Nothing here may block.
+
+struct PeriodicTask {
+  const char* name;
+  unsigned long periodMs;
+  void (*run)();
+  TaskTiming timing;
+};
+
+PeriodicTask periodicTasks[] = {
+  {"watering", 100, handleAutoWatering, {}},
+  {"led", 50, updateLEDStatus, {}},
+  {"history", 1000, addToHistory, {}},
+  {"rollup", ROLLUP_RAW_PERIOD_MS, addToRollup, {}},
+  {"soil adc", SOIL_ADC_DRAIN_MS, drainSoilAdc, {}},
+  {"i2c", 100, serviceI2c, {}},
+  {"network", 100, serviceNetwork, {}},
+  {"alerts", 1000, runAlerts, {}},
+  {"remote", 1000, handleRemoteSync, {}},
+  {"status", 500, printSensorStatus, {}},
+  {"telemetry", TELEMETRY_TIMING_MS, sendTimingTelemetry, {}},
+#if !REQUEST_LOG_TASK
+  {"reqlog", REQUEST_LOG_DRAIN_MS, drainRequestLog, {}},
+#endif
+};
+#define PERIODIC_TASK_COUNT (sizeof(periodicTasks) / sizeof(periodicTasks[0]))
+
+// Binary mode only: one TIMING record per scheduler slot (sensors, then tasks)
+void sendTimingTelemetry() {
+  if (!binaryTelemetry) return;
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    telemetry.begin(TELEMETRY_TIMING, millis()).u8(i).u32(sensors[i].timing.runs)
+      .u32(sensors[i].timing.maxJitterUs).str(sensors[i].name);
+    sendTelemetry();
+  }
+  for (size_t i = 0; i < PERIODIC_TASK_COUNT; i++) {
+    const PeriodicTask &task = periodicTasks[i];
+    telemetry.begin(TELEMETRY_TIMING, millis()).u8(SENSOR_COUNT + i).u32(task.timing.runs)
+      .u32(task.timing.maxJitterUs).str(task.name);
+    sendTelemetry();
+  }
+}
+
+static inline bool isDue(unsigned long dueUs, unsigned long nowUs) {
+  return (long)(nowUs - dueUs) >= 0;
+}
+
+static void noteJitter(TaskTiming &t, unsigned long nowUs) {
+  if (t.runs > 0) {
+    unsigned long late = nowUs - t.nextDueUs;
+    if (late > t.maxJitterUs) t.maxJitterUs = late;
+  }
+  t.runs++;
+}
+
+// Keep the cadence fixed; if we fell behind by a whole period, skip ahead instead of bursting
+static void scheduleNext(TaskTiming &t, unsigned long periodMs, unsigned long nowUs) {
+  unsigned long periodUs = periodMs * 1000UL;
+  t.nextDueUs = (t.runs > 1) ? t.nextDueUs + periodUs : nowUs + periodUs;
+  if (isDue(t.nextDueUs, nowUs)) t.nextDueUs = nowUs + periodUs;
+}
+
+// Returns true when a new value (or failure) was published to the registry
+static bool pollSensor(SensorInfo &s) {
+  if (!s.enabled || !s.collect) return false;
+  TaskTiming &t = s.timing;
+  unsigned long now = micros();
+  
+  if (!t.converting) {
+    if (!isDue(t.nextDueUs, now)) return false;
+    noteJitter(t, now);
+    if (s.start) s.start();
+    t.converting = true;
+    t.readyAtUs = now + s.conversionMs * 1000UL;
+  }
+  if (!isDue(t.readyAtUs, now)) return false;
+  
+  TRACE_BEGIN(collect, s.name);
+  SensorStep step = s.collect();
+  TRACE_END(collect);
+  if (step == SENSOR_STEP_AGAIN) {
+    t.readyAtUs += s.conversionMs * 1000UL;
+    return false;
+  }
+  int index = &s - sensors;
+  sensorReads[index].inc();
+  if (step == SENSOR_STEP_FAILED) sensorFailures[index].inc();
+  // Error markers (-999 / -1) bypass the chain; the next good read starts it afresh
+  if (step == SENSOR_STEP_DONE) *s.value = s.filter.apply(*s.value);
+  else s.filter.reset();
+  t.converting = false;
+  scheduleNext(t, s.periodMs, now);
+  updateSensorRegistry();
+  apiBodyStale = true;
+  return true;
+}
+
+// Takes over a filter chain posted to /sensors/filter (state restarts)
+static void applyFilterConfig(int i) {
+  static uint32_t applied[SENSOR_COUNT];
+  uint32_t version = sensorFilterConfig[i].version();
+  if (version == applied[i]) return;
+  sensors[i].filter.configure(sensorFilterConfig[i].read());
+  applied[i] = version;
+}
+
+void runScheduler() {
+  TRACE_BEGIN(pass, "scheduler");
+  bool changed = false;
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    applyFilterConfig(i);
+    changed |= pollSensor(sensors[i]);
+  }
+  for (size_t i = 0; i < PERIODIC_TASK_COUNT; i++) {
+    PeriodicTask &task = periodicTasks[i];
+    unsigned long now = micros();
+    if (!isDue(task.timing.nextDueUs, now)) continue;
+    noteJitter(task.timing, now);
+    {
+      TRACE_SCOPE(task.name);
+      task.run();
+    }
+    scheduleNext(task.timing, task.periodMs, now);
+    changed = true;
+  }
+  if (changed) publishSnapshot();
+  else TRACE_CANCEL(pass);  // idle pass: would only crowd the ring
+}
+
+void publishSnapshot() {
+  TRACE_SCOPE("publish");
+  SensorSnapshot snap;
+  snap.temperature = temperature;
+  snap.pressure = pressure;
+  snap.lightLevel = lightLevel;
+  snap.soilMoisture = soilMoisture;
+  snap.soilRaw = soilRaw;
+  snap.bmpRawTemperature = bmpSampleValid ? bmpSample.rawTemperature : 0;
+  snap.bmpRawPressure = bmpSampleValid ? bmpSample.rawPressure : 0;
+  snap.lightCounts = lightMeter.counts();
+  snap.lightRange = lightMeter.countsRange();
+  snap.minTemperature = minTemperature;
+  snap.maxTemperature = maxTemperature;
+  snap.totalReadings = totalReadingsCount;
+  snap.publishedAtMs = millis();
+  snap.isWatering = isWatering;
+  snap.manualWateringActive = manualWateringActive;
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    snap.sensorAvailable[i] = sensors[i].available;
+    snap.sensorValue[i] = sensors[i].lastValue;
+    snap.sensorLastRead[i] = sensors[i].lastRead;
+    snap.windowStats[i] = historyWindow[i].summary();
+  }
+  liveSnapshot.publish(snap);
+  if (apiBodyStale) renderApiBody(snap);
+  pushSensorEvents(snap);
+}
+
+// Appends to a fixed buffer; *len jumps to size once anything overflows
+static void jsonAppend(char *buf, size_t size, size_t *len, const char *fmt, ...) {
+  if (*len >= size) return;
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(buf + *len, size - *len, fmt, args);
+  va_end(args);
+  *len = (n < 0 || (size_t)n >= size - *len) ? size : *len + n;
+}
+
+// "key":value, comma-separated unless it opens an object; NaN/inf -> null
+static void jsonAppendNumber(char *buf, size_t size, size_t *len, const char *key, float v) {
+  const char *sep = (*len < size && *len > 0 && buf[*len - 1] != '{') ? "," : "";
+  if (isnan(v) || isinf(v)) {
+    jsonAppend(buf, size, len, "%s\"%s\":null", sep, key);
+  } else {
+    jsonAppend(buf, size, len, "%s\"%s\":%.7g", sep, key, (double)v);
+  }
+}
+
+// Renders the /api JSON for this snapshot into a spare cache slot. Runs on
+// the acquisition core, so RSSI and the timestamp are those of the sample.
+void renderApiBody(const SensorSnapshot &snap) {
+  char *buf = apiCache.beginWrite();
+  if (!buf) return;  // every spare still streaming; retry on the next publish
+  size_t len = 0;
+  jsonAppend(buf, API_BODY_SIZE, &len, "{");
+  jsonAppendNumber(buf, API_BODY_SIZE, &len, "temperature", snap.temperature);
+  jsonAppendNumber(buf, API_BODY_SIZE, &len, "pressure", snap.pressure);
+  jsonAppendNumber(buf, API_BODY_SIZE, &len, "light", snap.lightLevel);  // -1 when disconnected, not 0
+  jsonAppendNumber(buf, API_BODY_SIZE, &len, "soil", snap.soilMoisture);
+  jsonAppend(buf, API_BODY_SIZE, &len, ",\"timestamp\":%lu", (unsigned long)snap.publishedAtMs);
+  jsonAppendNumber(buf, API_BODY_SIZE, &len, "minTemperature", snap.minTemperature);
+  jsonAppendNumber(buf, API_BODY_SIZE, &len, "maxTemperature", snap.maxTemperature);
+  jsonAppend(buf, API_BODY_SIZE, &len, ",\"totalReadings\":%ld,\"wifiRSSI\":%d,\"stats\":{",
+            (long)snap.totalReadings, (int)WiFi.RSSI());
+  // 24h sliding-window stats per sensor (null while the window is empty)
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    const WindowSummary &w = snap.windowStats[i];
+    jsonAppend(buf, API_BODY_SIZE, &len, "%s\"%s\":{", i ? "," : "", SENSOR_KEYS[i]);
+    jsonAppendNumber(buf, API_BODY_SIZE, &len, "min", w.min);
+    jsonAppendNumber(buf, API_BODY_SIZE, &len, "max", w.max);
+    jsonAppendNumber(buf, API_BODY_SIZE, &len, "mean", w.mean);
+    jsonAppendNumber(buf, API_BODY_SIZE, &len, "stddev", w.stddev);
+    jsonAppend(buf, API_BODY_SIZE, &len, ",\"count\":%u}", w.count);
+  }
+  jsonAppend(buf, API_BODY_SIZE, &len, "}}");
+  if (len >= API_BODY_SIZE) {
+    Serial.println("/api body does not fit API_BODY_SIZE");
+    return;
+  }
+  apiCache.commit(len);
+  apiBodyStale = false;
+}
+
+// Prometheus text for /metrics. Runs on the AsyncTCP task at scrape time:
+// sensor values come from the snapshot, heap/WiFi/I2C are read now, the
+// rest from the counters and histograms the hot paths feed.
+void renderMetrics(MetricsWriter &w) {
+  SensorSnapshot snap = liveSnapshot.read();
+  char labels[64];
+
+  w.family("greenhouse_temperature_c", "gauge", "Current temperature in Celsius");
+  w.sample("greenhouse_temperature_c", nullptr, (double)snap.temperature);
+  w.family("greenhouse_pressure_hpa", "gauge", "Current pressure hPa");
+  w.sample("greenhouse_pressure_hpa", nullptr, (double)snap.pressure);
+  w.family("greenhouse_light_lux", "gauge", "Light level in lux");
+  w.sample("greenhouse_light_lux", nullptr, (double)(snap.lightLevel != -1 ? snap.lightLevel : 0));
+  w.family("greenhouse_soil_percent", "gauge", "Soil moisture percent");
+  w.sample("greenhouse_soil_percent", nullptr, (double)(snap.soilMoisture >= 0 ? snap.soilMoisture : 0));
+
+  // Per-sensor families, labelled from the sensors[] registry
+  w.family("greenhouse_sensor_value", "gauge", "Last filtered reading per sensor, in its unit");
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    if (!snap.sensorAvailable[i]) continue;
+    snprintf(labels, sizeof(labels), "sensor=\"%s\",unit=\"%s\"", SENSOR_KEYS[i], sensors[i].unit);
+    w.sample("greenhouse_sensor_value", labels, (double)snap.sensorValue[i]);
+  }
+  w.family("greenhouse_sensor_up", "gauge", "1 if the sensor's last read succeeded");
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    snprintf(labels, sizeof(labels), "sensor=\"%s\"", SENSOR_KEYS[i]);
+    w.sample("greenhouse_sensor_up", labels, (uint32_t)snap.sensorAvailable[i]);
+  }
+  w.family("greenhouse_sensor_reads_total", "counter", "Completed reads per sensor");
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    snprintf(labels, sizeof(labels), "sensor=\"%s\"", SENSOR_KEYS[i]);
+    w.sample("greenhouse_sensor_reads_total", labels, sensorReads[i].value());
+  }
+  w.family("greenhouse_sensor_failures_total", "counter", "Failed reads per sensor");
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    snprintf(labels, sizeof(labels), "sensor=\"%s\"", SENSOR_KEYS[i]);
+    w.sample("greenhouse_sensor_failures_total", labels, sensorFailures[i].value());
+  }
+
+  static const char *const WINDOW_STATS[4] = {"min", "max", "mean", "stddev"};
+  char name[48];
+  char help[64];
+  for (int k = 0; k < 4; k++) {
+    snprintf(name, sizeof(name), "greenhouse_window_%s", WINDOW_STATS[k]);
+    snprintf(help, sizeof(help), "24h sliding-window %s per sensor", WINDOW_STATS[k]);
+    w.family(name, "gauge", help);
+    for (int i = 0; i < SENSOR_COUNT; i++) {
+      const WindowSummary &ws = snap.windowStats[i];
+      if (!ws.count) continue;
+      float v = k == 0 ? ws.min : (k == 1 ? ws.max : (k == 2 ? ws.mean : ws.stddev));
+      snprintf(labels, sizeof(labels), "sensor=\"%s\"", SENSOR_KEYS[i]);
+      w.sample(name, labels, (double)v);
+    }
+  }
+  w.family("greenhouse_window_samples", "gauge", "Valid samples in the 24h window per sensor");
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    snprintf(labels, sizeof(labels), "sensor=\"%s\"", SENSOR_KEYS[i]);
+    w.sample("greenhouse_window_samples", labels, (uint32_t)snap.windowStats[i].count);
+  }
+
+  w.family("greenhouse_loop_duration_seconds", "histogram", "Scheduler pass (sensor polls and periodic tasks)");
+  w.histogram("greenhouse_loop_duration_seconds", nullptr, loopDuration, 1e-6);
+  w.family("greenhouse_scheduler_max_jitter_seconds", "gauge", "Worst lateness of a scheduled task since boot");
+  w.sample("greenhouse_scheduler_max_jitter_seconds", nullptr, schedulerMaxJitterUs() * 1e-6);
+  w.family("greenhouse_soil_read_seconds", "histogram", "Soil moisture read (filtered ADC and calibration)");
+  w.histogram("greenhouse_soil_read_seconds", nullptr, soilReadDuration, 1e-6);
+
+  w.family("greenhouse_http_request_duration_seconds", "histogram", "Handler time, entry to response queued");
+  w.histogram("greenhouse_http_request_duration_seconds", nullptr, httpDuration, 1e-6);
+  w.family("greenhouse_http_requests_total", "counter", "Requests per route and status class");
+  for (int route = 0; route <= REQUEST_LOG_ROUTES; route++) {
+    for (int c = 0; c < 5; c++) {
+      uint32_t n = httpRequests[route][c].value();
+      if (!n) continue;
+      snprintf(labels, sizeof(labels), "route=\"%s\",code=\"%dxx\"",
+               route < REQUEST_LOG_ROUTES ? requestLog.routeName(route) : "(none)", c + 1);
+      w.sample("greenhouse_http_requests_total", labels, n);
+    }
+  }
+  w.family("greenhouse_request_log_dropped_total", "counter", "Request log records dropped on a full ring");
+  w.sample("greenhouse_request_log_dropped_total", nullptr, requestLog.dropped());
+
+  static const char *const I2C_DEVICE_NAMES[] = {"bmp280", "bh1750"};
+  I2cDeviceStats ds[2] = {bmpDevice.stats(), lightDevice.stats()};
+  w.family("greenhouse_i2c_transfers_total", "counter", "I2C transfers per device");
+  for (int i = 0; i < 2; i++) {
+    snprintf(labels, sizeof(labels), "device=\"%s\"", I2C_DEVICE_NAMES[i]);
+    w.sample("greenhouse_i2c_transfers_total", labels, ds[i].transfers);
+  }
+  w.family("greenhouse_i2c_failures_total", "counter", "Failed I2C transfers per device");
+  for (int i = 0; i < 2; i++) {
+    snprintf(labels, sizeof(labels), "device=\"%s\"", I2C_DEVICE_NAMES[i]);
+    w.sample("greenhouse_i2c_failures_total", labels, ds[i].failures);
+  }
+  I2cBusStats bs[2] = {i2cBus0.stats(), i2cBus1.stats()};
+  w.family("greenhouse_i2c_bus_errors_total", "counter", "Bus-level I2C errors (NACK, timeout, arbitration)");
+  for (int i = 0; i < 2; i++) {
+    snprintf(labels, sizeof(labels), "bus=\"%d\"", i);
+    w.sample("greenhouse_i2c_bus_errors_total", labels, bs[i].errors);
+  }
+  w.family("greenhouse_i2c_bus_recoveries_total", "counter", "Stuck-bus recoveries (SCL clocked out)");
+  for (int i = 0; i < 2; i++) {
+    snprintf(labels, sizeof(labels), "bus=\"%d\"", i);
+    w.sample("greenhouse_i2c_bus_recoveries_total", labels, bs[i].recoveries);
+  }
+
+  w.family("greenhouse_relay_cycles_total", "counter", "Pump relay switch-ons");
+  w.sample("greenhouse_relay_cycles_total", nullptr, relayCycles.value());
+  w.family("greenhouse_watering_seconds_total", "counter", "Time the pump has run");
+  w.sample("greenhouse_watering_seconds_total", nullptr, wateringMs.value() / 1000.0);
+  w.family("greenhouse_watering_last_seconds", "gauge", "Length of the last completed watering");
+  w.sample("greenhouse_watering_last_seconds", nullptr, (double)lastWateringSeconds.value());
+  w.family("greenhouse_watering_active", "gauge", "1 while the pump runs");
+  w.sample("greenhouse_watering_active", nullptr, (uint32_t)snap.isWatering);
+
+  WifiLinkStats ws = wifiLink.stats();
+  w.family("greenhouse_wifi_reconnect_ms", "gauge", "Link loss (or boot) to IP address, last and worst");
+  w.sample("greenhouse_wifi_reconnect_ms", "stat=\"last\"", ws.lastConnectMs);
+  w.sample("greenhouse_wifi_reconnect_ms", "stat=\"max\"", ws.maxConnectMs);
+  w.family("greenhouse_wifi_connects_total", "counter", "Successful connects by path");
+  w.sample("greenhouse_wifi_connects_total", "path=\"fast\"", ws.fastConnects);
+  w.sample("greenhouse_wifi_connects_total", "path=\"scan\"", ws.scanConnects);
+  w.family("greenhouse_wifi_fallbacks_total", "counter", "Cached-AP connects that fell back to a full scan");
+  w.sample("greenhouse_wifi_fallbacks_total", nullptr, ws.fallbacks);
+  w.family("greenhouse_wifi_drops_total", "counter", "Link losses");
+  w.sample("greenhouse_wifi_drops_total", nullptr, ws.drops);
+
+  w.family("greenhouse_uptime_ms", "counter", "Uptime in milliseconds");
+  w.sample("greenhouse_uptime_ms", nullptr, (uint32_t)millis());
+  w.family("greenhouse_free_heap_bytes", "gauge", "Free heap bytes");
+  w.sample("greenhouse_free_heap_bytes", nullptr, (uint32_t)ESP.getFreeHeap());
+  w.family("greenhouse_min_free_heap_bytes", "gauge", "Lowest free heap since boot");
+  w.sample("greenhouse_min_free_heap_bytes", nullptr, (uint32_t)ESP.getMinFreeHeap());
+  w.family("greenhouse_largest_free_block_bytes", "gauge", "Largest allocatable heap block (fragmentation)");
+  w.sample("greenhouse_largest_free_block_bytes", nullptr, (uint32_t)ESP.getMaxAllocHeap());
+  w.family("greenhouse_metrics_body_bytes", "gauge", "Bytes of this body before this line (limit METRICS_BODY_SIZE)");
+  w.sample("greenhouse_metrics_body_bytes", nullptr, (uint32_t)w.length());
+}
+
+// Sensors that moved past their deadband (or came/went) since the last push,
+// as one `sensors` event with the /api keys of just those values
+void pushSensorEvents(const SensorSnapshot &snap) {
+  static float pushed[SENSOR_COUNT];
+  static bool primed = false;
+  const float values[SENSOR_COUNT] = {snap.temperature, snap.pressure, snap.lightLevel, snap.soilMoisture};
+  char data[EVENT_DATA_MAX];
+  size_t len = 0;
+  jsonAppend(data, sizeof(data), &len, "{");
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    float v = values[i];
+    bool crossed = sensors[i].missing(v) != sensors[i].missing(pushed[i]);  // came or went
+    if (primed && !crossed && fabsf(v - pushed[i]) <= sensors[i].deadband) continue;
+    jsonAppendNumber(data, sizeof(data), &len, SENSOR_KEYS[i], v);
+    pushed[i] = v;
+  }
+  if (len == 1 && primed) return;  // nothing moved
+  primed = true;
+  jsonAppend(data, sizeof(data), &len, "%s\"timestamp\":%lu}", len > 1 ? "," : "",
+             (unsigned long)snap.publishedAtMs);
+  if (len < sizeof(data)) liveEvents.push("sensors", data, len);
+}
+
+// Called from startWatering()/stopWatering() on the acquisition core
+void pushWateringEvent() {
+  char data[96];
+  int n = snprintf(data, sizeof(data), "{\"isWatering\":%s,\"manualWateringActive\":%s,\"autoEnabled\":%s}",
+                   isWatering ? "true" : "false", manualWateringActive ? "true" : "false",
+                   autoWateringEnabled ? "true" : "false");
+  liveEvents.push("watering", data, n);
+}
+
+// Microseconds until the next sensor step or task is due (0 = something is due now)
+unsigned long schedulerIdleUs() {
+  unsigned long now = micros();
+  unsigned long idle = 1000000UL;
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    const SensorInfo &s = sensors[i];
+    if (!s.enabled || !s.collect) continue;
+    unsigned long due = s.timing.converting ? s.timing.readyAtUs : s.timing.nextDueUs;
+    if (isDue(due, now)) return 0;
+    if (due - now < idle) idle = due - now;
+  }
+  for (size_t i = 0; i < PERIODIC_TASK_COUNT; i++) {
+    unsigned long due = periodicTasks[i].timing.nextDueUs;
+    if (isDue(due, now)) return 0;
+    if (due - now < idle) idle = due - now;
+  }
+  return idle;
+}
+
+unsigned long schedulerMaxJitterUs() {
+  unsigned long worst = 0;
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    if (sensors[i].timing.maxJitterUs > worst) worst = sensors[i].timing.maxJitterUs;
+  }
+  for (size_t i = 0; i < PERIODIC_TASK_COUNT; i++) {
+    if (periodicTasks[i].timing.maxJitterUs > worst) worst = periodicTasks[i].timing.maxJitterUs;
+  }
+  return worst;
+}
+
+// One scheduler pass + idle sleep (body of the pinned acquisition task)
+void runAcquisitionPass() {
+  unsigned long startUs = micros();
+  runScheduler();
+  loopDuration.observe((uint32_t)(micros() - startUs));
+  
+  // Sleep until ~1 ms before the next deadline (FreeRTOS tick is 1 ms),
+  // then just yield so wake-up jitter stays below a millisecond
+  unsigned long idleUs = schedulerIdleUs();
+  if (idleUs > 2000) {
+    delay(idleUs / 1000 - 1);
+  } else {
+    yield();
+  }
+}
+
+void loop() {
+#if ENABLE_ACQUISITION_TASK
+  // Acquisition has its own pinned task; the Arduino loop task is not needed
+  vTaskDelete(NULL);
+#else
+  runAcquisitionPass();
+#endif
 }
 
 // 🚦 LED Status Indicator System
 void updateLEDStatus() {
   unsigned long currentTime = millis();
   
-  // Check WiFi connection status
-  bool wifiConnected = (WiFi.status() == WL_CONNECTED);
+  // Link state kept by the WiFi event handler
+  bool wifiConnected = wifiLink.up();
   
   // Check if remote transmission is recent (within last 70 seconds)
   bool remoteActive = (currentTime - lastRemoteTransmission < REMOTE_TRANSMISSION_TIMEOUT);
@@ -949,45 +2266,69 @@ void updateLEDStatus() {
         break;
     }
     
+    TRACE_BEGIN(show, "FastLED.show");
     FastLED.show();
+    TRACE_END(show);
   }
 }
 
 void addToHistory() {
   unsigned long currentTime = millis();
   if (currentTime - lastHistoryUpdate >= HISTORY_INTERVAL) {
+    // A /history stream is walking the ring: retry on the next tick rather than
+    // overwriting the slot it may be reading (bounded by HISTORY_MAX_DEFER)
+    if (historyStreams.load() > 0 && currentTime - lastHistoryUpdate < HISTORY_INTERVAL + HISTORY_MAX_DEFER) {
+      return;
+    }
     lastHistoryUpdate = currentTime;
     
-    // Get current Unix timestamp (seconds since epoch)
-    time_t now;
-    time(&now);
-    unsigned long unixTimestamp = (unsigned long)now;
+    // Unix timestamp, or seconds since boot until NTP has synced
+    unsigned long unixTimestamp = sampleTimestamp();
+    time_t now = (time_t)unixTimestamp;
     
     // Add current reading to circular buffer with UNIX TIMESTAMP
+    historySeq.fetch_add(1, std::memory_order_relaxed);  // odd: readers retry
+    std::atomic_thread_fence(std::memory_order_release);
     sensorHistory[historyIndex].temperature = temperature;
     sensorHistory[historyIndex].pressure = pressure;
     sensorHistory[historyIndex].lightLevel = lightLevel;
     sensorHistory[historyIndex].soilMoisture = soilMoisture;
     sensorHistory[historyIndex].timestamp = unixTimestamp;  // UNIX timestamp, not millis!
     
+    
+    pushHistoryWindow(sensorHistory[historyIndex]);
+    const SensorReading &added = sensorHistory[historyIndex];
+    
     historyIndex = (historyIndex + 1) % MAX_HISTORY_POINTS;
     if (historyCount < MAX_HISTORY_POINTS) {
       historyCount++;
     }
+    historySeq.fetch_add(1, std::memory_order_release);
+    
+    // Persist once the clock is real (applyBootEpoch() writes the earlier ones).
+    // After the seqlock is closed: /history readers must not spin through a
+    // flash write
+    if (historyStoreReady && timeInitialized) {
+      TRACE_SCOPE("history store");
+      historyStore.append(added);
+    }
     
     // Increment total readings counter
     totalReadingsCount++;
     
-    // Calculate min/max temperature from last 24h of history
-    minTemperature = 999.0;
-    maxTemperature = -999.0;
-    for (int i = 0; i < historyCount; i++) {
-      float t = sensorHistory[i].temperature;
-      if (t > -50 && t < 100) {  // Valid temperature range
-        if (t < minTemperature) minTemperature = t;
-        if (t > maxTemperature) maxTemperature = t;
-      }
-    }
+    updateTemperatureRange();
+    apiBodyStale = true;
+    
+    // New chart point for /events clients (the dashboard used to reload /history)
+    char point[EVENT_DATA_MAX];
+    size_t len = 0;
+    jsonAppend(point, sizeof(point), &len, "{\"timestamp\":%lu", unixTimestamp);
+    jsonAppendNumber(point, sizeof(point), &len, "temperature", temperature);
+    jsonAppendNumber(point, sizeof(point), &len, "pressure", pressure);
+    jsonAppendNumber(point, sizeof(point), &len, "light", lightLevel);
+    jsonAppendNumber(point, sizeof(point), &len, "soil", soilMoisture);
+    jsonAppend(point, sizeof(point), &len, "}");
+    if (len < sizeof(point)) liveEvents.push("history", point, len);
     
     // Format timestamp for display
     struct tm timeinfo;
@@ -995,6 +2336,12 @@ void addToHistory() {
     char timeStr[20];
     strftime(timeStr, sizeof(timeStr), "%H:%M:%S", &timeinfo);
     
+    if (binaryTelemetry) {
+      telemetry.begin(TELEMETRY_HISTORY, millis()).u32(unixTimestamp).u16(historyCount).f32(temperature)
+        .f32(minTemperature).f32(maxTemperature);
+      sendTelemetry();
+      return;
+    }
     Serial.print("📊 History added: "); 
     Serial.print(historyCount); 
     Serial.print("/"); 
@@ -1011,6 +2358,95 @@ void addToHistory() {
   }
 }
 
+// Slides every metric's 24h window by one history point (O(1) amortized)
+void pushHistoryWindow(const SensorReading &r) {
+  float values[SENSOR_COUNT] = {r.temperature, r.pressure, r.lightLevel, r.soilMoisture};
+  uint8_t valid = rollupValidMask(values);
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    historyWindow[i].push(values[i], valid & (1 << i));
+  }
+}
+
+// Min/max temperature of the last 24h, from the sliding window
+void updateTemperatureRange() {
+  const SlidingWindow<MAX_HISTORY_POINTS> &w = historyWindow[SENSOR_BMP280_TEMP];
+  minTemperature = w.count() ? w.min() : 999.0;
+  maxTemperature = w.count() ? w.max() : -999.0;
+}
+
+// Refill the RAM ring with the newest points on flash (oldest first)
+void restoreHistoryFromStore() {
+  historyCount = (int)historyStore.readLatest(sensorHistory, MAX_HISTORY_POINTS);
+  historyIndex = historyCount % MAX_HISTORY_POINTS;
+  for (int i = 0; i < SENSOR_COUNT; i++) historyWindow[i].clear();
+  for (int i = 0; i < historyCount; i++) pushHistoryWindow(sensorHistory[i]);
+  updateTemperatureRange();
+  
+  HistoryStoreStats hs = historyStore.stats();
+  Serial.printf("📂 History store: %lu records in %lu segments, %d restored, %lu dropped, recovery %lu us\n",
+                (unsigned long)hs.records, (unsigned long)hs.segments, historyCount,
+                (unsigned long)hs.droppedRecords, (unsigned long)hs.recoveryUs);
+  
+  // Rebuild the 5m/1h/1d rollups from the stored 5-minute points
+  unsigned long t0 = millis();
+  uint32_t longest = Rollup::retention(ROLLUP_TIERS - 1);
+  uint32_t from = hs.newestTimestamp > longest ? hs.newestTimestamp - longest : 0;
+  HistoryStore::Cursor cursor = historyStore.query(from, hs.newestTimestamp);
+  SensorReading r;
+  uint32_t replayed = 0;
+  while (cursor.next(r)) {
+    float values[ROLLUP_METRICS] = {r.temperature, r.pressure, r.lightLevel, r.soilMoisture};
+    historyRollup.add((uint32_t)r.timestamp, values, rollupValidMask(values), 1);
+    replayed++;
+  }
+  Serial.printf("📈 Rollups rebuilt from %lu stored points in %lu ms\n", (unsigned long)replayed, millis() - t0);
+}
+
+// Which of {temperature, pressure, light, soil} hold real readings (not the error markers)
+uint8_t rollupValidMask(const float *values) {
+  uint8_t mask = 0;
+  if (values[0] > -50 && values[0] < 100) mask |= 1;
+  if (values[1] > 0) mask |= 2;
+  if (values[2] >= 0) mask |= 4;
+  if (values[3] >= 0) mask |= 8;
+  return mask;
+}
+
+// Raw rollup tier feed (every ROLLUP_RAW_PERIOD_MS); needs wall-clock time
+void addToRollup() {
+  if (!timeInitialized) return;
+  time_t now;
+  time(&now);
+  float values[ROLLUP_METRICS] = {temperature, pressure, lightLevel, soilMoisture};
+  historyRollup.add((uint32_t)now, values, rollupValidMask(values));
+}
+
+// First NTP sync: points taken before it carry seconds since boot. Shift them
+// to wall-clock time, then write them to flash and the rollups in order,
+// as if the clock had been right all along.
+void applyBootEpoch(unsigned long bootEpoch) {
+  int oldest = (historyIndex - historyCount + MAX_HISTORY_POINTS) % MAX_HISTORY_POINTS;
+  int fixed = 0;
+  historySeq.fetch_add(1, std::memory_order_relaxed);  // odd: readers retry
+  std::atomic_thread_fence(std::memory_order_release);
+  for (int i = 0; i < historyCount; i++) {
+    SensorReading &r = sensorHistory[(oldest + i) % MAX_HISTORY_POINTS];
+    if (r.timestamp >= TIME_VALID_MIN) continue;
+    r.timestamp += bootEpoch;
+    fixed++;
+  }
+  historySeq.fetch_add(1, std::memory_order_release);
+  if (!fixed) return;
+  for (int i = historyCount - fixed; i < historyCount; i++) {
+    const SensorReading &r = sensorHistory[(oldest + i) % MAX_HISTORY_POINTS];
+    if (historyStoreReady) historyStore.append(r);
+    float values[ROLLUP_METRICS] = {r.temperature, r.pressure, r.lightLevel, r.soilMoisture};
+    historyRollup.add((uint32_t)r.timestamp, values, rollupValidMask(values), 1);
+  }
+  apiBodyStale = true;
+  Serial.printf("🕒 %d history point(s) from before NTP sync re-timestamped\n", fixed);
+}
+
 // Update sensor registry with current values
 void updateSensorRegistry() {
   unsigned long now = millis();
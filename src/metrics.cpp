@@ -0,0 +1,60 @@
+/*
+ * Prometheus text rendering for the metrics in metrics.h.
+ */
+#include "metrics.h"
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+void MetricsWriter::line(const char *fmt, ...) {
+  if (overflow_) return;
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(buf_ + len_, size_ - len_, fmt, args);
+  va_end(args);
+  if (n < 0 || (size_t)n >= size_ - len_) {
+    overflow_ = true;
+    buf_[len_] = '\0';  // drop the partial line
+    return;
+  }
+  len_ += n;
+}
+
+void MetricsWriter::family(const char *name, const char *type, const char *help) {
+  line("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+void MetricsWriter::sample(const char *name, const char *labels, uint32_t v) {
+  if (labels) line("%s{%s} %lu\n", name, labels, (unsigned long)v);
+  else line("%s %lu\n", name, (unsigned long)v);
+}
+
+void MetricsWriter::sample(const char *name, const char *labels, double v) {
+  const char *text = isnan(v) ? "NaN" : (isinf(v) ? (v > 0 ? "+Inf" : "-Inf") : nullptr);
+  if (labels) {
+    if (text) line("%s{%s} %s\n", name, labels, text);
+    else line("%s{%s} %.7g\n", name, labels, v);
+  } else {
+    if (text) line("%s %s\n", name, text);
+    else line("%s %.7g\n", name, v);
+  }
+}
+
+void MetricsWriter::histogram(const char *name, const char *labels, const MetricHistogram &h, double scale) {
+  HistogramCounts c = h.read();
+  const char *sep = labels ? "," : "";
+  if (!labels) labels = "";
+  uint32_t cumulative = 0;
+  for (uint8_t i = 0; i < h.bucketCount(); i++) {
+    cumulative += c.buckets[i];
+    line("%s_bucket{%s%sle=\"%.7g\"} %lu\n", name, labels, sep, h.bounds()[i] * scale, (unsigned long)cumulative);
+  }
+  line("%s_bucket{%s%sle=\"+Inf\"} %lu\n", name, labels, sep, (unsigned long)c.count);
+  if (*labels) {
+    line("%s_sum{%s} %.7g\n", name, labels, (double)c.sum() * scale);
+    line("%s_count{%s} %lu\n", name, labels, (unsigned long)c.count);
+  } else {
+    line("%s_sum %.7g\n", name, (double)c.sum() * scale);
+    line("%s_count %lu\n", name, (unsigned long)c.count);
+  }
+}
@@ -0,0 +1,111 @@
+/*
+ * Instrumentation for /metrics: counters, gauges and fixed-bucket
+ * histograms, fed from the hot paths, and a writer that renders them in
+ * Prometheus text format (0.0.4) into a caller's buffer.
+ *
+ * Nothing here allocates. Counters and gauges are single relaxed atomics,
+ * so any task can update them. A histogram has one writer (the task that
+ * owns the path it times) and publishes through a Seqlock, so a scrape on
+ * the other core never sees a count without its bucket.
+ *
+ * Values are integers in the unit the hot path has at hand (microseconds,
+ * milliseconds); the writer scales them to base units (seconds) when it
+ * renders, which keeps floating point off the hot paths.
+ */
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+#include "seqlock.h"
+
+#define METRIC_BUCKETS_MAX 12  // finite upper bounds; +Inf is implicit
+
+class MetricCounter {
+public:
+  void inc(uint32_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+  uint32_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<uint32_t> value_{0};
+};
+
+class MetricGauge {
+public:
+  void set(float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    bits_.store(bits, std::memory_order_relaxed);
+  }
+  float value() const {
+    uint32_t bits = bits_.load(std::memory_order_relaxed);
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+  }
+
+private:
+  std::atomic<uint32_t> bits_{0};
+};
+
+struct HistogramCounts {
+  uint32_t buckets[METRIC_BUCKETS_MAX + 1];  // per bucket, not cumulative; last is +Inf
+  uint32_t count;
+  uint32_t sumLo, sumHi;  // 64-bit sum, split for the Seqlock's 32-bit words
+
+  uint64_t sum() const { return (uint64_t)sumHi << 32 | sumLo; }
+};
+
+class MetricHistogram {
+public:
+  // `bounds`: ascending upper bounds (le), at most METRIC_BUCKETS_MAX
+  MetricHistogram(const uint32_t *bounds, uint8_t bucketCount)
+    : bounds_(bounds), bucketCount_(bucketCount > METRIC_BUCKETS_MAX ? METRIC_BUCKETS_MAX : bucketCount) {}
+
+  // Single writer
+  void observe(uint32_t v) {
+    uint8_t i = 0;
+    while (i < bucketCount_ && v > bounds_[i]) i++;
+    counts_.buckets[i]++;
+    counts_.count++;
+    uint64_t sum = counts_.sum() + v;
+    counts_.sumLo = (uint32_t)sum;
+    counts_.sumHi = (uint32_t)(sum >> 32);
+    published_.publish(counts_);
+  }
+
+  HistogramCounts read() const { return published_.read(); }
+  const uint32_t *bounds() const { return bounds_; }
+  uint8_t bucketCount() const { return bucketCount_; }
+
+private:
+  const uint32_t *bounds_;
+  uint8_t bucketCount_;
+  HistogramCounts counts_ = {};  // writer's copy
+  Seqlock<HistogramCounts> published_;
+};
+
+// Prometheus text into a fixed buffer. A line that does not fit is dropped
+// whole (and overflowed() set), so the body stays parseable when truncated.
+// `labels` is the inside of the braces (`sensor="soil"`), or nullptr.
+class MetricsWriter {
+public:
+  MetricsWriter(char *buf, size_t size) : buf_(buf), size_(size) {}
+
+  void family(const char *name, const char *type, const char *help);
+  void sample(const char *name, const char *labels, uint32_t v);
+  void sample(const char *name, const char *labels, double v);
+  // _bucket/_sum/_count lines; bounds and sum are multiplied by `scale`
+  void histogram(const char *name, const char *labels, const MetricHistogram &h, double scale);
+
+  size_t length() const { return len_; }
+  bool overflowed() const { return overflow_; }
+
+private:
+  void line(const char *fmt, ...);
+
+  char *buf_;
+  size_t size_;
+  size_t len_ = 0;
+  bool overflow_ = false;
+};
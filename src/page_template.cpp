@@ -0,0 +1,322 @@
+/*
+ * Gzip page templates with streamed placeholder substitution (see
+ * page_template.h).
+ */
+#include "page_template.h"
+#include <stdarg.h>
+#include "response_writer.h"
+
+#define PAGE_INDEX_VERSION 1
+#define PAGE_INDEX_MAX_SIZE (2 + (PAGE_MAX_FIELDS + 1) * 16 + PAGE_MAX_FIELDS * PAGE_FIELD_NAME_SIZE)
+#define GZIP_HEADER_SIZE 10
+#define GZIP_TRAILER_SIZE 8
+#define STORED_HEADER_SIZE 5      // BFINAL/BTYPE byte, LEN, NLEN
+#define CRC32_POLY 0xEDB88320UL
+
+static uint32_t le32(const uint8_t *p) {
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void putLe32(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t crc32Update(uint32_t crc, const uint8_t *p, size_t n) {
+  crc = ~crc;
+  while (n--) {
+    crc ^= *p++;
+    for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (CRC32_POLY & (0u - (crc & 1)));
+  }
+  return ~crc;
+}
+
+// CRC-32 operators over GF(2), as in zlib's crc32_combine(): row n is the
+// image of bit n
+static uint32_t gf2Times(const uint32_t *mat, uint32_t vec) {
+  uint32_t sum = 0;
+  for (; vec; vec >>= 1, mat++) {
+    if (vec & 1) sum ^= *mat;
+  }
+  return sum;
+}
+
+static void gf2Square(uint32_t *square, const uint32_t *mat) {
+  for (int n = 0; n < 32; n++) square[n] = gf2Times(mat, mat[n]);
+}
+
+static void gf2Apply(uint32_t *op, const uint32_t *mat) {
+  for (int n = 0; n < 32; n++) op[n] = gf2Times(mat, op[n]);
+}
+
+// Operator that runs a CRC-32 on over `len` zero bytes:
+// crc(A + B) = zeros(len(B)) * crc(A) ^ crc(B)
+static void crc32Zeros(uint32_t len, uint32_t *op) {
+  uint32_t odd[32], even[32];
+  odd[0] = CRC32_POLY;  // one zero bit
+  for (int n = 1; n < 32; n++) odd[n] = 1UL << (n - 1);
+  gf2Square(even, odd);  // two bits
+  gf2Square(odd, even);  // four bits
+  for (int n = 0; n < 32; n++) op[n] = 1UL << n;
+  while (len) {
+    gf2Square(even, odd);  // first pass: one byte
+    if (len & 1) gf2Apply(op, even);
+    len >>= 1;
+    if (!len) break;
+    gf2Square(odd, even);
+    if (len & 1) gf2Apply(op, odd);
+    len >>= 1;
+  }
+}
+
+bool PageTemplate::begin(fs::FS &fs, const char *path) {
+  path_ = path;
+  loaded_ = false;
+  file_ = fs.open(path, "r");
+  if (!file_) return false;
+
+  // Header with FEXTRA, then the "GT" subfield among the extra data
+  uint8_t head[GZIP_HEADER_SIZE + 2];
+  if (file_.read(head, sizeof(head)) != sizeof(head)) return false;
+  if (head[0] != 0x1f || head[1] != 0x8b || head[2] != 8 || !(head[3] & 0x04)) return false;
+  uint32_t extraEnd = sizeof(head) + (head[10] | head[11] << 8);
+  uint8_t index[PAGE_INDEX_MAX_SIZE];
+  size_t indexLen = 0;
+  for (uint32_t at = sizeof(head); at + 4 <= extraEnd;) {
+    uint8_t sub[4];
+    if (file_.read(sub, 4) != 4) return false;
+    uint16_t len = sub[2] | sub[3] << 8;
+    if (sub[0] == 'G' && sub[1] == 'T' && len <= sizeof(index)) {
+      if (file_.read(index, len) != len) return false;
+      indexLen = len;
+      break;
+    }
+    at += 4 + len;
+    file_.seek(at);
+  }
+  if (indexLen < 2 || index[0] != PAGE_INDEX_VERSION || index[1] > PAGE_MAX_FIELDS) return false;
+
+  fields_ = index[1];
+  const uint8_t *p = index + 2, *end = index + indexLen;
+  for (uint8_t i = 0; i <= fields_; i++) {
+    if (end - p < 16) return false;
+    Segment &s = segments_[i];
+    s.offset = le32(p);
+    s.length = le32(p + 4);
+    s.rawLength = le32(p + 8);
+    s.crc = le32(p + 12);
+    crc32Zeros(s.rawLength, s.shift);
+    p += 16;
+  }
+  for (uint8_t i = 0; i < fields_; i++) {
+    if (p >= end || *p >= PAGE_FIELD_NAME_SIZE || end - p - 1 < *p) return false;
+    memcpy(names_[i], p + 1, *p);
+    names_[i][*p] = '\0';
+    p += 1 + *p;
+  }
+  if (file_.size() < segments_[fields_].offset + segments_[fields_].length) return false;
+  loaded_ = true;
+  return true;
+}
+
+size_t PageTemplate::read(uint32_t offset, uint8_t *buf, size_t len) {
+  if (!file_.seek(offset)) return 0;
+  return file_.read(buf, len);
+}
+
+struct PageResponse::Fill {
+  PageTemplate *page;
+  uint8_t header[GZIP_HEADER_SIZE];
+  uint8_t trailer[GZIP_TRAILER_SIZE];
+  uint16_t valueOffset[PAGE_MAX_FIELDS];
+  uint8_t valueLength[PAGE_MAX_FIELDS];
+  uint16_t used;
+  char values[PAGE_VALUES_SIZE];
+  uint32_t cachedAt, cachedLen;  // file range held in `cache`
+  uint8_t cache[PAGE_READ_SIZE];
+
+  size_t read(uint8_t *buf, size_t maxLen, size_t index);
+  size_t copyFile(uint32_t offset, uint8_t *buf, size_t len);
+  size_t renderText();
+  size_t readText(uint8_t *buf, size_t maxLen, size_t index);
+};
+
+// File bytes through the cache; one flash read covers the segments of a
+// small page
+size_t PageResponse::Fill::copyFile(uint32_t offset, uint8_t *buf, size_t len) {
+  if (offset < cachedAt || offset + len > cachedAt + cachedLen) {
+    uint32_t n = page->end() - offset;
+    if (n > PAGE_READ_SIZE) n = PAGE_READ_SIZE;
+    cachedAt = offset;
+    cachedLen = page->read(offset, cache, n);
+    if (len > cachedLen) len = cachedLen;  // longer than the cache: the filler asks again for the rest
+  }
+  memcpy(buf, cache + (offset - cachedAt), len);
+  return len;
+}
+
+// The part of the piece at [pos, pos + len) that the read at `at` wants
+static bool window(size_t pos, size_t len, size_t at, size_t room, size_t &from, size_t &take) {
+  if (!room || at < pos || at >= pos + len) return false;
+  from = at - pos;
+  take = len - from < room ? len - from : room;
+  return true;
+}
+
+// Body bytes [index, index + maxLen): header, segment 0, then per field a
+// stored block with its value and the next segment, then the trailer
+size_t PageResponse::Fill::read(uint8_t *buf, size_t maxLen, size_t index) {
+  size_t n = 0, pos = 0, from, take;
+  if (window(pos, GZIP_HEADER_SIZE, index + n, maxLen - n, from, take)) {
+    memcpy(buf + n, header + from, take);
+    n += take;
+  }
+  pos += GZIP_HEADER_SIZE;
+  for (uint8_t i = 0; i <= page->fieldCount(); i++) {
+    const PageTemplate::Segment &s = page->segment(i);
+    if (window(pos, s.length, index + n, maxLen - n, from, take)) {
+      size_t got = copyFile(s.offset + from, buf + n, take);
+      n += got;
+      if (got < take) return n;  // the rest in the next call (0 only if the flash read failed)
+    }
+    pos += s.length;
+    if (i == page->fieldCount()) break;
+    uint8_t len = valueLength[i];
+    uint8_t stored[STORED_HEADER_SIZE] = {0x00, len, 0x00, (uint8_t)~len, 0xff};  // non-final, LEN, NLEN
+    if (window(pos, STORED_HEADER_SIZE, index + n, maxLen - n, from, take)) {
+      memcpy(buf + n, stored + from, take);
+      n += take;
+    }
+    pos += STORED_HEADER_SIZE;
+    if (window(pos, len, index + n, maxLen - n, from, take)) {
+      memcpy(buf + n, values + valueOffset[i] + from, take);
+      n += take;
+    }
+    pos += len;
+  }
+  if (window(pos, GZIP_TRAILER_SIZE, index + n, maxLen - n, from, take)) {
+    memcpy(buf + n, trailer + from, take);
+    n += take;
+  }
+  return n;
+}
+
+// For clients without gzip: the values as "NAME: value" lines, once per
+// name, in `cache` (a plain response never reads the file)
+size_t PageResponse::Fill::renderText() {
+  size_t n = 0;
+  for (uint8_t i = 0; i < page->fieldCount(); i++) {
+    bool repeat = false;
+    for (uint8_t k = 0; k < i && !repeat; k++) repeat = !strcmp(page->fieldName(k), page->fieldName(i));
+    if (repeat) continue;
+    int w = snprintf((char *)cache + n, sizeof(cache) - n, "%s: %.*s\n", page->fieldName(i), (int)valueLength[i],
+                     values + valueOffset[i]);
+    if (w < 0 || (size_t)w >= sizeof(cache) - n) break;
+    n += w;
+  }
+  cachedAt = 0;
+  cachedLen = n;
+  return n;
+}
+
+size_t PageResponse::Fill::readText(uint8_t *buf, size_t maxLen, size_t index) {
+  size_t n = cachedLen - index;
+  if (n > maxLen) n = maxLen;
+  memcpy(buf, cache + index, n);
+  return n;
+}
+
+PageResponse::PageResponse(AsyncWebServerRequest *request, PageTemplate &page) : request_(request), page_(page) {
+  static_assert(sizeof(Fill) <= RESPONSE_BODY_SIZE, "page state must fit a response pool slot");
+  slot_ = responsePool.acquire();
+  fill_ = slot_ >= 0 ? reinterpret_cast<Fill *>(responsePool.body(slot_)) : nullptr;
+  if (!fill_) return;
+  fill_->page = &page;
+  fill_->used = 0;
+  fill_->cachedAt = fill_->cachedLen = 0;
+  memset(fill_->valueLength, 0, sizeof(fill_->valueLength));
+}
+
+PageResponse::~PageResponse() {
+  if (slot_ >= 0) responsePool.release(slot_);
+}
+
+PageResponse &PageResponse::set(const char *name, const char *fmt, ...) {
+  if (!fill_ || !page_.loaded()) return *this;
+  size_t room = PAGE_VALUES_SIZE - fill_->used;
+  if (room > 256) room = 256;  // a stored block here carries at most 255 bytes
+  if (!room) return *this;
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(fill_->values + fill_->used, room, fmt, args);
+  va_end(args);
+  if (n < 0) return *this;
+  if ((size_t)n >= room) n = (int)room - 1;  // truncated
+  for (uint8_t i = 0; i < page_.fieldCount(); i++) {
+    if (strcmp(page_.fieldName(i), name)) continue;
+    fill_->valueOffset[i] = fill_->used;
+    fill_->valueLength[i] = (uint8_t)n;
+  }
+  fill_->used += n;
+  return *this;
+}
+
+int PageResponse::send(int code) {
+  if (!fill_) {
+    sendStatic(request_, 503, "text/plain", "busy");
+    return 503;
+  }
+  if (!page_.loaded()) {
+    sendStatic(request_, 503, "text/plain", "page template missing: upload the filesystem image (pio run -t uploadfs)");
+    return 503;
+  }
+  Fill &f = *fill_;
+  int slot = slot_;
+  if (!request_->hasHeader("Accept-Encoding") ||
+      !strstr(request_->getHeader("Accept-Encoding")->value().c_str(), "gzip")) {
+    size_t n = f.renderText();
+    AsyncWebServerResponse *response = request_->beginResponse("text/plain", n,
+      [slot](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+        return reinterpret_cast<Fill *>(responsePool.body(slot))->readText(buffer, maxLen, index);
+      });
+    return finish(response, code, n);
+  }
+
+  uint32_t crc = 0, rawLength = 0;
+  size_t total = GZIP_HEADER_SIZE + GZIP_TRAILER_SIZE;
+  for (uint8_t i = 0; i <= page_.fieldCount(); i++) {
+    const PageTemplate::Segment &s = page_.segment(i);
+    crc = gf2Times(s.shift, crc) ^ s.crc;
+    rawLength += s.rawLength;
+    total += s.length;
+    if (i == page_.fieldCount()) break;
+    crc = crc32Update(crc, (const uint8_t *)f.values + f.valueOffset[i], f.valueLength[i]);
+    rawLength += f.valueLength[i];
+    total += STORED_HEADER_SIZE + f.valueLength[i];
+  }
+  static const uint8_t GZIP_HEADER[GZIP_HEADER_SIZE] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff};
+  memcpy(f.header, GZIP_HEADER, sizeof(f.header));
+  putLe32(f.trailer, crc);
+  putLe32(f.trailer + 4, rawLength);
+
+  AsyncWebServerResponse *response = request_->beginResponse("text/html", total,
+    [slot](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+      return reinterpret_cast<Fill *>(responsePool.body(slot))->read(buffer, maxLen, index);
+    });
+  response->addHeader("Content-Encoding", "gzip");
+  return finish(response, code, total);
+}
+
+int PageResponse::finish(AsyncWebServerResponse *response, int code, size_t length) {
+  int slot = slot_;
+  response->setCode(code);
+  response->addHeader("Cache-Control", "no-cache");
+  response->addHeader("Vary", "Accept-Encoding");
+  request_->onDisconnect([slot] { responsePool.release(slot); });
+  slot_ = -1;  // the disconnect callback owns it now
+  length_ = length;
+  request_->send(response);
+  return code;
+}
@@ -0,0 +1,95 @@
+/*
+ * HTML pages served gzip-compressed from LittleFS with live values filled
+ * in while the page streams, without inflating or building it in RAM.
+ *
+ * A template (made by tools/page_template.cpp from the pages in tools/pages) is
+ * a valid gzip file whose deflate stream is cut at every %NAME%
+ * placeholder: the text between placeholders is compressed and flushed to
+ * a byte boundary (Z_FULL_FLUSH, so nothing after refers back across the
+ * cut), and each placeholder is a stored block of its own. An index in the
+ * gzip header's extra field gives, for each compressed segment, its offset
+ * and length in the file and the CRC-32 and length of its text.
+ *
+ * A response is a fresh gzip member: a 10-byte header, the compressed
+ * segments copied from the file, a stored block with the value where each
+ * placeholder was, and a trailer whose CRC-32 is chained from the segment
+ * CRCs and the values (crc32_combine with a per-segment operator computed
+ * at load). The length is known before the first byte, so the body goes
+ * out with Content-Length in TCP-sized reads straight from flash. Per
+ * request state (values, header, trailer and the last PAGE_READ_SIZE
+ * bytes read from the file) lives in a ResponsePool slot.
+ *
+ * Browsers all accept gzip. A client that does not advertise it (curl,
+ * scripts) gets the same values as text/plain "NAME: value" lines, built
+ * in the slot without touching the file.
+ * Files and responses: AsyncTCP task only (the fillers share the file).
+ */
+#pragma once
+#include <Arduino.h>
+#include <FS.h>
+#include <ESPAsyncWebServer.h>
+
+#define PAGE_MAX_FIELDS 8        // placeholder occurrences per template
+#define PAGE_FIELD_NAME_SIZE 16
+#define PAGE_VALUES_SIZE 256     // all values of one response
+#define PAGE_READ_SIZE 1536      // flash read per refill: a whole small page in one read
+
+class PageTemplate {
+public:
+  struct Segment {
+    uint32_t offset;     // compressed bytes in the file
+    uint32_t length;
+    uint32_t rawLength;  // text they inflate to
+    uint32_t crc;        // CRC-32 of that text
+    uint32_t shift[32];  // CRC-32 operator for rawLength zero bytes
+  };
+
+  // Opens the file and reads its index; the file stays open
+  bool begin(fs::FS &fs, const char *path);
+  bool loaded() const { return loaded_; }
+  const char *path() const { return path_; }
+
+  uint8_t fieldCount() const { return fields_; }
+  const char *fieldName(uint8_t i) const { return names_[i]; }
+  const Segment &segment(uint8_t i) const { return segments_[i]; }  // fieldCount() + 1 of them
+
+  // Reads file bytes at `offset` (segment offsets are file offsets)
+  size_t read(uint32_t offset, uint8_t *buf, size_t len);
+  uint32_t end() const { return segments_[fields_].offset + segments_[fields_].length; }
+
+private:
+  File file_;
+  const char *path_ = nullptr;
+  bool loaded_ = false;
+  uint8_t fields_ = 0;
+  Segment segments_[PAGE_MAX_FIELDS + 1];
+  char names_[PAGE_MAX_FIELDS][PAGE_FIELD_NAME_SIZE];
+};
+
+// One page response; values are set by placeholder name (every occurrence
+// gets it, placeholders never set stay empty), then send()
+class PageResponse {
+public:
+  PageResponse(AsyncWebServerRequest *request, PageTemplate &page);
+  ~PageResponse();  // gives the slot back if send() was never reached
+  PageResponse(const PageResponse &) = delete;
+  PageResponse &operator=(const PageResponse &) = delete;
+
+  PageResponse &set(const char *name, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+
+  // Returns the status actually sent: 503 without a pool slot or template.
+  // Clients without gzip get the values as plain text (length() says how much)
+  int send(int code);
+  size_t length() const { return length_; }  // body bytes on the wire
+
+private:
+  struct Fill;  // in the pool slot, read by the filler
+
+  int finish(AsyncWebServerResponse *response, int code, size_t length);
+
+  AsyncWebServerRequest *request_;
+  PageTemplate &page_;
+  int slot_;
+  Fill *fill_;
+  size_t length_ = 0;
+};
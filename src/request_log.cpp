@@ -0,0 +1,68 @@
+/*
+ * Deferred HTTP request log (see request_log.h).
+ */
+#include <ESPAsyncWebServer.h>
+#include "request_log.h"
+
+uint8_t RequestLog::addRoute(const char *uri) {
+  for (uint8_t i = 0; i < routeCount_; i++) {
+    if (!strcmp(routes_[i], uri)) return i;  // same path, another method
+  }
+  if (routeCount_ >= REQUEST_LOG_ROUTES) return REQUEST_ROUTE_NONE;
+  routes_[routeCount_] = uri;
+  return routeCount_++;
+}
+
+const char *RequestLog::routeName(uint8_t route) const {
+  return route < routeCount_ ? routes_[route] : "(none)";
+}
+
+size_t RequestLog::drain(Print &out, size_t max) {
+  uint32_t tail = tail_.load(std::memory_order_relaxed);
+  size_t n = 0;
+  while (n < max && tail != head_.load(std::memory_order_acquire)) {
+    RequestRecord r = ring_[tail % REQUEST_LOG_ENTRIES];
+    tail_.store(++tail, std::memory_order_release);  // slot is free once copied
+    out.printf("REQ %s %s FROM %u.%u.%u.%u -> %u %lu.%03lu ms %lu B @%lu\n", requestMethodName(r.method),
+               routeName(r.route), (unsigned)(r.ip & 0xFF), (unsigned)((r.ip >> 8) & 0xFF),
+               (unsigned)((r.ip >> 16) & 0xFF), (unsigned)(r.ip >> 24), r.status,
+               (unsigned long)(r.latencyUs / 1000), (unsigned long)(r.latencyUs % 1000), (unsigned long)r.bytes,
+               (unsigned long)r.atMs);
+    n++;
+  }
+  uint32_t dropped = dropped_.load(std::memory_order_relaxed);
+  if (dropped != reportedDrops_) {
+    out.printf("REQ log full: %lu records dropped\n", (unsigned long)(dropped - reportedDrops_));
+    reportedDrops_ = dropped;
+  }
+  return n;
+}
+
+#if REQUEST_LOG_TASK
+static void drainTask(void *arg) {
+  RequestLog *log = (RequestLog *)arg;
+  for (;;) {
+    log->drain(Serial);
+    vTaskDelay(pdMS_TO_TICKS(REQUEST_LOG_DRAIN_MS));
+  }
+}
+#endif
+
+void RequestLog::begin() {
+#if REQUEST_LOG_TASK
+  xTaskCreatePinnedToCore(drainTask, "reqlog", REQUEST_LOG_STACK, this, REQUEST_LOG_PRIORITY, NULL,
+                          REQUEST_LOG_CORE);
+#endif
+}
+
+const char *requestMethodName(uint8_t method) {
+  switch (method) {
+    case HTTP_GET: return "GET";
+    case HTTP_POST: return "POST";
+    case HTTP_PUT: return "PUT";
+    case HTTP_PATCH: return "PATCH";
+    case HTTP_DELETE: return "DELETE";
+    case HTTP_OPTIONS: return "OPTIONS";
+    default: return "OTHER";
+  }
+}
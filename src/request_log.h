@@ -0,0 +1,89 @@
+/*
+ * Deferred HTTP request log.
+ *
+ * logRequest() used to Serial.printf() every request from inside its
+ * handler, formatting the client address into a heap String and holding
+ * the AsyncTCP task on the 115200-baud UART (a line is ~5 ms on the wire
+ * once the 128-byte TX FIFO is full). Now the handler side only fills a
+ * fixed 20-byte record and pushes it into a single-producer ring; a
+ * low-priority task on the network core formats and prints the records
+ * later. When the ring is full the record is counted as dropped, the
+ * handler never waits.
+ *
+ * Producer: the AsyncTCP task (every handler runs there). Consumer: the
+ * drain task, or a periodic task on the host build.
+ *
+ * Routes are registered once at setup (addRoute(), see onRoute() in
+ * main.cpp) so a record carries a one-byte route id instead of the URL.
+ */
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+#ifndef NATIVE_BUILD
+#define REQUEST_LOG_TASK 1
+#else
+#define REQUEST_LOG_TASK 0  // host: drained from the scheduler
+#endif
+
+#define REQUEST_LOG_ENTRIES 64       // power of two
+#define REQUEST_LOG_ROUTES 48
+#define REQUEST_ROUTE_NONE 0xFF      // no registered route (404)
+#define REQUEST_LOG_DRAIN_MS 50
+#define REQUEST_LOG_STACK 3072
+#define REQUEST_LOG_PRIORITY 1       // below AsyncTCP: printing waits for idle time
+#define REQUEST_LOG_CORE 0
+
+struct RequestRecord {
+  uint32_t atMs;
+  uint32_t ip;         // first octet in the low byte
+  uint32_t latencyUs;  // handler entry to return (response queued)
+  uint32_t bytes;      // response body, 0 if streamed
+  uint16_t status;
+  uint8_t method;      // WebRequestMethod bit
+  uint8_t route;
+};
+
+class RequestLog {
+public:
+  // Setup only, before the server starts; REQUEST_ROUTE_NONE when full
+  uint8_t addRoute(const char *uri);
+  const char *routeName(uint8_t route) const;
+
+  // Producer side. Never blocks: false (and counted) when the ring is full.
+  bool push(const RequestRecord &record) {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) >= REQUEST_LOG_ENTRIES) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    ring_[head % REQUEST_LOG_ENTRIES] = record;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side: formats and prints up to `max` records, then a note for
+  // any drops since the last call. Returns the records printed.
+  size_t drain(Print &out, size_t max = REQUEST_LOG_ENTRIES);
+
+  // Starts the drain task (device build)
+  void begin();
+
+  void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+  uint32_t pending() const { return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_relaxed); }
+  uint32_t logged() const { return tail_.load(std::memory_order_acquire); }
+  uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+  RequestRecord ring_[REQUEST_LOG_ENTRIES];
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> tail_{0};
+  std::atomic<uint32_t> dropped_{0};
+  uint32_t reportedDrops_ = 0;  // consumer side
+  std::atomic<bool> enabled_{true};
+  const char *routes_[REQUEST_LOG_ROUTES] = {};
+  uint8_t routeCount_ = 0;
+};
+
+const char *requestMethodName(uint8_t method);
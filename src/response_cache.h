@@ -0,0 +1,135 @@
+/*
+ * Pre-rendered response body, rendered once by the acquisition task when
+ * the data behind it changes and sent to every request until then.
+ *
+ * SLOTS fixed buffers: one holds the current body, the others are spares
+ * the writer renders into. A request leases the current slot (reference
+ * count) and the response reads straight from it while it drains, however
+ * slowly; the writer only reuses a spare nobody holds and never waits -
+ * if all spares are still leased it skips that render and the previous
+ * body stays current.
+ *
+ * Lease protocol: the reader bumps the refcount of the slot it saw as
+ * current, then checks it is still current. The writer only picks a slot
+ * that is not current with a zero refcount, so either it sees the
+ * reader's reference or the reader sees that the slot was replaced and
+ * retries.
+ */
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+template <size_t SLOTS, size_t SIZE>
+class ResponseCache {
+  static_assert(SLOTS >= 2, "need a spare slot to render into");
+
+public:
+  // Holds one slot until destroyed; keep it alive for as long as the
+  // response reads data()
+  class Lease {
+  public:
+    Lease() {}
+    ~Lease() { release(); }
+    Lease(const Lease &) = delete;
+    Lease &operator=(const Lease &) = delete;
+
+    bool valid() const { return cache_ != nullptr; }
+    const char *data() const { return cache_->slots_[slot_].body; }
+    size_t length() const { return cache_->slots_[slot_].length; }
+    // The leased body's version; like data(), only meaningful while held
+    uint32_t version() const { return cache_->slots_[slot_].version; }
+
+    void release() {
+      if (cache_) cache_->releaseSlot(slot_);
+      cache_ = nullptr;
+    }
+
+  private:
+    friend class ResponseCache;
+    const ResponseCache *cache_ = nullptr;
+    int slot_ = 0;
+  };
+
+  // --- Writer (single thread) ---
+
+  // Buffer of SIZE bytes for the next body, or nullptr if every spare is leased
+  char *beginWrite() {
+    int current = current_.load(std::memory_order_relaxed);
+    // seq_cst against the reader's fetch_add and recheck (Dekker): the
+    // reader either shows up here or sees current_ moved and backs off
+    for (int i = 0; i < (int)SLOTS; i++) {
+      if (i == current || slots_[i].refs.load(std::memory_order_seq_cst) != 0) continue;
+      writing_ = i;
+      return slots_[i].body;
+    }
+    writing_ = -1;
+    return nullptr;
+  }
+
+  // Publishes the buffer from beginWrite(). An identical body keeps the
+  // current slot and version, so conditional requests still match.
+  bool commit(size_t length) {
+    if (writing_ < 0 || length > SIZE) return false;
+    int current = current_.load(std::memory_order_relaxed);
+    Slot &s = slots_[writing_];
+    if (current >= 0 && slots_[current].length == length && memcmp(slots_[current].body, s.body, length) == 0) {
+      writing_ = -1;
+      return false;
+    }
+    s.length = length;
+    s.version = ++version_;
+    published_.store(version_, std::memory_order_release);
+    current_.store(writing_, std::memory_order_seq_cst);
+    writing_ = -1;
+    return true;
+  }
+
+  // --- Readers (any thread) ---
+
+  // false until the first commit()
+  bool acquire(Lease &lease) const {
+    lease.release();
+    int slot = acquireSlot();
+    if (slot < 0) return false;
+    lease.cache_ = this;
+    lease.slot_ = slot;
+    return true;
+  }
+
+  // Lease without the object, for a holder that is released from a callback
+  // (a response's onDisconnect) and so has no destructor to rely on: the
+  // current slot with a reference taken, -1 until the first commit(). Every
+  // slot >= 0 needs exactly one releaseSlot().
+  int acquireSlot() const {
+    for (;;) {
+      int current = current_.load(std::memory_order_seq_cst);
+      if (current < 0) return -1;
+      slots_[current].refs.fetch_add(1, std::memory_order_seq_cst);
+      if (current_.load(std::memory_order_seq_cst) == current) return current;
+      slots_[current].refs.fetch_sub(1, std::memory_order_release);
+    }
+  }
+  void releaseSlot(int slot) const { slots_[slot].refs.fetch_sub(1, std::memory_order_release); }
+  // Only while the slot is leased: a released slot may be rendered into
+  const char *data(int slot) const { return slots_[slot].body; }
+  size_t length(int slot) const { return slots_[slot].length; }
+  uint32_t version(int slot) const { return slots_[slot].version; }
+
+  // Version of the current body without a lease, 0 before the first commit()
+  uint32_t version() const { return published_.load(std::memory_order_acquire); }
+
+private:
+  struct Slot {
+    char body[SIZE];
+    size_t length = 0;
+    uint32_t version = 0;
+    mutable std::atomic<uint16_t> refs{0};
+  };
+
+  Slot slots_[SLOTS];
+  std::atomic<int> current_{-1};
+  std::atomic<uint32_t> published_{0};  // version_ as of the last commit(), for unleased readers
+  int writing_ = -1;
+  uint32_t version_ = 0;
+};
@@ -0,0 +1,182 @@
+/*
+ * Fixed-buffer response writer (see response_writer.h).
+ */
+#include "response_writer.h"
+#include <stdarg.h>
+#include <math.h>
+
+ResponsePool responsePool;
+
+int ResponsePool::acquire() {
+  for (int i = 0; i < RESPONSE_POOL_SLOTS; i++) {
+    if (used_[i]) continue;
+    used_[i] = true;
+    lengths_[i] = 0;
+    return i;
+  }
+  exhausted_++;
+  return -1;
+}
+
+ResponseWriter::ResponseWriter(AsyncWebServerRequest *request) : request_(request) {
+  slot_ = responsePool.acquire();
+  buf_ = slot_ >= 0 ? responsePool.body(slot_) : nullptr;
+  overflow_ = slot_ < 0;
+}
+
+ResponseWriter::~ResponseWriter() {
+  if (slot_ >= 0) responsePool.release(slot_);
+}
+
+void ResponseWriter::append(const char *text, size_t n) {
+  if (overflow_) return;
+  if (n > RESPONSE_BODY_SIZE - len_) {
+    overflow_ = true;
+    return;
+  }
+  memcpy(buf_ + len_, text, n);
+  len_ += n;
+}
+
+ResponseWriter &ResponseWriter::print(const char *text) {
+  append(text, strlen(text));
+  return *this;
+}
+
+ResponseWriter &ResponseWriter::printf(const char *fmt, ...) {
+  if (overflow_) return *this;
+  va_list args;
+  va_start(args, fmt);
+  size_t room = RESPONSE_BODY_SIZE - len_;
+  int n = vsnprintf(buf_ + len_, room, fmt, args);
+  va_end(args);
+  if (n < 0 || (size_t)n >= room) overflow_ = true;
+  else len_ += n;
+  return *this;
+}
+
+void ResponseWriter::escaped(const char *text) {
+  append("\"", 1);
+  for (const char *p = text; *p; p++) {
+    char c = *p;
+    if (c == '"' || c == '\\') {
+      char e[2] = {'\\', c};
+      append(e, 2);
+    } else if ((unsigned char)c < 0x20) {
+      printf("\\u%04x", (unsigned)c);
+    } else {
+      append(&c, 1);
+    }
+  }
+  append("\"", 1);
+}
+
+void ResponseWriter::key(const char *key) {
+  if (!overflow_ && len_ > 0 && buf_[len_ - 1] != '{' && buf_[len_ - 1] != '[') append(",", 1);
+  if (!key) return;
+  escaped(key);
+  append(":", 1);
+}
+
+ResponseWriter &ResponseWriter::beginObject(const char *k) {
+  key(k);
+  append("{", 1);
+  return *this;
+}
+
+ResponseWriter &ResponseWriter::endObject() {
+  append("}", 1);
+  return *this;
+}
+
+ResponseWriter &ResponseWriter::beginArray(const char *k) {
+  key(k);
+  append("[", 1);
+  return *this;
+}
+
+ResponseWriter &ResponseWriter::endArray() {
+  append("]", 1);
+  return *this;
+}
+
+ResponseWriter &ResponseWriter::field(const char *k, double v) {
+  key(k);
+  if (isnan(v) || isinf(v)) return print("null");
+  return printf("%.7g", v);
+}
+
+ResponseWriter &ResponseWriter::field(const char *k, float v) { return field(k, (double)v); }
+
+ResponseWriter &ResponseWriter::field(const char *k, int32_t v) {
+  key(k);
+  return printf("%ld", (long)v);
+}
+
+ResponseWriter &ResponseWriter::field(const char *k, uint32_t v) {
+  key(k);
+  return printf("%lu", (unsigned long)v);
+}
+
+ResponseWriter &ResponseWriter::field(const char *k, bool v) {
+  key(k);
+  return print(v ? "true" : "false");
+}
+
+ResponseWriter &ResponseWriter::field(const char *k, const char *v) {
+  key(k);
+  escaped(v ? v : "");
+  return *this;
+}
+
+ResponseWriter &ResponseWriter::header(const char *name, const char *value) {
+  if (headerCount_ < RESPONSE_MAX_HEADERS) {
+    headers_[headerCount_][0] = name;
+    headers_[headerCount_][1] = value;
+    headerCount_++;
+  }
+  return *this;
+}
+
+int ResponseWriter::send(int code, const char *contentType) {
+  if (slot_ < 0) {
+    sendStatic(request_, 503, "text/plain", "busy");
+    return 503;
+  }
+  if (overflow_) {
+    Serial.printf("%s: response does not fit RESPONSE_BODY_SIZE\n", request_->url().c_str());
+    len_ = 0;
+    sendStatic(request_, 500, "text/plain", "response too large");
+    return 500;
+  }
+  int slot = slot_;
+  responsePool.length(slot) = len_;
+  AsyncWebServerResponse *response = request_->beginResponse(contentType, len_,
+    [slot](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+      size_t n = responsePool.length(slot) - index;
+      if (n > maxLen) n = maxLen;
+      memcpy(buffer, responsePool.body(slot) + index, n);
+      return n;
+    });
+  response->setCode(code);
+  for (uint8_t i = 0; i < headerCount_; i++) response->addHeader(headers_[i][0], headers_[i][1]);
+  request_->onDisconnect([slot] { responsePool.release(slot); });
+  slot_ = -1;  // the disconnect callback owns it now
+  request_->send(response);
+  return code;
+}
+
+size_t sendStatic(AsyncWebServerRequest *request, int code, const char *contentType, const char *body, bool cors) {
+  size_t len = strlen(body);
+  AsyncWebServerResponse *response = request->beginResponse(contentType, len,
+    [body, len](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+      size_t n = len - index;
+      if (n > maxLen) n = maxLen;
+      memcpy(buffer, body + index, n);
+      return n;
+    });
+  response->setCode(code);
+  if (cors) response->addHeader("Access-Control-Allow-Origin", "*");
+  request->send(response);
+  return len;
+}
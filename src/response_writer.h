@@ -0,0 +1,124 @@
+/*
+ * Response bodies for the web handlers without String or heap buffers.
+ *
+ * The handlers used to build bodies with String += chains and
+ * serializeJson(doc, String), then hand the String to send(), which copies
+ * it again: a few hundred bytes to a few KB of short-lived heap per request.
+ * After days of polling that fragments the heap.
+ *
+ * ResponseWriter renders into one of RESPONSE_POOL_SLOTS fixed buffers
+ * (printf and JSON members) and the response reads straight from the slot.
+ * The slot goes back to the pool from the request's onDisconnect callback,
+ * once the client has the body or is gone. The filler and the callback
+ * capture only the slot number, which std::function keeps inline, so a
+ * handler that answers through a writer allocates nothing itself (the
+ * request, response and header objects are ESPAsyncWebServer's own).
+ *
+ * sendStatic() streams text with static storage (error JSON, pages) in
+ * place, and beginCachedResponse() does the same for the current body of a
+ * ResponseCache (/api, /metrics), holding its slot until the disconnect.
+ *
+ * Pool and writers: AsyncTCP task only; handlers, fillers and disconnect
+ * callbacks all run there.
+ */
+#pragma once
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include "response_cache.h"
+
+#define RESPONSE_POOL_SLOTS 4        // bodies in flight at once; a 5th request gets 503
+#define RESPONSE_BODY_SIZE 2048
+#define RESPONSE_MAX_HEADERS 4
+
+class ResponsePool {
+public:
+  int acquire();  // -1 when every slot is still streaming
+  void release(int slot) { used_[slot] = false; }
+  char *body(int slot) { return bodies_[slot]; }
+  size_t &length(int slot) { return lengths_[slot]; }
+  uint32_t exhausted() const { return exhausted_; }  // requests answered 503 for want of a slot
+
+private:
+  alignas(8) char bodies_[RESPONSE_POOL_SLOTS][RESPONSE_BODY_SIZE];  // also holds a PageResponse's state
+  size_t lengths_[RESPONSE_POOL_SLOTS] = {};
+  bool used_[RESPONSE_POOL_SLOTS] = {};
+  uint32_t exhausted_ = 0;
+};
+
+extern ResponsePool responsePool;
+
+class ResponseWriter {
+public:
+  explicit ResponseWriter(AsyncWebServerRequest *request);
+  ~ResponseWriter();  // gives the slot back if send() was never reached
+  ResponseWriter(const ResponseWriter &) = delete;
+  ResponseWriter &operator=(const ResponseWriter &) = delete;
+
+  ResponseWriter &print(const char *text);
+  ResponseWriter &printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+  // JSON: a comma goes in before a member unless it opens an object or
+  // array. `key` may be nullptr for array elements; NaN/inf become null.
+  ResponseWriter &beginObject(const char *key = nullptr);
+  ResponseWriter &endObject();
+  ResponseWriter &beginArray(const char *key);
+  ResponseWriter &endArray();
+  ResponseWriter &field(const char *key, float v);
+  ResponseWriter &field(const char *key, double v);
+  ResponseWriter &field(const char *key, int32_t v);
+  ResponseWriter &field(const char *key, uint32_t v);
+  ResponseWriter &field(const char *key, bool v);
+  ResponseWriter &field(const char *key, const char *v);  // escaped string
+
+  // Applied in send(); name and value must stay valid until then
+  ResponseWriter &header(const char *name, const char *value);
+  ResponseWriter &cors() { return header("Access-Control-Allow-Origin", "*"); }
+
+  // Sends the body as written and returns the status actually sent: 503
+  // without a pool slot, 500 if the body overflowed RESPONSE_BODY_SIZE
+  int send(int code, const char *contentType);
+
+  size_t length() const { return len_; }
+  bool overflowed() const { return overflow_; }
+
+private:
+  void key(const char *key);
+  void escaped(const char *text);
+  void append(const char *text, size_t n);
+
+  AsyncWebServerRequest *request_;
+  int slot_;
+  char *buf_;
+  size_t len_ = 0;
+  bool overflow_ = false;
+  const char *headers_[RESPONSE_MAX_HEADERS][2];
+  uint8_t headerCount_ = 0;
+};
+
+// Text with static storage (a literal), streamed from where it is
+size_t sendStatic(AsyncWebServerRequest *request, int code, const char *contentType, const char *body,
+                  bool cors = false);
+
+// Response over the current body of `cache`, with its slot held until the
+// client is gone; nullptr before the first commit(). The caller adds
+// headers and sends it. `version` and `length` describe the leased body.
+template <size_t SLOTS, size_t SIZE>
+AsyncWebServerResponse *beginCachedResponse(AsyncWebServerRequest *request, const ResponseCache<SLOTS, SIZE> &cache,
+                                            const char *contentType, uint32_t *version = nullptr,
+                                            size_t *length = nullptr) {
+  typedef ResponseCache<SLOTS, SIZE> Cache;
+  const Cache *c = &cache;
+  int slot = cache.acquireSlot();
+  if (slot < 0) return nullptr;
+  if (version) *version = cache.version(slot);
+  if (length) *length = cache.length(slot);
+  AsyncWebServerResponse *response = request->beginResponse(contentType, cache.length(slot),
+    [c, slot](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+      size_t n = c->length(slot) - index;
+      if (n > maxLen) n = maxLen;
+      memcpy(buffer, c->data(slot) + index, n);
+      return n;
+    });
+  request->onDisconnect([c, slot] { c->releaseSlot(slot); });
+  return response;
+}
@@ -0,0 +1,241 @@
+/*
+ * Multi-resolution history: min/max/mean/count per metric at several bucket
+ * widths, updated as samples arrive, so a chart of any range costs the same
+ * on the device and on the wire.
+ *
+ *   tier  bucket  buckets  covers
+ *   raw     30 s      120     1 h
+ *   5m     5 min      288    24 h
+ *   1h      1 h       168     7 d
+ *   1d      1 d        90    90 d
+ *
+ * Each tier is a time-indexed ring: a bucket starting at t lives in slot
+ * (t / width) % capacity and remembers its start, so gaps (device off) and
+ * stale slots need no bookkeeping. Every sample updates one bucket per tier.
+ * One writer (acquisition task); readers merge buckets under a seqlock.
+ */
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+
+#define ROLLUP_METRICS 4           // temperature, pressure, light, soil
+#define ROLLUP_TIERS 4
+#define ROLLUP_RAW_PERIOD_MS 30000 // sampling period of the raw tier
+#define ROLLUP_DEFAULT_POINTS 288  // /history?range= without step
+#define ROLLUP_MAX_POINTS 1000     // step is raised so a response never exceeds this
+#define ROLLUP_EMPTY 0xFFFFFFFFu   // start of a slot that never held data
+
+struct RollupBucket {
+  uint32_t start;
+  float min[ROLLUP_METRICS];
+  float max[ROLLUP_METRICS];
+  float sum[ROLLUP_METRICS];
+  uint16_t count[ROLLUP_METRICS];
+};
+
+struct RollupTierSpec {
+  const char *name;
+  uint32_t width;     // seconds per bucket
+  uint16_t capacity;  // buckets kept
+  uint16_t offset;    // first slot in Rollup::slots_
+};
+
+// Resolved /history?range=&step= request: `points` buckets of `step` seconds
+// from `start`, each merged from tier buckets
+struct RollupQuery {
+  int tier;
+  uint32_t start;
+  uint32_t step;
+  uint32_t points;
+};
+
+class Rollup {
+public:
+  static const RollupTierSpec &spec(int tier) {
+    static const RollupTierSpec SPECS[ROLLUP_TIERS] = {
+      {"raw", 30, 120, 0}, {"5m", 300, 288, 120}, {"1h", 3600, 168, 408}, {"1d", 86400, 90, 576}
+    };
+    return SPECS[tier];
+  }
+  static uint32_t retention(int tier) { return spec(tier).width * spec(tier).capacity; }
+
+  Rollup() {
+    for (int i = 0; i < SLOTS; i++) slots_[i].start = ROLLUP_EMPTY;
+  }
+
+  // Single writer. validMask bit m = values[m] is a real reading.
+  // firstTier > 0 skips the fine tiers (replaying 5-minute points from flash).
+  void add(uint32_t ts, const float *values, uint8_t validMask, int firstTier = 0) {
+    seq_.fetch_add(1, std::memory_order_relaxed);  // odd: readers retry
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int t = firstTier; t < ROLLUP_TIERS; t++) {
+      uint32_t start = ts - ts % spec(t).width;
+      RollupBucket &b = slot(t, start);
+      if (b.start != start) {
+        memset(&b, 0, sizeof(b));
+        b.start = start;
+      }
+      for (int m = 0; m < ROLLUP_METRICS; m++) {
+        if (!(validMask & (1 << m)) || b.count[m] == UINT16_MAX) continue;
+        float v = values[m];
+        if (!b.count[m] || v < b.min[m]) b.min[m] = v;
+        if (!b.count[m] || v > b.max[m]) b.max[m] = v;
+        b.sum[m] += v;
+        b.count[m]++;
+      }
+    }
+    seq_.fetch_add(1, std::memory_order_release);
+  }
+
+  // Cheapest tier for a request: the coarsest whose buckets still fit inside
+  // step, moved up to the first tier that reaches back over the whole range
+  static int selectTier(uint32_t range, uint32_t step) {
+    int best = 0;
+    for (int t = 1; t < ROLLUP_TIERS; t++) {
+      if (spec(t).width <= step) best = t;
+    }
+    while (best < ROLLUP_TIERS - 1 && retention(best) < range) best++;
+    return best;
+  }
+
+  // range/step in seconds (0 = defaults); buckets are aligned to step and the
+  // last one contains `now`
+  static RollupQuery plan(uint32_t now, uint32_t range, uint32_t step) {
+    uint32_t longest = retention(ROLLUP_TIERS - 1);
+    if (range == 0) range = 86400;
+    if (range > longest) range = longest;
+    if (step == 0) step = range / ROLLUP_DEFAULT_POINTS;
+    uint32_t minStep = (range + ROLLUP_MAX_POINTS - 1) / ROLLUP_MAX_POINTS;
+    if (step < minStep) step = minStep;
+
+    RollupQuery q;
+    q.tier = selectTier(range, step);
+    uint32_t width = spec(q.tier).width;
+    q.step = (step + width - 1) / width * width;  // round up: never more than ROLLUP_MAX_POINTS
+    q.points = (range + q.step - 1) / q.step;
+    uint32_t end = now - now % q.step + q.step;
+    q.start = end - q.points * q.step;
+    return q;
+  }
+
+  // Merges the tier's buckets in [start, start + span) into out
+  void merge(int tier, uint32_t start, uint32_t span, RollupBucket &out) const {
+    uint32_t width = spec(tier).width;
+    uint32_t seq;
+    do {
+      while ((seq = seq_.load(std::memory_order_acquire)) & 1) {}
+      memset(&out, 0, sizeof(out));
+      out.start = start;
+      for (uint32_t s = start; s - start < span; s += width) {
+        const RollupBucket &b = slot(tier, s);
+        if (b.start != s) continue;
+        for (int m = 0; m < ROLLUP_METRICS; m++) {
+          if (!b.count[m]) continue;
+          if (!out.count[m] || b.min[m] < out.min[m]) out.min[m] = b.min[m];
+          if (!out.count[m] || b.max[m] > out.max[m]) out.max[m] = b.max[m];
+          out.sum[m] += b.sum[m];
+          uint32_t c = (uint32_t)out.count[m] + b.count[m];
+          out.count[m] = c > UINT16_MAX ? UINT16_MAX : (uint16_t)c;
+        }
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+    } while (seq_.load(std::memory_order_relaxed) != seq);
+  }
+
+private:
+  enum { SLOTS = 120 + 288 + 168 + 90 };
+
+  RollupBucket &slot(int tier, uint32_t start) {
+    const RollupTierSpec &s = spec(tier);
+    return slots_[s.offset + (start / s.width) % s.capacity];
+  }
+  const RollupBucket &slot(int tier, uint32_t start) const {
+    const RollupTierSpec &s = spec(tier);
+    return slots_[s.offset + (start / s.width) % s.capacity];
+  }
+
+  RollupBucket slots_[SLOTS];
+  std::atomic<uint32_t> seq_{0};
+};
+
+// /history?range=&step= body, streamed like HistoryJsonStream, one row per
+// bucket:
+//   {"tier":"1h","step":3600,"columns":["timestamp","temperature",
+//    "temperature_min","temperature_max", ... ,"count"],"rows":[[..],..]}
+// timestamp is the bucket start; empty buckets are null; count is the most
+// samples any metric had in the bucket. Each row comes from one merge(), so
+// its values agree even if the writer updates that bucket mid-response.
+class RollupJsonStream {
+public:
+  RollupJsonStream(const Rollup &rollup, const RollupQuery &q) : rollup_(rollup), q_(q) {}
+
+  size_t fill(uint8_t *buf, size_t maxLen) {
+    size_t written = 0;
+    while (written < maxLen) {
+      if (pendingPos_ == pendingLen_ && !renderNext()) break;
+      size_t n = pendingLen_ - pendingPos_;
+      if (n > maxLen - written) n = maxLen - written;
+      memcpy(buf + written, pending_ + pendingPos_, n);
+      pendingPos_ += n;
+      written += n;
+    }
+    return written;
+  }
+
+private:
+  bool renderNext() {
+    static const char *const METRICS[ROLLUP_METRICS] = {"temperature", "pressure", "light", "soil"};
+    int n;
+    if (row_ < 0) {
+      n = snprintf(pending_, sizeof(pending_), "{\"tier\":\"%s\",\"step\":%lu,\"columns\":[\"timestamp\"",
+                   Rollup::spec(q_.tier).name, (unsigned long)q_.step);
+      for (int m = 0; m < ROLLUP_METRICS; m++) {
+        n += snprintf(pending_ + n, sizeof(pending_) - n, ",\"%s\",\"%s_min\",\"%s_max\"", METRICS[m],
+                      METRICS[m], METRICS[m]);
+      }
+      n += snprintf(pending_ + n, sizeof(pending_) - n, ",\"count\"],\"rows\":[");
+      row_ = 0;
+      return set(nullptr, n);
+    }
+    if ((uint32_t)row_ == q_.points) {
+      if (done_) return false;
+      done_ = true;
+      return set("]}", 2);
+    }
+
+    uint32_t start = q_.start + (uint32_t)row_ * q_.step;
+    RollupBucket b;
+    rollup_.merge(q_.tier, start, q_.step, b);
+    n = snprintf(pending_, sizeof(pending_), "%s[%lu", row_ > 0 ? "," : "", (unsigned long)start);
+    uint16_t most = 0;
+    for (int m = 0; m < ROLLUP_METRICS; m++) {
+      if (b.count[m] > most) most = b.count[m];
+      float v[3] = {b.count[m] ? b.sum[m] / b.count[m] : NAN, b.min[m], b.max[m]};
+      for (int k = 0; k < 3; k++) {
+        if (!b.count[m] || isnan(v[k]) || isinf(v[k])) n += snprintf(pending_ + n, sizeof(pending_) - n, ",null");
+        else n += snprintf(pending_ + n, sizeof(pending_) - n, ",%.7g", (double)v[k]);
+      }
+    }
+    n += snprintf(pending_ + n, sizeof(pending_) - n, ",%u]", most);
+    row_++;
+    return set(nullptr, n);
+  }
+
+  bool set(const char *text, size_t len) {
+    if (text) memcpy(pending_, text, len);
+    pendingLen_ = (uint16_t)len;
+    pendingPos_ = 0;
+    return true;
+  }
+
+  const Rollup &rollup_;
+  RollupQuery q_;
+  int row_ = -1;       // -1 = header not emitted yet
+  bool done_ = false;
+  char pending_[256];  // header, or one row: 14 numbers of at most 15 characters
+  uint16_t pendingLen_ = 0;
+  uint16_t pendingPos_ = 0;
+};
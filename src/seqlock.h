@@ -0,0 +1,67 @@
+/*
+ * Seqlock for publishing a small struct from one writer to many readers.
+ * The writer (acquisition task) never waits; readers (AsyncTCP handlers on
+ * the other core) retry if a publish raced with their copy, so they can
+ * never observe a half-updated value.
+ *
+ * The payload is stored as relaxed 32-bit atomics so the concurrent copy is
+ * well defined; T must be trivially copyable.
+ */
+#pragma once
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+template <typename T>
+class Seqlock {
+  static_assert(std::is_trivially_copyable<T>::value, "Seqlock payload must be trivially copyable");
+  static const size_t WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+public:
+  // Single writer only
+  void publish(const T &value) {
+    uint32_t words[WORDS] = {};
+    memcpy(words, &value, sizeof(T));
+
+    uint32_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);  // odd = write in progress
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < WORDS; i++) {
+      data_[i].store(words[i], std::memory_order_relaxed);
+    }
+    seq_.store(seq + 2, std::memory_order_release);
+  }
+
+  // One attempt; false if a publish was in progress or raced with the copy
+  bool tryRead(T &out) const {
+    uint32_t seq = seq_.load(std::memory_order_acquire);
+    if (seq & 1) return false;
+
+    uint32_t words[WORDS];
+    for (size_t i = 0; i < WORDS; i++) {
+      words[i] = data_[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (seq_.load(std::memory_order_relaxed) != seq) return false;
+
+    memcpy(&out, words, sizeof(T));
+    return true;
+  }
+
+  // Publishes take well under a microsecond, so spinning here is bounded
+  T read(uint32_t *retries = nullptr) const {
+    T value;
+    uint32_t spins = 0;
+    while (!tryRead(value)) spins++;
+    if (retries) *retries += spins;
+    return value;
+  }
+
+  // Even number that changes with every publish (usable as a version/ETag)
+  uint32_t version() const { return seq_.load(std::memory_order_acquire) & ~1u; }
+
+private:
+  std::atomic<uint32_t> seq_{0};
+  std::atomic<uint32_t> data_[WORDS] = {};
+};
@@ -0,0 +1,65 @@
+/*
+ * Continuous-ADC driver glue for the soil probe (see soil_adc.h).
+ */
+#include "soil_adc.h"
+
+bool SoilAdc::begin(uint8_t pin) {
+  uint8_t channel = digitalPinToAnalogChannel(pin);
+  if (channel == 0xFF || channel >= 10) return false;  // not on ADC1
+  channel_ = channel;
+
+  adc_digi_init_config_t init = {};
+  init.max_store_buf_size = SOIL_ADC_POOL_BYTES;
+  init.conv_num_each_intr = SOIL_ADC_FRAME_SAMPLES * SOC_ADC_DIGI_RESULT_BYTES;
+  init.adc1_chan_mask = 1u << channel;
+  init.adc2_chan_mask = 0;
+  if (adc_digi_initialize(&init) != ESP_OK) return false;
+
+  adc_digi_pattern_config_t pattern = {};
+  pattern.atten = ADC_ATTEN_DB_11;   // full 0..3.1 V range, as analogRead() used
+  pattern.channel = channel;
+  pattern.unit = 0;                  // ADC1
+  pattern.bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+
+  adc_digi_configuration_t config = {};
+  config.conv_limit_en = false;
+  config.conv_limit_num = 250;
+  config.pattern_num = 1;
+  config.adc_pattern = &pattern;
+  config.sample_freq_hz = SOIL_ADC_SAMPLE_HZ;
+  config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+  config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+  if (adc_digi_controller_configure(&config) != ESP_OK || adc_digi_start() != ESP_OK) {
+    adc_digi_deinitialize();
+    return false;
+  }
+  filter_.reset();
+  running_ = true;
+  return true;
+}
+
+size_t SoilAdc::drain() {
+  if (!running_) return 0;
+  stats_.drains++;
+  size_t total = 0;
+  // Bounded: at most one pool's worth per call even if the DMA keeps up
+  for (int frames = 0; frames < SOIL_ADC_POOL_BYTES / (int)sizeof(frame_) + 1; frames++) {
+    uint32_t length = 0;
+    esp_err_t err = adc_digi_read_bytes(frame_, sizeof(frame_), &length, 0);
+    if (err == ESP_ERR_INVALID_STATE) stats_.overruns++;  // data is still valid
+    else if (err != ESP_OK) break;
+    uint16_t raw[SOIL_ADC_FRAME_SAMPLES];
+    size_t n = 0;
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= length; i += SOC_ADC_DIGI_RESULT_BYTES) {
+      adc_digi_output_data_t d;
+      memcpy(&d, frame_ + i, sizeof(d));
+      if (d.type2.unit != 0 || d.type2.channel != channel_) { stats_.rejected++; continue; }
+      raw[n++] = (uint16_t)d.type2.data;
+    }
+    filter_.process(raw, n);
+    total += n;
+    if (length < sizeof(frame_)) break;  // pool empty
+  }
+  stats_.samples += total;
+  return total;
+}
@@ -0,0 +1,46 @@
+/*
+ * Soil probe on the continuous (DMA) ADC.
+ *
+ * ADC1 converts the probe pin at SOIL_ADC_SAMPLE_HZ into the driver's pool
+ * with no CPU involvement; a periodic task drains the pool every
+ * SOIL_ADC_DRAIN_MS into SoilFilter, and the soil sensor's collect() just
+ * reads the filter's latest value. The pool holds SOIL_ADC_POOL_BYTES
+ * (256 ms of samples), so a drain may run late by several periods before
+ * anything is lost; lost samples are counted as overruns.
+ */
+#pragma once
+#include <Arduino.h>
+#include <driver/adc.h>
+#include "soil_filter.h"
+
+#define SOIL_ADC_FRAME_SAMPLES 128   // samples per DMA frame / per read
+#define SOIL_ADC_POOL_BYTES 4096     // driver pool, 4 bytes per sample
+#define SOIL_ADC_DRAIN_MS 32
+
+struct SoilAdcStats {
+  uint32_t samples;    // handed to the filter
+  uint32_t overruns;   // reads that reported a full pool (samples were dropped)
+  uint32_t rejected;   // results for another channel/unit
+  uint32_t drains;
+};
+
+class SoilAdc {
+public:
+  // Starts continuous conversion of an ADC1 pin; false if the pin or the
+  // driver refuses (soil then reads as missing)
+  bool begin(uint8_t pin);
+
+  // Moves everything the DMA has collected into the filter. Never waits.
+  size_t drain();
+
+  bool running() const { return running_; }
+  const SoilFilter &filter() const { return filter_; }
+  SoilAdcStats stats() const { return stats_; }
+
+private:
+  SoilFilter filter_;
+  bool running_ = false;
+  uint8_t channel_ = 0;
+  uint8_t frame_[SOIL_ADC_FRAME_SAMPLES * SOC_ADC_DIGI_RESULT_BYTES];
+  SoilAdcStats stats_ = {};
+};
@@ -0,0 +1,131 @@
+/*
+ * Soil calibration table and its NVS copy (format in soil_calibration.h).
+ */
+#include <Arduino.h>
+#include <Preferences.h>
+#include "soil_calibration.h"
+
+SoilCalibration::SoilCalibration() {
+  points_.count = 0;
+  set(twoPoint(SOIL_CAL_RAW_MAX, 0));
+}
+
+SoilCalPoints SoilCalibration::twoPoint(uint16_t dryRaw, uint16_t wetRaw) {
+  SoilCalPoints p = {};
+  p.points[0] = {dryRaw, 0.0f};
+  p.points[1] = {wetRaw, 100.0f};
+  p.count = 2;
+  return p;
+}
+
+bool SoilCalibration::set(const SoilCalPoints &in) {
+  if (in.count < 2 || in.count > SOIL_CAL_MAX_POINTS) return false;
+  SoilCalPoints p = in;
+  for (uint8_t i = 1; i < p.count; i++) {  // insertion sort by raw
+    SoilCalPoint v = p.points[i];
+    int j = i;
+    while (j > 0 && p.points[j - 1].raw > v.raw) {
+      p.points[j] = p.points[j - 1];
+      j--;
+    }
+    p.points[j] = v;
+  }
+  for (uint8_t i = 0; i < p.count; i++) {
+    const SoilCalPoint &pt = p.points[i];
+    if (pt.raw > SOIL_CAL_RAW_MAX || !(pt.percent >= 0 && pt.percent <= 100)) return false;
+    if (i && pt.raw == p.points[i - 1].raw) return false;
+  }
+
+  points_ = p;
+  for (uint8_t i = 0; i + 1 < p.count; i++) {
+    int32_t r0 = p.points[i].raw * 16, r1 = p.points[i + 1].raw * 16;
+    int32_t q0 = (int32_t)lroundf(p.points[i].percent * 256), q1 = (int32_t)lroundf(p.points[i + 1].percent * 256);
+    segments_[i].startQ4 = r0;
+    segments_[i].baseQ8 = q0;
+    int64_t num = (int64_t)(q1 - q0) * 65536;
+    segments_[i].slopeQ16 = (int32_t)((num + (num >= 0 ? 1 : -1) * (r1 - r0) / 2) / (r1 - r0));
+  }
+  firstQ4_ = p.points[0].raw * 16;
+  lastQ4_ = p.points[p.count - 1].raw * 16;
+  lastQ8_ = (int32_t)lroundf(p.points[p.count - 1].percent * 256);
+  segments_[p.count - 1] = {lastQ4_, lastQ8_, 0};  // sentinel
+
+  uint8_t s = 0;
+  for (int b = 0; b < SOIL_CAL_BUCKETS; b++) {
+    int32_t start = (int32_t)b << BUCKET_SHIFT;
+    while (s + 2 < p.count && start >= segments_[s + 1].startQ4) s++;
+    bucket_[b] = s;
+  }
+  return true;
+}
+
+float SoilCalibration::percentReference(float raw) const {
+  const SoilCalPoint *pt = points_.points;
+  uint8_t n = points_.count;
+  if (raw <= pt[0].raw) return pt[0].percent;
+  if (raw >= pt[n - 1].raw) return pt[n - 1].percent;
+  uint8_t i = 0;
+  while (raw >= pt[i + 1].raw) i++;
+  return pt[i].percent + (raw - pt[i].raw) * (pt[i + 1].percent - pt[i].percent) / (pt[i + 1].raw - pt[i].raw);
+}
+
+size_t SoilCalibration::pack(const SoilCalPoints &p, uint8_t *out, size_t size) {
+  size_t len = 4 + 4 * (size_t)p.count;
+  if (p.count > SOIL_CAL_MAX_POINTS || size < len) return 0;
+  out[0] = 'S';
+  out[1] = 'C';
+  out[2] = SOIL_CAL_VERSION;
+  out[3] = p.count;
+  for (uint8_t i = 0; i < p.count; i++) {
+    uint16_t pct = (uint16_t)lroundf(p.points[i].percent * 100);
+    uint8_t *q = out + 4 + 4 * i;
+    q[0] = (uint8_t)p.points[i].raw;
+    q[1] = (uint8_t)(p.points[i].raw >> 8);
+    q[2] = (uint8_t)pct;
+    q[3] = (uint8_t)(pct >> 8);
+  }
+  return len;
+}
+
+bool SoilCalibration::unpack(const uint8_t *in, size_t len, SoilCalPoints &out) {
+  if (len < 4 || in[0] != 'S' || in[1] != 'C' || in[2] != SOIL_CAL_VERSION) return false;
+  uint8_t count = in[3];
+  if (count > SOIL_CAL_MAX_POINTS || len != 4 + 4 * (size_t)count) return false;
+  out = {};
+  for (uint8_t i = 0; i < count; i++) {
+    const uint8_t *q = in + 4 + 4 * i;
+    out.points[i].raw = (uint16_t)(q[0] | (q[1] << 8));
+    out.points[i].percent = (uint16_t)(q[2] | (q[3] << 8)) / 100.0f;
+  }
+  out.count = count;
+  return true;
+}
+
+bool loadSoilCalibration(SoilCalPoints &out) {
+  Preferences prefs;
+  if (!prefs.begin(SOIL_CAL_NVS_NAMESPACE, true)) return false;
+  uint8_t blob[4 + 4 * SOIL_CAL_MAX_POINTS];
+  size_t len = prefs.getBytesLength(SOIL_CAL_NVS_KEY);
+  bool ok = len > 0 && len <= sizeof(blob) && prefs.getBytes(SOIL_CAL_NVS_KEY, blob, len) == len &&
+            SoilCalibration::unpack(blob, len, out);
+  prefs.end();
+  return ok;
+}
+
+bool saveSoilCalibration(const SoilCalPoints &points) {
+  uint8_t blob[4 + 4 * SOIL_CAL_MAX_POINTS];
+  size_t len = SoilCalibration::pack(points, blob, sizeof(blob));
+  if (!len) return false;
+  Preferences prefs;
+  if (!prefs.begin(SOIL_CAL_NVS_NAMESPACE, false)) return false;
+  bool ok = prefs.putBytes(SOIL_CAL_NVS_KEY, blob, len) == len;
+  prefs.end();
+  return ok;
+}
+
+void clearSoilCalibration() {
+  Preferences prefs;
+  if (!prefs.begin(SOIL_CAL_NVS_NAMESPACE, false)) return;
+  prefs.remove(SOIL_CAL_NVS_KEY);
+  prefs.end();
+}
@@ -0,0 +1,93 @@
+/*
+ * Soil probe calibration: raw ADC counts -> moisture %, piecewise linear
+ * through up to SOIL_CAL_MAX_POINTS measured points (capacitive probes are
+ * far from linear between dry and wet, so two points are wrong mid-range).
+ *
+ * set() turns the points into a segment table in fixed point: raw in Q4
+ * (the filtered reading keeps 1/16 count), percent in Q8, slopes in Q16.
+ * A 64-bucket index over the raw range gives the first candidate segment,
+ * so a lookup is one table read, usually zero iterations of the
+ * forward scan, and one 32x32->64 multiply. Raw values outside the table
+ * clamp to its end points.
+ *
+ * NVS blob (namespace "soilcal", key "points"), little-endian:
+ *   'S' 'C', u8 version, u8 count, count x (u16 raw, u16 percent*100)
+ */
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+#define SOIL_CAL_MAX_POINTS 8
+#define SOIL_CAL_BUCKETS 64
+#define SOIL_CAL_RAW_MAX 4095
+#define SOIL_CAL_NVS_NAMESPACE "soilcal"
+#define SOIL_CAL_NVS_KEY "points"
+#define SOIL_CAL_VERSION 1
+
+struct SoilCalPoint {
+  uint16_t raw;
+  float percent;
+};
+
+// Trivially copyable, so it can go through a Seqlock
+struct SoilCalPoints {
+  SoilCalPoint points[SOIL_CAL_MAX_POINTS];
+  uint8_t count;
+};
+
+class SoilCalibration {
+public:
+  SoilCalibration();
+
+  // Sorts by raw and rebuilds the segment table. Needs 2..SOIL_CAL_MAX_POINTS
+  // points with distinct raw values and percentages within 0..100; on
+  // failure the previous table stays.
+  bool set(const SoilCalPoints &points);
+  const SoilCalPoints &points() const { return points_; }
+
+  // Fixed-point path: raw counts in Q4 -> percent in Q8
+  int32_t percentQ8(int32_t rawQ4) const {
+    if (rawQ4 <= firstQ4_) return segments_[0].baseQ8;
+    if (rawQ4 >= lastQ4_) return lastQ8_;
+    uint8_t s = bucket_[rawQ4 >> BUCKET_SHIFT];
+    while (rawQ4 >= segments_[s + 1].startQ4) s++;
+    const Segment &seg = segments_[s];
+    return seg.baseQ8 + (int32_t)(((int64_t)(rawQ4 - seg.startQ4) * seg.slopeQ16) >> 16);
+  }
+
+  float percent(float raw) const {
+    int32_t q4 = raw <= 0 ? 0 : (raw >= SOIL_CAL_RAW_MAX ? SOIL_CAL_RAW_MAX * 16 : (int32_t)(raw * 16 + 0.5f));
+    return percentQ8(q4) * (1.0f / 256);
+  }
+
+  // Same interpolation in float, for checking the fixed-point table
+  float percentReference(float raw) const;
+
+  // The compile-time two-point map(SOIL_DRY_VALUE..SOIL_WET_VALUE) this replaces
+  static SoilCalPoints twoPoint(uint16_t dryRaw, uint16_t wetRaw);
+
+  static size_t pack(const SoilCalPoints &points, uint8_t *out, size_t size);
+  static bool unpack(const uint8_t *in, size_t len, SoilCalPoints &out);
+
+private:
+  enum { BUCKET_SHIFT = 10 };  // Q4 raw (16 bits) / 64 buckets
+
+  struct Segment {
+    int32_t startQ4;
+    int32_t baseQ8;
+    int32_t slopeQ16;  // Q8 percent per Q4 count, scaled by 2^16
+  };
+
+  SoilCalPoints points_;
+  // One segment per pair of points plus a sentinel that stops the scan
+  Segment segments_[SOIL_CAL_MAX_POINTS];
+  uint8_t bucket_[SOIL_CAL_BUCKETS];
+  int32_t firstQ4_ = 0;
+  int32_t lastQ4_ = 0;
+  int32_t lastQ8_ = 0;
+};
+
+// NVS persistence (Preferences); false if nothing valid is stored
+bool loadSoilCalibration(SoilCalPoints &out);
+bool saveSoilCalibration(const SoilCalPoints &points);
+void clearSoilCalibration();
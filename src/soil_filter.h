@@ -0,0 +1,219 @@
+/*
+ * Soil channel DSP: raw ADC samples from the continuous (DMA) ADC in,
+ * one filtered reading out that acquisition reads in O(1).
+ *
+ *   4 kHz raw --median-of-3--> --64-tap FIR, /16--> 250 Hz --25-pt mean--> latest
+ *
+ * The median removes single-sample spikes (WiFi TX bursts, the pull-down
+ * catching a bad contact) before they can smear through the FIR. The FIR
+ * is a Hamming-windowed sinc low-pass at 100 Hz with integer taps summing
+ * to 2^15, evaluated only at the decimated output points. The 100 ms
+ * running mean spans whole periods of 50 and 60 Hz, so mains hum cancels.
+ * A window where most raw samples sit at 0 (probe unplugged, INPUT_PULLDOWN)
+ * is reported as missing rather than as 100 % wet.
+ *
+ * soil_dsp::firDot has a scalar reference and a GCC vector-extension path
+ * (SSE/NEON on the host; on Xtensa the scalar one is used). Both are exact
+ * integer arithmetic, so they must agree bit for bit.
+ */
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#define SOIL_ADC_SAMPLE_HZ 4000
+#define SOIL_FIR_TAPS 64
+#define SOIL_FIR_DECIMATION 16
+#define SOIL_FIR_CUTOFF_HZ 100
+#define SOIL_MEAN_POINTS 25        // 100 ms of FIR output
+#define SOIL_TAP_SCALE 32768       // taps are Q15
+
+#if !defined(SOIL_FIR_VECTOR)
+#if defined(__SSE2__) || defined(__ARM_NEON)
+#define SOIL_FIR_VECTOR 1
+#else
+#define SOIL_FIR_VECTOR 0
+#endif
+#endif
+
+namespace soil_dsp {
+
+// Windowed-sinc low-pass, rounded to integers that sum to exactly `scale`
+inline void designLowPass(int32_t *taps, int n, float cutoffHz, float sampleHz, int32_t scale) {
+  const float PI_F = 3.14159265f;
+  float fc = cutoffHz / sampleHz;
+  float h[SOIL_FIR_TAPS];
+  float sum = 0;
+  for (int i = 0; i < n; i++) {
+    float m = i - (n - 1) / 2.0f;
+    float sinc = m == 0 ? 2 * fc : sinf(2 * PI_F * fc * m) / (PI_F * m);
+    h[i] = sinc * (0.54f - 0.46f * cosf(2 * PI_F * i / (n - 1)));
+    sum += h[i];
+  }
+  int32_t total = 0;
+  for (int i = 0; i < n; i++) {
+    taps[i] = (int32_t)lroundf(h[i] / sum * scale);
+    total += taps[i];
+  }
+  taps[n / 2] += scale - total;  // rounding residue into the centre tap
+}
+
+// Median of each sample and its neighbours; the ends pass through
+inline void median3(const int32_t *in, int32_t *out, size_t n) {
+  if (n) out[0] = in[0];
+  for (size_t i = 1; i + 1 < n; i++) {
+    int32_t a = in[i - 1], b = in[i], c = in[i + 1];
+    int32_t lo = a < b ? a : b, hi = a < b ? b : a;
+    out[i] = c < lo ? lo : (c > hi ? hi : c);
+  }
+  if (n > 1) out[n - 1] = in[n - 1];
+}
+
+// Reference dot product
+inline int32_t firDotScalar(const int32_t *x, const int32_t *taps, int n) {
+  int32_t acc = 0;
+  for (int i = 0; i < n; i++) acc += x[i] * taps[i];
+  return acc;
+}
+
+#if SOIL_FIR_VECTOR
+typedef int32_t v4i32 __attribute__((vector_size(16)));
+
+// Four lanes at a time; n is a multiple of 16 (SOIL_FIR_TAPS)
+inline int32_t firDotVector(const int32_t *x, const int32_t *taps, int n) {
+  v4i32 acc0 = {0, 0, 0, 0}, acc1 = acc0, acc2 = acc0, acc3 = acc0;
+  for (int i = 0; i < n; i += 16) {
+    v4i32 x0, x1, x2, x3, h0, h1, h2, h3;
+    memcpy(&x0, x + i, 16); memcpy(&h0, taps + i, 16);
+    memcpy(&x1, x + i + 4, 16); memcpy(&h1, taps + i + 4, 16);
+    memcpy(&x2, x + i + 8, 16); memcpy(&h2, taps + i + 8, 16);
+    memcpy(&x3, x + i + 12, 16); memcpy(&h3, taps + i + 12, 16);
+    acc0 += x0 * h0;
+    acc1 += x1 * h1;
+    acc2 += x2 * h2;
+    acc3 += x3 * h3;
+  }
+  v4i32 acc = (acc0 + acc1) + (acc2 + acc3);
+  return acc[0] + acc[1] + acc[2] + acc[3];
+}
+#endif
+
+inline int32_t firDot(const int32_t *x, const int32_t *taps, int n) {
+#if SOIL_FIR_VECTOR
+  return firDotVector(x, taps, n);
+#else
+  return firDotScalar(x, taps, n);
+#endif
+}
+
+}  // namespace soil_dsp
+
+class SoilFilter {
+public:
+  typedef int32_t (*DotFn)(const int32_t *x, const int32_t *taps, int n);
+
+  explicit SoilFilter(DotFn dot = soil_dsp::firDot) : dot_(dot) {
+    soil_dsp::designLowPass(taps_, SOIL_FIR_TAPS, SOIL_FIR_CUTOFF_HZ, SOIL_ADC_SAMPLE_HZ, SOIL_TAP_SCALE);
+    reset();
+  }
+
+  void reset() {
+    hist_ = 0;
+    phase_ = 0;
+    zeros_ = 0;
+    havePrev_ = false;
+    meanHead_ = meanCount_ = 0;
+    meanSum_ = 0;
+    meanZeros_ = 0;
+    outputs_ = 0;
+  }
+
+  // Feeds raw 12-bit samples in arrival order (any block size)
+  void process(const uint16_t *raw, size_t n) {
+    while (n) {
+      // Median needs one sample of look-ahead: the last raw sample of a block
+      // waits in prev_/pprev_ until the next one arrives
+      size_t take = n;
+      if (take > BLOCK) take = BLOCK;
+      int32_t in[BLOCK + 2];
+      size_t m = 0;
+      if (havePrev_) { in[m++] = pprev_; in[m++] = prev_; }
+      for (size_t i = 0; i < take; i++) in[m++] = raw[i];
+      raw += take;
+      n -= take;
+      if (m < 3) {  // first samples ever: just remember them
+        if (m == 2) { pprev_ = in[0]; prev_ = in[1]; havePrev_ = true; }
+        else if (m == 1) { pprev_ = prev_ = in[0]; havePrev_ = true; }
+        continue;
+      }
+      int32_t med[BLOCK + 2];
+      soil_dsp::median3(in, med, m);
+      // med[1..m-2] are final; keep the last two raw samples for next time
+      for (size_t i = 1; i + 1 < m; i++) push(med[i], in[i] == 0);
+      pprev_ = in[m - 2];
+      prev_ = in[m - 1];
+      havePrev_ = true;
+    }
+  }
+
+  bool ready() const { return meanCount_ == SOIL_MEAN_POINTS; }
+  // Filtered reading in raw ADC counts (fractional), NAN until ready
+  float latest() const { return ready() ? (float)meanSum_ / ((float)SOIL_MEAN_POINTS * SOIL_TAP_SCALE) : NAN; }
+  // Most of the last 100 ms read 0: nothing is driving the pin
+  bool missing() const { return ready() && meanZeros_ * 2 > SOIL_MEAN_POINTS * SOIL_FIR_DECIMATION; }
+  uint32_t outputs() const { return outputs_; }
+  const int32_t *taps() const { return taps_; }
+
+private:
+  static constexpr size_t BLOCK = 128;  // samples per median pass (stack buffers)
+
+  // One median-filtered sample into the FIR delay line
+  void push(int32_t v, bool zero) {
+    // Linear delay line twice the FIR length: shift down once it is full
+    if (hist_ == HIST) {
+      memmove(line_, line_ + HIST - (SOIL_FIR_TAPS - 1), (SOIL_FIR_TAPS - 1) * sizeof(int32_t));
+      hist_ = SOIL_FIR_TAPS - 1;
+    }
+    line_[hist_++] = v;
+    if (zero) zeros_++;
+    if (++phase_ < SOIL_FIR_DECIMATION || hist_ < SOIL_FIR_TAPS) {
+      if (phase_ >= SOIL_FIR_DECIMATION) { phase_ = 0; zeros_ = 0; }  // still priming
+      return;
+    }
+    phase_ = 0;
+    int32_t y = dot_(line_ + hist_ - SOIL_FIR_TAPS, taps_, SOIL_FIR_TAPS);
+
+    // 100 ms running mean of FIR outputs (and of the zero counts)
+    if (meanCount_ == SOIL_MEAN_POINTS) {
+      meanSum_ -= meanRing_[meanHead_];
+      meanZeros_ -= meanZeroRing_[meanHead_];
+    } else {
+      meanCount_++;
+    }
+    meanRing_[meanHead_] = y;
+    meanZeroRing_[meanHead_] = zeros_;
+    meanSum_ += y;
+    meanZeros_ += zeros_;
+    meanHead_ = (meanHead_ + 1) % SOIL_MEAN_POINTS;
+    zeros_ = 0;
+    outputs_++;
+  }
+
+  static constexpr int HIST = 2 * SOIL_FIR_TAPS;  // compared with hist_
+
+  DotFn dot_;
+  int32_t taps_[SOIL_FIR_TAPS];
+  int32_t line_[HIST];
+  int hist_;
+  int phase_;
+  uint16_t zeros_;
+  int32_t pprev_ = 0, prev_ = 0;
+  bool havePrev_;
+  int32_t meanRing_[SOIL_MEAN_POINTS];
+  uint16_t meanZeroRing_[SOIL_MEAN_POINTS];
+  int meanHead_, meanCount_;
+  int64_t meanSum_;
+  uint32_t meanZeros_;
+  uint32_t outputs_;
+};
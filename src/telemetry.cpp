@@ -0,0 +1,200 @@
+/*
+ * COBS + CRC framing for the binary telemetry (format in telemetry.h).
+ */
+#include "telemetry.h"
+#include <string.h>
+
+TelemetryEncoder &TelemetryEncoder::begin(TelemetryType type, uint32_t ms) {
+  len_ = 0;
+  overflow_ = false;
+  u8(type);
+  u8(seq_);
+  return u32(ms);
+}
+
+TelemetryEncoder &TelemetryEncoder::u8(uint8_t v) {
+  if (len_ + 1 > TELEMETRY_PAYLOAD_MAX - 2) {  // room for the CRC
+    overflow_ = true;
+    return *this;
+  }
+  payload_[len_++] = v;
+  return *this;
+}
+
+TelemetryEncoder &TelemetryEncoder::u16(uint16_t v) {
+  u8((uint8_t)v);
+  return u8((uint8_t)(v >> 8));
+}
+
+TelemetryEncoder &TelemetryEncoder::u32(uint32_t v) {
+  u16((uint16_t)v);
+  return u16((uint16_t)(v >> 16));
+}
+
+TelemetryEncoder &TelemetryEncoder::f32(float v) {
+  uint32_t bits;
+  memcpy(&bits, &v, sizeof(bits));
+  return u32(bits);
+}
+
+TelemetryEncoder &TelemetryEncoder::str(const char *s) {
+  size_t n = strlen(s);
+  if (n > TELEMETRY_NAME_MAX) n = TELEMETRY_NAME_MAX;
+  u8((uint8_t)n);
+  for (size_t i = 0; i < n; i++) u8((uint8_t)s[i]);
+  return *this;
+}
+
+size_t TelemetryEncoder::end() {
+  if (overflow_) return 0;
+  uint16_t crc = telemetryCrc16(payload_, len_);
+  payload_[len_++] = (uint8_t)crc;
+  payload_[len_++] = (uint8_t)(crc >> 8);
+  frame_[0] = 0;
+  size_t n = cobsEncode(payload_, len_, frame_ + 1);
+  frame_[1 + n] = 0;
+  seq_++;
+  return n + 2;
+}
+
+size_t cobsEncode(const uint8_t *in, size_t len, uint8_t *out) {
+  size_t code = 0, o = 1;
+  uint8_t run = 1;
+  for (size_t i = 0; i < len; i++) {
+    if (in[i]) {
+      out[o++] = in[i];
+      run++;
+    }
+    if (!in[i] || run == 0xFF) {
+      out[code] = run;
+      code = o++;
+      run = 1;
+    }
+  }
+  out[code] = run;
+  return o;
+}
+
+size_t cobsDecode(const uint8_t *in, size_t len, uint8_t *out, size_t cap) {
+  size_t i = 0, o = 0;
+  while (i < len) {
+    uint8_t code = in[i++];
+    if (!code || i + code - 1 > len) return 0;
+    for (uint8_t k = 1; k < code; k++) {
+      if (o >= cap || !in[i]) return 0;
+      out[o++] = in[i++];
+    }
+    if (code != 0xFF && i < len) {
+      if (o >= cap) return 0;
+      out[o++] = 0;
+    }
+  }
+  return o;
+}
+
+uint16_t telemetryCrc16(const uint8_t *data, size_t len) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (int b = 0; b < 8; b++) crc = crc & 0x8000 ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+  }
+  return crc;
+}
+
+namespace {
+struct Reader {
+  const uint8_t *p;
+  size_t len, pos;
+  bool ok;
+  uint8_t u8() {
+    if (pos + 1 > len) {
+      ok = false;
+      return 0;
+    }
+    return p[pos++];
+  }
+  uint16_t u16() { uint16_t lo = u8(); return (uint16_t)(lo | (uint16_t)u8() << 8); }
+  uint32_t u32() { uint32_t lo = u16(); return lo | (uint32_t)u16() << 16; }
+  float f32() {
+    uint32_t bits = u32();
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+  }
+};
+}  // namespace
+
+bool decodeTelemetryFrame(const uint8_t *cobs, size_t len, TelemetryRecord &out) {
+  uint8_t payload[TELEMETRY_PAYLOAD_MAX];
+  if (len < 2 || len > TELEMETRY_FRAME_MAX) return false;
+  size_t n = cobsDecode(cobs, len, payload, sizeof(payload));
+  if (n < 8) return false;
+  uint16_t crc = (uint16_t)(payload[n - 2] | payload[n - 1] << 8);
+  if (telemetryCrc16(payload, n - 2) != crc) return false;
+
+  Reader r{payload, n - 2, 0, true};
+  memset(&out, 0, sizeof(out));
+  out.type = (TelemetryType)r.u8();
+  out.seq = r.u8();
+  out.ms = r.u32();
+  switch (out.type) {
+    case TELEMETRY_SAMPLE:
+      out.sample.temperature = r.f32();
+      out.sample.pressure = r.f32();
+      out.sample.light = r.f32();
+      out.sample.soil = r.f32();
+      out.sample.soilRaw = r.u16();
+      out.sample.adcSamples = r.u32();
+      out.sample.adcOverruns = r.u32();
+      break;
+    case TELEMETRY_HISTORY:
+      out.history.timestamp = r.u32();
+      out.history.points = r.u16();
+      out.history.temperature = r.f32();
+      out.history.minTemperature = r.f32();
+      out.history.maxTemperature = r.f32();
+      break;
+    case TELEMETRY_WATERING:
+      out.watering.on = r.u8();
+      out.watering.manual = r.u8();
+      out.watering.soil = r.f32();
+      break;
+    case TELEMETRY_ALERT:
+      out.alert.kind = r.u8();
+      out.alert.value = r.f32();
+      out.alert.threshold = r.f32();
+      break;
+    case TELEMETRY_TIMING: {
+      out.timing.slot = r.u8();
+      out.timing.runs = r.u32();
+      out.timing.maxJitterUs = r.u32();
+      uint8_t nameLen = r.u8();
+      if (nameLen > TELEMETRY_NAME_MAX) return false;
+      for (uint8_t i = 0; i < nameLen; i++) out.timing.name[i] = (char)r.u8();
+      break;
+    }
+    default:
+      return false;
+  }
+  return r.ok && r.pos == r.len;
+}
+
+const char *telemetryTypeName(TelemetryType type) {
+  switch (type) {
+    case TELEMETRY_SAMPLE: return "sample";
+    case TELEMETRY_HISTORY: return "history";
+    case TELEMETRY_WATERING: return "watering";
+    case TELEMETRY_ALERT: return "alert";
+    case TELEMETRY_TIMING: return "timing";
+    default: return "unknown";
+  }
+}
+
+const char *telemetryAlertName(uint8_t kind) {
+  switch (kind) {
+    case TELEMETRY_ALERT_TEMP_HIGH: return "temp_high";
+    case TELEMETRY_ALERT_TEMP_LOW: return "temp_low";
+    case TELEMETRY_ALERT_SOIL_LOW: return "soil_low";
+    default: return "unknown";
+  }
+}
@@ -0,0 +1,112 @@
+/*
+ * Binary serial telemetry: typed records in COBS frames.
+ *
+ * The text status lines (printSensorStatus(), the history line) take ~20
+ * Serial.print() calls and 100-150 bytes each, which at 115200 baud is
+ * ~10 ms of UART per line and cannot be parsed reliably once other log
+ * lines interleave. With SERIAL_TELEMETRY_BINARY the same information goes
+ * out as one Serial.write() of a 20-40 byte frame; tools/telemetry_decode
+ * turns a capture into CSV or JSON lines.
+ *
+ * Frame on the wire:   0x00, COBS(payload), 0x00
+ * Payload (little-endian):
+ *   u8 type, u8 seq (per frame, gaps = lost frames), u32 millis(),
+ *   body, u16 CRC-16/CCITT-FALSE over everything before it
+ * Bodies:
+ *   SAMPLE   f32 temperature, f32 pressure, f32 light, f32 soil,
+ *            u16 filtered soil raw, u32 ADC samples, u32 ADC overruns
+ *   HISTORY  u32 timestamp, u16 points, f32 temperature, f32 min, f32 max
+ *   WATERING u8 on, u8 manual, f32 soil
+ *   ALERT    u8 kind (TelemetryAlert), f32 value, f32 threshold
+ *   TIMING   u8 slot, u32 runs, u32 worst jitter in us, u8 length, name
+ * Text that is still printed between frames (boot messages, warnings)
+ * fails the CRC and is passed through as text by the decoder.
+ *
+ * No Arduino dependency: the host decoder compiles this file as is.
+ */
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+#define TELEMETRY_PAYLOAD_MAX 48
+#define TELEMETRY_FRAME_MAX (TELEMETRY_PAYLOAD_MAX + TELEMETRY_PAYLOAD_MAX / 254 + 3)
+#define TELEMETRY_NAME_MAX 16
+
+enum TelemetryType : uint8_t {
+  TELEMETRY_SAMPLE = 1,
+  TELEMETRY_HISTORY = 2,
+  TELEMETRY_WATERING = 3,
+  TELEMETRY_ALERT = 4,
+  TELEMETRY_TIMING = 5,
+};
+
+enum TelemetryAlert : uint8_t {
+  TELEMETRY_ALERT_TEMP_HIGH = 1,
+  TELEMETRY_ALERT_TEMP_LOW = 2,
+  TELEMETRY_ALERT_SOIL_LOW = 3,
+};
+
+// One frame at a time, built in place: begin(), the body fields, end().
+// Fields past TELEMETRY_PAYLOAD_MAX are dropped and end() returns 0.
+class TelemetryEncoder {
+public:
+  TelemetryEncoder &begin(TelemetryType type, uint32_t ms);
+  TelemetryEncoder &u8(uint8_t v);
+  TelemetryEncoder &u16(uint16_t v);
+  TelemetryEncoder &u32(uint32_t v);
+  TelemetryEncoder &f32(float v);
+  TelemetryEncoder &str(const char *s);  // u8 length + up to TELEMETRY_NAME_MAX bytes
+
+  // Adds the CRC and COBS-encodes into frame(); returns the frame length
+  size_t end();
+  const uint8_t *frame() const { return frame_; }
+  uint8_t seq() const { return seq_; }
+
+private:
+  uint8_t payload_[TELEMETRY_PAYLOAD_MAX];
+  uint8_t frame_[TELEMETRY_FRAME_MAX];
+  size_t len_ = 0;
+  bool overflow_ = false;
+  uint8_t seq_ = 0;
+};
+
+struct TelemetryRecord {
+  TelemetryType type;
+  uint8_t seq;
+  uint32_t ms;
+  union {
+    struct {
+      float temperature, pressure, light, soil;
+      uint16_t soilRaw;
+      uint32_t adcSamples, adcOverruns;
+    } sample;
+    struct {
+      uint32_t timestamp;
+      uint16_t points;
+      float temperature, minTemperature, maxTemperature;
+    } history;
+    struct {
+      uint8_t on, manual;
+      float soil;
+    } watering;
+    struct {
+      uint8_t kind;
+      float value, threshold;
+    } alert;
+    struct {
+      uint8_t slot;
+      uint32_t runs, maxJitterUs;
+      char name[TELEMETRY_NAME_MAX + 1];
+    } timing;
+  };
+};
+
+// Bytes between two 0x00 delimiters -> record. False for anything that is
+// not a complete frame with a good CRC and a known type.
+bool decodeTelemetryFrame(const uint8_t *cobs, size_t len, TelemetryRecord &out);
+
+size_t cobsEncode(const uint8_t *in, size_t len, uint8_t *out);
+size_t cobsDecode(const uint8_t *in, size_t len, uint8_t *out, size_t cap);  // 0 if malformed
+uint16_t telemetryCrc16(const uint8_t *data, size_t len);
+const char *telemetryTypeName(TelemetryType type);
+const char *telemetryAlertName(uint8_t kind);
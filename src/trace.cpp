@@ -0,0 +1,78 @@
+/*
+ * Trace ring and the /trace JSON export (see trace.h).
+ */
+#include "trace.h"
+#include <stdio.h>
+#include <string.h>
+
+#if ENABLE_TRACE
+TraceRing traceRing;
+
+static const char *const TRACK_NAMES[TRACE_TRACKS] = {"core 0 (network)", "core 1 (acquisition)", "i2c bus 0",
+                                                      "i2c bus 1"};
+
+TraceJsonStream::TraceJsonStream(uint32_t seconds) {
+  if (seconds > TRACE_MAX_SECONDS) seconds = TRACE_MAX_SECONDS;
+  end_ = traceRing.head();
+  next_ = end_ > TRACE_ENTRIES ? end_ - TRACE_ENTRIES : 0;
+  cutoffUs_ = traceMicros() - seconds * 1000000UL;
+  cyclesPerUs_ = traceCyclesPerUs();
+}
+
+size_t TraceJsonStream::fill(uint8_t *buf, size_t maxLen) {
+  size_t written = 0;
+  while (written < maxLen) {
+    if (pendingPos_ == pendingLen_ && !renderNext()) break;
+    size_t n = pendingLen_ - pendingPos_;
+    if (n > maxLen - written) n = maxLen - written;
+    memcpy(buf + written, pending_ + pendingPos_, n);
+    pendingPos_ += n;
+    written += n;
+  }
+  return written;
+}
+
+// Renders the next piece: the header, one track name, one span, or the tail
+bool TraceJsonStream::renderNext() {
+  int n = 0;
+  switch (stage_) {
+    case 0:
+      n = snprintf(pending_, sizeof(pending_), "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+      stage_ = 1;
+      break;
+    case 1:
+      n = snprintf(pending_, sizeof(pending_),
+                   "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                   track_ ? "," : "", track_, TRACK_NAMES[track_]);
+      if (++track_ == TRACE_TRACKS) stage_ = 2;
+      break;
+    case 2: {
+      TraceEvent e;
+      while (next_ != end_) {
+        uint32_t index = next_++;
+        if (!traceRing.read(index, e) || !e.name || (int32_t)(e.startUs - cutoffUs_) < 0) continue;
+        uint32_t us = e.cycles / cyclesPerUs_;
+        uint32_t frac = (e.cycles % cyclesPerUs_) * 1000 / cyclesPerUs_;  // ns
+        n = snprintf(pending_, sizeof(pending_),
+                     ",{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%lu,\"dur\":%lu.%03lu}",
+                     e.name, (unsigned)e.track, (unsigned long)e.startUs, (unsigned long)us, (unsigned long)frac);
+        events_++;
+        break;
+      }
+      if (n) break;
+      stage_ = 3;
+      return renderNext();
+    }
+    case 3:
+      n = snprintf(pending_, sizeof(pending_), "]}\n");
+      stage_ = 4;
+      break;
+    default:
+      return false;
+  }
+  if (n < 0) n = 0;
+  pendingLen_ = (size_t)n < sizeof(pending_) ? (size_t)n : sizeof(pending_) - 1;
+  pendingPos_ = 0;
+  return true;
+}
+#endif
@@ -0,0 +1,185 @@
+/*
+ * Hot-path tracing: begin/end spans in a fixed ring, exported by /trace as
+ * Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev).
+ *
+ * Off unless built with -DENABLE_TRACE=1: the TRACE_* macros then expand
+ * to nothing, and the ring, the exporter and /trace are not built at all. When on, a span costs two
+ * cycle-counter reads, one micros() and a slot write (~1 us on the
+ * ESP32-S3), and the ring bounds the memory: TRACE_ENTRIES spans, the
+ * oldest overwritten, which is a few seconds of a busy loop.
+ *
+ * Timing: the start is micros() (one clock for both cores), the duration
+ * ESP.getCycleCount() end - start, converted at export, so short spans
+ * keep sub-microsecond resolution. Spans run on the core they started on
+ * (every task that traces is pinned) and must be shorter than one cycle
+ * counter wrap (~17 s at 240 MHz). The host build uses std::chrono for
+ * both, so the spans show real CPU time rather than the sim's clock.
+ *
+ * Any task may record: a span claims its slot with one atomic add and
+ * stamps it with a sequence number when complete; the exporter skips
+ * slots that were overwritten or still being written while it read them.
+ *
+ * Span names are stored as pointers: string literals or other static text
+ * only.
+ */
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#ifdef NATIVE_BUILD
+#include <chrono>
+#endif
+
+#ifndef ENABLE_TRACE
+#define ENABLE_TRACE 0
+#endif
+
+#define TRACE_ENTRIES 1024           // power of two; 20 bytes each on the device
+#define TRACE_DEFAULT_SECONDS 2      // /trace without ?seconds=
+#define TRACE_MAX_SECONDS 600
+
+// Chrome "tid" rows
+enum TraceTrack : uint8_t {
+  TRACE_TRACK_CORE0 = 0,   // network: AsyncTCP, WiFi, request log
+  TRACE_TRACK_CORE1 = 1,   // acquisition task (the host build records everything here)
+  TRACE_TRACK_I2C = 2,     // I2C transfers: + bus number, one row per bus worker
+  TRACE_TRACK_I2C_LAST = TRACE_TRACK_I2C + 1,
+  TRACE_TRACKS
+};
+
+#ifdef NATIVE_BUILD
+inline uint32_t traceCycles() {  // 1 "cycle" = 1 ns
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+inline uint32_t traceMicros() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+inline uint32_t traceCyclesPerUs() { return 1000; }
+inline uint8_t traceTrack() { return TRACE_TRACK_CORE1; }
+#else
+inline uint32_t traceMicros() { return micros(); }
+inline uint32_t traceCycles() { return ESP.getCycleCount(); }
+inline uint32_t traceCyclesPerUs() { return ESP.getCpuFreqMHz(); }
+inline uint8_t traceTrack() { return (uint8_t)xPortGetCoreID(); }
+#endif
+
+struct TraceEvent {
+  const char *name;
+  uint32_t startUs;
+  uint32_t cycles;
+  uint8_t track;
+};
+
+class TraceRing {
+public:
+  void record(const char *name, uint32_t startUs, uint32_t cycles, uint8_t track) {
+    uint32_t index = head_.fetch_add(1, std::memory_order_relaxed);
+    Slot &s = slots_[index % TRACE_ENTRIES];
+    s.seq.store(0, std::memory_order_relaxed);  // being written
+    std::atomic_thread_fence(std::memory_order_release);
+    s.name.store(name, std::memory_order_relaxed);
+    s.startUs.store(startUs, std::memory_order_relaxed);
+    s.cycles.store(cycles, std::memory_order_relaxed);
+    s.track.store(track, std::memory_order_relaxed);
+    s.seq.store(index + 1, std::memory_order_release);
+  }
+
+  // Span number `index` (0 = first since boot); false once overwritten or
+  // while it is being written
+  bool read(uint32_t index, TraceEvent &out) const {
+    const Slot &s = slots_[index % TRACE_ENTRIES];
+    if (s.seq.load(std::memory_order_acquire) != index + 1) return false;
+    out.name = s.name.load(std::memory_order_relaxed);
+    out.startUs = s.startUs.load(std::memory_order_relaxed);
+    out.cycles = s.cycles.load(std::memory_order_relaxed);
+    out.track = s.track.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return s.seq.load(std::memory_order_relaxed) == index + 1;
+  }
+
+  uint32_t head() const { return head_.load(std::memory_order_acquire); }  // spans recorded since boot
+
+private:
+  struct Slot {
+    std::atomic<uint32_t> seq{0};  // index + 1 once complete
+    std::atomic<const char *> name{nullptr};
+    std::atomic<uint32_t> startUs{0};
+    std::atomic<uint32_t> cycles{0};
+    std::atomic<uint8_t> track{0};
+  };
+
+  Slot slots_[TRACE_ENTRIES];
+  std::atomic<uint32_t> head_{0};
+};
+
+#if ENABLE_TRACE
+extern TraceRing traceRing;
+
+// Records [construction, end()) as one complete span; end() runs from the
+// destructor unless called earlier. cancel() drops the span (e.g. an idle
+// scheduler pass, which would only crowd the ring).
+class TraceSpan {
+public:
+  explicit TraceSpan(const char *name, uint8_t track = traceTrack())
+    : name_(name), track_(track), startUs_(traceMicros()), startCycles_(traceCycles()) {}
+  ~TraceSpan() { end(); }
+  TraceSpan(const TraceSpan &) = delete;
+  TraceSpan &operator=(const TraceSpan &) = delete;
+
+  void end() {
+    if (!name_) return;
+    traceRing.record(name_, startUs_, traceCycles() - startCycles_, track_);
+    name_ = nullptr;
+  }
+  void cancel() { name_ = nullptr; }
+
+private:
+  const char *name_;
+  uint8_t track_;
+  uint32_t startUs_;
+  uint32_t startCycles_;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name)
+#define TRACE_SCOPE_TRACK(name, track) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name, track)
+#define TRACE_BEGIN(span, name) TraceSpan span(name)
+#define TRACE_END(span) span.end()
+#define TRACE_CANCEL(span) span.cancel()
+
+// The /trace document: {"traceEvents":[track names, then one "X" event per
+// span that started within the last `seconds`]}, rendered from the ring
+// one event at a time for a chunked response (same shape as
+// HistoryJsonStream). Spans overwritten while it streams are skipped.
+class TraceJsonStream {
+public:
+  explicit TraceJsonStream(uint32_t seconds);
+
+  // Copies up to maxLen bytes of the document into buf; 0 once it is complete
+  size_t fill(uint8_t *buf, size_t maxLen);
+
+  uint32_t events() const { return events_; }
+
+private:
+  bool renderNext();
+
+  uint32_t end_;        // ring head when the request came in
+  uint32_t next_;
+  uint32_t cutoffUs_;
+  uint32_t cyclesPerUs_;
+  uint32_t events_ = 0;
+  int stage_ = 0;       // 0 header, 1 track names, 2 spans, 3 closing, 4 done
+  int track_ = 0;
+  char pending_[160];
+  size_t pendingLen_ = 0;
+  size_t pendingPos_ = 0;
+};
+#else
+#define TRACE_SCOPE(name) do {} while (0)
+#define TRACE_SCOPE_TRACK(name, track) do {} while (0)
+#define TRACE_BEGIN(span, name) do {} while (0)
+#define TRACE_END(span) do {} while (0)
+#define TRACE_CANCEL(span) do {} while (0)
+#endif
@@ -0,0 +1,231 @@
+/*
+ * Event-driven WiFi reconnect with a cached AP and lease (see wifi_link.h).
+ */
+#include "wifi_link.h"
+#include <Preferences.h>
+
+WifiLink *WifiLink::instance_ = nullptr;
+
+static void copyAddress(uint8_t *out, const IPAddress &ip) {
+  for (int i = 0; i < 4; i++) out[i] = ip[i];
+}
+
+#if WIFI_STATIC_IP
+static IPAddress toAddress(const uint8_t *in) { return IPAddress(in[0], in[1], in[2], in[3]); }
+#endif
+
+void WifiLink::begin(const char *ssid, const char *password) {
+  ssid_ = ssid;
+  password_ = password;
+  WifiLease lease = {};
+  if (!loadWifiLease(lease)) lease = {};
+  lease_.publish(lease);
+  stats_.publish(counters_);
+
+  instance_ = this;
+  WiFi.mode(WIFI_STA);
+  WiFi.persistent(false);         // the lease lives in our own NVS namespace
+  WiFi.setAutoReconnect(false);   // service() decides how to reconnect
+  WiFi.onEvent(onEvent);
+  lossMs_ = millis();
+  connect(lease.valid(), lossMs_);
+}
+
+const char *WifiLink::stateName() const {
+  switch (state()) {
+    case WIFI_LINK_FAST: return "fast";
+    case WIFI_LINK_SCAN: return "scan";
+    case WIFI_LINK_UP: return "up";
+    default: return "down";
+  }
+}
+
+void WifiLink::onEvent(arduino_event_id_t event, arduino_event_info_t info) {
+  if (instance_) instance_->handleEvent(event, info);
+}
+
+// WiFi event task
+void WifiLink::handleEvent(arduino_event_id_t event, const arduino_event_info_t &info) {
+  if (forget_.load(std::memory_order_acquire)) {
+    lease_.publish(WifiLease());
+    clearWifiLease();
+    forget_.store(false, std::memory_order_release);
+  }
+  switch (event) {
+    case ARDUINO_EVENT_WIFI_STA_CONNECTED:
+      assocChannel_ = info.wifi_sta_connected.channel;
+      memcpy(assocBssid_, info.wifi_sta_connected.bssid, sizeof(assocBssid_));
+      break;
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP: {
+      gotIpMs_.store(millis(), std::memory_order_relaxed);
+      up_.store(true, std::memory_order_release);
+      gotIp_.store(true, std::memory_order_release);
+      WifiLease lease = {};
+      lease.channel = assocChannel_;
+      memcpy(lease.bssid, assocBssid_, sizeof(lease.bssid));
+      copyAddress(lease.ip, WiFi.localIP());
+      copyAddress(lease.gateway, WiFi.gatewayIP());
+      copyAddress(lease.mask, WiFi.subnetMask());
+      copyAddress(lease.dns, WiFi.dnsIP());
+      // NVS write blocks for a few ms; here it stays off the acquisition core
+      if (lease.valid() && lease != lease_.read()) {
+        lease_.publish(lease);
+        saveWifiLease(lease);
+      }
+      break;
+    }
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+      // Our own WiFi.disconnect() before a new attempt
+      if (info.wifi_sta_disconnected.reason == WIFI_REASON_ASSOC_LEAVE) break;
+      up_.store(false, std::memory_order_release);
+      disconnectMs_.store(millis(), std::memory_order_relaxed);
+      disconnects_.fetch_add(1, std::memory_order_release);
+      break;
+    case ARDUINO_EVENT_WIFI_STA_LOST_IP:
+      // A drop usually comes as DISCONNECTED then LOST_IP: count it once, and
+      // never let a late LOST_IP cancel the attempt service() already started
+      if (!up_.exchange(false, std::memory_order_acq_rel)) break;
+      disconnectMs_.store(millis(), std::memory_order_relaxed);
+      disconnects_.fetch_add(1, std::memory_order_release);
+      break;
+    default:
+      break;
+  }
+}
+
+void WifiLink::connect(bool fast, unsigned long nowMs) {
+  WifiLease lease = lease_.read();
+  fast = fast && lease.valid() && !forget_.load(std::memory_order_acquire);
+  if (state_ == WIFI_LINK_FAST || state_ == WIFI_LINK_SCAN) WiFi.disconnect();
+#if WIFI_STATIC_IP
+  if (fast) {
+    WiFi.config(toAddress(lease.ip), toAddress(lease.gateway), toAddress(lease.mask), toAddress(lease.dns));
+    staticApplied_ = true;
+  } else if (staticApplied_) {
+    WiFi.config(IPAddress(), IPAddress(), IPAddress());  // back to DHCP: the lease may be stale
+    staticApplied_ = false;
+  }
+#endif
+  if (fast) {
+    WiFi.begin(ssid_, password_, lease.channel, lease.bssid);
+  } else {
+    WiFi.begin(ssid_, password_);
+  }
+  state_ = fast ? WIFI_LINK_FAST : WIFI_LINK_SCAN;
+  attemptMs_ = nowMs;
+}
+
+void WifiLink::connected(unsigned long gotIpMs) {
+  uint32_t ms = (uint32_t)(gotIpMs - lossMs_);
+  counters_.connects++;
+  if (state_ == WIFI_LINK_FAST) {
+    counters_.fastConnects++;
+  } else {
+    counters_.scanConnects++;
+  }
+  counters_.lastConnectMs = ms;
+  if (ms > counters_.maxConnectMs) counters_.maxConnectMs = ms;
+  state_ = WIFI_LINK_UP;
+}
+
+void WifiLink::service(unsigned long nowMs) {
+  bool changed = false;
+  if (gotIp_.exchange(false, std::memory_order_acquire) &&
+      state_ != WIFI_LINK_UP) {
+    connected(gotIpMs_.load(std::memory_order_relaxed));
+    changed = true;
+  }
+
+  uint32_t drops = disconnects_.load(std::memory_order_acquire);
+  if (drops != seenDrops_) {
+    seenDrops_ = drops;
+    changed = true;
+    switch (state_) {
+      case WIFI_LINK_UP:
+        counters_.drops++;
+        lossMs_ = disconnectMs_.load(std::memory_order_relaxed);
+        state_ = WIFI_LINK_DOWN;
+        connect(true, nowMs);
+        break;
+      case WIFI_LINK_FAST:  // cached AP not there (moved channel, replaced, down)
+        counters_.fallbacks++;
+        connect(false, nowMs);
+        break;
+      case WIFI_LINK_SCAN:
+        state_ = WIFI_LINK_DOWN;
+        attemptMs_ = nowMs;
+        break;
+      default:
+        break;
+    }
+  }
+
+  if (state_ == WIFI_LINK_FAST && nowMs - attemptMs_ >= WIFI_FAST_TIMEOUT_MS) {
+    counters_.fallbacks++;
+    connect(false, nowMs);
+    changed = true;
+  } else if (state_ == WIFI_LINK_SCAN && nowMs - attemptMs_ >= WIFI_SCAN_TIMEOUT_MS) {
+    WiFi.disconnect();
+    state_ = WIFI_LINK_DOWN;
+    attemptMs_ = nowMs;
+  } else if (state_ == WIFI_LINK_DOWN && nowMs - attemptMs_ >= WIFI_RETRY_MS) {
+    connect(true, nowMs);
+  }
+  if (changed) stats_.publish(counters_);
+}
+
+size_t packWifiLease(const WifiLease &lease, uint8_t *out, size_t cap) {
+  if (cap < WIFI_LINK_BLOB_SIZE) return 0;
+  out[0] = 'W';
+  out[1] = 'L';
+  out[2] = WIFI_LINK_VERSION;
+  out[3] = lease.channel;
+  memcpy(out + 4, lease.bssid, 6);
+  memcpy(out + 10, lease.ip, 4);
+  memcpy(out + 14, lease.gateway, 4);
+  memcpy(out + 18, lease.mask, 4);
+  memcpy(out + 22, lease.dns, 4);
+  return WIFI_LINK_BLOB_SIZE;
+}
+
+bool unpackWifiLease(const uint8_t *in, size_t len, WifiLease &out) {
+  if (len != WIFI_LINK_BLOB_SIZE || in[0] != 'W' || in[1] != 'L' || in[2] != WIFI_LINK_VERSION || !in[3]) {
+    return false;
+  }
+  out.channel = in[3];
+  memcpy(out.bssid, in + 4, 6);
+  memcpy(out.ip, in + 10, 4);
+  memcpy(out.gateway, in + 14, 4);
+  memcpy(out.mask, in + 18, 4);
+  memcpy(out.dns, in + 22, 4);
+  return true;
+}
+
+bool loadWifiLease(WifiLease &out) {
+  Preferences prefs;
+  if (!prefs.begin(WIFI_LINK_NVS_NAMESPACE, true)) return false;
+  uint8_t blob[WIFI_LINK_BLOB_SIZE];
+  size_t len = prefs.getBytesLength(WIFI_LINK_NVS_KEY);
+  bool ok = len == sizeof(blob) && prefs.getBytes(WIFI_LINK_NVS_KEY, blob, len) == len &&
+            unpackWifiLease(blob, len, out);
+  prefs.end();
+  return ok;
+}
+
+bool saveWifiLease(const WifiLease &lease) {
+  uint8_t blob[WIFI_LINK_BLOB_SIZE];
+  size_t len = packWifiLease(lease, blob, sizeof(blob));
+  if (!len) return false;
+  Preferences prefs;
+  if (!prefs.begin(WIFI_LINK_NVS_NAMESPACE, false)) return false;
+  bool ok = prefs.putBytes(WIFI_LINK_NVS_KEY, blob, len) == len;
+  prefs.end();
+  return ok;
+}
+
+void clearWifiLease() {
+  Preferences prefs;
+  if (!prefs.begin(WIFI_LINK_NVS_NAMESPACE, false)) return;
+  prefs.remove(WIFI_LINK_NVS_KEY);
+  prefs.end();
+}
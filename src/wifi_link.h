@@ -0,0 +1,122 @@
+/*
+ * WiFi station link: reconnects driven by WiFi events instead of polling
+ * WiFi.status(), with a directed fast-connect to the last good AP.
+ *
+ * After every successful connect the AP's BSSID and channel and the DHCP
+ * lease (address, gateway, mask, DNS) are kept in NVS. The next connect,
+ * at boot or after the link drops, passes that channel + BSSID to
+ * WiFi.begin(), which skips the all-channel scan. If that attempt fails
+ * (AP moved to another channel, replaced, or is still down) the link falls
+ * back to a normal full-scan connect. With WIFI_STATIC_IP the cached lease
+ * is also applied as a static config, which saves the DHCP exchange; it is
+ * off by default because a router that hands the address to someone else
+ * meanwhile gives a conflict.
+ *
+ * Threads: the event handler runs on the WiFi event task and only sets
+ * atomics (and writes NVS when the lease changed, which keeps flash writes
+ * off the acquisition core); it is the only writer of the lease. service()
+ * runs the state machine from a periodic task; stats() can be read from
+ * anywhere.
+ *
+ * NVS blob (namespace "wifilink", key "lease"):
+ *   'W' 'L', u8 version, u8 channel, bssid[6], ip[4], gateway[4], mask[4],
+ *   dns[4]
+ */
+#pragma once
+#include <Arduino.h>
+#include <WiFi.h>
+#include <atomic>
+#include "seqlock.h"
+
+#ifndef WIFI_STATIC_IP
+#define WIFI_STATIC_IP 0  // 1: reuse the cached lease as a static config
+#endif
+
+#define WIFI_LINK_NVS_NAMESPACE "wifilink"
+#define WIFI_LINK_NVS_KEY "lease"
+#define WIFI_LINK_VERSION 1
+#define WIFI_LINK_BLOB_SIZE 26
+#define WIFI_FAST_TIMEOUT_MS 3000    // directed connect + DHCP; then full scan
+#define WIFI_SCAN_TIMEOUT_MS 15000
+#define WIFI_RETRY_MS 5000           // after a failed full scan
+
+struct WifiLease {
+  uint8_t channel;  // 0 = nothing cached
+  uint8_t bssid[6];
+  uint8_t ip[4];
+  uint8_t gateway[4];
+  uint8_t mask[4];
+  uint8_t dns[4];
+
+  bool valid() const { return channel != 0; }
+  bool operator==(const WifiLease &o) const { return !memcmp(this, &o, sizeof(*this)); }
+  bool operator!=(const WifiLease &o) const { return !(*this == o); }
+};
+
+// Latencies run from the moment the link was lost (or begin()) to GOT_IP
+struct WifiLinkStats {
+  uint32_t connects;
+  uint32_t fastConnects;
+  uint32_t scanConnects;
+  uint32_t fallbacks;  // directed attempts that ended in a full scan
+  uint32_t drops;
+  uint32_t lastConnectMs;
+  uint32_t maxConnectMs;
+};
+
+enum WifiLinkState : uint8_t { WIFI_LINK_DOWN, WIFI_LINK_FAST, WIFI_LINK_SCAN, WIFI_LINK_UP };
+
+class WifiLink {
+public:
+  // Loads the cached lease, registers the event handler and starts the
+  // first connect
+  void begin(const char *ssid, const char *password);
+  void service(unsigned long nowMs);
+
+  bool up() const { return up_.load(std::memory_order_acquire); }
+  WifiLinkState state() const { return state_.load(std::memory_order_relaxed); }
+  const char *stateName() const;
+  bool leaseCached() const { return !forget_.load(std::memory_order_acquire) && lease_.read().valid(); }
+  WifiLinkStats stats() const { return stats_.read(); }
+  // Drops the cached AP (RAM and NVS), so the next connect scans. Only
+  // requests it: the event handler, the lease's single writer, clears it
+  // at the next WiFi event, and connects scan until then.
+  void forget() { forget_.store(true, std::memory_order_release); }
+
+private:
+  static void onEvent(arduino_event_id_t event, arduino_event_info_t info);
+  void handleEvent(arduino_event_id_t event, const arduino_event_info_t &info);
+  void connect(bool fast, unsigned long nowMs);
+  void connected(unsigned long gotIpMs);
+
+  const char *ssid_ = nullptr;
+  const char *password_ = nullptr;
+  std::atomic<WifiLinkState> state_{WIFI_LINK_DOWN};  // written by service() only
+  unsigned long attemptMs_ = 0;
+  unsigned long lossMs_ = 0;
+  bool staticApplied_ = false;
+  uint32_t seenDrops_ = 0;
+  WifiLinkStats counters_ = {};  // service() side; published to stats_
+
+  // Written by the event handler
+  std::atomic<bool> up_{false};
+  std::atomic<bool> gotIp_{false};
+  std::atomic<uint32_t> gotIpMs_{0};
+  std::atomic<uint32_t> disconnects_{0};
+  std::atomic<uint32_t> disconnectMs_{0};
+  std::atomic<bool> forget_{false};  // set by forget(), taken by the event handler
+  uint8_t assocChannel_ = 0;
+  uint8_t assocBssid_[6] = {};
+  Seqlock<WifiLease> lease_;
+  Seqlock<WifiLinkStats> stats_;
+
+  static WifiLink *instance_;
+};
+
+size_t packWifiLease(const WifiLease &lease, uint8_t *out, size_t cap);
+bool unpackWifiLease(const uint8_t *in, size_t len, WifiLease &out);
+
+// NVS persistence (Preferences); false if nothing valid is stored
+bool loadWifiLease(WifiLease &out);
+bool saveWifiLease(const WifiLease &lease);
+void clearWifiLease();
@@ -0,0 +1,104 @@
+/*
+ * Sliding-window min/max/mean/stddev over the last N samples in O(1)
+ * amortized per push and O(1) per query, without allocating.
+ *
+ * min/max use monotonic deques of window slots: a new sample evicts every
+ * queued value it dominates, so each sample enters and leaves each deque
+ * once, and the head leaves when its slot is about to be overwritten.
+ * mean/stddev come from running sums in double. A second pair of sums
+ * restarts every N pushes and, once it spans exactly the window, replaces
+ * the running pair, so add/subtract rounding never accumulates.
+ * Invalid samples (sensor errors) still occupy their slot in the window but
+ * do not contribute.
+ */
+#pragma once
+#include <stdint.h>
+#include <math.h>
+
+struct WindowSummary {
+  float min;
+  float max;
+  float mean;
+  float stddev;
+  uint16_t count;  // valid samples in the window
+};
+
+template <uint16_t N>
+class SlidingWindow {
+  static_assert(N > 0, "empty window");
+
+public:
+  SlidingWindow() { clear(); }
+
+  void clear() {
+    for (uint16_t i = 0; i < N; i++) values_[i] = NAN;
+    slot_ = 0;
+    pushes_ = 0;
+    minHead_ = minLen_ = maxHead_ = maxLen_ = 0;
+    sum_ = sumSq_ = freshSum_ = freshSumSq_ = 0;
+    valid_ = 0;
+  }
+
+  void push(float v, bool valid) {
+    uint16_t slot = slot_;
+    if (!isnan(values_[slot])) {  // oldest sample leaves the window
+      double old = values_[slot];
+      sum_ -= old;
+      sumSq_ -= old * old;
+      valid_--;
+    }
+    if (minLen_ && minQ_[minHead_] == slot) { minHead_ = (minHead_ + 1) % N; minLen_--; }
+    if (maxLen_ && maxQ_[maxHead_] == slot) { maxHead_ = (maxHead_ + 1) % N; maxLen_--; }
+    values_[slot] = valid ? v : NAN;
+    slot_ = (uint16_t)((slot + 1) % N);
+
+    if (valid) {
+      while (minLen_ && values_[minQ_[(minHead_ + minLen_ - 1) % N]] >= v) minLen_--;
+      minQ_[(minHead_ + minLen_++) % N] = slot;
+      while (maxLen_ && values_[maxQ_[(maxHead_ + maxLen_ - 1) % N]] <= v) maxLen_--;
+      maxQ_[(maxHead_ + maxLen_++) % N] = slot;
+      sum_ += v;
+      sumSq_ += (double)v * v;
+      freshSum_ += v;
+      freshSumSq_ += (double)v * v;
+      valid_++;
+    }
+
+    if (++pushes_ == N) {  // fresh sums now cover exactly the window
+      sum_ = freshSum_;
+      sumSq_ = freshSumSq_;
+      freshSum_ = freshSumSq_ = 0;
+      pushes_ = 0;
+    }
+  }
+
+  uint16_t count() const { return valid_; }
+  float min() const { return minLen_ ? values_[minQ_[minHead_]] : NAN; }
+  float max() const { return maxLen_ ? values_[maxQ_[maxHead_]] : NAN; }
+  float mean() const { return valid_ ? (float)(sum_ / valid_) : NAN; }
+  float stddev() const {
+    if (!valid_) return NAN;
+    double m = sum_ / valid_;
+    double var = sumSq_ / valid_ - m * m;
+    return var > 0 ? (float)sqrt(var) : 0.0f;
+  }
+
+  WindowSummary summary() const {
+    WindowSummary s = {min(), max(), mean(), stddev(), valid_};
+    return s;
+  }
+
+private:
+  float values_[N];     // NaN = empty or invalid
+  uint16_t minQ_[N];    // slots, values increasing from the head
+  uint16_t maxQ_[N];    // slots, values decreasing from the head
+  uint16_t slot_;       // next slot to write (the oldest sample)
+  uint16_t pushes_;     // since the fresh sums restarted
+  uint16_t minHead_, minLen_;
+  uint16_t maxHead_, maxLen_;
+  double sum_;
+  double sumSq_;
+  double freshSum_;
+  double freshSumSq_;
+  uint16_t valid_;
+};
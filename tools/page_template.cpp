@@ -0,0 +1,163 @@
+/*
+ * Builds the gzip page templates served by src/page_template.h.
+ *
+ *   g++ -std=c++17 -O2 tools/page_template.cpp -lz -o page_template
+ *   page_template tools/pages/simple.html data/simple.html.gz
+ *   page_template tools/pages/calibrate.html data/calibrate.html.gz
+ *
+ * Placeholders are %NAME% with NAME in [A-Z0-9_] (anything else between
+ * percent signs, e.g. "Soil (%)", is plain text). The text between them is
+ * deflated and flushed with Z_FULL_FLUSH, each placeholder becomes a
+ * stored block holding "%NAME%", and the segment index goes into a "GT"
+ * subfield of the gzip extra field. The output is an ordinary gzip file:
+ * zcat shows the template with its placeholders.
+ *
+ * Run it again (and `pio run -t uploadfs`) after editing a page.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+#define PAGE_INDEX_VERSION 1  // keep in step with src/page_template.cpp
+#define PAGE_MAX_FIELDS 8
+#define PAGE_FIELD_NAME_SIZE 16
+
+struct Segment {
+  std::string text;
+  uint32_t offset = 0, length = 0;  // offset relative to the deflate stream until the header is known
+};
+
+static void putLe16(std::vector<uint8_t> &out, uint32_t v) {
+  out.push_back((uint8_t)v);
+  out.push_back((uint8_t)(v >> 8));
+}
+
+static void putLe32(std::vector<uint8_t> &out, uint32_t v) {
+  putLe16(out, v & 0xffff);
+  putLe16(out, v >> 16);
+}
+
+static bool isNameChar(char c) { return (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_'; }
+
+// Splits `page` into segments.size() == names.size() + 1
+static bool parse(const std::string &page, std::vector<Segment> &segments, std::vector<std::string> &names) {
+  segments.assign(1, Segment());
+  for (size_t i = 0; i < page.size(); i++) {
+    size_t end = page[i] == '%' ? page.find('%', i + 1) : std::string::npos;
+    bool field = end != std::string::npos && end > i + 1;
+    for (size_t k = i + 1; field && k < end; k++) field = isNameChar(page[k]);
+    if (!field) {
+      segments.back().text += page[i];
+      continue;
+    }
+    std::string name = page.substr(i + 1, end - i - 1);
+    if (name.size() >= PAGE_FIELD_NAME_SIZE) {
+      fprintf(stderr, "placeholder %%%s%% is longer than %d characters\n", name.c_str(), PAGE_FIELD_NAME_SIZE - 1);
+      return false;
+    }
+    names.push_back(name);
+    segments.push_back(Segment());
+    i = end;
+  }
+  if (names.size() > PAGE_MAX_FIELDS) {
+    fprintf(stderr, "%zu placeholders, at most %d\n", names.size(), PAGE_MAX_FIELDS);
+    return false;
+  }
+  return true;
+}
+
+static bool deflateSegments(std::vector<Segment> &segments, const std::vector<std::string> &names,
+                            std::vector<uint8_t> &stream) {
+  z_stream z = {};
+  if (deflateInit2(&z, 9, Z_DEFLATED, -15, 9, Z_DEFAULT_STRATEGY) != Z_OK) return false;
+  uint8_t chunk[4096];
+  for (size_t i = 0; i < segments.size(); i++) {
+    Segment &s = segments[i];
+    bool last = i + 1 == segments.size();
+    s.offset = (uint32_t)stream.size();
+    z.next_in = (Bytef *)s.text.data();
+    z.avail_in = (uInt)s.text.size();
+    int rc;
+    do {
+      z.next_out = chunk;
+      z.avail_out = sizeof(chunk);
+      rc = deflate(&z, last ? Z_FINISH : Z_FULL_FLUSH);
+      stream.insert(stream.end(), chunk, chunk + (sizeof(chunk) - z.avail_out));
+    } while (z.avail_out == 0 || (last && rc != Z_STREAM_END));
+    s.length = (uint32_t)stream.size() - s.offset;
+    if (last) break;
+    // The placeholder as a stored block; the full flush left the stream byte aligned
+    std::string token = "%" + names[i] + "%";
+    stream.push_back(0x00);
+    putLe16(stream, (uint32_t)token.size());
+    putLe16(stream, ~(uint32_t)token.size() & 0xffff);
+    stream.insert(stream.end(), token.begin(), token.end());
+  }
+  deflateEnd(&z);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s page.html out.html.gz\n", argv[0]);
+    return 2;
+  }
+  FILE *in = fopen(argv[1], "rb");
+  if (!in) {
+    perror(argv[1]);
+    return 1;
+  }
+  std::string page;
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), in)) > 0) page.append(buf, n);
+  fclose(in);
+
+  std::vector<Segment> segments;
+  std::vector<std::string> names;
+  std::vector<uint8_t> stream;
+  if (!parse(page, segments, names) || !deflateSegments(segments, names, stream)) return 1;
+
+  // Index: version, field count, per segment offset/length/raw length/CRC, then the names
+  std::vector<uint8_t> index;
+  index.push_back(PAGE_INDEX_VERSION);
+  index.push_back((uint8_t)names.size());
+  size_t headerSize = 10 + 2 + 4 + 2 + 16 * segments.size();
+  for (const std::string &name : names) headerSize += 1 + name.size();
+  for (const Segment &s : segments) {
+    putLe32(index, (uint32_t)(headerSize + s.offset));
+    putLe32(index, s.length);
+    putLe32(index, (uint32_t)s.text.size());
+    putLe32(index, (uint32_t)crc32(0, (const Bytef *)s.text.data(), (uInt)s.text.size()));
+  }
+  for (const std::string &name : names) {
+    index.push_back((uint8_t)name.size());
+    index.insert(index.end(), name.begin(), name.end());
+  }
+
+  std::vector<uint8_t> out = {0x1f, 0x8b, 8, 0x04, 0, 0, 0, 0, 2, 0xff};  // FEXTRA, best compression, OS unknown
+  putLe16(out, (uint32_t)(4 + index.size()));
+  out.push_back('G');
+  out.push_back('T');
+  putLe16(out, (uint32_t)index.size());
+  out.insert(out.end(), index.begin(), index.end());
+  if (out.size() != headerSize) {
+    fprintf(stderr, "internal error: header is %zu bytes, expected %zu\n", out.size(), headerSize);
+    return 1;
+  }
+  out.insert(out.end(), stream.begin(), stream.end());
+  putLe32(out, (uint32_t)crc32(0, (const Bytef *)page.data(), (uInt)page.size()));
+  putLe32(out, (uint32_t)page.size());
+
+  FILE *f = fopen(argv[2], "wb");
+  if (!f || fwrite(out.data(), 1, out.size(), f) != out.size() || fclose(f) != 0) {
+    perror(argv[2]);
+    return 1;
+  }
+  fprintf(stderr, "%s: %zu bytes of HTML, %zu placeholders -> %zu bytes\n", argv[2], page.size(), names.size(),
+          out.size());
+  return 0;
+}
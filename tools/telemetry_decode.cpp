@@ -0,0 +1,204 @@
+/*
+ * Host-side decoder for the binary serial telemetry (src/telemetry.h).
+ *
+ *   g++ -std=c++17 -O2 -Isrc tools/telemetry_decode.cpp src/telemetry.cpp -o telemetry_decode
+ *   telemetry_decode [--json] [--text] [capture.bin]     (stdin without a file)
+ *
+ * Capture the port raw, e.g. `stty -F /dev/ttyACM0 115200 raw && cat
+ * /dev/ttyACM0 > capture.bin`. Output is CSV (one header, columns of the
+ * other record types left empty) or JSON lines. Text printed between
+ * frames is skipped, or copied to stderr with --text. A summary of frames,
+ * CRC failures and sequence gaps goes to stderr at the end.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "telemetry.h"
+
+struct Options {
+  bool json = false;
+  bool text = false;
+  const char *path = nullptr;
+};
+
+struct Summary {
+  unsigned long frames = 0, bad = 0, text = 0, lost = 0;
+  unsigned long byType[6] = {};
+};
+
+static void number(FILE *out, float v, bool json) {
+  if (isnan(v) || isinf(v)) {
+    fputs(json ? "null" : "", out);
+  } else {
+    fprintf(out, "%.2f", v);
+  }
+}
+
+enum CsvColumn {
+  COL_TYPE, COL_SEQ, COL_MS, COL_TEMPERATURE, COL_PRESSURE, COL_LIGHT, COL_SOIL, COL_SOIL_RAW, COL_ADC_SAMPLES,
+  COL_ADC_OVERRUNS, COL_TIMESTAMP, COL_HISTORY_POINTS, COL_MIN_TEMPERATURE, COL_MAX_TEMPERATURE, COL_WATERING,
+  COL_MANUAL, COL_ALERT, COL_VALUE, COL_THRESHOLD, COL_SLOT, COL_TASK, COL_RUNS, COL_MAX_JITTER_US, COL_COUNT
+};
+
+static const char *const CSV_HEADER[COL_COUNT] = {
+  "type", "seq", "ms", "temperature", "pressure", "light", "soil", "soil_raw", "adc_samples", "adc_overruns",
+  "timestamp", "history_points", "min_temperature", "max_temperature", "watering", "manual", "alert", "value",
+  "threshold", "slot", "task", "runs", "max_jitter_us",
+};
+
+typedef char CsvRow[COL_COUNT][24];
+
+static void cell(CsvRow &row, CsvColumn col, unsigned long v) { snprintf(row[col], sizeof(row[col]), "%lu", v); }
+static void cell(CsvRow &row, CsvColumn col, const char *v) { snprintf(row[col], sizeof(row[col]), "%s", v); }
+static void cellFloat(CsvRow &row, CsvColumn col, float v) {
+  if (!isnan(v) && !isinf(v)) snprintf(row[col], sizeof(row[col]), "%.2f", v);
+}
+
+static void printCsvHeader(FILE *out) {
+  for (int c = 0; c < COL_COUNT; c++) fprintf(out, "%s%c", CSV_HEADER[c], c + 1 < COL_COUNT ? ',' : '\n');
+}
+
+static void printCsv(FILE *out, const TelemetryRecord &r) {
+  CsvRow row = {};
+  cell(row, COL_TYPE, telemetryTypeName(r.type));
+  cell(row, COL_SEQ, r.seq);
+  cell(row, COL_MS, r.ms);
+  switch (r.type) {
+    case TELEMETRY_SAMPLE:
+      cellFloat(row, COL_TEMPERATURE, r.sample.temperature);
+      cellFloat(row, COL_PRESSURE, r.sample.pressure);
+      cellFloat(row, COL_LIGHT, r.sample.light);
+      cellFloat(row, COL_SOIL, r.sample.soil);
+      cell(row, COL_SOIL_RAW, r.sample.soilRaw);
+      cell(row, COL_ADC_SAMPLES, r.sample.adcSamples);
+      cell(row, COL_ADC_OVERRUNS, r.sample.adcOverruns);
+      break;
+    case TELEMETRY_HISTORY:
+      cell(row, COL_TIMESTAMP, r.history.timestamp);
+      cell(row, COL_HISTORY_POINTS, r.history.points);
+      cellFloat(row, COL_TEMPERATURE, r.history.temperature);
+      cellFloat(row, COL_MIN_TEMPERATURE, r.history.minTemperature);
+      cellFloat(row, COL_MAX_TEMPERATURE, r.history.maxTemperature);
+      break;
+    case TELEMETRY_WATERING:
+      cell(row, COL_WATERING, r.watering.on);
+      cell(row, COL_MANUAL, r.watering.manual);
+      cellFloat(row, COL_SOIL, r.watering.soil);
+      break;
+    case TELEMETRY_ALERT:
+      cell(row, COL_ALERT, telemetryAlertName(r.alert.kind));
+      cellFloat(row, COL_VALUE, r.alert.value);
+      cellFloat(row, COL_THRESHOLD, r.alert.threshold);
+      break;
+    case TELEMETRY_TIMING:
+      cell(row, COL_SLOT, r.timing.slot);
+      cell(row, COL_TASK, r.timing.name);
+      cell(row, COL_RUNS, r.timing.runs);
+      cell(row, COL_MAX_JITTER_US, r.timing.maxJitterUs);
+      break;
+    default:
+      break;
+  }
+  for (int c = 0; c < COL_COUNT; c++) fprintf(out, "%s%c", row[c], c + 1 < COL_COUNT ? ',' : '\n');
+}
+
+static void field(FILE *out, const char *name, float v) {
+  fprintf(out, ",\"%s\":", name);
+  number(out, v, true);
+}
+
+static void printJson(FILE *out, const TelemetryRecord &r) {
+  fprintf(out, "{\"type\":\"%s\",\"seq\":%u,\"ms\":%lu", telemetryTypeName(r.type), r.seq, (unsigned long)r.ms);
+  switch (r.type) {
+    case TELEMETRY_SAMPLE:
+      field(out, "temperature", r.sample.temperature);
+      field(out, "pressure", r.sample.pressure);
+      field(out, "light", r.sample.light);
+      field(out, "soil", r.sample.soil);
+      fprintf(out, ",\"soil_raw\":%u,\"adc_samples\":%lu,\"adc_overruns\":%lu", r.sample.soilRaw,
+              (unsigned long)r.sample.adcSamples, (unsigned long)r.sample.adcOverruns);
+      break;
+    case TELEMETRY_HISTORY:
+      fprintf(out, ",\"timestamp\":%lu,\"points\":%u", (unsigned long)r.history.timestamp, r.history.points);
+      field(out, "temperature", r.history.temperature);
+      field(out, "min_temperature", r.history.minTemperature);
+      field(out, "max_temperature", r.history.maxTemperature);
+      break;
+    case TELEMETRY_WATERING:
+      fprintf(out, ",\"watering\":%s,\"manual\":%s", r.watering.on ? "true" : "false",
+              r.watering.manual ? "true" : "false");
+      field(out, "soil", r.watering.soil);
+      break;
+    case TELEMETRY_ALERT:
+      fprintf(out, ",\"alert\":\"%s\"", telemetryAlertName(r.alert.kind));
+      field(out, "value", r.alert.value);
+      field(out, "threshold", r.alert.threshold);
+      break;
+    case TELEMETRY_TIMING:
+      fprintf(out, ",\"slot\":%u,\"task\":\"%s\",\"runs\":%lu,\"max_jitter_us\":%lu", r.timing.slot, r.timing.name,
+              (unsigned long)r.timing.runs, (unsigned long)r.timing.maxJitterUs);
+      break;
+    default:
+      break;
+  }
+  fputs("}\n", out);
+}
+
+static bool parseArgs(int argc, char **argv, Options &opt) {
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--json")) opt.json = true;
+    else if (!strcmp(argv[i], "--text")) opt.text = true;
+    else if (argv[i][0] == '-' && argv[i][1]) return false;
+    else opt.path = argv[i];
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  Options opt;
+  if (!parseArgs(argc, argv, opt)) {
+    fprintf(stderr, "usage: %s [--json] [--text] [capture.bin]\n", argv[0]);
+    return 2;
+  }
+  FILE *in = opt.path ? fopen(opt.path, "rb") : stdin;
+  if (!in) {
+    perror(opt.path);
+    return 1;
+  }
+
+  Summary sum;
+  std::vector<uint8_t> segment;
+  int lastSeq = -1;
+  if (!opt.json) printCsvHeader(stdout);
+  for (int c = fgetc(in);; c = fgetc(in)) {
+    if (c != EOF && c != 0) {
+      segment.push_back((uint8_t)c);
+      continue;
+    }
+    if (!segment.empty()) {
+      TelemetryRecord r;
+      if (decodeTelemetryFrame(segment.data(), segment.size(), r)) {
+        sum.frames++;
+        sum.byType[r.type < 6 ? r.type : 0]++;
+        if (lastSeq >= 0) sum.lost += (uint8_t)(r.seq - lastSeq - 1);
+        lastSeq = r.seq;
+        if (opt.json) printJson(stdout, r); else printCsv(stdout, r);
+      } else if (segment.size() > TELEMETRY_FRAME_MAX || memchr(segment.data(), '\n', segment.size())) {
+        sum.text++;
+        if (opt.text) fwrite(segment.data(), 1, segment.size(), stderr);
+      } else {
+        sum.bad++;
+      }
+      segment.clear();
+    }
+    if (c == EOF) break;
+  }
+  if (in != stdin) fclose(in);
+
+  fprintf(stderr, "%lu frames (%lu sample, %lu history, %lu watering, %lu alert, %lu timing), %lu bad, "
+          "%lu lost by sequence, %lu text segments\n", sum.frames, sum.byType[TELEMETRY_SAMPLE],
+          sum.byType[TELEMETRY_HISTORY], sum.byType[TELEMETRY_WATERING], sum.byType[TELEMETRY_ALERT],
+          sum.byType[TELEMETRY_TIMING], sum.bad, sum.lost, sum.text);
+  return 0;
+}